@@ -116,8 +116,10 @@ else()
 	#
 	check_include_file("alloca.h"    HAVE_ALLOCA_H)
 endif()
+check_function_exists("fallocate"        HAVE_FALLOCATE)
 check_function_exists("getifaddrs"       HAVE_GETIFADDRS)
 check_function_exists("issetugid"        HAVE_ISSETUGID)
+check_function_exists("memfd_create"     HAVE_MEMFD_CREATE)
 check_function_exists("mkstemps"         HAVE_MKSTEMPS)
 check_function_exists("setresgid"        HAVE_SETRESGID)
 check_function_exists("setresuid"        HAVE_SETRESUID)
@@ -23,6 +23,7 @@ extern "C" {
 #include "capture_opts.h"
 
 #include <wsutil/processes.h>
+#include <wsutil/shm_tail.h>
 
 #ifdef HAVE_LIBPCAP
 /* Current state of capture engine. XXX - differentiate states */
@@ -56,6 +57,7 @@ typedef struct _capture_session {
     Buffer buf;                           /**< Buffer we're reading packet data into */
     struct wtap *wtap;                    /**< current wtap file */
     struct _info_data *cap_data_info;     /**< stats for this capture */
+    shm_tail_t *shm_tail;                 /**< end of the file, shared with the child, or NULL */
 } capture_session;
 
 extern void
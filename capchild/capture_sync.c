@@ -31,6 +31,10 @@
 # include <sys/wait.h>
 #endif
 
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+
 #include "caputils/capture-pcap-util.h"
 
 #ifndef _WIN32
@@ -80,6 +84,7 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/shm_tail.h>
 #include "extcap.h"
 #include "log.h"
 
@@ -129,6 +134,16 @@ capture_session_init(capture_session *cap_session, capture_file *cf)
 #endif
     cap_session->count                           = 0;
     cap_session->session_started                 = FALSE;
+    cap_session->shm_tail                        = NULL;
+}
+
+/* Drop our reference to the end of the capture file shared with the
+   child; the readers of the file have their own. */
+static void
+sync_pipe_release_shm_tail(capture_session *cap_session)
+{
+    shm_tail_unref(cap_session->shm_tail);
+    cap_session->shm_tail = NULL;
 }
 
 /* Append an arg (realloc) to an argc/argv array */
@@ -210,6 +225,8 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
     char errmsg[1024+1];
     int sync_pipe[2];                       /* pipe used to send messages from child to parent */
     enum PIPES { PIPE_READ, PIPE_WRITE };   /* Constants 0 and 1 for PIPE_READ and PIPE_WRITE */
+    char sshm_tail_fd[ARGV_NUMBER_LEN];
+    int err;
 #endif
     int sync_pipe_read_fd;
     int argc;
@@ -419,6 +436,24 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
         argv = sync_pipe_add_arg(argv, &argc, "-w");
         argv = sync_pipe_add_arg(argv, &argc, capture_opts->save_file);
     }
+
+#ifndef _WIN32
+    /* Have dumpcap copy the end of the file to shared memory as it writes
+       it, so that we can read new packets from there (hidden feature). */
+    sync_pipe_release_shm_tail(cap_session);
+    if (capture_opts->shm_tail_size != 0) {
+        cap_session->shm_tail = shm_tail_create((gsize)capture_opts->shm_tail_size * 1024 * 1024, &err);
+        if (cap_session->shm_tail != NULL) {
+            g_snprintf(sshm_tail_fd, ARGV_NUMBER_LEN, "%d", shm_tail_fd(cap_session->shm_tail));
+            argv = sync_pipe_add_arg(argv, &argc, "--shm-tail");
+            argv = sync_pipe_add_arg(argv, &argc, sshm_tail_fd);
+        } else {
+            g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_DEBUG,
+                  "sync_pipe_start: no shared memory for the capture file: %s", g_strerror(err));
+        }
+    }
+#endif
+
     for (i = 0; i < argc; i++) {
         g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_DEBUG, "argv[%d]: %s", i, argv[i]);
     }
@@ -544,6 +579,7 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
         /* Couldn't create the pipe between parent and child. */
         report_failure("Couldn't create sync pipe: %s", g_strerror(errno));
         free_argv(argv, argc);
+        sync_pipe_release_shm_tail(cap_session);
         return FALSE;
     }
 
@@ -554,6 +590,8 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
          */
         dup2(sync_pipe[PIPE_WRITE], 2);
         ws_close(sync_pipe[PIPE_READ]);
+        if (cap_session->shm_tail != NULL)
+            fcntl(shm_tail_fd(cap_session->shm_tail), F_SETFD, 0);
         execv(argv[0], argv);
         g_snprintf(errmsg, sizeof errmsg, "Couldn't run %s in child process: %s",
                    argv[0], g_strerror(errno));
@@ -596,6 +634,7 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
 #ifdef _WIN32
         ws_close(cap_session->signal_pipe_write_fd);
 #endif
+        sync_pipe_release_shm_tail(cap_session);
         return FALSE;
     }
 
@@ -1651,6 +1690,7 @@ sync_pipe_input_cb(gint source, gpointer user_data)
         g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_DEBUG, "sync_pipe_input_cb: cleaning extcap pipe");
         extcap_if_cleanup(cap_session->capture_opts, &primary_msg);
         capture_input_closed(cap_session, primary_msg);
+        sync_pipe_release_shm_tail(cap_session);
         g_free(primary_msg);
         return FALSE;
     }
@@ -1679,6 +1719,7 @@ sync_pipe_input_cb(gint source, gpointer user_data)
                "standard output", as the capture file. */
             sync_pipe_stop(cap_session);
             capture_input_closed(cap_session, NULL);
+            sync_pipe_release_shm_tail(cap_session);
             return FALSE;
         }
         break;
@@ -283,6 +283,7 @@ typedef struct capture_options_tag {
     /* GUI related */
     gboolean           real_time_mode;        /**< Update list of packets in real time */
     gboolean           show_info;             /**< show the info dialog. */
+    guint              shm_tail_size;         /**< MiB of the file to share with the capture child, 0 for none */
     gboolean           restart;               /**< restart after closing is done */
     gchar             *orig_save_file;        /**< the original capture file name (saved for a restart) */
 
@@ -125,6 +125,7 @@ typedef struct _capture_file {
   gulong                      computed_elapsed;     /* Elapsed time to load the file (in msec). */
 
   guint32                     cum_bytes;
+  struct filter_cache        *filter_cache;         /* Frames matching earlier display filters */
 } capture_file;
 
 extern void cap_file_init(capture_file *cf);
@@ -81,6 +81,8 @@
 #include "wsutil/inet_addr.h"
 #include "wsutil/time_util.h"
 #include "wsutil/please_report_bug.h"
+#include "wsutil/spsc_ring.h"
+#include "wsutil/shm_tail.h"
 
 #include "caputils/ws80211_utils.h"
 
@@ -111,11 +113,15 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
+/* The limits for each interface's ring; 0 is no limit. */
+static gsize pcap_ring_byte_limit;
+static guint pcap_ring_packet_limit;
+/* Set while the writer waits for packets to be queued. */
+static volatile gint writer_waiting;
+static GMutex writer_wait_mtx;
+static GCond writer_wait_cond;
 
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 #ifdef _WIN32
@@ -238,6 +244,7 @@ typedef struct _capture_src {
     gboolean                     pcap_err;
     guint                        interface_id;
     GThread                     *tid;
+    spsc_ring_t                 *ring;                   /**< Packets queued for the writer, if use_threads */
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
@@ -300,9 +307,9 @@ typedef struct _loop_data {
     GArray   *saved_idbs;          /**< Array of saved_idb_t, written when we have a new section or output file. */
     GRWLock   saved_shb_idb_lock;  /**< Saved IDB RW mutex */
     /* output file(s) */
-    FILE     *pdh;
+    pcapio_writer_t *writer;
     int       save_file_fd;
-    char     *io_buffer;           /**< Our IO buffer if we increase the size from the standard size */
+    pcapio_writer_stats_t writer_stats; /**< Statistics of the writers of all the files */
     guint64   bytes_written;       /**< Bytes written for the current file. */
     /* autostop conditions */
     int       packets_written;     /**< Packets written for the current file. */
@@ -313,13 +320,15 @@ typedef struct _loop_data {
     int      interval_s;
 } loop_data;
 
+/*
+ * A packet or block in a capture_src's ring; the data follows it.
+ */
 typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
+    guint64            ts;      /**< nanoseconds since the Epoch, to interleave interfaces */
     union {
         struct pcap_pkthdr  phdr;
         pcapng_block_header_t  bh;
     } u;
-    u_char             *pd;
 } pcap_queue_element;
 
 /*
@@ -363,6 +372,10 @@ static gboolean need_timeout_workaround;
 
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+/* Most packets the writer writes before checking stop conditions, or
+   signals from our parent, again. */
+#define WRITER_BATCH_SIZE 256
+
 static void
 console_log_handler(const char *log_domain, GLogLevelFlags log_level,
                     const char *message, gpointer user_data _U_);
@@ -371,6 +384,10 @@ console_log_handler(const char *log_domain, GLogLevelFlags log_level,
 static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
+static compress_file_type_t ring_compress_type = COMPRESS_FILE_NONE;
+static guint writer_flags = 0;           /**< PCAPIO_WRITER_ flags for the output file(s) */
+static gboolean preallocate_files = FALSE; /**< Allocate each ring buffer file's size up front */
+static shm_tail_t *output_tail = NULL;   /**< Shared with our parent, which reads the end of the file from it */
 static guint64 start_time;
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -390,11 +407,28 @@ static void WS_NORETURN exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_queue_high_water(spsc_ring_t *ring, gchar *name);
+static void report_writer_stats(const pcapio_writer_stats_t *stats);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
 #define MSG_MAX_LENGTH 4096
 
+static void
+print_compress_types(FILE *output)
+{
+    GSList *names, *name;
+
+    names = compress_file_type_names();
+    if (names == NULL)
+        return;
+    fprintf(output, "Compression types for --compress-type:\n");
+    for (name = names; name != NULL; name = g_slist_next(name))
+        fprintf(output, "    %s\n", (const char *)name->data);
+    fprintf(output, "\n");
+    g_slist_free(names);
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -459,6 +493,12 @@ print_usage(FILE *output)
     fprintf(output, "                            packets:NUM - ringbuffer: replace after NUM packets\n");
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
+    fprintf(output, "  --compress-type <type>   compress each ring buffer file once it is complete;\n");
+    fprintf(output, "                           see below for the types\n");
+    fprintf(output, "  --async-write            write the output file(s) from a separate thread\n");
+    fprintf(output, "  --direct-io              bypass the page cache when writing the output\n");
+    fprintf(output, "                           file(s), where supported\n");
+    fprintf(output, "  --preallocate            allocate each ring buffer file's filesize up front\n");
     fprintf(output, "  --capture-comment <comment>\n");
     fprintf(output, "                           add a capture comment to the output file\n");
     fprintf(output, "                           (only for pcapng)\n");
@@ -472,6 +512,7 @@ print_usage(FILE *output)
     fprintf(output, "  -v                       print version information and exit\n");
     fprintf(output, "  -h                       display this help and exit\n");
     fprintf(output, "\n");
+    print_compress_types(output);
 #ifdef __linux__
     fprintf(output, "Dumpcap can benefit from an enabled BPF JIT compiler if available.\n");
     fprintf(output, "You might want to enable it by executing:\n");
@@ -2934,6 +2975,8 @@ static void capture_loop_close_input(loop_data *ld)
                 pcap_src->pcap_h = NULL;
             }
         }
+        spsc_ring_free(pcap_src->ring);
+        pcap_src->ring = NULL;
     }
 
     ld->go = FALSE;
@@ -3001,21 +3044,21 @@ capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld)
 
         memcpy(&bh, ld->saved_shb, sizeof(pcapng_block_header_t));
 
-        successful = pcapng_write_block(ld->pdh, ld->saved_shb, bh.block_total_length, &ld->bytes_written, &err);
+        successful = pcapng_write_block_to_writer(ld->writer, ld->saved_shb, bh.block_total_length, &ld->bytes_written, &err);
 
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: wrote saved passthrough SHB %d", G_STRFUNC, successful);
     } else {
         GString *cpu_info_str = g_string_new("");
         get_cpu_info(cpu_info_str);
 
-        successful = pcapng_write_section_header_block(ld->pdh,
-                                                       (const char *)capture_opts->capture_comment,   /* Comment */
-                                                       cpu_info_str->str,           /* HW */
-                                                       os_info_str->str,            /* OS */
-                                                       get_appname_and_version(),
-                                                       -1,                          /* section_length */
-                                                       &ld->bytes_written,
-                                                       &err);
+        successful = pcapng_write_section_header_block_to_writer(ld->writer,
+                                                                 (const char *)capture_opts->capture_comment,   /* Comment */
+                                                                 cpu_info_str->str,           /* HW */
+                                                                 os_info_str->str,            /* OS */
+                                                                 get_appname_and_version(),
+                                                                 -1,                          /* section_length */
+                                                                 &ld->bytes_written,
+                                                                 &err);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: wrote dumpcap SHB %d", G_STRFUNC, successful);
         g_string_free(cpu_info_str, TRUE);
     }
@@ -3036,21 +3079,21 @@ capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld)
              * It might make more sense to write the original data so that
              * so that our IDB lists are more consistent across files.
              */
-            successful = pcapng_write_interface_description_block(global_ld.pdh,
-                                                                  "Interface went out of scope",    /* OPT_COMMENT       1 */
-                                                                  "dummy",                          /* IDB_NAME          2 */
-                                                                  "Dumpcap dummy interface",        /* IDB_DESCRIPTION   3 */
-                                                                  NULL,                             /* IDB_FILTER       11 */
-                                                                  os_info_str->str,                 /* IDB_OS           12 */
-                                                                  -1,
-                                                                  0,
-                                                                  &(global_ld.bytes_written),
-                                                                  0,                                /* IDB_IF_SPEED      8 */
-                                                                  6,                                /* IDB_TSRESOL       9 */
-                                                                  &global_ld.err);
+            successful = pcapng_write_interface_description_block_to_writer(global_ld.writer,
+                                                                            "Interface went out of scope",    /* OPT_COMMENT       1 */
+                                                                            "dummy",                          /* IDB_NAME          2 */
+                                                                            "Dumpcap dummy interface",        /* IDB_DESCRIPTION   3 */
+                                                                            NULL,                             /* IDB_FILTER       11 */
+                                                                            os_info_str->str,                 /* IDB_OS           12 */
+                                                                            -1,
+                                                                            0,
+                                                                            &(global_ld.bytes_written),
+                                                                            0,                                /* IDB_IF_SPEED      8 */
+                                                                            6,                                /* IDB_TSRESOL       9 */
+                                                                            &global_ld.err);
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: skipping deleted pcapng IDB %u", G_STRFUNC, i);
         } else if (idb_source.idb && idb_source.idb_len) {
-            successful = pcapng_write_block(global_ld.pdh, idb_source.idb, idb_source.idb_len, &ld->bytes_written, &err);
+            successful = pcapng_write_block_to_writer(global_ld.writer, idb_source.idb, idb_source.idb_len, &ld->bytes_written, &err);
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: wrote pcapng IDB %d", G_STRFUNC, successful);
         } else if (idb_source.interface_id < capture_opts->ifaces->len) {
             unsigned if_id = idb_source.interface_id;
@@ -3061,18 +3104,18 @@ capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld)
             } else {
                 pcap_src->snaplen = pcap_snapshot(pcap_src->pcap_h);
             }
-            successful = pcapng_write_interface_description_block(global_ld.pdh,
-                                                                  NULL,                       /* OPT_COMMENT       1 */
-                                                                  interface_opts->name,       /* IDB_NAME          2 */
-                                                                  interface_opts->descr,      /* IDB_DESCRIPTION   3 */
-                                                                  interface_opts->cfilter,    /* IDB_FILTER       11 */
-                                                                  os_info_str->str,           /* IDB_OS           12 */
-                                                                  pcap_src->linktype,
-                                                                  pcap_src->snaplen,
-                                                                  &(global_ld.bytes_written),
-                                                                  0,                          /* IDB_IF_SPEED      8 */
-                                                                  pcap_src->ts_nsec ? 9 : 6,  /* IDB_TSRESOL       9 */
-                                                                  &global_ld.err);
+            successful = pcapng_write_interface_description_block_to_writer(global_ld.writer,
+                                                                            NULL,                       /* OPT_COMMENT       1 */
+                                                                            interface_opts->name,       /* IDB_NAME          2 */
+                                                                            interface_opts->descr,      /* IDB_DESCRIPTION   3 */
+                                                                            interface_opts->cfilter,    /* IDB_FILTER       11 */
+                                                                            os_info_str->str,           /* IDB_OS           12 */
+                                                                            pcap_src->linktype,
+                                                                            pcap_src->snaplen,
+                                                                            &(global_ld.bytes_written),
+                                                                            0,                          /* IDB_IF_SPEED      8 */
+                                                                            pcap_src->ts_nsec ? 9 : 6,  /* IDB_TSRESOL       9 */
+                                                                            &global_ld.err);
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: wrote capture_opts IDB %d: %d", G_STRFUNC, if_id, successful);
         }
     }
@@ -3083,6 +3126,24 @@ capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld)
     return successful;
 }
 
+/*
+ * Copy what's written to a new output file to the shared memory our
+ * parent gave us, if it did, so that it needn't wait for it to be
+ * written to the file.  The writer has to have written everything that
+ * no longer fits to the file, so the memory must be bigger than its
+ * buffers; if it isn't, we do without it.
+ */
+static void
+capture_loop_share_output(pcapio_writer_t *writer)
+{
+    if (output_tail != NULL && !pcapio_writer_set_tail(writer, output_tail)) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+              "capture_loop_share_output: shared memory too small for the output buffers, not using it");
+        shm_tail_unref(output_tail);
+        output_tail = NULL;
+    }
+}
+
 /* set up to write to the already-opened capture output file/files */
 static gboolean
 capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *errmsg, int errmsg_len)
@@ -3101,29 +3162,17 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
 
     /* Set up to write to the capture file. */
     if (capture_opts->multi_files_on) {
-        ld->pdh = ringbuf_init_libpcap_fdopen(&err);
-    } else {
-        ld->pdh = ws_fdopen(ld->save_file_fd, "wb");
-        if (ld->pdh == NULL) {
-            err = errno;
-        } else {
-            size_t buffsize = IO_BUF_SIZE;
-#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
-            ws_statb64 statb;
+        guint64 preallocate = 0;
 
-            if (ws_fstat64(ld->save_file_fd, &statb) == 0) {
-                if (statb.st_blksize > IO_BUF_SIZE) {
-                    buffsize = statb.st_blksize;
-                }
-            }
-#endif
-            /* Increase the size of the IO buffer */
-            ld->io_buffer = (char *)g_malloc(buffsize);
-            setvbuf(ld->pdh, ld->io_buffer, _IOFBF, buffsize);
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_init_output: buffsize %zu", buffsize);
-        }
+        /* The files are cut back to what was written when they're closed. */
+        if (preallocate_files && capture_opts->has_autostop_filesize)
+            preallocate = (guint64)capture_opts->autostop_filesize * 1000;
+        ld->writer = ringbuf_init_writer(writer_flags, preallocate, &ld->writer_stats);
+    } else {
+        ld->writer = pcapio_writer_open(ld->save_file_fd, writer_flags, 0, 0, &ld->writer_stats);
     }
-    if (ld->pdh) {
+    if (ld->writer) {
+        capture_loop_share_output(ld->writer);
         if (capture_opts->use_pcapng) {
             successful = capture_loop_init_pcapng_output(capture_opts, ld);
         } else {
@@ -3134,18 +3183,22 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
             } else {
                 pcap_src->snaplen = pcap_snapshot(pcap_src->pcap_h);
             }
-            successful = libpcap_write_file_header(ld->pdh, pcap_src->linktype, pcap_src->snaplen,
-                                                pcap_src->ts_nsec, &ld->bytes_written, &err);
+            successful = libpcap_write_file_header_to_writer(ld->writer, pcap_src->linktype, pcap_src->snaplen,
+                                                             pcap_src->ts_nsec, &ld->bytes_written, &err);
         }
         if (!successful) {
-            fclose(ld->pdh);
-            ld->pdh = NULL;
-            g_free(ld->io_buffer);
-            ld->io_buffer = NULL;
+            /* The ringbuffer code closes its own files on error. */
+            if (!capture_opts->multi_files_on) {
+                int close_err;
+
+                pcapio_writer_close(ld->writer, &close_err);
+                ld->save_file_fd = -1;
+            }
+            ld->writer = NULL;
         }
     }
 
-    if (ld->pdh == NULL) {
+    if (ld->writer == NULL) {
         /* We couldn't set up to write to the capture file. */
         /* XXX - use cf_open_error_message from tshark instead? */
         if (err < 0) {
@@ -3193,32 +3246,36 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                         isb_ifrecv = G_MAXUINT64;
                         isb_ifdrop = G_MAXUINT64;
                     }
-                    pcapng_write_interface_statistics_block(ld->pdh,
-                                                            i,
-                                                            &ld->bytes_written,
-                                                            "Counters provided by dumpcap",
-                                                            start_time,
-                                                            end_time,
-                                                            isb_ifrecv,
-                                                            isb_ifdrop,
-                                                            err_close);
+                    pcapng_write_interface_statistics_block_to_writer(ld->writer,
+                                                                      i,
+                                                                      &ld->bytes_written,
+                                                                      "Counters provided by dumpcap",
+                                                                      start_time,
+                                                                      end_time,
+                                                                      isb_ifrecv,
+                                                                      isb_ifdrop,
+                                                                      err_close);
                 }
             }
         }
-        if (fclose(ld->pdh) == EOF) {
-            if (err_close != NULL) {
-                *err_close = errno;
-            }
-            success = FALSE;
-        } else {
-            success = TRUE;
-        }
-        g_free(ld->io_buffer);
-        ld->io_buffer = NULL;
+        success = pcapio_writer_close(ld->writer, err_close);
+        ld->writer = NULL;
         return success;
     }
 }
 
+/*
+ * Write out what's buffered, so that a reader of the file sees it.  An
+ * error is reported by the next write, or when the file is closed.
+ */
+static void
+capture_loop_flush_output(void)
+{
+    int err;
+
+    pcapio_writer_flush(global_ld.writer, &err);
+}
+
 /* dispatch incoming packets (pcap or capture pipe)
  *
  * Waits for incoming packets to be available, and calls pcap_dispatch()
@@ -3485,7 +3542,8 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                 /* ringbuffer is enabled */
                 *save_file_fd = ringbuf_init(capfile_name,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
-                                             capture_opts->group_read_access);
+                                             capture_opts->group_read_access,
+                                             ring_compress_type);
 
                 /* capfile_name is unused as the ringbuffer provides its own filename. */
                 if (*save_file_fd != -1) {
@@ -3635,27 +3693,25 @@ do_file_switch_or_stop(capture_options *capture_opts)
         }
 
         /* Switch to the next ringbuffer file */
-        if (ringbuf_switch_file(&global_ld.pdh, &capture_opts->save_file,
+        if (ringbuf_switch_file(&global_ld.writer, &capture_opts->save_file,
                                 &global_ld.save_file_fd, &global_ld.err)) {
 
             /* File switch succeeded: reset the conditions */
             global_ld.bytes_written = 0;
             global_ld.packets_written = 0;
+            capture_loop_share_output(global_ld.writer);
             if (capture_opts->use_pcapng) {
                 successful = capture_loop_init_pcapng_output(capture_opts, &global_ld);
             } else {
                 capture_src *pcap_src;
                 pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
-                successful = libpcap_write_file_header(global_ld.pdh, pcap_src->linktype, pcap_src->snaplen,
-                                                       pcap_src->ts_nsec, &global_ld.bytes_written, &global_ld.err);
+                successful = libpcap_write_file_header_to_writer(global_ld.writer, pcap_src->linktype, pcap_src->snaplen,
+                                                                 pcap_src->ts_nsec, &global_ld.bytes_written, &global_ld.err);
             }
 
             if (!successful) {
-                fclose(global_ld.pdh);
-                global_ld.pdh = NULL;
+                /* ringbuf_libpcap_dump_close() closes it. */
                 global_ld.go = FALSE;
-                g_free(global_ld.io_buffer);
-                global_ld.io_buffer = NULL;
                 return FALSE;
             }
             if (global_ld.file_duration_timer) {
@@ -3664,7 +3720,7 @@ do_file_switch_or_stop(capture_options *capture_opts)
             if (global_ld.next_interval_time) {
                 global_ld.next_interval_time = get_next_time_interval(global_ld.interval_s);
             }
-            fflush(global_ld.pdh);
+            capture_loop_flush_output();
             if (!quiet)
                 report_packet_count(global_ld.inpkts_to_sync_pipe);
             global_ld.inpkts_to_sync_pipe = 0;
@@ -3703,46 +3759,137 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
+/* Size for pcap_src's ring, with room for its byte limit of packets and
+   then the largest packet it could capture.  With only a packet limit,
+   there's room for that many of the largest packets, so that the ring
+   doesn't drop packets the limits would have let in; that's as far as
+   spsc_ring_new() goes, 1 GiB, and the ring's pages are only touched as
+   packets are queued. */
+static gsize
+capture_loop_ring_size(capture_src *pcap_src)
+{
+    gsize max_len;
+    gsize limit;
+
+    if (pcap_src->from_pcapng)
+        max_len = pcap_src->cap_pipe_max_pkt_size;
+    else if (pcap_src->snaplen > 0)
+        max_len = pcap_src->snaplen;
+    else
+        max_len = WTAP_MAX_PACKET_SIZE_STANDARD;
+    max_len += sizeof(pcap_queue_element) + 8;
+
+    if (pcap_ring_byte_limit != 0)
+        limit = pcap_ring_byte_limit;
+    else if (pcap_ring_packet_limit <= G_MAXSIZE / max_len)
+        limit = pcap_ring_packet_limit * max_len;
+    else
+        limit = G_MAXSIZE / 2;
+
+    /* A packet may need twice its size when it wraps around. */
+    if (limit > G_MAXSIZE / 2 - 2 * max_len)
+        return G_MAXSIZE / 2;
+    return limit + 2 * max_len;
+}
+
 static gboolean
-capture_loop_dequeue_packet(void) {
-    pcap_queue_element *queue_element;
+capture_loop_packets_queued(void)
+{
+    capture_src *pcap_src;
+    guint        i;
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
-        }
-        pcap_queue_packets -= 1;
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        if (pcap_src->ring != NULL && spsc_ring_count(pcap_src->ring) > 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Wait up to WRITER_THREAD_TIMEOUT for a packet to be queued. */
+static void
+capture_loop_wait_for_packets(void)
+{
+    gint64 end_time = g_get_monotonic_time() + WRITER_THREAD_TIMEOUT;
+
+    g_mutex_lock(&writer_wait_mtx);
+    g_atomic_int_set(&writer_waiting, 1);
+    /* A packet queued before we set writer_waiting didn't signal us. */
+    while (!capture_loop_packets_queued() && global_ld.go) {
+        if (!g_cond_wait_until(&writer_wait_cond, &writer_wait_mtx, end_time))
+            break;
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
+    g_atomic_int_set(&writer_waiting, 0);
+    g_mutex_unlock(&writer_wait_mtx);
+}
+
+/*
+ * Write up to WRITER_BATCH_SIZE queued packets, waiting for some first,
+ * if "wait" is TRUE and there are none.
+ *
+ * Each interface's packets are written in the order they were captured.
+ * Between interfaces, the packet written next is the oldest of those at
+ * the heads of the rings, so packets are in timestamp order as far as
+ * the ones already queued allow.
+ *
+ * Returns the number of packets written.
+ */
+static int
+capture_loop_dequeue_packets(gboolean wait)
+{
+    capture_src        *pcap_src, *oldest_src;
+    pcap_queue_element *queue_element, *oldest_element;
+    gsize               len;
+    guint               i;
+    int                 written = 0;
+
+    while (written < WRITER_BATCH_SIZE) {
+        oldest_src = NULL;
+        oldest_element = NULL;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_src->ring == NULL)
+                continue;
+            queue_element = (pcap_queue_element *)spsc_ring_peek(pcap_src->ring, &len);
+            if (queue_element != NULL &&
+                (oldest_element == NULL || queue_element->ts < oldest_element->ts)) {
+                oldest_src = pcap_src;
+                oldest_element = queue_element;
+            }
+        }
+
+        if (oldest_element == NULL) {
+            if (written == 0 && wait) {
+                capture_loop_wait_for_packets();
+                wait = FALSE;
+                continue;
+            }
+            break;
+        }
+
+        if (oldest_src->from_pcapng) {
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                   "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
+                  oldest_element->u.bh.block_type, oldest_element->u.bh.block_total_length,
+                  oldest_src->interface_id);
 
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                        &queue_element->u.bh,
-                                        queue_element->pd);
+            capture_loop_write_pcapng_cb(oldest_src,
+                                        &oldest_element->u.bh,
+                                        (u_char *)(oldest_element + 1));
         } else {
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                 "Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+                oldest_element->u.phdr.caplen, oldest_src->interface_id);
 
-            capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
-                                        &queue_element->u.phdr,
-                                        queue_element->pd);
+            capture_loop_write_packet_cb((u_char *) oldest_src,
+                                        &oldest_element->u.phdr,
+                                        (u_char *)(oldest_element + 1));
         }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
+        /* The peek at oldest_src's ring was the last one. */
+        spsc_ring_release(oldest_src->ring);
+        written++;
     }
-    return FALSE;
+    return written;
 }
 
 /* Do the low-level work of a capture.
@@ -3778,9 +3925,9 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 #endif
     global_ld.inpkts_to_sync_pipe = 0;
     global_ld.err                 = 0;  /* no error seen yet */
-    global_ld.pdh                 = NULL;
+    global_ld.writer              = NULL;
     global_ld.save_file_fd        = -1;
-    global_ld.io_buffer           = NULL;
+    memset(&global_ld.writer_stats, 0, sizeof global_ld.writer_stats);
     global_ld.file_count          = 0;
     global_ld.file_duration_timer = NULL;
     global_ld.next_interval_time  = 0;
@@ -3854,7 +4001,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
            message to our parent so that they'll open the capture file and
            update its windows to indicate that we have a live capture in
            progress. */
-        fflush(global_ld.pdh);
+        capture_loop_flush_output();
         report_new_capture_file(capture_opts->save_file);
     }
 
@@ -3891,9 +4038,17 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
+        /* The limits are shared out between the interfaces. */
+        pcap_ring_byte_limit = (gsize)(pcap_queue_byte_limit / global_ld.pcaps->len);
+        pcap_ring_packet_limit = (guint)(pcap_queue_packet_limit / global_ld.pcaps->len);
+        if (pcap_queue_byte_limit > 0 && pcap_ring_byte_limit == 0)
+            pcap_ring_byte_limit = 1;
+        if (pcap_queue_packet_limit > 0 && pcap_ring_packet_limit == 0)
+            pcap_ring_packet_limit = 1;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_src->ring = spsc_ring_new(capture_loop_ring_size(pcap_src));
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -3903,13 +4058,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-
-            if (dequeued) {
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+            inpkts = capture_loop_dequeue_packets(TRUE);
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -3949,7 +4098,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             global_ld.inpkts_to_sync_pipe += inpkts;
 
             if (capture_opts->output_to_pipe) {
-                fflush(global_ld.pdh);
+                capture_loop_flush_output();
             }
         } /* inpkts */
 
@@ -3978,8 +4127,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 #endif
             /* Let the parent process know. */
             if (global_ld.inpkts_to_sync_pipe) {
-                /* do sync here */
-                fflush(global_ld.pdh);
+                /* do sync here, unless our parent reads the new packets
+                   from shared memory */
+                if (output_tail == NULL)
+                    capture_loop_flush_output();
 
                 /* Send our parent a message saying we've written out
                    "global_ld.inpkts_to_sync_pipe" packets to the capture file. */
@@ -4023,14 +4174,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Thread of interface %u terminated.",
                   pcap_src->interface_id);
         }
-        while (1) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-            if (!dequeued) {
-                break;
-            }
-            global_ld.inpkts_to_sync_pipe += 1;
+        while ((inpkts = capture_loop_dequeue_packets(FALSE)) > 0) {
+            global_ld.inpkts_to_sync_pipe += inpkts;
             if (capture_opts->output_to_pipe) {
-                fflush(global_ld.pdh);
+                capture_loop_flush_output();
             }
         }
     }
@@ -4150,7 +4297,11 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             }
         }
         report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        if (pcap_src->ring != NULL)
+            report_queue_high_water(pcap_src->ring, interface_opts->display_name);
     }
+    if (capture_opts->saving_to_file && (writer_flags & PCAPIO_WRITER_ASYNC))
+        report_writer_stats(&global_ld.writer_stats);
 
     /* close the input file (pcap or capture pipe) */
     capture_loop_close_input(&global_ld);
@@ -4275,7 +4426,7 @@ capture_loop_wrote_one_packet(capture_src *pcap_src) {
 
     /* check -c NUM / -a packets:NUM */
     if (global_capture_opts.has_autostop_packets && global_ld.packets_captured >= global_capture_opts.autostop_packets) {
-        fflush(global_ld.pdh);
+        capture_loop_flush_output();
         global_ld.go = FALSE;
         return;
     }
@@ -4328,18 +4479,18 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    if (global_ld.pdh) {
+    if (global_ld.writer) {
         gboolean successful;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
            "ld->err" to the error. */
-        successful = pcapng_write_block(global_ld.pdh,
-                                       pd,
-                                       bh->block_total_length,
-                                       &global_ld.bytes_written, &err);
+        successful = pcapng_write_block_to_writer(global_ld.writer,
+                                                  pd,
+                                                  bh->block_total_length,
+                                                  &global_ld.bytes_written, &err);
 
-        fflush(global_ld.pdh);
+        capture_loop_flush_output();
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4375,27 +4526,27 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    if (global_ld.pdh) {
+    if (global_ld.writer) {
         gboolean successful;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
            "ld->err" to the error. */
         if (global_capture_opts.use_pcapng) {
-            successful = pcapng_write_enhanced_packet_block(global_ld.pdh,
-                                                            NULL,
-                                                            phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                                            phdr->caplen, phdr->len,
-                                                            pcap_src->interface_id,
-                                                            ts_mul,
-                                                            pd, 0,
-                                                            &global_ld.bytes_written, &err);
+            successful = pcapng_write_enhanced_packet_block_to_writer(global_ld.writer,
+                                                                      NULL,
+                                                                      phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
+                                                                      phdr->caplen, phdr->len,
+                                                                      pcap_src->interface_id,
+                                                                      ts_mul,
+                                                                      pd, 0,
+                                                                      &global_ld.bytes_written, &err);
         } else {
-            successful = libpcap_write_packet(global_ld.pdh,
-                                              phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                              phdr->caplen, phdr->len,
-                                              pd,
-                                              &global_ld.bytes_written, &err);
+            successful = libpcap_write_packet_to_writer(global_ld.writer,
+                                                        phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
+                                                        phdr->caplen, phdr->len,
+                                                        pd,
+                                                        &global_ld.bytes_written, &err);
         }
         if (!successful) {
             global_ld.go = FALSE;
@@ -4412,6 +4563,30 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     }
 }
 
+/* Reserve room in pcap_src's ring for a packet or block of length len,
+   unless that would go over the limits. */
+static pcap_queue_element *
+capture_loop_queue_reserve(capture_src *pcap_src, guint32 len)
+{
+    if ((pcap_ring_byte_limit != 0 && spsc_ring_used(pcap_src->ring) >= pcap_ring_byte_limit) ||
+        (pcap_ring_packet_limit != 0 && spsc_ring_count(pcap_src->ring) >= pcap_ring_packet_limit))
+        return NULL;
+    return (pcap_queue_element *)spsc_ring_reserve(pcap_src->ring, sizeof(pcap_queue_element) + len);
+}
+
+/* Hand the reserved packet or block to the writer. */
+static void
+capture_loop_queue_commit(capture_src *pcap_src)
+{
+    spsc_ring_commit(pcap_src->ring);
+    pcap_src->received++;
+    if (g_atomic_int_get(&writer_waiting)) {
+        g_mutex_lock(&writer_wait_mtx);
+        g_cond_signal(&writer_wait_cond);
+        g_mutex_unlock(&writer_wait_mtx);
+    }
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -4419,7 +4594,6 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4429,49 +4603,25 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
+    queue_element = capture_loop_queue_reserve(pcap_src, phdr->caplen);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    queue_element->ts = (guint64)phdr->ts.tv_sec * 1000000000 +
+                        (guint64)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    queue_element->u.phdr = *phdr;
+    memcpy(queue_element + 1, pd, phdr->caplen);
+    capture_loop_queue_commit(pcap_src);
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_src->interface_id);
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+          "Queue size is now %" G_GSIZE_MODIFIER "u bytes (%u packets)",
+          spsc_ring_used(pcap_src->ring), spsc_ring_count(pcap_src->ring));
 }
 
 /* one pcapng block was captured, queue it */
@@ -4479,7 +4629,6 @@ static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
 {
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4489,49 +4638,26 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
+    queue_element = capture_loop_queue_reserve(pcap_src, bh->block_total_length);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a block of type 0x%08x of length %d captured on interface %u.",
-              bh->block_type, bh->block_total_length, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    /* Blocks carry timestamps in their interface's resolution, which we
+       don't track, so interleave them by when they arrived. */
+    queue_element->ts = (guint64)g_get_real_time() * 1000;
+    queue_element->u.bh = *bh;
+    memcpy(queue_element + 1, pd, bh->block_total_length);
+    capture_loop_queue_commit(pcap_src);
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+          "Queued a block of type 0x%08x of length %d captured on interface %u.",
+          bh->block_type, bh->block_total_length, pcap_src->interface_id);
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queue size is now %" G_GSIZE_MODIFIER "u bytes (%u packets)",
+          spsc_ring_used(pcap_src->ring), spsc_ring_count(pcap_src->ring));
 }
 
 static int
@@ -4604,6 +4730,17 @@ get_dumpcap_runtime_info(GString *str)
     get_runtime_caplibs_version(str);
 }
 
+/*
+ * Long options of dumpcap's own, numbered after the ones
+ * LONGOPT_CAPTURE_COMMON uses; they have to be defined before
+ * main()'s long_options[].
+ */
+#define LONGOPT_COMPRESS_TYPE 4096
+#define LONGOPT_ASYNC_WRITE   4097
+#define LONGOPT_DIRECT_IO     4098
+#define LONGOPT_PREALLOCATE   4099
+#define LONGOPT_SHM_TAIL      4100
+
 /* And now our feature presentation... [ fade to music ] */
 int
 main(int argc, char *argv[])
@@ -4614,6 +4751,11 @@ main(int argc, char *argv[])
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         LONGOPT_CAPTURE_COMMON
+        {"compress-type", required_argument, NULL, LONGOPT_COMPRESS_TYPE},
+        {"async-write", no_argument, NULL, LONGOPT_ASYNC_WRITE},
+        {"direct-io", no_argument, NULL, LONGOPT_DIRECT_IO},
+        {"preallocate", no_argument, NULL, LONGOPT_PREALLOCATE},
+        {"shm-tail", required_argument, NULL, LONGOPT_SHM_TAIL},
         {0, 0, 0, 0 }
     };
 
@@ -5014,6 +5156,33 @@ main(int argc, char *argv[])
         case 'q':        /* Quiet */
             quiet = TRUE;
             break;
+        case LONGOPT_COMPRESS_TYPE:
+            if (!compress_file_type_from_name(optarg, &ring_compress_type)) {
+                cmdarg_err("\"%s\" isn't a supported compression type", optarg);
+                print_compress_types(stderr);
+                exit_main(1);
+            }
+            break;
+        case LONGOPT_ASYNC_WRITE:
+            writer_flags |= PCAPIO_WRITER_ASYNC;
+            break;
+        case LONGOPT_DIRECT_IO:
+            writer_flags |= PCAPIO_WRITER_DIRECT;
+            break;
+        case LONGOPT_PREALLOCATE:
+            preallocate_files = TRUE;
+            break;
+        case LONGOPT_SHM_TAIL:   /* shared memory from our parent (hidden option) */
+        {
+            int shm_err;
+
+            shm_tail_unref(output_tail);
+            output_tail = shm_tail_open_fd(get_natural_int(optarg, "shared memory fd"), &shm_err);
+            if (output_tail == NULL)
+                g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+                      "Couldn't map the shared memory for the capture file: %s", g_strerror(shm_err));
+            break;
+        }
         case 't':
             use_threads = TRUE;
             break;
@@ -5163,6 +5332,15 @@ main(int argc, char *argv[])
                 exit_main(1);
             }
         }
+        if (ring_compress_type != COMPRESS_FILE_NONE && !global_capture_opts.multi_files_on) {
+            cmdarg_err("Compression was requested, but only ring buffer files are compressed.");
+            exit_main(1);
+        }
+        if (preallocate_files &&
+            !(global_capture_opts.multi_files_on && global_capture_opts.has_autostop_filesize)) {
+            cmdarg_err("Preallocation was requested, but only ring buffer files with a filesize limit are preallocated.");
+            exit_main(1);
+        }
     }
 
     /*
@@ -5570,6 +5748,38 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+static void
+report_queue_high_water(spsc_ring_t *ring, gchar *name)
+{
+    if (capture_child) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Packet queue high-water mark on interface '%s': %" G_GSIZE_MODIFIER "u/%" G_GSIZE_MODIFIER "u bytes, %u packets",
+            name, spsc_ring_high_water(ring), spsc_ring_size(ring), spsc_ring_high_water_count(ring));
+    } else {
+        fprintf(stderr,
+            "Packet queue high-water mark on interface '%s': %" G_GSIZE_MODIFIER "u/%" G_GSIZE_MODIFIER "u bytes, %u packets\n",
+            name, spsc_ring_high_water(ring), spsc_ring_size(ring), spsc_ring_high_water_count(ring));
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
+static void
+report_writer_stats(const pcapio_writer_stats_t *stats)
+{
+    if (capture_child) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Output writer: %" G_GINT64_MODIFIER "u buffers written, queue depth at most %u, stalled %" G_GINT64_MODIFIER "u times for %.3f ms",
+            stats->buffers_written, stats->max_queue_depth, stats->stalls, stats->stall_ns / 1e6);
+    } else {
+        fprintf(stderr,
+            "Output writer: %" G_GINT64_MODIFIER "u buffers written, queue depth at most %u, stalled %" G_GINT64_MODIFIER "u times for %.3f ms\n",
+            stats->buffers_written, stats->max_queue_depth, stats->stalls, stats->stall_ns / 1e6);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
@@ -105,14 +105,32 @@ typedef struct _fd_hash_t {
     guint8     digest[16];
     guint32    len;
     nstime_t   frame_time;
+    gboolean   indexed;     /* entry is present in fd_hash_index */
 } fd_hash_t;
 
+/*
+ * Index over the digests currently held in fd_hash[], so that a
+ * duplicate can be found without walking the whole window.  Each
+ * distinct (digest, len) pair has one entry, which records how many
+ * ring slots currently hold it and which of those slots is the most
+ * recent one.  The first two members must match fd_hash_t, as the
+ * hash and equality functions only look at those.
+ */
+typedef struct _fd_hash_index_entry_t {
+    guint8     digest[16];
+    guint32    len;
+    int        last_slot;   /* most recently filled slot with this digest */
+    guint      refs;        /* number of slots with this digest */
+} fd_hash_index_entry_t;
+
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
 #define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
 
-static fd_hash_t fd_hash[MAX_DUP_DEPTH];
-static int       dup_window    = DEFAULT_DUP_DEPTH;
-static int       cur_dup_entry = 0;
+static fd_hash_t   fd_hash[MAX_DUP_DEPTH];
+static GHashTable *fd_hash_index = NULL;
+static int         dup_window    = DEFAULT_DUP_DEPTH;
+static int         cur_dup_entry = 0;
+static gboolean    dup_fast_hash = FALSE;  /* Used with --fast-dedup-hash */
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
@@ -159,6 +177,7 @@ static int                    out_file_type_subtype     = WTAP_FILE_TYPE_SUBTYPE
 static int                    out_file_type_subtype     = WTAP_FILE_TYPE_SUBTYPE_PCAP; /* default to pcap     */
 #endif
 static int                    out_frame_type            = -2; /* Leave frame type alone */
+static wtap_compression_type  out_compression_type      = WTAP_UNCOMPRESSED;
 static int                    verbose                   = 0;  /* Not so verbose         */
 static struct time_adjustment time_adj                  = {NSTIME_INIT_ZERO, 0}; /* no adjustment */
 static nstime_t               relative_time_window      = NSTIME_INIT_ZERO; /* de-dup time window */
@@ -583,9 +602,146 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+/*
+ * Non-cryptographic 128-bit digest used instead of MD5 when
+ * --fast-dedup-hash is given.  Two independently seeded 64-bit lanes
+ * consume the data a word at a time and are finished with the
+ * splitmix64 mixer; collisions are astronomically unlikely for
+ * de-duplication purposes, which is all this is used for.
+ */
+#define FAST_HASH_MUL1 G_GUINT64_CONSTANT(0x9e3779b97f4a7c15)
+#define FAST_HASH_MUL2 G_GUINT64_CONSTANT(0xc2b2ae3d27d4eb4f)
+
+static inline guint64
+fast_hash_mix(guint64 h)
+{
+    h ^= h >> 30;
+    h *= G_GUINT64_CONSTANT(0xbf58476d1ce4e5b9);
+    h ^= h >> 27;
+    h *= G_GUINT64_CONSTANT(0x94d049bb133111eb);
+    h ^= h >> 31;
+    return h;
+}
+
+static void
+fast_hash_buffer(guint8 *digest, const guint8 *data, guint32 len)
+{
+    guint64 h1 = FAST_HASH_MUL1 ^ len;
+    guint64 h2 = FAST_HASH_MUL2 ^ ((guint64)len << 32);
+    guint64 w;
+    guint32 i;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        w = pletoh64(&data[i]);
+        h1 = (h1 ^ w) * FAST_HASH_MUL1;
+        h1 = (h1 << 31) | (h1 >> 33);
+        h2 = (h2 ^ w) * FAST_HASH_MUL2;
+        h2 = (h2 << 29) | (h2 >> 35);
+    }
+    if (i < len) {
+        w = 0;
+        memcpy(&w, &data[i], len - i);
+        w = GUINT64_FROM_LE(w);
+        h1 = (h1 ^ w) * FAST_HASH_MUL1;
+        h2 = (h2 ^ w) * FAST_HASH_MUL2;
+    }
+
+    h1 = fast_hash_mix(h1 + h2);
+    h2 = fast_hash_mix(h2 + h1);
+    phtole64(&digest[0], h1);
+    phtole64(&digest[8], h2);
+}
+
+static void
+dup_digest(guint8 *digest, const guint8 *data, guint32 len)
+{
+    if (dup_fast_hash)
+        fast_hash_buffer(digest, data, len);
+    else
+        gcry_md_hash_buffer(GCRY_MD_MD5, digest, data, len);
+}
+
+static guint
+fd_hash_index_hash(gconstpointer key)
+{
+    const fd_hash_index_entry_t *entry = (const fd_hash_index_entry_t *)key;
+    guint h;
+
+    /* The digest is already well mixed; any 32 bits of it will do. */
+    memcpy(&h, entry->digest, sizeof h);
+    return h ^ entry->len;
+}
+
+static gboolean
+fd_hash_index_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_index_entry_t *ea = (const fd_hash_index_entry_t *)a;
+    const fd_hash_index_entry_t *eb = (const fd_hash_index_entry_t *)b;
+
+    return ea->len == eb->len && memcmp(ea->digest, eb->digest, 16) == 0;
+}
+
+static fd_hash_index_entry_t *
+fd_hash_index_lookup(const fd_hash_t *fh)
+{
+    fd_hash_index_entry_t key;
+
+    memcpy(key.digest, fh->digest, 16);
+    key.len = fh->len;
+    return (fd_hash_index_entry_t *)g_hash_table_lookup(fd_hash_index, &key);
+}
+
+/*
+ * Drop the ring slot that is about to be overwritten from the index.
+ * The slot being reused is always the oldest one in the window, so if
+ * the index entry still points at it there are no other references.
+ */
+static void
+fd_hash_index_evict(int slot)
+{
+    fd_hash_index_entry_t *entry;
+
+    if (!fd_hash[slot].indexed)
+        return;
+    fd_hash[slot].indexed = FALSE;
+
+    entry = fd_hash_index_lookup(&fd_hash[slot]);
+    if (entry == NULL)
+        return;
+    if (--entry->refs == 0)
+        g_hash_table_remove(fd_hash_index, entry);
+}
+
+/*
+ * Add the (already filled in) ring slot to the index, returning the
+ * most recent other slot holding the same digest, or -1 if there is
+ * none in the window.
+ */
+static int
+fd_hash_index_insert(int slot)
+{
+    fd_hash_index_entry_t *entry;
+    int prev_slot = -1;
+
+    entry = fd_hash_index_lookup(&fd_hash[slot]);
+    if (entry == NULL) {
+        entry = g_new(fd_hash_index_entry_t, 1);
+        memcpy(entry->digest, fd_hash[slot].digest, 16);
+        entry->len = fd_hash[slot].len;
+        entry->refs = 0;
+        g_hash_table_insert(fd_hash_index, entry, entry);
+    } else {
+        prev_slot = entry->last_slot;
+    }
+    entry->last_slot = slot;
+    entry->refs++;
+    fd_hash[slot].indexed = TRUE;
+
+    return prev_slot;
+}
+
 static gboolean
 is_duplicate(guint8* fd, guint32 len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
@@ -612,28 +768,21 @@ is_duplicate(guint8* fd, guint32 len) {
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
 
+    fd_hash_index_evict(cur_dup_entry);
+
     /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
+    dup_digest(fd_hash[cur_dup_entry].digest, new_fd, new_len);
 
     fd_hash[cur_dup_entry].len = len;
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
-    }
-
-    return FALSE;
+    /* Look for duplicates in the rest of the window */
+    return fd_hash_index_insert(cur_dup_entry) != -1;
 }
 
 static gboolean
 is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
     int i;
+    int prev_slot;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
@@ -651,13 +800,35 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
 
+    fd_hash_index_evict(cur_dup_entry);
+
     /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
+    dup_digest(fd_hash[cur_dup_entry].digest, new_fd, new_len);
 
     fd_hash[cur_dup_entry].len = len;
     fd_hash[cur_dup_entry].frame_time.secs = current->secs;
     fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
 
+    prev_slot = fd_hash_index_insert(cur_dup_entry);
+    if (prev_slot == -1) {
+        /* No packet with this digest anywhere in the window. */
+        return FALSE;
+    }
+
+    /*
+     * If the most recent packet with the same digest is not older than
+     * the current one, its timestamp tells us nothing (the input isn't
+     * in chronological order); fall back to walking the window below.
+     * Otherwise it's the only candidate that matters.
+     */
+    if (!nstime_is_unset(&(fd_hash[prev_slot].frame_time))) {
+        nstime_t delta;
+
+        nstime_delta(&delta, current, &fd_hash[prev_slot].frame_time);
+        if (delta.secs >= 0 && delta.nsecs >= 0)
+            return nstime_cmp(&delta, &relative_time_window) <= 0;
+    }
+
     /*
      * Look for relative time related duplicates.
      * This is hopefully a reasonably efficient mechanism for
@@ -778,6 +949,8 @@ print_usage(FILE *output)
     fprintf(output, "  --skip-radiotap-header skip radiotap header when checking for packet duplicates.\n");
     fprintf(output, "                         Useful when processing packets captured by multiple radios\n");
     fprintf(output, "                         on the same channel in the vicinity of each other.\n");
+    fprintf(output, "  --fast-dedup-hash      use a fast non-cryptographic hash instead of MD5 when\n");
+    fprintf(output, "                         checking for packet duplicates.\n");
     fprintf(output, "\n");
     fprintf(output, "Packet manipulation:\n");
     fprintf(output, "  -s <snaplen>           truncate each packet to max. <snaplen> bytes of data.\n");
@@ -833,6 +1006,7 @@ print_usage(FILE *output)
     fprintf(output, "  -F <capture type>      set the output file type; default is pcap.\n");
 #endif
     fprintf(output, "                         An empty \"-F\" option will list the file types.\n");
+    fprintf(output, "  --compress <type>      compress the output file(s) with the given method.\n");
     fprintf(output, "  -T <encap type>        set the output file encapsulation type; default is the\n");
     fprintf(output, "                         same as the input file. An empty \"-T\" option will\n");
     fprintf(output, "                         list the encapsulation types.\n");
@@ -898,6 +1072,17 @@ list_capture_types(FILE *stream) {
     g_free(captypes);
 }
 
+static void
+list_compression_types(FILE *stream) {
+    GSList *names, *name;
+
+    fprintf(stream, "editcap: The available compression types for the \"--compress\" flag are:\n");
+    names = wtap_get_all_output_compression_type_names_list();
+    for (name = names; name != NULL; name = g_slist_next(name))
+        fprintf(stream, "    %s\n", (const char *)name->data);
+    g_slist_free(names);
+}
+
 static void
 list_encap_types(FILE *stream) {
     int i;
@@ -997,10 +1182,10 @@ editcap_dump_open(const char *filename, const wtap_dump_params *params,
 
     if (strcmp(filename, "-") == 0) {
         /* Write to the standard output. */
-        pdh = wtap_dump_open_stdout(out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open_stdout(out_file_type_subtype, out_compression_type,
                                     params, write_err);
     } else {
-        pdh = wtap_dump_open(filename, out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open(filename, out_file_type_subtype, out_compression_type,
                              params, write_err);
     }
     return pdh;
@@ -1019,12 +1204,16 @@ main(int argc, char *argv[])
 #define LONGOPT_SEED                 0x8102
 #define LONGOPT_INJECT_SECRETS       0x8103
 #define LONGOPT_DISCARD_ALL_SECRETS  0x8104
+#define LONGOPT_FAST_DEDUP_HASH      0x8105
+#define LONGOPT_COMPRESS             0x8106
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, LONGOPT_NO_VLAN},
         {"skip-radiotap-header", no_argument, NULL, LONGOPT_SKIP_RADIOTAP_HEADER},
         {"seed", required_argument, NULL, LONGOPT_SEED},
         {"inject-secrets", required_argument, NULL, LONGOPT_INJECT_SECRETS},
         {"discard-all-secrets", no_argument, NULL, LONGOPT_DISCARD_ALL_SECRETS},
+        {"fast-dedup-hash", no_argument, NULL, LONGOPT_FAST_DEDUP_HASH},
+        {"compress", required_argument, NULL, LONGOPT_COMPRESS},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'V'},
         {0, 0, 0, 0 }
@@ -1164,6 +1353,25 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_FAST_DEDUP_HASH:
+        {
+            dup_fast_hash = TRUE;
+            break;
+        }
+
+        case LONGOPT_COMPRESS:
+        {
+            out_compression_type = wtap_name_to_compression_type(optarg);
+            if (out_compression_type == WTAP_UNKNOWN_COMPRESSION) {
+                fprintf(stderr, "editcap: \"%s\" isn't a valid compression type\n\n",
+                        optarg);
+                list_compression_types(stderr);
+                ret = INVALID_OPTION;
+                goto clean_exit;
+            }
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1564,7 +1772,11 @@ main(int argc, char *argv[])
             memset(&fd_hash[i].digest, 0, 16);
             fd_hash[i].len = 0;
             nstime_set_unset(&fd_hash[i].frame_time);
+            fd_hash[i].indexed = FALSE;
         }
+        fd_hash_index = g_hash_table_new_full(fd_hash_index_hash,
+                                              fd_hash_index_equal,
+                                              g_free, NULL);
     }
 
     /* Read all of the packets in turn */
@@ -1838,9 +2050,10 @@ main(int argc, char *argv[])
                 if (dup_detect) {
                     if (is_duplicate(buf, rec->rec_header.packet_header.caplen)) {
                         if (verbose) {
-                            fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
+                            fprintf(stderr, "Skipped: %u, Len: %u, %s Hash: ",
                                     count,
-                                    rec->rec_header.packet_header.caplen);
+                                    rec->rec_header.packet_header.caplen,
+                                    dup_fast_hash ? "Fast" : "MD5");
                             for (i = 0; i < 16; i++)
                                 fprintf(stderr, "%02x",
                                         (unsigned char)fd_hash[cur_dup_entry].digest[i]);
@@ -1851,9 +2064,10 @@ main(int argc, char *argv[])
                         continue;
                     } else {
                         if (verbose) {
-                            fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
+                            fprintf(stderr, "Packet: %u, Len: %u, %s Hash: ",
                                     count,
-                                    rec->rec_header.packet_header.caplen);
+                                    rec->rec_header.packet_header.caplen,
+                                    dup_fast_hash ? "Fast" : "MD5");
                             for (i = 0; i < 16; i++)
                                 fprintf(stderr, "%02x",
                                         (unsigned char)fd_hash[cur_dup_entry].digest[i]);
@@ -1874,9 +2088,10 @@ main(int argc, char *argv[])
                                                   rec->rec_header.packet_header.caplen,
                                                   &current)) {
                             if (verbose) {
-                                fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
+                                fprintf(stderr, "Skipped: %u, Len: %u, %s Hash: ",
                                         count,
-                                        rec->rec_header.packet_header.caplen);
+                                        rec->rec_header.packet_header.caplen,
+                                        dup_fast_hash ? "Fast" : "MD5");
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
                                             (unsigned char)fd_hash[cur_dup_entry].digest[i]);
@@ -1887,9 +2102,10 @@ main(int argc, char *argv[])
                             continue;
                         } else {
                             if (verbose) {
-                                fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
+                                fprintf(stderr, "Packet: %u, Len: %u, %s Hash: ",
                                         count,
-                                        rec->rec_header.packet_header.caplen);
+                                        rec->rec_header.packet_header.caplen,
+                                        dup_fast_hash ? "Fast" : "MD5");
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
                                             (unsigned char)fd_hash[cur_dup_entry].digest[i]);
@@ -2081,6 +2297,9 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    if (fd_hash_index) {
+        g_hash_table_destroy(fd_hash_index);
+    }
     if (dsb_filenames) {
         g_array_free(dsb_types, TRUE);
         g_ptr_array_free(dsb_filenames, TRUE);
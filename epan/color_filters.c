@@ -43,6 +43,12 @@ static GSList *color_filter_list = NULL;
 static GSList *color_filter_deleted_list = NULL;
 static GSList *color_filter_valid_list   = NULL;
 
+/* the compiled filters of the enabled entries of color_filter_list, in
+ * list order, tested together so that fields used by several of them are
+ * read only once per packet; rebuilt whenever color_filter_list changes */
+static dfilter_multi_t *color_filter_set = NULL;
+static gboolean color_filter_set_changed = TRUE;
+
 /* Color Filters can en-/disabled. */
 static gboolean filters_enabled = TRUE;
 
@@ -163,6 +169,7 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
                 colorf->filter_text = g_strdup(tmpfilter);
                 colorf->c_colorfilter = compiled_filter;
                 colorf->disabled = ((i!=filt_nr) ? TRUE : disabled);
+                color_filter_set_changed = TRUE;
                 /* Remember that there are now temporary coloring filters set */
                 if( filter )
                     tmp_colors_set = TRUE;
@@ -323,6 +330,7 @@ color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* delete all currently existing filters */
     color_filter_list_delete(&color_filter_list);
+    color_filter_set_changed = TRUE;
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -335,6 +343,7 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filter_set_changed = TRUE;
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -345,6 +354,10 @@ color_filters_cleanup(void)
 {
     /* delete the previously deleted filters */
     color_filter_list_delete(&color_filter_deleted_list);
+
+    dfilter_multi_free(color_filter_set);
+    color_filter_set = NULL;
+    color_filter_set_changed = TRUE;
 }
 
 typedef struct _color_clone
@@ -429,6 +442,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filter_set_changed = TRUE;
 
     /* clone all list entries from tmp/edit to normal list */
     color_filter_valid_list = NULL;
@@ -486,23 +500,51 @@ color_filters_prime_edt(epan_dissect_t *edt)
         g_slist_foreach(color_filter_list, prime_edt, edt);
 }
 
+static void
+color_filter_set_rebuild(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+
+    if (color_filter_set == NULL)
+        color_filter_set = dfilter_multi_new();
+    else
+        dfilter_multi_clear(color_filter_set);
+
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if ((!colorf->disabled) && (colorf->c_colorfilter != NULL))
+            dfilter_multi_add(color_filter_set, colorf->c_colorfilter);
+    }
+    color_filter_set_changed = FALSE;
+}
+
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
     GSList         *curr;
     color_filter_t *colorf;
+    guint           idx = 0;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
+        if (color_filter_set_changed)
+            color_filter_set_rebuild();
+        else
+            dfilter_multi_reset(color_filter_set);
+
+        /* The filters were added to the set in list order, skipping
+         * the same entries as here. */
         curr = color_filter_list;
 
         while(curr != NULL) {
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
+                 (colorf->c_colorfilter != NULL)) {
+                if (dfilter_multi_apply_one(color_filter_set, edt, idx))
+                    return colorf;
+                idx++;
             }
             curr = g_slist_next(curr);
         }
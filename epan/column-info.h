@@ -45,6 +45,7 @@ typedef struct {
   gchar              *col_buf;              /**< Buffer into which to copy data for column */
   int                 col_fence;            /**< Stuff in column buffer before this index is immutable */
   gboolean            writable;             /**< writable or not */
+  GArray             *col_pending;          /**< Deferred appends not yet rendered into col_buf */
 } col_item_t;
 
 /** Column info */
@@ -57,6 +58,8 @@ struct epan_column_info {
   col_expr_t          col_expr;             /**< Column expressions and values */
   gboolean            writable;             /**< writable or not @todo Are we still writing to the columns? */
   GRegex             *prime_regex;          /**< Used to prime custom columns */
+  gboolean            deferred;             /**< Appends are queued and rendered when the text is needed */
+  GString            *deferred_text;        /**< Copies of deferred strings for the current packet */
 };
 
 #ifdef __cplusplus
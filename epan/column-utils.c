@@ -58,6 +58,7 @@ col_setup(column_info *cinfo, const gint num_cols)
   cinfo->col_last              = g_new(int, NUM_COL_FMTS);
   for (i = 0; i < num_cols; i++) {
     cinfo->columns[i].col_custom_fields_ids = NULL;
+    cinfo->columns[i].col_pending = NULL;
   }
   cinfo->col_expr.col_expr     = g_new(const gchar*, num_cols + 1);
   cinfo->col_expr.col_expr_val = g_new(gchar*, num_cols + 1);
@@ -69,6 +70,8 @@ col_setup(column_info *cinfo, const gint num_cols)
   cinfo->prime_regex = g_regex_new(COL_CUSTOM_PRIME_REGEX,
     (GRegexCompileFlags) (G_REGEX_ANCHORED | G_REGEX_RAW),
     G_REGEX_MATCH_ANCHORED, NULL);
+  cinfo->deferred = FALSE;
+  cinfo->deferred_text = NULL;
 }
 
 static void
@@ -101,6 +104,8 @@ col_cleanup(column_info *cinfo)
     g_free(col_item->col_buf);
     g_free(cinfo->col_expr.col_expr_val[i]);
     col_custom_fields_ids_free(&col_item->col_custom_fields_ids);
+    if (col_item->col_pending)
+      g_array_free(col_item->col_pending, TRUE);
   }
 
   g_free(cinfo->columns);
@@ -117,6 +122,10 @@ col_cleanup(column_info *cinfo)
   g_free(cinfo->col_expr.col_expr_val);
   if (cinfo->prime_regex)
     g_regex_unref(cinfo->prime_regex);
+  if (cinfo->deferred_text) {
+    g_string_free(cinfo->deferred_text, TRUE);
+    cinfo->deferred_text = NULL;
+  }
 }
 
 /* Initialize the data structures for constructing column data. */
@@ -135,9 +144,13 @@ col_init(column_info *cinfo, const struct epan_session *epan)
     col_item->col_data = col_item->col_buf;
     col_item->col_fence = 0;
     col_item->writable = TRUE;
+    if (col_item->col_pending)
+      g_array_set_size(col_item->col_pending, 0);
     cinfo->col_expr.col_expr[i] = "";
     cinfo->col_expr.col_expr_val[i][0] = '\0';
   }
+  if (cinfo->deferred_text)
+    g_string_truncate(cinfo->deferred_text, 0);
   cinfo->writable = TRUE;
   cinfo->epan = epan;
 }
@@ -194,6 +207,201 @@ col_set_writable(column_info *cinfo, const gint col, const gboolean writable)
       /* There is at least one column in that format */ \
     ((cinfo)->col_first[el] >= 0))
 
+#define COL_CHECK_APPEND(col_item, max_len) \
+  if (col_item->col_data != col_item->col_buf) {        \
+    /* This was set with "col_set_str()"; copy the string they  \
+       set it to into the buffer, so we can append to it. */    \
+    g_strlcpy(col_item->col_buf, col_item->col_data, max_len);  \
+    col_item->col_data = col_item->col_buf;         \
+  }
+
+#define COL_BUF_MAX_LEN (((COL_MAX_INFO_LEN) > (COL_MAX_LEN)) ? \
+    (COL_MAX_INFO_LEN) : (COL_MAX_LEN))
+
+static inline void
+col_snprint_port(gchar *buf, gulong buf_siz, port_type typ, guint16 val)
+{
+  const char *str;
+
+  if (gbl_resolv_flags.transport_name &&
+        (str = try_serv_name_lookup(typ, val)) != NULL) {
+    ws_snprintf(buf, buf_siz, "%s(%"G_GUINT16_FORMAT")", str, val);
+  } else {
+    ws_snprintf(buf, buf_siz, "%"G_GUINT16_FORMAT, val);
+  }
+}
+
+/*
+ * Deferred mode.  Appends are recorded per column as a list of fragments
+ * and rendered into col_buf, in order, only when the column text is
+ * needed.  Text fragments are copied into cinfo->deferred_text, since
+ * dissectors are free to pass us buffers that won't last; port and number
+ * fragments keep their values and are formatted when rendered.
+ *
+ * Anything that replaces the text after the fence (col_add_*(),
+ * col_set_str(), col_clear()) just drops the queued fragments: they can
+ * only have been appended after the fence, as setting a fence renders
+ * them.
+ */
+typedef enum {
+  COL_DEFERRED_TEXT,      /* text copied into deferred_text */
+  COL_DEFERRED_UINT,      /* guint32 value */
+  COL_DEFERRED_PORTS      /* "src → dst" port pair */
+} col_deferred_kind_t;
+
+typedef struct {
+  col_deferred_kind_t kind;
+  gsize       sep_offset;   /* separator, added only if the column isn't empty */
+  gsize       sep_len;
+  gsize       offset;       /* COL_DEFERRED_TEXT */
+  gsize       len;
+  guint32     val;          /* COL_DEFERRED_UINT */
+  port_type   ptype;        /* COL_DEFERRED_PORTS */
+  guint16     src_port;
+  guint16     dst_port;
+} col_deferred_t;
+
+void
+col_set_deferred(column_info *cinfo, const gboolean deferred)
+{
+  if (!cinfo)
+    return;
+
+  cinfo->deferred = deferred;
+  if (deferred && cinfo->deferred_text == NULL)
+    cinfo->deferred_text = g_string_sized_new(COL_MAX_INFO_LEN);
+}
+
+/* Copy a string for a deferred fragment, returning its offset. */
+static gsize
+col_deferred_add_text(column_info *cinfo, const gchar *str, gsize len)
+{
+  gsize offset = cinfo->deferred_text->len;
+
+  g_string_append_len(cinfo->deferred_text, str, len);
+  return offset;
+}
+
+/* Queue a fragment on every column with the given format. */
+static void
+col_deferred_queue(column_info *cinfo, const gint el, const col_deferred_t *frag)
+{
+  int i;
+  col_item_t* col_item;
+
+  for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
+    col_item = &cinfo->columns[i];
+    if (col_item->fmt_matx[el]) {
+      if (col_item->col_pending == NULL)
+        col_item->col_pending = g_array_new(FALSE, FALSE, sizeof(col_deferred_t));
+      g_array_append_vals(col_item->col_pending, frag, 1);
+    }
+  }
+}
+
+/* Queue a text fragment already copied to deferred_text. */
+static void
+col_deferred_queue_text(column_info *cinfo, const gint el, const gchar *separator, gsize offset, gsize len)
+{
+  col_deferred_t frag;
+
+  memset(&frag, 0, sizeof frag);
+  frag.kind = COL_DEFERRED_TEXT;
+  if (separator != NULL) {
+    frag.sep_len = strlen(separator);
+    frag.sep_offset = col_deferred_add_text(cinfo, separator, frag.sep_len);
+  }
+  frag.offset = offset;
+  frag.len = len;
+  col_deferred_queue(cinfo, el, &frag);
+}
+
+static inline void
+col_deferred_drop(col_item_t *col_item)
+{
+  if (col_item->col_pending != NULL)
+    g_array_set_size(col_item->col_pending, 0);
+}
+
+/* Append at most len bytes of str to buf, which holds *pos bytes. */
+static inline void
+col_buf_append(gchar *buf, gsize *pos, const gsize max_len, const gchar *str, gsize len)
+{
+  if (*pos + len >= max_len)
+    len = max_len - 1 - *pos;
+  memcpy(&buf[*pos], str, len);
+  *pos += len;
+  buf[*pos] = '\0';
+}
+
+/* Render the queued fragments of a column into its buffer. */
+static void
+col_deferred_render(column_info *cinfo, col_item_t *col_item)
+{
+  gsize pos, max_len;
+  guint i;
+  const col_deferred_t *frag;
+  const gchar *text;
+  char buf[32];
+
+  if (col_item->col_pending == NULL || col_item->col_pending->len == 0)
+    return;
+
+  if (col_item->col_fmt == COL_INFO)
+    max_len = COL_MAX_INFO_LEN;
+  else
+    max_len = COL_MAX_LEN;
+
+  COL_CHECK_APPEND(col_item, max_len);
+
+  text = cinfo->deferred_text->str;
+  pos = strlen(col_item->col_buf);
+  for (i = 0; i < col_item->col_pending->len && pos < max_len - 1; i++) {
+    frag = &g_array_index(col_item->col_pending, col_deferred_t, i);
+    if (frag->sep_len != 0 && pos != 0)
+      col_buf_append(col_item->col_buf, &pos, max_len, &text[frag->sep_offset], frag->sep_len);
+
+    switch (frag->kind) {
+
+    case COL_DEFERRED_TEXT:
+      col_buf_append(col_item->col_buf, &pos, max_len, &text[frag->offset], frag->len);
+      break;
+
+    case COL_DEFERRED_UINT:
+      guint32_to_str_buf(frag->val, buf, sizeof(buf));
+      col_buf_append(col_item->col_buf, &pos, max_len, buf, strlen(buf));
+      break;
+
+    case COL_DEFERRED_PORTS:
+      col_snprint_port(buf, sizeof(buf), frag->ptype, frag->src_port);
+      col_buf_append(col_item->col_buf, &pos, max_len, buf, strlen(buf));
+      col_buf_append(col_item->col_buf, &pos, max_len, " " UTF8_RIGHTWARDS_ARROW " ",
+                     strlen(" " UTF8_RIGHTWARDS_ARROW " "));
+      col_snprint_port(buf, sizeof(buf), frag->ptype, frag->dst_port);
+      col_buf_append(col_item->col_buf, &pos, max_len, buf, strlen(buf));
+      break;
+    }
+  }
+  g_array_set_size(col_item->col_pending, 0);
+}
+
+/* Render the queued fragments of every column with the given format. */
+static void
+col_deferred_render_el(column_info *cinfo, const gint el)
+{
+  int i;
+  col_item_t* col_item;
+
+  if (!cinfo->deferred)
+    return;
+
+  for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
+    col_item = &cinfo->columns[i];
+    if (col_item->fmt_matx[el])
+      col_deferred_render(cinfo, col_item);
+  }
+}
+
 /* Sets the fence for a column to be at the end of the column. */
 void
 col_set_fence(column_info *cinfo, const gint el)
@@ -204,6 +412,8 @@ col_set_fence(column_info *cinfo, const gint el)
   if (!CHECK_COL(cinfo, el))
     return;
 
+  col_deferred_render_el(cinfo, el);
+
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
@@ -242,6 +452,8 @@ col_get_text(column_info *cinfo, const gint el)
     return NULL;
   }
 
+  col_deferred_render_el(cinfo, el);
+
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
@@ -270,6 +482,7 @@ col_clear(column_info *cinfo, const gint el)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       /*
        * At this point, either
        *
@@ -300,14 +513,6 @@ col_clear(column_info *cinfo, const gint el)
   }
 }
 
-#define COL_CHECK_APPEND(col_item, max_len) \
-  if (col_item->col_data != col_item->col_buf) {        \
-    /* This was set with "col_set_str()"; copy the string they  \
-       set it to into the buffer, so we can append to it. */    \
-    g_strlcpy(col_item->col_buf, col_item->col_data, max_len);  \
-    col_item->col_data = col_item->col_buf;         \
-  }
-
 #define COL_CHECK_REF_TIME(fd, buf)         \
   if (fd->ref_time) {                 \
     g_strlcpy(buf, "*REF*", COL_MAX_LEN );  \
@@ -348,6 +553,7 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
     if (col_item->fmt_matx[COL_CUSTOM] &&
         col_item->col_custom_fields &&
         col_item->col_custom_fields_ids) {
+        col_deferred_drop(col_item);
         col_item->col_data = col_item->col_buf;
         cinfo->col_expr.col_expr[i] = epan_custom_set(edt, col_item->col_custom_fields_ids,
                                      col_item->col_custom_occurrence,
@@ -390,6 +596,22 @@ col_append_lstr(column_info *cinfo, const gint el, const gchar *str1, ...)
   if (!CHECK_COL(cinfo, el))
     return;
 
+  if (cinfo->deferred) {
+    pos = cinfo->deferred_text->len;
+    va_start(ap, str1);
+    str = str1;
+    do {
+       if (G_UNLIKELY(str == NULL))
+           str = "(null)";
+
+       g_string_append(cinfo->deferred_text, str);
+
+    } while ((str = va_arg(ap, const char *)) != COL_ADD_LSTR_TERMINATOR);
+    va_end(ap);
+    col_deferred_queue_text(cinfo, el, NULL, pos, cinfo->deferred_text->len - pos);
+    return;
+  }
+
   if (el == COL_INFO)
     max_len = COL_MAX_INFO_LEN;
   else
@@ -425,28 +647,42 @@ void
 col_append_str_uint(column_info *cinfo, const gint col, const gchar *abbrev, guint32 val, const gchar *sep)
 {
   char buf[16];
+  col_deferred_t frag;
 
-  guint32_to_str_buf(val, buf, sizeof(buf));
-  col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", buf, COL_ADD_LSTR_TERMINATOR);
-}
-
-static inline void
-col_snprint_port(gchar *buf, gulong buf_siz, port_type typ, guint16 val)
-{
-  const char *str;
+  if (!CHECK_COL(cinfo, col))
+    return;
 
-  if (gbl_resolv_flags.transport_name &&
-        (str = try_serv_name_lookup(typ, val)) != NULL) {
-    ws_snprintf(buf, buf_siz, "%s(%"G_GUINT16_FORMAT")", str, val);
-  } else {
-    ws_snprintf(buf, buf_siz, "%"G_GUINT16_FORMAT, val);
+  if (cinfo->deferred) {
+    col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", COL_ADD_LSTR_TERMINATOR);
+    memset(&frag, 0, sizeof frag);
+    frag.kind = COL_DEFERRED_UINT;
+    frag.val = val;
+    col_deferred_queue(cinfo, col, &frag);
+    return;
   }
+
+  guint32_to_str_buf(val, buf, sizeof(buf));
+  col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", buf, COL_ADD_LSTR_TERMINATOR);
 }
 
 void
 col_append_ports(column_info *cinfo, const gint col, port_type typ, guint16 src, guint16 dst)
 {
   char buf_src[32], buf_dst[32];
+  col_deferred_t frag;
+
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  if (cinfo->deferred) {
+    memset(&frag, 0, sizeof frag);
+    frag.kind = COL_DEFERRED_PORTS;
+    frag.ptype = typ;
+    frag.src_port = src;
+    frag.dst_port = dst;
+    col_deferred_queue(cinfo, col, &frag);
+    return;
+  }
 
   col_snprint_port(buf_src, 32, typ, src);
   col_snprint_port(buf_dst, 32, typ, dst);
@@ -476,6 +712,20 @@ col_do_append_fstr(column_info *cinfo, const int el, const char *separator, cons
   else
     max_len = COL_MAX_LEN;
 
+  if (cinfo->deferred) {
+    va_list ap2;
+
+    /* Arguments can't be kept, so format them now. */
+    len = cinfo->deferred_text->len;
+    g_string_set_size(cinfo->deferred_text, len + max_len);
+    G_VA_COPY(ap2, ap);
+    ws_vsnprintf(&cinfo->deferred_text->str[len], (guint32)max_len, format, ap2);
+    va_end(ap2);
+    g_string_truncate(cinfo->deferred_text, len + strlen(&cinfo->deferred_text->str[len]));
+    col_deferred_queue_text(cinfo, el, separator, len, cinfo->deferred_text->len - len);
+    return;
+  }
+
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
@@ -540,8 +790,6 @@ col_append_sep_fstr(column_info *cinfo, const gint el, const gchar *separator,
 }
 
 /* Prepends a vararg list to a packet info string. */
-#define COL_BUF_MAX_LEN (((COL_MAX_INFO_LEN) > (COL_MAX_LEN)) ? \
-    (COL_MAX_INFO_LEN) : (COL_MAX_LEN))
 void
 col_prepend_fstr(column_info *cinfo, const gint el, const gchar *format, ...)
 {
@@ -555,6 +803,8 @@ col_prepend_fstr(column_info *cinfo, const gint el, const gchar *format, ...)
   if (!CHECK_COL(cinfo, el))
     return;
 
+  col_deferred_render_el(cinfo, el);
+
   if (el == COL_INFO)
     max_len = COL_MAX_INFO_LEN;
   else
@@ -598,6 +848,8 @@ col_prepend_fence_fstr(column_info *cinfo, const gint el, const gchar *format, .
   if (!CHECK_COL(cinfo, el))
     return;
 
+  col_deferred_render_el(cinfo, el);
+
   if (el == COL_INFO)
     max_len = COL_MAX_INFO_LEN;
   else
@@ -652,6 +904,7 @@ col_add_str(column_info *cinfo, const gint el, const gchar* str)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       if (col_item->col_fence != 0) {
         /*
          * We will append the string after the fence.
@@ -691,6 +944,7 @@ col_set_str(column_info *cinfo, const gint el, const gchar* str)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       if (col_item->col_fence != 0) {
         /*
          * We will append the string after the fence.
@@ -731,6 +985,7 @@ col_add_lstr(column_info *cinfo, const gint el, const gchar *str1, ...)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       pos = col_item->col_fence;
       if (pos != 0) {
         /*
@@ -779,6 +1034,7 @@ col_add_fstr(column_info *cinfo, const gint el, const gchar *format, ...)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       if (col_item->col_fence != 0) {
         /*
          * We will append the string after the fence.
@@ -806,6 +1062,12 @@ col_do_append_str(column_info *cinfo, const gint el, const gchar* separator,
   size_t len, max_len;
   col_item_t* col_item;
 
+  if (cinfo->deferred) {
+    len = strlen(str);
+    col_deferred_queue_text(cinfo, el, separator, col_deferred_add_text(cinfo, str, len), len);
+    return;
+  }
+
   if (el == COL_INFO)
     max_len = COL_MAX_INFO_LEN;
   else
@@ -1891,6 +2153,7 @@ col_set_time(column_info *cinfo, const gint el, const nstime_t *ts, const char *
   for (col = cinfo->col_first[el]; col <= cinfo->col_last[el]; col++) {
     col_item = &cinfo->columns[col];
     if (col_item->fmt_matx[el]) {
+      col_deferred_drop(col_item);
       switch (timestamp_get_precision()) {
       case TS_PREC_FIXED_SEC:
         display_signed_time(col_item->col_buf, COL_MAX_LEN,
@@ -1939,6 +2202,7 @@ col_set_addr(packet_info *pinfo, const int col, const address *addr, const gbool
     return;
   }
 
+  col_deferred_drop(col_item);
   if (res && (name = address_to_name(addr)) != NULL)
     col_item->col_data = name;
   else {
@@ -1969,6 +2233,7 @@ col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gbo
 
   /* TODO: Use fill_col_exprs */
 
+  col_deferred_drop(col_item);
   switch (pinfo->ptype) {
   case PT_SCTP:
     if (is_res)
@@ -2078,6 +2343,10 @@ col_fill_in_frame_data(const frame_data *fd, column_info *cinfo, const gint col,
 {
   col_item_t* col_item = &cinfo->columns[col];
 
+  /* All of these replace the column text. */
+  if (col_based_on_frame_data(cinfo, col))
+    col_deferred_drop(col_item);
+
   switch (col_item->col_fmt) {
   case COL_NUMBER:
     guint32_to_str_buf(fd->num, col_item->col_buf, COL_MAX_LEN);
@@ -2249,6 +2518,9 @@ col_fill_in(packet_info *pinfo, const gboolean fill_col_exprs, const gboolean fi
         break;
       }
     }
+    /* Whatever the setters above didn't replace */
+    if (pinfo->cinfo->deferred)
+      col_deferred_render(pinfo->cinfo, col_item);
   }
 }
 
@@ -2266,6 +2538,13 @@ col_fill_in_error(column_info *cinfo, frame_data *fdata, const gboolean fill_col
   if (!cinfo)
     return;
 
+  /* Put what has been appended in place first, so that queued fragments
+     don't end up after the text set here. */
+  if (cinfo->deferred) {
+    for (i = 0; i < cinfo->num_cols; i++)
+      col_deferred_render(cinfo, &cinfo->columns[i]);
+  }
+
   for (i = 0; i < cinfo->num_cols; i++) {
     col_item = &cinfo->columns[i];
     if (col_based_on_frame_data(cinfo, i)) {
@@ -106,6 +106,20 @@ WS_DLL_PUBLIC void col_setup(column_info *cinfo, const gint num_cols);
  */
 WS_DLL_PUBLIC void col_cleanup(column_info *cinfo);
 
+/** Queue appended column text and render it only when it's needed.
+ *
+ * In deferred mode the col_append_*() functions record what they were
+ * asked to append instead of writing it into the column buffer, and the
+ * text is put together when col_get_text(), col_fill_in() or a call that
+ * modifies the existing text needs it. Port and number fragments from
+ * col_append_ports() and col_append_str_uint() are not even formatted
+ * until then. Column data must be read through col_get_text() or after
+ * col_fill_in().
+ *
+ * Internal, don't use this in dissectors!
+ */
+WS_DLL_PUBLIC void col_set_deferred(column_info *cinfo, const gboolean deferred);
+
 /** Initialize the data structures for constructing column data.
  *
  * Internal, don't use this in dissectors!
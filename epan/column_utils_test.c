@@ -0,0 +1,184 @@
+/* column_utils_test.c
+ * Standalone program to test that column text comes out the same with
+ * and without deferred appends, when columns are set after text has
+ * been appended to them.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet_info.h>
+#include <epan/frame_data.h>
+#include <epan/column.h>
+#include <epan/column-info.h>
+#include <epan/column-utils.h>
+
+static gboolean failed = FALSE;
+
+static const gint test_col_fmts[] = {
+	COL_NUMBER,
+	COL_INFO,
+	COL_UNRES_SRC_PORT,
+	COL_UNRES_DL_SRC
+};
+#define NUM_TEST_COLS	G_N_ELEMENTS(test_col_fmts)
+
+static column_info cinfo;
+static frame_data fdata;
+static packet_info pinfo;
+
+static void
+setup_columns(gboolean deferred)
+{
+	guint i;
+
+	col_setup(&cinfo, NUM_TEST_COLS);
+	for (i = 0; i < NUM_TEST_COLS; i++) {
+		cinfo.columns[i].col_fmt = test_col_fmts[i];
+		cinfo.columns[i].col_title = NULL;
+		cinfo.columns[i].col_fence = 0;
+	}
+	col_finalize(&cinfo);
+	col_set_deferred(&cinfo, deferred);
+
+	memset(&fdata, 0, sizeof fdata);
+	fdata.num = 42;
+	memset(&pinfo, 0, sizeof pinfo);
+	pinfo.cinfo = &cinfo;
+	pinfo.fd = &fdata;
+	pinfo.num = fdata.num;
+	pinfo.ptype = PT_TCP;
+	pinfo.srcport = 80;
+}
+
+/* What col_init() does for each packet */
+static void
+start_packet(void)
+{
+	guint i;
+
+	for (i = 0; i < NUM_TEST_COLS; i++) {
+		cinfo.columns[i].col_buf[0] = '\0';
+		cinfo.columns[i].col_data = cinfo.columns[i].col_buf;
+		cinfo.columns[i].col_fence = 0;
+		cinfo.columns[i].writable = TRUE;
+		if (cinfo.columns[i].col_pending != NULL)
+			g_array_set_size(cinfo.columns[i].col_pending, 0);
+		cinfo.col_expr.col_expr[i] = "";
+		cinfo.col_expr.col_expr_val[i][0] = '\0';
+	}
+	if (cinfo.deferred_text != NULL)
+		g_string_truncate(cinfo.deferred_text, 0);
+	cinfo.writable = TRUE;
+}
+
+static void
+check_text(const char *what, gboolean deferred, gint el, const char *expected)
+{
+	const char *text = col_get_text(&cinfo, el);
+
+	if (text == NULL || strcmp(text, expected) != 0) {
+		printf("Failed %s (%s): column %d is \"%s\", expected \"%s\"\n",
+		       what, deferred ? "deferred" : "immediate", el,
+		       text ? text : "(null)", expected);
+		failed = TRUE;
+	}
+}
+
+/* Text appended before col_fill_in() sets a column is replaced, on
+ * columns it doesn't set it is kept. */
+static void
+test_fill_in(gboolean deferred)
+{
+	start_packet();
+	col_append_str(&cinfo, COL_NUMBER, "number");
+	col_append_str(&cinfo, COL_INFO, "info");
+	col_append_str_uint(&cinfo, COL_INFO, "n", 5, " ");
+	col_append_str_uint(&cinfo, COL_UNRES_SRC_PORT, "port", 8080, NULL);
+	/* no link-layer address, so this column isn't set */
+	col_append_sep_str(&cinfo, COL_UNRES_DL_SRC, ", ", "kept");
+	col_fill_in(&pinfo, FALSE, TRUE);
+
+	check_text("fill_in", deferred, COL_NUMBER, "42");
+	check_text("fill_in", deferred, COL_INFO, "info n=5");
+	check_text("fill_in", deferred, COL_UNRES_SRC_PORT, "80");
+	check_text("fill_in", deferred, COL_UNRES_DL_SRC, "kept");
+}
+
+/* col_fill_in_error() replaces what was appended; text appended later,
+ * e.g. by the caller, comes after its text. */
+static void
+test_fill_in_error(gboolean deferred)
+{
+	start_packet();
+	col_append_str(&cinfo, COL_NUMBER, "number");
+	col_append_fstr(&cinfo, COL_INFO, "frame %u", 1);
+	col_append_str(&cinfo, COL_UNRES_SRC_PORT, "port");
+	col_fill_in_error(&cinfo, &fdata, FALSE, TRUE);
+
+	check_text("fill_in_error", deferred, COL_NUMBER, "42");
+	check_text("fill_in_error", deferred, COL_INFO, "Read error");
+	check_text("fill_in_error", deferred, COL_UNRES_SRC_PORT, "???");
+
+	col_append_str(&cinfo, COL_INFO, " (truncated)");
+	check_text("fill_in_error", deferred, COL_INFO, "Read error (truncated)");
+}
+
+/* Setting text in a dissector drops what was appended after the fence. */
+static void
+test_set(gboolean deferred)
+{
+	start_packet();
+	col_append_str(&cinfo, COL_INFO, "fenced");
+	col_set_fence(&cinfo, COL_INFO);
+	col_append_str(&cinfo, COL_INFO, " dropped");
+	col_set_str(&cinfo, COL_INFO, " set");
+	col_append_str(&cinfo, COL_INFO, " appended");
+	check_text("set", deferred, COL_INFO, "fenced set appended");
+
+	col_clear(&cinfo, COL_INFO);
+	check_text("set", deferred, COL_INFO, "fenced");
+}
+
+int
+main(void)
+{
+	gboolean deferred;
+
+	for (deferred = FALSE; deferred <= TRUE; deferred++) {
+		setup_columns(deferred);
+		test_fill_in(deferred);
+		test_fill_in_error(deferred);
+		test_set(deferred);
+		col_cleanup(&cinfo);
+	}
+
+	if (failed)
+		exit(1);
+	printf("Passed column-utils tests\n");
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
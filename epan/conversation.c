@@ -65,6 +65,43 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 static guint32 new_index;
 
+/*
+ * Presence filters for the wildcard tables, one bit per port 1 value
+ * (folded to 16 bits).  A bit is set whenever a conversation is inserted
+ * into the matching table and only cleared when the file is reset, so a
+ * clear bit means the table cannot hold a match and the hash probe can be
+ * skipped.  For a new flow this turns the up to six wildcard probes in
+ * find_conversation() into bit tests.  The exact table is always probed.
+ */
+#define CONV_PORT1_FILTER_BITS	65536
+static guint8 conversation_port1_filter_no_addr2[CONV_PORT1_FILTER_BITS / 8];
+static guint8 conversation_port1_filter_no_port2[CONV_PORT1_FILTER_BITS / 8];
+static guint8 conversation_port1_filter_no_addr2_or_port2[CONV_PORT1_FILTER_BITS / 8];
+
+/*
+ * Bumped whenever a conversation is added to, moved between or removed
+ * from the hash tables; used to validate the per-packet lookup cache.
+ */
+static guint32 conversation_generation;
+
+/*
+ * Result of the last find_conversation_pinfo() call for a packet, and
+ * the lookup that produced it.  Allocated from pinfo->pool, so it goes
+ * away with the packet.
+ */
+struct conversation_pinfo_cache {
+	conversation_t *conv;
+	guint32 generation;
+	guint32 frame_num;
+	const struct endpoint *endpoint;
+	address src;
+	address dst;
+	endpoint_type etype;
+	guint32 srcport;
+	guint32 destport;
+	guint options;
+};
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -480,6 +517,27 @@ void conversation_epan_reset(void)
 	 * Start the conversation indices over at 0.
 	 */
 	new_index = 0;
+
+	memset(conversation_port1_filter_no_addr2, 0, sizeof conversation_port1_filter_no_addr2);
+	memset(conversation_port1_filter_no_port2, 0, sizeof conversation_port1_filter_no_port2);
+	memset(conversation_port1_filter_no_addr2_or_port2, 0, sizeof conversation_port1_filter_no_addr2_or_port2);
+	conversation_generation++;
+}
+
+/*
+ * Returns the port 1 presence filter for a hash table, or NULL for the
+ * exact table, which has none.
+ */
+static guint8 *
+conversation_port1_filter(const wmem_map_t *hashtable)
+{
+	if (hashtable == conversation_hashtable_no_addr2)
+		return conversation_port1_filter_no_addr2;
+	if (hashtable == conversation_hashtable_no_port2)
+		return conversation_port1_filter_no_port2;
+	if (hashtable == conversation_hashtable_no_addr2_or_port2)
+		return conversation_port1_filter_no_addr2_or_port2;
+	return NULL;
 }
 
 /*
@@ -492,6 +550,15 @@ static void
 conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *chain_tail, *cur, *prev;
+	guint8 *filter;
+	guint32 bit;
+
+	filter = conversation_port1_filter(hashtable);
+	if (filter != NULL) {
+		bit = conv->key_ptr->port1 & (CONV_PORT1_FILTER_BITS - 1);
+		filter[bit >> 3] |= 1 << (bit & 7);
+	}
+	conversation_generation++;
 
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
@@ -549,6 +616,8 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *cur, *prev;
 
+	conversation_generation++;
+
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
 	if (conv == chain_head) {
@@ -848,6 +917,19 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	conversation_t* match=NULL;
 	conversation_t* chain_head=NULL;
 	struct conversation_key key;
+	const guint8 *filter;
+	guint32 bit;
+
+	/*
+	 * Nothing with this port 1 was ever put in a wildcard table;
+	 * don't bother hashing the key.
+	 */
+	filter = conversation_port1_filter(hashtable);
+	if (filter != NULL) {
+		bit = port1 & (CONV_PORT1_FILTER_BITS - 1);
+		if (!(filter[bit >> 3] & (1 << (bit & 7))))
+			return NULL;
+	}
 
 	/*
 	 * We don't make a copy of the address data, we just copy the
@@ -1440,22 +1522,95 @@ try_conversation_dissector_by_id(const endpoint_type etype, const guint32 id, tv
 	return FALSE;
 }
 
+/*
+ * Does the cached lookup for this packet match the one we're about to do?
+ * Nothing may have been added to or moved in the hash tables since, as
+ * that could change the answer.
+ */
+static gboolean
+conversation_pinfo_cache_matches(const struct conversation_pinfo_cache *cache, const packet_info *pinfo,
+    const endpoint_type etype, const guint options)
+{
+	if (cache->generation != conversation_generation || cache->frame_num != pinfo->num ||
+	    cache->options != options)
+		return FALSE;
+
+	if (pinfo->use_endpoint)
+		return cache->endpoint == pinfo->conv_endpoint;
+
+	return cache->endpoint == NULL && cache->etype == etype &&
+	    cache->srcport == pinfo->srcport && cache->destport == pinfo->destport &&
+	    addresses_equal(&cache->src, &pinfo->src) && addresses_equal(&cache->dst, &pinfo->dst);
+}
+
+static void
+conversation_pinfo_cache_store(packet_info *pinfo, conversation_t *conv, const endpoint_type etype,
+    const guint options)
+{
+	struct conversation_pinfo_cache *cache = pinfo->conv_cache;
+
+	if (cache == NULL) {
+		cache = wmem_new0(pinfo->pool, struct conversation_pinfo_cache);
+		pinfo->conv_cache = cache;
+	}
+
+	cache->conv = conv;
+	cache->generation = conversation_generation;
+	cache->frame_num = pinfo->num;
+	cache->options = options;
+	if (pinfo->use_endpoint) {
+		cache->endpoint = pinfo->conv_endpoint;
+		return;
+	}
+	cache->endpoint = NULL;
+	cache->etype = etype;
+	cache->srcport = pinfo->srcport;
+	cache->destport = pinfo->destport;
+	/*
+	 * Take copies; the packet's addresses may point at buffers that
+	 * are reused (e.g. while dissecting the payload of an ICMP error).
+	 */
+	if (!addresses_equal(&cache->src, &pinfo->src)) {
+		free_address_wmem(pinfo->pool, &cache->src);
+		copy_address_wmem(pinfo->pool, &cache->src, &pinfo->src);
+	}
+	if (!addresses_equal(&cache->dst, &pinfo->dst)) {
+		free_address_wmem(pinfo->pool, &cache->dst);
+		copy_address_wmem(pinfo->pool, &cache->dst, &pinfo->dst);
+	}
+}
+
 /**  A helper function that calls find_conversation() using data from pinfo
  *  The frame number and addresses are taken from pinfo.
+ *
+ *  The result is remembered in pinfo, so that the dissectors for the
+ *  other layers of the same packet asking for the same conversation
+ *  don't have to look it up again.
  */
 conversation_t *
 find_conversation_pinfo(packet_info *pinfo, const guint options)
 {
 	conversation_t *conv=NULL;
+	endpoint_type etype;
 
 	DPRINT(("called for frame #%u: %s:%d -> %s:%d (ptype=%d)",
 		pinfo->num, address_to_str(wmem_packet_scope(), &pinfo->src), pinfo->srcport,
 		address_to_str(wmem_packet_scope(), &pinfo->dst), pinfo->destport, pinfo->ptype));
 	DINDENT();
 
+	etype = conversation_pt_to_endpoint_type(pinfo->ptype);
+	if (pinfo->use_endpoint)
+		DISSECTOR_ASSERT(pinfo->conv_endpoint);
+
+	if (pinfo->conv_cache != NULL &&
+	    conversation_pinfo_cache_matches(pinfo->conv_cache, pinfo, etype, options)) {
+		DPRINT(("using cached conversation lookup for frame #%u", pinfo->num));
+		DENDENT();
+		return pinfo->conv_cache->conv;
+	}
+
 	/* Have we seen this conversation before? */
 	if (pinfo->use_endpoint) {
-		DISSECTOR_ASSERT(pinfo->conv_endpoint);
 		if ((conv = find_conversation(pinfo->num, &pinfo->conv_endpoint->addr1, &pinfo->conv_endpoint->addr2,
 					      pinfo->conv_endpoint->etype, pinfo->conv_endpoint->port1,
 					      pinfo->conv_endpoint->port2, pinfo->conv_endpoint->options)) != NULL) {
@@ -1467,7 +1622,7 @@ find_conversation_pinfo(packet_info *pinfo, const guint options)
 		}
 	} else {
 		if ((conv = find_conversation(pinfo->num, &pinfo->src, &pinfo->dst,
-					      conversation_pt_to_endpoint_type(pinfo->ptype), pinfo->srcport,
+					      etype, pinfo->srcport,
 					      pinfo->destport, options)) != NULL) {
 			DPRINT(("found previous conversation for frame #%u (last_frame=%d)",
 					pinfo->num, conv->last_frame));
@@ -1477,6 +1632,8 @@ find_conversation_pinfo(packet_info *pinfo, const guint options)
 		}
 	}
 
+	conversation_pinfo_cache_store(pinfo, conv, etype, options);
+
 	DENDENT();
 
 	return conv;
@@ -0,0 +1,194 @@
+/* crc32_test.c
+ * Standalone program to test the CRC-32 routines and their tvbuff
+ * wrappers, and, given a number of megabytes, to report their throughput
+ * over that much data.
+ *
+ * The CRC-32 routines use the fastest implementation the CPU supports;
+ * set WIRESHARK_CRC32 to "slice8" or "bytewise" to test a slower one.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "tvbuff.h"
+#include "crc32-tvb.h"
+#include "exceptions.h"
+#include <wsutil/crc32.h>
+
+#define BUF_SIZE	(64 * 1024)
+
+static gboolean failed = FALSE;
+
+/* The CRC register after feeding it buf a bit at a time, with the
+ * bit-reversed polynomial. */
+static guint32
+crc32_bitwise(const guint8 *buf, guint len, guint32 crc, guint32 poly)
+{
+	guint i;
+	int   bit;
+
+	for (i = 0; i < len; i++) {
+		crc ^= buf[i];
+		for (bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+	return crc;
+}
+
+#define CRC32_CCITT_POLY	0xEDB88320
+#define CRC32C_POLY		0x82F63B78
+
+static void
+check(const char *name, guint offset, guint len, guint32 actual, guint32 expected)
+{
+	if (actual != expected) {
+		printf("Failed %s at offset %u length %u: 0x%08x, expected 0x%08x\n",
+		       name, offset, len, actual, expected);
+		failed = TRUE;
+	}
+}
+
+/* Every combination of alignment and length up to a few blocks, then
+ * random ones up to the whole buffer. */
+static void
+test_correctness(const guint8 *buf, tvbuff_t *tvb)
+{
+	GRand  *rand = g_rand_new_with_seed(1);
+	guint   offset, len;
+	int     i;
+
+	check("crc32_ccitt check value", 0, 9,
+	      crc32_ccitt((const guint8 *)"123456789", 9), 0xCBF43926);
+	check("crc32c check value", 0, 9,
+	      ~crc32c_calculate_no_swap("123456789", 9, CRC32C_PRELOAD), 0xE3069283);
+
+	for (offset = 0; offset < 16; offset++) {
+		for (len = 0; len <= 300; len++) {
+			guint32 seed = g_rand_int(rand);
+
+			check("crc32_ccitt_seed", offset, len,
+			      crc32_ccitt_seed(buf + offset, len, seed),
+			      ~crc32_bitwise(buf + offset, len, seed, CRC32_CCITT_POLY));
+			check("crc32c_calculate_no_swap", offset, len,
+			      crc32c_calculate_no_swap(buf + offset, len, seed),
+			      crc32_bitwise(buf + offset, len, seed, CRC32C_POLY));
+			check("crc32c_calculate", offset, len,
+			      crc32c_calculate(buf + offset, len, seed),
+			      GUINT32_SWAP_LE_BE(crc32_bitwise(buf + offset, len, GUINT32_SWAP_LE_BE(seed), CRC32C_POLY)));
+		}
+	}
+
+	for (i = 0; i < 100; i++) {
+		guint32 seed = g_rand_int(rand);
+
+		offset = g_rand_int_range(rand, 0, 64);
+		len = g_rand_int_range(rand, 0, BUF_SIZE - 64);
+		check("crc32_ccitt_seed", offset, len,
+		      crc32_ccitt_seed(buf + offset, len, seed),
+		      ~crc32_bitwise(buf + offset, len, seed, CRC32_CCITT_POLY));
+		check("crc32c_calculate_no_swap", offset, len,
+		      crc32c_calculate_no_swap(buf + offset, len, seed),
+		      crc32_bitwise(buf + offset, len, seed, CRC32C_POLY));
+		check("crc32_ccitt_tvb_offset", offset, len,
+		      crc32_ccitt_tvb_offset(tvb, offset, len),
+		      ~crc32_bitwise(buf + offset, len, CRC32_CCITT_SEED, CRC32_CCITT_POLY));
+		check("crc32c_tvb_offset_calculate", offset, len,
+		      crc32c_tvb_offset_calculate(tvb, offset, len, CRC32C_PRELOAD),
+		      GUINT32_SWAP_LE_BE(crc32_bitwise(buf + offset, len, CRC32C_PRELOAD, CRC32C_POLY)));
+		check("crc32_802_tvb", 0, len,
+		      crc32_802_tvb(tvb, len),
+		      GUINT32_SWAP_LE_BE(~crc32_bitwise(buf, len, CRC32_CCITT_SEED, CRC32_CCITT_POLY)));
+	}
+
+	g_rand_free(rand);
+}
+
+static void
+report_throughput(const char *name, guint32 (*func)(const guint8 *, guint),
+		  const guint8 *buf, guint len, guint mbytes)
+{
+	guint64 iterations = ((guint64)mbytes * 1024 * 1024 + len - 1) / len;
+	guint64 i;
+	gint64  start;
+	double  seconds;
+	guint32 sum = 0;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+		sum += func(buf, len);
+	seconds = (g_get_monotonic_time() - start) / 1e6;
+	printf("%-12s %6u bytes: %8.0f MB/s (%08x)\n", name, len,
+	       iterations * len / seconds / 1e6, sum);
+}
+
+static guint32
+crc32_ccitt_one(const guint8 *buf, guint len)
+{
+	return crc32_ccitt(buf, len);
+}
+
+static guint32
+crc32c_one(const guint8 *buf, guint len)
+{
+	return crc32c_calculate(buf, len, CRC32C_PRELOAD);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const guint sizes[] = { 64, 1500, 9000, BUF_SIZE };
+	guint8   *buf = (guint8 *)g_malloc(BUF_SIZE);
+	tvbuff_t *tvb;
+	guint     mbytes = 0;
+	guint     i;
+
+	if (argc > 1)
+		mbytes = (guint)strtoul(argv[1], NULL, 10);
+
+	for (i = 0; i < BUF_SIZE; i++)
+		buf[i] = (guint8)(i * 2654435761U >> 24);
+
+	except_init();
+	tvb = tvb_new_real_data(buf, BUF_SIZE, BUF_SIZE);
+
+	test_correctness(buf, tvb);
+	if (failed)
+		exit(1);
+	printf("Passed CRC-32 tests (WIRESHARK_CRC32=%s)\n",
+	       g_getenv("WIRESHARK_CRC32") ? g_getenv("WIRESHARK_CRC32") : "");
+
+	if (mbytes != 0) {
+		for (i = 0; i < G_N_ELEMENTS(sizes); i++) {
+			report_throughput("crc32_ccitt", crc32_ccitt_one, buf, sizes[i], mbytes);
+			report_throughput("crc32c", crc32c_one, buf, sizes[i], mbytes);
+		}
+	}
+
+	tvb_free(tvb);
+	except_deinit();
+	g_free(buf);
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -24,9 +24,12 @@ struct epan_dfilter {
 	GList		**registers;
 	gboolean	*attempted_load;
 	gboolean	*owns_memory;
+	gboolean	*cached_list;	/* register list belongs to a dfvm_field_cache_t */
 	int		*interesting_fields;
 	int		num_interesting_fields;
 	GPtrArray	*deprecated;
+	dfilter_part_op_t part_op;	/* set by dfilter_compile_parts() */
+	dfilter_t	*parts[2];
 };
 
 typedef struct {
@@ -42,6 +45,9 @@ typedef struct {
 	int		next_const_id;
 	int		next_register;
 	int		first_constant; /* first register used as a constant */
+	gboolean	specialize;	/* generate type-specialized instructions */
+	gboolean	keep_tree;	/* borrow constants from the syntax tree
+					 * instead of taking them over */
 } dfwork_t;
 
 /*
@@ -13,6 +13,7 @@
 
 #include "dfilter-int.h"
 #include "syntax-tree.h"
+#include "sttype-test.h"
 #include "gencode.h"
 #include "semcheck.h"
 #include "dfvm.h"
@@ -34,6 +35,9 @@ static void*	ParserObj = NULL;
  */
 dfwork_t *global_dfw;
 
+/* Generate type-specialized instructions where possible? */
+static gboolean specialize_code = TRUE;
+
 void
 dfilter_fail(dfwork_t *dfw, const char *format, ...)
 {
@@ -74,6 +78,12 @@ dfilter_init(void)
 	dfilter_macro_init();
 }
 
+void
+dfilter_set_specialize(gboolean enable)
+{
+	specialize_code = enable;
+}
+
 /* Clean-up the dfilter module */
 void
 dfilter_cleanup(void)
@@ -124,6 +134,10 @@ dfilter_free(dfilter_t *df)
 	if (!df)
 		return;
 
+	/* The operands may borrow constants from the filter itself. */
+	dfilter_free(df->parts[0]);
+	dfilter_free(df->parts[1]);
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -150,6 +164,7 @@ dfilter_free(dfilter_t *df)
 	g_free(df->registers);
 	g_free(df->attempted_load);
 	g_free(df->owns_memory);
+	g_free(df->cached_list);
 	g_free(df);
 }
 
@@ -161,6 +176,7 @@ dfwork_new(void)
 
 	dfw = g_new0(dfwork_t, 1);
 	dfw->first_constant = -1;
+	dfw->specialize = specialize_code;
 
 	return dfw;
 }
@@ -195,8 +211,105 @@ dfwork_free(dfwork_t *dfw)
 	g_free(dfw);
 }
 
-gboolean
-dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
+/* Returns the logical operation at "node", if it is one, and sets "arg1"
+ * and "arg2" to its operands. */
+static dfilter_part_op_t
+dfilter_node_op(stnode_t *node, stnode_t **arg1, stnode_t **arg2)
+{
+	test_op_t	op = TEST_OP_UNINITIALIZED;
+
+	*arg1 = NULL;
+	*arg2 = NULL;
+	if (stnode_type_id(node) == STTYPE_TEST)
+		sttype_test_get(node, &op, arg1, arg2);
+
+	switch (op) {
+		case TEST_OP_NOT:
+			return DFILTER_PART_NOT;
+		case TEST_OP_AND:
+			return DFILTER_PART_AND;
+		case TEST_OP_OR:
+			return DFILTER_PART_OR;
+		default:
+			return DFILTER_PART_NONE;
+	}
+}
+
+/* Turns the syntax tree at "node" into bytecode. */
+static dfilter_t *
+dfilter_generate(dfwork_t *dfw, stnode_t *node)
+{
+	dfilter_t	*dfilter;
+	stnode_t	*st_root;
+
+	st_root = dfw->st_root;
+	dfw->st_root = node;
+	dfw_gencode(dfw);
+	dfw->st_root = st_root;
+
+	/* Tuck away the bytecode in the dfilter_t */
+	dfilter = dfilter_new();
+	dfilter->insns = dfw->insns;
+	dfilter->consts = dfw->consts;
+	dfw->insns = NULL;
+	dfw->consts = NULL;
+	dfilter->interesting_fields = dfw_interesting_fields(dfw,
+		&dfilter->num_interesting_fields);
+
+	/* Initialize run-time space */
+	dfilter->num_registers = dfw->first_constant;
+	dfilter->max_registers = dfw->next_register;
+	dfilter->registers = g_new0(GList*, dfilter->max_registers);
+	dfilter->attempted_load = g_new0(gboolean, dfilter->max_registers);
+	dfilter->owns_memory = g_new0(gboolean, dfilter->max_registers);
+	dfilter->cached_list = g_new0(gboolean, dfilter->max_registers);
+
+	/* Initialize constants */
+	dfvm_init_const(dfilter);
+
+	return dfilter;
+}
+
+/* Turns each operand of the logical operation at "node", if it is one,
+ * into bytecode of its own in "parts", and their operands in turn.
+ * Returns the operation. */
+static dfilter_part_op_t
+dfilter_generate_parts(dfwork_t *dfw, stnode_t *node, dfilter_t **parts)
+{
+	dfilter_part_op_t part_op;
+	stnode_t	*args[2];
+	dfilter_t	*sub_parts[2];
+	guint		i, num_parts;
+
+	part_op = dfilter_node_op(node, &args[0], &args[1]);
+	switch (part_op) {
+		case DFILTER_PART_NOT:
+			num_parts = 1;
+			break;
+		case DFILTER_PART_AND:
+		case DFILTER_PART_OR:
+			num_parts = 2;
+			break;
+		default:
+			num_parts = 0;
+			break;
+	}
+
+	for (i = 0; i < num_parts; i++) {
+		sub_parts[0] = sub_parts[1] = NULL;
+		parts[i] = dfilter_generate(dfw, args[i]);
+		parts[i]->part_op = dfilter_generate_parts(dfw, args[i], sub_parts);
+		parts[i]->parts[0] = sub_parts[0];
+		parts[i]->parts[1] = sub_parts[1];
+	}
+	return part_op;
+}
+
+/* Compiles "text", along with the operands of its logical operations if
+ * "with_parts" is TRUE (see dfilter_compile_parts()). */
+static gboolean
+dfilter_compile_real(const gchar *text, dfilter_t **dfp, gchar **err_msg,
+		gboolean with_parts)
 {
 	gchar		*expanded_text;
 	int		token;
@@ -210,6 +323,8 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 	guint		i;
 	/* XXX, GHashTable */
 	GPtrArray	*deprecated;
+	dfilter_t	*parts[2] = { NULL, NULL };
+	dfilter_part_op_t part_op = DFILTER_PART_NONE;
 
 	g_assert(dfp);
 
@@ -335,30 +450,23 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		}
 
 		/* Create bytecode */
-		dfw_gencode(dfw);
-
-		/* Tuck away the bytecode in the dfilter_t */
-		dfilter = dfilter_new();
-		dfilter->insns = dfw->insns;
-		dfilter->consts = dfw->consts;
-		dfw->insns = NULL;
-		dfw->consts = NULL;
-		dfilter->interesting_fields = dfw_interesting_fields(dfw,
-			&dfilter->num_interesting_fields);
-
-		/* Initialize run-time space */
-		dfilter->num_registers = dfw->first_constant;
-		dfilter->max_registers = dfw->next_register;
-		dfilter->registers = g_new0(GList*, dfilter->max_registers);
-		dfilter->attempted_load = g_new0(gboolean, dfilter->max_registers);
-		dfilter->owns_memory = g_new0(gboolean, dfilter->max_registers);
-
-		/* Initialize constants */
-		dfvm_init_const(dfilter);
+		if (with_parts) {
+			/* The operands borrow their constants from the syntax
+			 * tree, so they come before the whole filter, which
+			 * takes them over. */
+			dfw->keep_tree = TRUE;
+			part_op = dfilter_generate_parts(dfw, dfw->st_root, parts);
+			dfw->keep_tree = FALSE;
+		}
+		dfilter = dfilter_generate(dfw, dfw->st_root);
 
 		/* Add any deprecated items */
 		dfilter->deprecated = deprecated;
 
+		dfilter->part_op = part_op;
+		dfilter->parts[0] = parts[0];
+		dfilter->parts[1] = parts[1];
+
 		/* And give it to the user. */
 		*dfp = dfilter;
 	}
@@ -397,17 +505,69 @@ FAILURE:
 	return FALSE;
 }
 
+gboolean
+dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
+{
+	return dfilter_compile_real(text, dfp, err_msg, FALSE);
+}
+
+gboolean
+dfilter_compile_parts(const gchar *text, dfilter_t **dfp, gchar **err_msg)
+{
+	return dfilter_compile_real(text, dfp, err_msg, TRUE);
+}
+
+dfilter_part_op_t
+dfilter_get_parts(const dfilter_t *df, dfilter_t **part1, dfilter_t **part2)
+{
+	*part1 = df->parts[0];
+	*part2 = df->parts[1];
+
+	switch (df->part_op) {
+		case DFILTER_PART_NOT:
+			if (!df->parts[0])
+				return DFILTER_PART_NONE;
+			break;
+		case DFILTER_PART_AND:
+		case DFILTER_PART_OR:
+			if (!df->parts[0] || !df->parts[1])
+				return DFILTER_PART_NONE;
+			break;
+		default:
+			break;
+	}
+	return df->part_op;
+}
+
+gchar *
+dfilter_signature(dfilter_t *df)
+{
+	return dfvm_signature(df);
+}
+
+gboolean
+dfilter_uses_field(const dfilter_t *df, int hf_id)
+{
+	int i;
+
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		if (df->interesting_fields[i] == hf_id)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree)
 {
-	return dfvm_apply(df, tree);
+	return dfvm_apply(df, tree, NULL);
 }
 
 gboolean
 dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 {
-	return dfvm_apply(df, edt->tree);
+	return dfvm_apply(df, edt->tree, NULL);
 }
 
 
@@ -453,6 +613,135 @@ dfilter_dump(dfilter_t *df)
 	}
 }
 
+struct epan_dfilter_multi {
+	GPtrArray	*programs;	/* distinct filters, by slot */
+	GArray		*slots;		/* guint slot of each added filter */
+	GHashTable	*by_signature;	/* program signature -> slot + 1 */
+	guint32		*evaluated;	/* per slot: has run on this packet */
+	guint32		*matched;	/* per slot: matched this packet */
+	guint		mask_words;
+	dfvm_field_cache_t *cache;
+};
+
+dfilter_multi_t *
+dfilter_multi_new(void)
+{
+	dfilter_multi_t *dfm;
+
+	dfm = g_new0(dfilter_multi_t, 1);
+	dfm->programs = g_ptr_array_new();
+	dfm->slots = g_array_new(FALSE, FALSE, sizeof(guint));
+	dfm->by_signature = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, NULL);
+	dfm->cache = dfvm_field_cache_new();
+	return dfm;
+}
+
+void
+dfilter_multi_free(dfilter_multi_t *dfm)
+{
+	if (!dfm)
+		return;
+
+	g_ptr_array_free(dfm->programs, TRUE);
+	g_array_free(dfm->slots, TRUE);
+	g_hash_table_destroy(dfm->by_signature);
+	g_free(dfm->evaluated);
+	g_free(dfm->matched);
+	dfvm_field_cache_free(dfm->cache);
+	g_free(dfm);
+}
+
+guint
+dfilter_multi_add(dfilter_multi_t *dfm, dfilter_t *df)
+{
+	gchar	*signature;
+	guint	slot;
+
+	g_assert(df);
+
+	signature = dfvm_signature(df);
+	slot = signature ? GPOINTER_TO_UINT(g_hash_table_lookup(dfm->by_signature, signature)) : 0;
+	if (slot > 0) {
+		/* Same program as an earlier filter; share its result. */
+		slot--;
+		g_free(signature);
+	}
+	else {
+		slot = dfm->programs->len;
+		g_ptr_array_add(dfm->programs, df);
+		if (signature)
+			g_hash_table_insert(dfm->by_signature, signature, GUINT_TO_POINTER(slot + 1));
+
+		if (DFILTER_MULTI_MASK_WORDS(dfm->programs->len) > dfm->mask_words) {
+			dfm->mask_words = DFILTER_MULTI_MASK_WORDS(dfm->programs->len);
+			dfm->evaluated = g_renew(guint32, dfm->evaluated, dfm->mask_words);
+			dfm->matched = g_renew(guint32, dfm->matched, dfm->mask_words);
+		}
+	}
+	g_array_append_val(dfm->slots, slot);
+	dfilter_multi_reset(dfm);
+
+	return dfm->slots->len - 1;
+}
+
+void
+dfilter_multi_clear(dfilter_multi_t *dfm)
+{
+	g_ptr_array_set_size(dfm->programs, 0);
+	g_array_set_size(dfm->slots, 0);
+	g_hash_table_remove_all(dfm->by_signature);
+	dfilter_multi_reset(dfm);
+}
+
+guint
+dfilter_multi_count(const dfilter_multi_t *dfm)
+{
+	return dfm->slots->len;
+}
+
+void
+dfilter_multi_reset(dfilter_multi_t *dfm)
+{
+	if (dfm->mask_words > 0)
+		memset(dfm->evaluated, 0, dfm->mask_words * sizeof(guint32));
+	dfvm_field_cache_reset(dfm->cache);
+}
+
+gboolean
+dfilter_multi_apply_one(dfilter_multi_t *dfm, epan_dissect_t *edt, guint idx)
+{
+	guint		slot;
+	guint32		bit;
+
+	g_assert(idx < dfm->slots->len);
+
+	slot = g_array_index(dfm->slots, guint, idx);
+	bit = 1U << (slot % 32);
+	if (!(dfm->evaluated[slot / 32] & bit)) {
+		dfm->evaluated[slot / 32] |= bit;
+		if (dfvm_apply((dfilter_t *)g_ptr_array_index(dfm->programs, slot),
+				edt->tree, dfm->cache))
+			dfm->matched[slot / 32] |= bit;
+		else
+			dfm->matched[slot / 32] &= ~bit;
+	}
+	return (dfm->matched[slot / 32] & bit) != 0;
+}
+
+void
+dfilter_multi_apply_edt(dfilter_multi_t *dfm, epan_dissect_t *edt, guint32 *matches)
+{
+	guint i;
+
+	dfilter_multi_reset(dfm);
+	memset(matches, 0, DFILTER_MULTI_MASK_WORDS(dfm->slots->len) * sizeof(guint32));
+	for (i = 0; i < dfm->slots->len; i++) {
+		if (dfilter_multi_apply_one(dfm, edt, i))
+			matches[i / 32] |= 1U << (i % 32);
+	}
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
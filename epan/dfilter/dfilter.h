@@ -31,6 +31,14 @@ dfilter_init(void);
 void
 dfilter_cleanup(void);
 
+/* Enables or disables (for comparison and debugging) the generation of
+ * type-specialized instructions, which test integer and IPv4 fields
+ * against constants in place rather than through the generic register
+ * machinery. Enabled by default; affects subsequent compilations only. */
+WS_DLL_PUBLIC
+void
+dfilter_set_specialize(gboolean enable);
+
 /* Compiles a string to a dfilter_t.
  * On success, sets the dfilter* pointed to by dfp
  * to either a NULL pointer (if the filter is a null
@@ -49,6 +57,42 @@ WS_DLL_PUBLIC
 gboolean
 dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg);
 
+/* Like dfilter_compile(), but if the filter is a "not", "and" or "or"
+ * of other tests, each operand is compiled as a filter of its own as
+ * well, recursively, so that its results can be looked up or cached
+ * separately; see dfilter_get_parts(). */
+WS_DLL_PUBLIC
+gboolean
+dfilter_compile_parts(const gchar *text, dfilter_t **dfp, gchar **err_msg);
+
+typedef enum {
+	DFILTER_PART_NONE,	/* not split, or not a logical operation */
+	DFILTER_PART_NOT,	/* !part1 */
+	DFILTER_PART_AND,	/* part1 && part2 */
+	DFILTER_PART_OR		/* part1 || part2 */
+} dfilter_part_op_t;
+
+/* Returns the top-level logical operation of a filter compiled with
+ * dfilter_compile_parts() and sets "part1" and "part2" (NULL for "not")
+ * to its operands. The operands belong to "df". */
+WS_DLL_PUBLIC
+dfilter_part_op_t
+dfilter_get_parts(const dfilter_t *df, dfilter_t **part1, dfilter_t **part2);
+
+/* Returns a g_malloc'ed string identifying the compiled program of
+ * "df", equal for filters that differ only in spelling (field aliases,
+ * spacing, number formats and so on), or NULL if no reliable key can
+ * be made. Constants are written out exactly, so two filters share a
+ * signature only if they always give the same result. */
+WS_DLL_PUBLIC
+gchar *
+dfilter_signature(dfilter_t *df);
+
+/* Returns TRUE if "df" reads the field with id "hf_id". */
+WS_DLL_PUBLIC
+gboolean
+dfilter_uses_field(const dfilter_t *df, int hf_id);
+
 /* Frees all memory used by dfilter, and frees
  * the dfilter itself. */
 WS_DLL_PUBLIC
@@ -81,6 +125,62 @@ WS_DLL_PUBLIC
 void
 dfilter_dump(dfilter_t *df);
 
+/* A set of compiled filters that are tested against the same packets.
+ * Each field is read from the tree once per packet for all of the
+ * filters in the set, filters with identical programs are run only
+ * once, and each filter is run at most once per packet. */
+typedef struct epan_dfilter_multi dfilter_multi_t;
+
+/* Number of guint32 words in a match mask for "n" filters */
+#define DFILTER_MULTI_MASK_WORDS(n)	(((n) + 31) / 32)
+
+/* Tests bit "i" of a match mask */
+#define DFILTER_MULTI_MASK_TEST(mask, i) \
+	(((mask)[(i) / 32] >> ((i) % 32)) & 1)
+
+WS_DLL_PUBLIC
+dfilter_multi_t *
+dfilter_multi_new(void);
+
+WS_DLL_PUBLIC
+void
+dfilter_multi_free(dfilter_multi_t *dfm);
+
+/* Adds a filter to the set and returns its index, counting from 0.
+ * The filter is not copied; it must stay valid until the set is
+ * cleared or freed. */
+WS_DLL_PUBLIC
+guint
+dfilter_multi_add(dfilter_multi_t *dfm, dfilter_t *df);
+
+/* Removes all filters from the set. */
+WS_DLL_PUBLIC
+void
+dfilter_multi_clear(dfilter_multi_t *dfm);
+
+WS_DLL_PUBLIC
+guint
+dfilter_multi_count(const dfilter_multi_t *dfm);
+
+/* Forgets the results for the previous packet. Must be called before
+ * testing a new packet with dfilter_multi_apply_one(). */
+WS_DLL_PUBLIC
+void
+dfilter_multi_reset(dfilter_multi_t *dfm);
+
+/* Returns whether filter "idx" matches the packet in "edt", running it
+ * only if it has not been run since the last dfilter_multi_reset(). */
+WS_DLL_PUBLIC
+gboolean
+dfilter_multi_apply_one(dfilter_multi_t *dfm, struct epan_dissect *edt, guint idx);
+
+/* Runs every filter in the set against the packet in "edt" and sets bit
+ * i of "matches", which must hold DFILTER_MULTI_MASK_WORDS(count) words,
+ * if filter i matches. Implies dfilter_multi_reset(). */
+WS_DLL_PUBLIC
+void
+dfilter_multi_apply_edt(dfilter_multi_t *dfm, struct epan_dissect *edt, guint32 *matches);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -10,8 +10,12 @@
 
 #include "dfvm.h"
 
+#include <string.h>
+
 #include <ftypes/ftypes-int.h>
 
+#define DFVM_INT_SIGN_BIAS	G_GUINT64_CONSTANT(0x8000000000000000)
+
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op)
 {
@@ -29,6 +33,11 @@ dfvm_insn_new(dfvm_opcode_t op)
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
+	if (v->borrowed) {
+		g_free(v);
+		return;
+	}
+
 	switch (v->type) {
 		case FVALUE:
 			FVALUE_FREE(v->value.fvalue);
@@ -36,6 +45,9 @@ dfvm_value_free(dfvm_value_t *v)
 		case DRANGE:
 			drange_free(v->value.drange);
 			break;
+		case INT_SET:
+			dfvm_int_set_free(v->value.intset);
+			break;
 		default:
 			/* nothing */
 			;
@@ -69,9 +81,121 @@ dfvm_value_new(dfvm_value_type_t type)
 
 	v = g_new(dfvm_value_t, 1);
 	v->type = type;
+	v->borrowed = FALSE;
 	return v;
 }
 
+static gint
+compare_range_lows(gconstpointer a, gconstpointer b)
+{
+	guint64 low_a = *(const guint64 *)a;
+	guint64 low_b = *(const guint64 *)b;
+
+	if (low_a < low_b)
+		return -1;
+	return low_a > low_b;
+}
+
+/* Builds a set from an array of guint64 (low, high) pairs, in any order
+ * and possibly overlapping. Pairs with low > high are empty and dropped.
+ * The array is sorted in place but not freed. */
+dfvm_int_set_t*
+dfvm_int_set_new(dfvm_int_kind_t kind, GArray *ranges)
+{
+	dfvm_int_set_t	*set;
+	guint		i, n, count;
+	guint64		low, high;
+
+	g_assert(ranges->len % 2 == 0);
+	count = ranges->len / 2;
+	qsort(ranges->data, count, 2 * sizeof(guint64), compare_range_lows);
+
+	set = g_new(dfvm_int_set_t, 1);
+	set->kind = kind;
+	set->bounds = g_new(guint64, ranges->len);
+	n = 0;
+	for (i = 0; i < count; i++) {
+		low = g_array_index(ranges, guint64, 2 * i);
+		high = g_array_index(ranges, guint64, 2 * i + 1);
+		if (low > high)
+			continue;
+		/* Merge with the previous range if they overlap or touch. */
+		if (n > 0 && set->bounds[2 * n - 1] != G_MAXUINT64 &&
+				low <= set->bounds[2 * n - 1] + 1) {
+			if (high > set->bounds[2 * n - 1])
+				set->bounds[2 * n - 1] = high;
+			continue;
+		}
+		if (n > 0 && set->bounds[2 * n - 1] == G_MAXUINT64)
+			continue;
+		set->bounds[2 * n] = low;
+		set->bounds[2 * n + 1] = high;
+		n++;
+	}
+	set->num_ranges = n;
+	return set;
+}
+
+void
+dfvm_int_set_free(dfvm_int_set_t *set)
+{
+	g_free(set->bounds);
+	g_free(set);
+}
+
+gboolean
+dfvm_int_set_contains(const dfvm_int_set_t *set, guint64 key)
+{
+	guint	lo = 0, hi = set->num_ranges, mid;
+
+	/* Binary search for the last range starting at or before key. */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (set->bounds[2 * mid] <= key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo > 0 && key <= set->bounds[2 * (lo - 1) + 1];
+}
+
+static void
+int_set_key_dump(FILE *f, dfvm_int_kind_t kind, guint64 key)
+{
+	switch (kind) {
+		case DFVM_INT_UINT32:
+		case DFVM_INT_UINT64:
+			fprintf(f, "%" G_GINT64_MODIFIER "u", key);
+			break;
+		case DFVM_INT_SINT32:
+		case DFVM_INT_SINT64:
+			fprintf(f, "%" G_GINT64_MODIFIER "d", (gint64)(key ^ DFVM_INT_SIGN_BIAS));
+			break;
+		case DFVM_INT_IPV4:
+			fprintf(f, "%u.%u.%u.%u",
+				(guint)(key >> 24) & 0xff, (guint)(key >> 16) & 0xff,
+				(guint)(key >> 8) & 0xff, (guint)key & 0xff);
+			break;
+	}
+}
+
+static void
+int_set_dump(FILE *f, const dfvm_int_set_t *set)
+{
+	guint	i;
+
+	fprintf(f, "{");
+	for (i = 0; i < set->num_ranges; i++) {
+		if (i > 0)
+			fprintf(f, " ");
+		int_set_key_dump(f, set->kind, set->bounds[2 * i]);
+		if (set->bounds[2 * i + 1] != set->bounds[2 * i]) {
+			fprintf(f, "..");
+			int_set_key_dump(f, set->kind, set->bounds[2 * i + 1]);
+		}
+	}
+	fprintf(f, "}");
+}
 
 void
 dfvm_dump(FILE *f, dfilter_t *df)
@@ -119,6 +243,7 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_IN_INT_SET:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -259,6 +384,13 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					arg3->value.numeric);
 				break;
 
+			case FIELD_IN_INT_SET:
+				fprintf(f, "%05d FIELD_IN_INT_SET\t%s in ",
+					id, arg1->value.hfinfo->abbrev);
+				int_set_dump(f, arg2->value.intset);
+				fprintf(f, "\n");
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -284,16 +416,197 @@ dfvm_dump(FILE *f, dfilter_t *df)
 	}
 }
 
-/* Reads a field from the proto_tree and loads the fvalues into a register,
- * if that field has not already been read. */
+/* Appends a constant exactly. The display filter representation is
+ * not enough: it drops IPv4 netmasks and IPv6 prefixes and rounds
+ * floating point values, so different constants could look the same.
+ * Returns FALSE for a constant that has no exact representation. */
+static gboolean
+signature_append_fvalue(GString *sig, fvalue_t *fv)
+{
+	char		*value_str;
+	guint64		bits;
+	guint		i;
+
+	g_string_append_printf(sig, "<%s>", fvalue_type_name(fv));
+	switch (fvalue_type_ftenum(fv)) {
+		case FT_IPv4:
+			g_string_append_printf(sig, "%08x/%08x",
+				fv->value.ipv4.addr, fv->value.ipv4.nmask);
+			break;
+		case FT_IPv6:
+			for (i = 0; i < sizeof fv->value.ipv6.addr.bytes; i++)
+				g_string_append_printf(sig, "%02x", fv->value.ipv6.addr.bytes[i]);
+			g_string_append_printf(sig, "/%u", fv->value.ipv6.prefix);
+			break;
+		case FT_FLOAT:
+		case FT_DOUBLE:
+			memcpy(&bits, &fv->value.floating, sizeof bits);
+			g_string_append_printf(sig, "%016" G_GINT64_MODIFIER "x", bits);
+			break;
+		case FT_ABSOLUTE_TIME:
+		case FT_RELATIVE_TIME:
+			g_string_append_printf(sig, "%" G_GINT64_MODIFIER "d.%09d",
+				(gint64)fv->value.time.secs, fv->value.time.nsecs);
+			break;
+		default:
+			/* Exact for integers, strings and byte strings. */
+			value_str = fvalue_to_string_repr(NULL, fv,
+				FTREPR_DFILTER, BASE_NONE);
+			if (!value_str)
+				return FALSE;
+			g_string_append(sig, value_str);
+			wmem_free(NULL, value_str);
+			break;
+	}
+	return TRUE;
+}
+
 static gboolean
-read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
+signature_append_value(GString *sig, const dfvm_value_t *v)
+{
+	GSList		*range_list;
+	drange_node	*range_item;
+	guint		i;
+
+	switch (v->type) {
+		case FVALUE:
+			return signature_append_fvalue(sig, v->value.fvalue);
+		case HFINFO:
+			g_string_append_printf(sig, "%s", v->value.hfinfo->abbrev);
+			break;
+		case INSN_NUMBER:
+		case REGISTER:
+		case INTEGER:
+			g_string_append_printf(sig, "%u", v->value.numeric);
+			break;
+		case DRANGE:
+			for (range_list = v->value.drange->range_list;
+			     range_list != NULL;
+			     range_list = range_list->next) {
+				range_item = (drange_node *)range_list->data;
+				g_string_append_printf(sig, "%d/%d/%d/%d,",
+					range_item->ending, range_item->start_offset,
+					range_item->length, range_item->end_offset);
+			}
+			break;
+		case FUNCTION_DEF:
+			g_string_append_printf(sig, "%s", v->value.funcdef->name);
+			break;
+		case INT_SET:
+			g_string_append_printf(sig, "%d", v->value.intset->kind);
+			for (i = 0; i < 2 * v->value.intset->num_ranges; i++) {
+				g_string_append_printf(sig, ",%" G_GINT64_MODIFIER "x",
+					v->value.intset->bounds[i]);
+			}
+			break;
+		case EMPTY:
+		default:
+			break;
+	}
+	return TRUE;
+}
+
+static gboolean
+signature_append_insns(GString *sig, GPtrArray *insns)
+{
+	dfvm_insn_t	*insn;
+	guint		id;
+
+	for (id = 0; id < insns->len; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(insns, id);
+		/* Compiled regular expressions print as their pattern,
+		 * which does not capture the compile flags; don't guess. */
+		if (insn->op == PUT_FVALUE &&
+		    fvalue_type_ftenum(insn->arg1->value.fvalue) == FT_PCRE)
+			return FALSE;
+		g_string_append_printf(sig, "%d(", insn->op);
+		if (insn->arg1 && !signature_append_value(sig, insn->arg1))
+			return FALSE;
+		g_string_append_c(sig, ';');
+		if (insn->arg2 && !signature_append_value(sig, insn->arg2))
+			return FALSE;
+		g_string_append_c(sig, ';');
+		if (insn->arg3 && !signature_append_value(sig, insn->arg3))
+			return FALSE;
+		g_string_append_c(sig, ';');
+		if (insn->arg4 && !signature_append_value(sig, insn->arg4))
+			return FALSE;
+		g_string_append(sig, ")\n");
+	}
+	return TRUE;
+}
+
+gchar*
+dfvm_signature(dfilter_t *df)
+{
+	GString		*sig;
+
+	sig = g_string_new(NULL);
+	if (!signature_append_insns(sig, df->consts) ||
+	    !signature_append_insns(sig, df->insns)) {
+		g_string_free(sig, TRUE);
+		return NULL;
+	}
+	return g_string_free(sig, FALSE);
+}
+
+dfvm_field_cache_t*
+dfvm_field_cache_new(void)
+{
+	dfvm_field_cache_t	*cache;
+
+	cache = g_new(dfvm_field_cache_t, 1);
+	cache->fields = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+		NULL, (GDestroyNotify)g_list_free);
+	return cache;
+}
+
+void
+dfvm_field_cache_reset(dfvm_field_cache_t *cache)
+{
+	g_hash_table_remove_all(cache->fields);
+}
+
+void
+dfvm_field_cache_free(dfvm_field_cache_t *cache)
+{
+	if (!cache)
+		return;
+	g_hash_table_destroy(cache->fields);
+	g_free(cache);
+}
+
+/* Collects the values of every field named like "hfinfo". */
+static GList*
+collect_fvalues(proto_tree *tree, header_field_info *hfinfo)
 {
 	GPtrArray	*finfos;
 	field_info	*finfo;
 	int		i, len;
 	GList		*fvalues = NULL;
-	gboolean	found_something = FALSE;
+
+	while (hfinfo) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos != NULL) {
+			len = finfos->len;
+			for (i = 0; i < len; i++) {
+				finfo = (field_info *)g_ptr_array_index(finfos, i);
+				fvalues = g_list_prepend(fvalues, &finfo->value);
+			}
+		}
+		hfinfo = hfinfo->same_name_next;
+	}
+	return fvalues;
+}
+
+/* Reads a field from the proto_tree and loads the fvalues into a register,
+ * if that field has not already been read. */
+static gboolean
+read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg,
+		dfvm_field_cache_t *cache)
+{
+	GList		*fvalues;
+	gpointer	cached;
 
 	/* Already loaded in this run of the dfilter? */
 	if (df->attempted_load[reg]) {
@@ -307,26 +620,22 @@ read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
 
 	df->attempted_load[reg] = TRUE;
 
-	while (hfinfo) {
-		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
-		if ((finfos == NULL) || (g_ptr_array_len(finfos) == 0)) {
-			hfinfo = hfinfo->same_name_next;
-			continue;
+	if (cache) {
+		/* Another filter in the set may have read it already. */
+		if (g_hash_table_lookup_extended(cache->fields, hfinfo, NULL, &cached)) {
+			fvalues = (GList *)cached;
 		}
 		else {
-			found_something = TRUE;
-		}
-
-		len = finfos->len;
-		for (i = 0; i < len; i++) {
-			finfo = (field_info *)g_ptr_array_index(finfos, i);
-			fvalues = g_list_prepend(fvalues, &finfo->value);
+			fvalues = collect_fvalues(tree, hfinfo);
+			g_hash_table_insert(cache->fields, hfinfo, fvalues);
 		}
-
-		hfinfo = hfinfo->same_name_next;
+		df->cached_list[reg] = TRUE;
+	}
+	else {
+		fvalues = collect_fvalues(tree, hfinfo);
 	}
 
-	if (!found_something) {
+	if (!fvalues) {
 		return FALSE;
 	}
 
@@ -400,6 +709,54 @@ any_in_range(dfilter_t *df, int reg1, int reg2, int reg3)
 	return FALSE;
 }
 
+/* Tests the values of a field directly against a compiled set of
+ * integer keys, without loading them into a register first. */
+static gboolean
+field_in_int_set(proto_tree *tree, header_field_info *hfinfo,
+		const dfvm_int_set_t *set)
+{
+	GPtrArray	*finfos;
+	fvalue_t	*fv;
+	guint64		key;
+	guint		i;
+
+	while (hfinfo) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos != NULL) {
+			for (i = 0; i < finfos->len; i++) {
+				fv = &((field_info *)g_ptr_array_index(finfos, i))->value;
+				switch (set->kind) {
+					case DFVM_INT_UINT32:
+						key = fv->value.uinteger;
+						break;
+					case DFVM_INT_UINT64:
+						key = fv->value.uinteger64;
+						break;
+					case DFVM_INT_SINT32:
+						key = (guint64)(gint64)fv->value.sinteger ^ DFVM_INT_SIGN_BIAS;
+						break;
+					case DFVM_INT_SINT64:
+						key = (guint64)fv->value.sinteger64 ^ DFVM_INT_SIGN_BIAS;
+						break;
+					case DFVM_INT_IPV4:
+						/* Field values always carry a /32 mask;
+						 * constant masks were folded into the set. */
+						key = fv->value.ipv4.addr;
+						break;
+					default:
+						g_assert_not_reached();
+						return FALSE;
+				}
+				if (dfvm_int_set_contains(set, key)) {
+					return TRUE;
+				}
+			}
+		}
+		hfinfo = hfinfo->same_name_next;
+	}
+	return FALSE;
+}
+
 
 static void
 free_owned_register(gpointer data, gpointer user_data _U_)
@@ -422,9 +779,12 @@ free_register_overhead(dfilter_t* df)
 				g_list_foreach(df->registers[i], free_owned_register, NULL);
 				df->owns_memory[i] = FALSE;
 			}
-			g_list_free(df->registers[i]);
+			if (!df->cached_list[i]) {
+				g_list_free(df->registers[i]);
+			}
 			df->registers[i] = NULL;
 		}
+		df->cached_list[i] = FALSE;
 	}
 }
 
@@ -459,7 +819,7 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+dfvm_apply(dfilter_t *df, proto_tree *tree, dfvm_field_cache_t *cache)
 {
 	int		id, length;
 	gboolean	accum = TRUE;
@@ -471,6 +831,7 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	header_field_info	*hfinfo;
 	GList		*param1;
 	GList		*param2;
+	gpointer	cached;
 
 	g_assert(tree);
 
@@ -486,6 +847,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 		switch (insn->op) {
 			case CHECK_EXISTS:
 				hfinfo = arg1->value.hfinfo;
+				if (cache && g_hash_table_lookup_extended(cache->fields,
+						hfinfo, NULL, &cached)) {
+					accum = (cached != NULL);
+					break;
+				}
 				while(hfinfo) {
 					accum = proto_check_for_protocol_or_field(tree,
 							hfinfo->id);
@@ -500,7 +866,8 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case READ_TREE:
 				accum = read_tree(df, tree,
-						arg1->value.hfinfo, arg2->value.numeric);
+						arg1->value.hfinfo, arg2->value.numeric,
+						cache);
 				break;
 
 			case CALL_FUNCTION:
@@ -579,6 +946,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg3->value.numeric);
 				break;
 
+			case FIELD_IN_INT_SET:
+				accum = field_in_int_set(tree,
+						arg1->value.hfinfo, arg2->value.intset);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -654,6 +1026,7 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_IN_INT_SET:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
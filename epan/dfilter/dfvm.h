@@ -23,9 +23,31 @@ typedef enum {
 	REGISTER,
 	INTEGER,
 	DRANGE,
-	FUNCTION_DEF
+	FUNCTION_DEF,
+	INT_SET
 } dfvm_value_type_t;
 
+/* How the values of a field are mapped onto the 64-bit keys of a
+ * dfvm_int_set_t. Signed values are biased so that unsigned order
+ * matches signed order. */
+typedef enum {
+	DFVM_INT_UINT32,	/* fvalue uinteger */
+	DFVM_INT_UINT64,	/* fvalue uinteger64 */
+	DFVM_INT_SINT32,	/* fvalue sinteger */
+	DFVM_INT_SINT64,	/* fvalue sinteger64 */
+	DFVM_INT_IPV4		/* fvalue ipv4 address, host order */
+} dfvm_int_kind_t;
+
+/* A set of integer keys, as a sorted array of disjoint, non-adjacent
+ * inclusive [low, high] ranges. Comparisons of an integer or IPv4 field
+ * against constants (==, !=, <, <=, >, >=, and "in" sets) are compiled
+ * into one of these. */
+typedef struct {
+	dfvm_int_kind_t	kind;
+	guint		num_ranges;
+	guint64		*bounds;	/* low0, high0, low1, high1, ... */
+} dfvm_int_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -35,7 +57,9 @@ typedef struct {
 		drange_t		*drange;
 		header_field_info	*hfinfo;
         df_func_def_t   *funcdef;
+		dfvm_int_set_t		*intset;
 	} value;
+	gboolean		borrowed;	/* value belongs to someone else */
 
 } dfvm_value_t;
 
@@ -60,7 +84,8 @@ typedef enum {
 	ANY_MATCHES,
 	MK_RANGE,
 	CALL_FUNCTION,
-	ANY_IN_RANGE
+	ANY_IN_RANGE,
+	FIELD_IN_INT_SET
 
 } dfvm_opcode_t;
 
@@ -82,13 +107,45 @@ dfvm_insn_free(dfvm_insn_t *insn);
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type);
 
+/* Field values read from one proto_tree, shared by the filters of a
+ * dfilter_multi_t so that each field is looked up only once per tree. */
+typedef struct {
+	GHashTable	*fields;	/* header_field_info * -> GList * of fvalue_t * */
+} dfvm_field_cache_t;
+
+dfvm_field_cache_t*
+dfvm_field_cache_new(void);
+
+void
+dfvm_field_cache_reset(dfvm_field_cache_t *cache);
+
+void
+dfvm_field_cache_free(dfvm_field_cache_t *cache);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
+/* Returns a string that is equal for two filters exactly when their
+ * programs are, or NULL if the program cannot be represented.
+ * The string is allocated with g_malloc(). */
+gchar*
+dfvm_signature(dfilter_t *df);
+
+/* Runs the program against "tree". If "cache" is not NULL, fields are
+ * read through it instead of straight from the tree. */
 gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree);
+dfvm_apply(dfilter_t *df, proto_tree *tree, dfvm_field_cache_t *cache);
 
 void
 dfvm_init_const(dfilter_t *df);
 
+dfvm_int_set_t*
+dfvm_int_set_new(dfvm_int_kind_t kind, GArray *ranges);
+
+void
+dfvm_int_set_free(dfvm_int_set_t *set);
+
+gboolean
+dfvm_int_set_contains(const dfvm_int_set_t *set, guint64 key);
+
 #endif
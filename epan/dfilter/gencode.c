@@ -17,6 +17,7 @@
 #include "sttype-set.h"
 #include "sttype-function.h"
 #include "ftypes/ftypes.h"
+#include "ftypes/ftypes-int.h"
 
 static void
 gencode(dfwork_t *dfw, stnode_t *st_node);
@@ -40,6 +41,19 @@ dfw_append_const(dfwork_t *dfw, dfvm_insn_t *insn)
 	g_ptr_array_add(dfw->consts, insn);
 }
 
+/* Records the FIELD_ID of a field, and of all fields with the same
+ * name, in the hash of interesting fields. */
+static void
+dfw_add_interesting_fields(dfwork_t *dfw, header_field_info *hfinfo)
+{
+	while (hfinfo) {
+		g_hash_table_insert(dfw->interesting_fields,
+			GINT_TO_POINTER(hfinfo->id),
+			GUINT_TO_POINTER(TRUE));
+		hfinfo = hfinfo->same_name_next;
+	}
+}
+
 /* returns register number */
 static int
 dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo)
@@ -85,13 +99,7 @@ dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo)
 	dfw_append_insn(dfw, insn);
 
 	if (added_new_hfinfo) {
-		while (hfinfo) {
-			/* Record the FIELD_ID in hash of interesting fields. */
-			g_hash_table_insert(dfw->interesting_fields,
-			    GINT_TO_POINTER(hfinfo->id),
-			    GUINT_TO_POINTER(TRUE));
-			hfinfo = hfinfo->same_name_next;
-		}
+		dfw_add_interesting_fields(dfw, hfinfo);
 	}
 
 	return reg;
@@ -108,6 +116,7 @@ dfw_append_put_fvalue(dfwork_t *dfw, fvalue_t *fv)
 	insn = dfvm_insn_new(PUT_FVALUE);
 	val1 = dfvm_value_new(FVALUE);
 	val1->value.fvalue = fv;
+	val1->borrowed = dfw->keep_tree;
 	val2 = dfvm_value_new(REGISTER);
 	reg = dfw->first_constant--;
 	val2->value.numeric = reg;
@@ -145,9 +154,11 @@ dfw_append_mk_range(dfwork_t *dfw, stnode_t *node, dfvm_value_t **p_jmp)
 
 	val = dfvm_value_new(DRANGE);
 	val->value.drange = sttype_range_drange(node);
+	val->borrowed = dfw->keep_tree;
 	insn->arg3 = val;
 
-	sttype_range_remove_drange(node);
+	if (!dfw->keep_tree)
+		sttype_range_remove_drange(node);
 
 	dfw_append_insn(dfw, insn);
 
@@ -276,6 +287,224 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_ar
 	}
 }
 
+static gboolean
+int_kind_for_ftype(enum ftenum ftype, dfvm_int_kind_t *p_kind)
+{
+	if (IS_FT_UINT32(ftype))
+		*p_kind = DFVM_INT_UINT32;
+	else if (IS_FT_UINT64(ftype))
+		*p_kind = DFVM_INT_UINT64;
+	else if (IS_FT_INT32(ftype))
+		*p_kind = DFVM_INT_SINT32;
+	else if (IS_FT_INT64(ftype))
+		*p_kind = DFVM_INT_SINT64;
+	else if (ftype == FT_IPv4)
+		*p_kind = DFVM_INT_IPV4;
+	else
+		return FALSE;
+	return TRUE;
+}
+
+/* If st_arg is a field whose values (including those of all other fields
+ * with the same name) can all be tested as integer keys of one kind,
+ * returns the first field of that name and sets *p_kind. */
+static header_field_info *
+int_set_field(stnode_t *st_arg, dfvm_int_kind_t *p_kind)
+{
+	header_field_info	*hfinfo, *first;
+	dfvm_int_kind_t		kind;
+
+	if (stnode_type_id(st_arg) != STTYPE_FIELD)
+		return NULL;
+
+	first = (header_field_info*)stnode_data(st_arg);
+	while (first->same_name_prev_id != -1) {
+		first = proto_registrar_get_nth(first->same_name_prev_id);
+	}
+
+	if (!int_kind_for_ftype(first->type, p_kind))
+		return NULL;
+	for (hfinfo = first->same_name_next; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (!int_kind_for_ftype(hfinfo->type, &kind) || kind != *p_kind)
+			return NULL;
+	}
+	return first;
+}
+
+/* Gets the range of keys that compare equal to a constant: a single
+ * key for integers, and every address in the subnet for IPv4. */
+static gboolean
+int_set_const_range(stnode_t *st_arg, dfvm_int_kind_t kind,
+		guint64 *p_low, guint64 *p_high)
+{
+	fvalue_t	*fv;
+	dfvm_int_kind_t	const_kind;
+
+	if (stnode_type_id(st_arg) != STTYPE_FVALUE)
+		return FALSE;
+	fv = (fvalue_t*)stnode_data(st_arg);
+	if (!int_kind_for_ftype(fvalue_type_ftenum(fv), &const_kind) || const_kind != kind)
+		return FALSE;
+
+	switch (kind) {
+		case DFVM_INT_UINT32:
+			*p_low = *p_high = fv->value.uinteger;
+			break;
+		case DFVM_INT_UINT64:
+			*p_low = *p_high = fv->value.uinteger64;
+			break;
+		case DFVM_INT_SINT32:
+			*p_low = *p_high = (guint64)(gint64)fv->value.sinteger ^ G_GUINT64_CONSTANT(0x8000000000000000);
+			break;
+		case DFVM_INT_SINT64:
+			*p_low = *p_high = (guint64)fv->value.sinteger64 ^ G_GUINT64_CONSTANT(0x8000000000000000);
+			break;
+		case DFVM_INT_IPV4:
+			*p_low = fv->value.ipv4.addr & fv->value.ipv4.nmask;
+			*p_high = *p_low | (~fv->value.ipv4.nmask & 0xffffffff);
+			break;
+	}
+	return TRUE;
+}
+
+static void
+int_set_add_range(GArray *ranges, guint64 low, guint64 high)
+{
+	g_array_append_val(ranges, low);
+	g_array_append_val(ranges, high);
+}
+
+static void
+dfw_append_field_in_int_set(dfwork_t *dfw, header_field_info *hfinfo,
+		dfvm_int_kind_t kind, GArray *ranges)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2;
+
+	insn = dfvm_insn_new(FIELD_IN_INT_SET);
+	val1 = dfvm_value_new(HFINFO);
+	val1->value.hfinfo = hfinfo;
+	val2 = dfvm_value_new(INT_SET);
+	val2->value.intset = dfvm_int_set_new(kind, ranges);
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	dfw_add_interesting_fields(dfw, hfinfo);
+}
+
+/* Try to generate a single FIELD_IN_INT_SET instruction for an ordering
+ * or equality test of an integer or IPv4 field against a constant, which
+ * tests the field values in place instead of loading them into a register
+ * and comparing fvalues one pair at a time. Returns FALSE, having generated
+ * nothing, if the relation doesn't have that shape. */
+static gboolean
+gen_relation_int_set(dfwork_t *dfw, test_op_t op, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	header_field_info	*hfinfo;
+	dfvm_int_kind_t		kind;
+	guint64			low, high;
+	GArray			*ranges;
+
+	if (!dfw->specialize)
+		return FALSE;
+
+	hfinfo = int_set_field(st_arg1, &kind);
+	if (hfinfo == NULL) {
+		/* Try "constant <op> field", mirroring the operator. */
+		hfinfo = int_set_field(st_arg2, &kind);
+		if (hfinfo == NULL)
+			return FALSE;
+		st_arg2 = st_arg1;
+		switch (op) {
+			case TEST_OP_GT: op = TEST_OP_LT; break;
+			case TEST_OP_GE: op = TEST_OP_LE; break;
+			case TEST_OP_LT: op = TEST_OP_GT; break;
+			case TEST_OP_LE: op = TEST_OP_GE; break;
+			default: break;
+		}
+	}
+	if (!int_set_const_range(st_arg2, kind, &low, &high))
+		return FALSE;
+
+	/* The set of field values for which the test is true. */
+	ranges = g_array_new(FALSE, FALSE, sizeof(guint64));
+	switch (op) {
+		case TEST_OP_EQ:
+			int_set_add_range(ranges, low, high);
+			break;
+		case TEST_OP_NE:
+			if (low > 0)
+				int_set_add_range(ranges, 0, low - 1);
+			if (high < G_MAXUINT64)
+				int_set_add_range(ranges, high + 1, G_MAXUINT64);
+			break;
+		case TEST_OP_GT:
+			if (high < G_MAXUINT64)
+				int_set_add_range(ranges, high + 1, G_MAXUINT64);
+			break;
+		case TEST_OP_GE:
+			int_set_add_range(ranges, low, G_MAXUINT64);
+			break;
+		case TEST_OP_LT:
+			if (low > 0)
+				int_set_add_range(ranges, 0, low - 1);
+			break;
+		case TEST_OP_LE:
+			int_set_add_range(ranges, 0, high);
+			break;
+		default:
+			g_array_free(ranges, TRUE);
+			return FALSE;
+	}
+
+	dfw_append_field_in_int_set(dfw, hfinfo, kind, ranges);
+	g_array_free(ranges, TRUE);
+	return TRUE;
+}
+
+/* Like gen_relation_int_set(), for the "in" operator with a set made
+ * up only of constants and ranges of constants. The elements are merged
+ * into one sorted set, so the test is a binary search rather than a
+ * chain of ANY_EQ and ANY_IN_RANGE instructions. */
+static gboolean
+gen_relation_in_int_set(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	header_field_info	*hfinfo;
+	dfvm_int_kind_t		kind;
+	guint64			low, high, unused;
+	GSList			*nodelist;
+	stnode_t		*node1, *node2;
+	GArray			*ranges;
+
+	if (!dfw->specialize)
+		return FALSE;
+
+	hfinfo = int_set_field(st_arg1, &kind);
+	if (hfinfo == NULL)
+		return FALSE;
+
+	ranges = g_array_new(FALSE, FALSE, sizeof(guint64));
+	nodelist = (GSList*)stnode_data(st_arg2);
+	while (nodelist) {
+		node1 = (stnode_t*)nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		node2 = (stnode_t*)nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (!int_set_const_range(node1, kind, &low, &high) ||
+		    (node2 && !int_set_const_range(node2, kind, &unused, &high))) {
+			g_array_free(ranges, TRUE);
+			return FALSE;
+		}
+		int_set_add_range(ranges, low, high);
+	}
+
+	dfw_append_field_in_int_set(dfw, hfinfo, kind, ranges);
+	g_array_free(ranges, TRUE);
+	return TRUE;
+}
+
 static void
 fixup_jumps(gpointer data, gpointer user_data)
 {
@@ -304,7 +533,10 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 	reg1 = gen_entity(dfw, st_arg1, &jmp1);
 
 	/* Create code for the set on the RHS of the relation */
-	nodelist_head = nodelist = (GSList*)stnode_steal_data(st_arg2);
+	if (dfw->keep_tree)
+		nodelist_head = nodelist = (GSList*)stnode_data(st_arg2);
+	else
+		nodelist_head = nodelist = (GSList*)stnode_steal_data(st_arg2);
 	while (nodelist) {
 		node1 = (stnode_t*)nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -365,7 +597,8 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 
 	/* Clean up */
 	g_slist_free(jumplist);
-	set_nodelist_free(nodelist_head);
+	if (!dfw->keep_tree)
+		set_nodelist_free(nodelist_head);
 }
 
 /* Parse an entity, returning the reg that it gets put into.
@@ -392,7 +625,10 @@ gen_entity(dfwork_t *dfw, stnode_t *st_arg, dfvm_value_t **p_jmp)
 		dfw_append_insn(dfw, insn);
 	}
 	else if (e_type == STTYPE_FVALUE) {
-		reg = dfw_append_put_fvalue(dfw, (fvalue_t *)stnode_steal_data(st_arg));
+		if (dfw->keep_tree)
+			reg = dfw_append_put_fvalue(dfw, (fvalue_t *)stnode_data(st_arg));
+		else
+			reg = dfw_append_put_fvalue(dfw, (fvalue_t *)stnode_steal_data(st_arg));
 	}
 	else if (e_type == STTYPE_RANGE) {
 		reg = dfw_append_mk_range(dfw, st_arg, p_jmp);
@@ -438,13 +674,7 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			insn->arg1 = val1;
 			dfw_append_insn(dfw, insn);
 
-			/* Record the FIELD_ID in hash of interesting fields. */
-			while (hfinfo) {
-				g_hash_table_insert(dfw->interesting_fields,
-					GINT_TO_POINTER(hfinfo->id),
-					GUINT_TO_POINTER(TRUE));
-				hfinfo = hfinfo->same_name_next;
-			}
+			dfw_add_interesting_fields(dfw, hfinfo);
 
 			break;
 
@@ -479,27 +709,33 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_EQ:
-			gen_relation(dfw, ANY_EQ, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_EQ, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_NE:
-			gen_relation(dfw, ANY_NE, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_NE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_GT:
-			gen_relation(dfw, ANY_GT, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_GT, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_GE:
-			gen_relation(dfw, ANY_GE, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_GE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_LT:
-			gen_relation(dfw, ANY_LT, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_LT, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_LE:
-			gen_relation(dfw, ANY_LE, st_arg1, st_arg2);
+			if (!gen_relation_int_set(dfw, st_op, st_arg1, st_arg2))
+				gen_relation(dfw, ANY_LE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_BITWISE_AND:
@@ -515,7 +751,8 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_IN:
-			gen_relation_in(dfw, st_arg1, st_arg2);
+			if (!gen_relation_in_int_set(dfw, st_arg1, st_arg2))
+				gen_relation_in(dfw, st_arg1, st_arg2);
 			break;
 	}
 }
@@ -544,6 +781,14 @@ dfw_gencode(dfwork_t *dfw)
 	dfvm_insn_t	*insn, *insn1, *prev;
 	dfvm_value_t	*arg1;
 
+	/* Start afresh if code was generated before, for another operand. */
+	if (dfw->loaded_fields)
+		g_hash_table_destroy(dfw->loaded_fields);
+	if (dfw->interesting_fields)
+		g_hash_table_destroy(dfw->interesting_fields);
+	dfw->next_register = 0;
+	dfw->first_constant = -1;
+
 	dfw->insns = g_ptr_array_new();
 	dfw->consts = g_ptr_array_new();
 	dfw->loaded_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
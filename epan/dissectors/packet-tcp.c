@@ -7794,6 +7794,9 @@ proto_register_tcp(void)
     register_init_routine(tcp_init);
     reassembly_table_register(&tcp_reassembly_table,
                           &addresses_ports_reassembly_table_functions);
+    /* Long streams can collect many out-of-order segments per PDU. */
+    reassembly_table_set_fragment_store(&tcp_reassembly_table,
+                                        REASSEMBLY_STORE_INDEXED);
 
     register_decode_as(&tcp_da);
 
@@ -50,11 +50,13 @@ typedef enum {
    number unknown".
 
    There is one of these structures for every frame in the capture.
-   That means a lot of memory if we have a lot of frames.
-   They are packed into power-of-2 chunks, so their size is effectively
-   rounded up to a power of 2.
-   Try to keep it close to, and less than or equal to, a power of 2.
-   "Smaller than a power of 2" is OK for ILP32 platforms.
+   That means a lot of memory if we have a lot of frames; at 100 million
+   frames every 8 bytes here is most of a gigabyte.  They are stored in
+   arrays of 1024 by frame_data_sequence, and callers keep pointers to
+   them, so they can't be packed any further than the structure itself.
+   Keep it free of padding, and keep anything that isn't needed for
+   every frame out of it; the time shift offsets, for example, are kept
+   by the frame_data_sequence, see frame_data_sequence_get_shift_offset().
 
    XXX - shuffle the fields to try to keep the most commonly-accessed
    fields within the first 16 or 32 bytes, so they all fit in a cache
@@ -88,9 +90,9 @@ typedef struct _frame_data {
   unsigned int has_user_comment : 1; /** 1 = user set (also deleted) comment for this packet */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+  /* Fills the 32 bits after subnum and the bitfields, before abs_ts. */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
 DIAG_ON_PEDANTIC
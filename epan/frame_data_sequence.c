@@ -32,6 +32,9 @@
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
   void        *ptree_root;      /* Pointer to the root node */
+  gsize        node_bytes;      /* Bytes allocated for the nodes */
+  GArray      *shift_offsets;   /* nstime_t for each frame, from frame 1,
+                                   or NULL if no frame has been shifted */
 };
 
 /*
@@ -55,9 +58,24 @@ new_frame_data_sequence(void)
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
   fds->ptree_root = NULL;
+  fds->node_bytes = 0;
+  fds->shift_offsets = NULL;
   return fds;
 }
 
+/*
+ * Allocate a node of NODES_PER_LEVEL elements; the nodes above the
+ * leaves start out with null pointers.
+ */
+static void *
+alloc_node(frame_data_sequence *fds, gsize elem_size, gboolean leaf)
+{
+  gsize size = elem_size*NODES_PER_LEVEL;
+
+  fds->node_bytes += size;
+  return leaf ? g_malloc(size) : g_malloc0(size);
+}
+
 /*
  * Add a new frame_data structure to a frame_data_sequence.
  */
@@ -80,7 +98,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
   if (fds->count == 0) {
     /* The tree is empty; allocate the first leaf node, which will be
        the root node. */
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
     node = &leaf[0];
     fds->ptree_root = leaf;
   } else if (fds->count < NODES_PER_LEVEL) {
@@ -89,9 +107,9 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     node = &leaf[fds->count];
   } else if (fds->count == NODES_PER_LEVEL) {
     /* It's a 1-level tree that will turn into a 2-level tree. */
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
+    level1 = (frame_data **)alloc_node(fds, sizeof *level1, FALSE);
     level1[0] = (frame_data *)fds->ptree_root;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
     level1[1] = leaf;
     node = &leaf[0];
     fds->ptree_root = level1;
@@ -100,17 +118,17 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level1 = (frame_data **)fds->ptree_root;
     leaf = level1[fds->count >> LOG2_NODES_PER_LEVEL];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
       level1[fds->count >> LOG2_NODES_PER_LEVEL] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
   } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL) {
     /* It's a 2-level tree that will turn into a 3-level tree */
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
+    level2 = (frame_data ***)alloc_node(fds, sizeof *level2, FALSE);
     level2[0] = (frame_data **)fds->ptree_root;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
+    level1 = (frame_data **)alloc_node(fds, sizeof *level1, FALSE);
     level2[1] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
     level1[0] = leaf;
     node = &leaf[0];
     fds->ptree_root = level2;
@@ -119,24 +137,24 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level2 = (frame_data ***)fds->ptree_root;
     level1 = level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
     if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
+      level1 = (frame_data **)alloc_node(fds, sizeof *level1, FALSE);
       level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)] = level1;
     }
     leaf = level1[LEVEL_1_INDEX(fds->count)];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
       level1[LEVEL_1_INDEX(fds->count)] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
   } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
     /* It's a 3-level tree that will turn into a 4-level tree */
-    level3 = (frame_data ****)g_malloc0((sizeof *level3)*NODES_PER_LEVEL);
+    level3 = (frame_data ****)alloc_node(fds, sizeof *level3, FALSE);
     level3[0] = (frame_data ***)fds->ptree_root;
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
+    level2 = (frame_data ***)alloc_node(fds, sizeof *level2, FALSE);
     level3[1] = level2;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
+    level1 = (frame_data **)alloc_node(fds, sizeof *level1, FALSE);
     level2[0] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
     level1[0] = leaf;
     node = &leaf[0];
     fds->ptree_root = level3;
@@ -152,17 +170,17 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level3 = (frame_data ****)fds->ptree_root;
     level2 = level3[LEVEL_3_INDEX(fds->count)];
     if (level2 == NULL) {
-      level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
+      level2 = (frame_data ***)alloc_node(fds, sizeof *level2, FALSE);
       level3[LEVEL_3_INDEX(fds->count)] = level2;
     }
     level1 = level2[LEVEL_2_INDEX(fds->count)];
     if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
+      level1 = (frame_data **)alloc_node(fds, sizeof *level1, FALSE);
       level2[LEVEL_2_INDEX(fds->count)] = level1;
     }
     leaf = level1[LEVEL_1_INDEX(fds->count)];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = (frame_data *)alloc_node(fds, sizeof *leaf, TRUE);
       level1[LEVEL_1_INDEX(fds->count)] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
@@ -307,10 +325,53 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  if (fds->shift_offsets)
+    g_array_free(fds->shift_offsets, TRUE);
+
   /* free the header struct */
   g_free(fds);
 }
 
+gsize
+frame_data_sequence_memory_size(const frame_data_sequence *fds)
+{
+  gsize size = sizeof *fds + fds->node_bytes;
+
+  if (fds->shift_offsets)
+    size += fds->shift_offsets->len * sizeof (nstime_t);
+  return size;
+}
+
+void
+frame_data_sequence_get_shift_offset(const frame_data_sequence *fds,
+    guint32 num, nstime_t *shift_offset)
+{
+  if (fds->shift_offsets && num != 0 && num <= fds->shift_offsets->len)
+    *shift_offset = g_array_index(fds->shift_offsets, nstime_t, num - 1);
+  else
+    nstime_set_zero(shift_offset);
+}
+
+void
+frame_data_sequence_set_shift_offset(frame_data_sequence *fds,
+    guint32 num, const nstime_t *shift_offset)
+{
+  if (num == 0)
+    return;
+  if (!fds->shift_offsets || num > fds->shift_offsets->len) {
+    /* Unshifted frames past the end are zero already. */
+    if (shift_offset->secs == 0 && shift_offset->nsecs == 0)
+      return;
+    /* Shifts usually apply to every frame, so make room for all of them
+       at once. */
+    if (!fds->shift_offsets)
+      fds->shift_offsets = g_array_sized_new(FALSE, TRUE, sizeof (nstime_t),
+          MAX(fds->count, num));
+    g_array_set_size(fds->shift_offsets, MAX(fds->count, num));
+  }
+  g_array_index(fds->shift_offsets, nstime_t, num - 1) = *shift_offset;
+}
+
 void
 find_and_mark_frame_depended_upon(gpointer data, gpointer user_data)
 {
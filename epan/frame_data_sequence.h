@@ -28,6 +28,25 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_add(frame_data_sequence *fds,
 WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
     guint32 num);
 
+/*
+ * Get the number of bytes allocated for a frame_data_sequence and the
+ * frame_data structures in it, not counting per-frame data they point to.
+ */
+WS_DLL_PUBLIC gsize frame_data_sequence_memory_size(const frame_data_sequence *fds);
+
+/*
+ * Get or set how much a frame's time stamp has been shifted, i.e. its
+ * abs_ts minus the time stamp in the file.  Setting it doesn't change
+ * abs_ts; the caller does that.  Once any frame has been shifted, the
+ * offsets of all the frames are kept here, rather than in the frame_data
+ * structures; they're freed with the sequence, so they outlive
+ * redissection.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_get_shift_offset(const frame_data_sequence *fds,
+    guint32 num, nstime_t *shift_offset);
+WS_DLL_PUBLIC void frame_data_sequence_set_shift_offset(frame_data_sequence *fds,
+    guint32 num, const nstime_t *shift_offset);
+
 /*
  * Free a frame_data_sequence and all the frame_data structures in it.
  */
@@ -0,0 +1,188 @@
+/* frame_data_sequence_test.c
+ * Standalone program to test frame_data_sequence and the frame_data side
+ * tables.  Given a number of frames, it also reports the memory used per
+ * frame for a capture that long, e.g. "frame_data_sequence_test 100000000".
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wiretap/wtap.h>
+
+#include "frame_data.h"
+#include "frame_data_sequence.h"
+
+static gboolean failed = FALSE;
+
+static frame_data_sequence *
+make_sequence(guint32 count)
+{
+	frame_data_sequence *fds = new_frame_data_sequence();
+	wtap_rec rec;
+	frame_data fdlocal;
+	guint32 cum_bytes = 0;
+	gint64 offset = 24;
+	guint32 i;
+
+	memset(&rec, 0, sizeof rec);
+	rec.rec_type = REC_TYPE_PACKET;
+	rec.presence_flags = WTAP_HAS_TS;
+	rec.tsprec = WTAP_TSPREC_USEC;
+	for (i = 1; i <= count; i++) {
+		rec.ts.secs = 1500000000 + i / 1000;
+		rec.ts.nsecs = (i % 1000) * 1000000;
+		rec.rec_header.packet_header.len = 60 + i % 1400;
+		rec.rec_header.packet_header.caplen = rec.rec_header.packet_header.len;
+		frame_data_init(&fdlocal, i, &rec, offset, cum_bytes);
+		cum_bytes = fdlocal.cum_bytes;
+		offset += 16 + rec.rec_header.packet_header.caplen;
+		frame_data_sequence_add(fds, &fdlocal);
+	}
+	return fds;
+}
+
+static void
+test_count(guint32 count)
+{
+	frame_data_sequence *fds = make_sequence(count);
+	frame_data *fdata;
+	gint64 offset = 24;
+	guint32 i;
+
+	for (i = 1; i <= count; i++) {
+		fdata = frame_data_sequence_find(fds, i);
+		if (!fdata || fdata->num != i || fdata->file_off != offset ||
+		    fdata->pkt_len != 60 + i % 1400 ||
+		    fdata->abs_ts.secs != 1500000000 + i / 1000) {
+			printf("Failed finding frame %u of %u\n", i, count);
+			failed = TRUE;
+			break;
+		}
+		offset += 16 + fdata->cap_len;
+	}
+	if (frame_data_sequence_find(fds, 0) != NULL ||
+	    frame_data_sequence_find(fds, count + 1) != NULL) {
+		printf("Failed: found a frame that isn't in %u\n", count);
+		failed = TRUE;
+	}
+	if (frame_data_sequence_memory_size(fds) < (gsize)count * sizeof(frame_data)) {
+		printf("Failed: %u frames in %" G_GSIZE_FORMAT " bytes\n", count,
+		       frame_data_sequence_memory_size(fds));
+		failed = TRUE;
+	}
+	free_frame_data_sequence(fds);
+}
+
+static void
+test_shift_offset(void)
+{
+	frame_data_sequence *fds = make_sequence(3000);
+	frame_data *fdata;
+	nstime_t offset, got;
+	guint32 i;
+
+	/* Shift every third frame by its number of seconds. */
+	for (i = 3; i <= 3000; i += 3) {
+		nstime_set_zero(&offset);
+		offset.secs = i;
+		frame_data_sequence_set_shift_offset(fds, i, &offset);
+	}
+	/* Then unshift every sixth one. */
+	nstime_set_zero(&offset);
+	for (i = 6; i <= 3000; i += 6)
+		frame_data_sequence_set_shift_offset(fds, i, &offset);
+
+	/* Redissection destroys the frames' per-packet data, but not their
+	 * offsets. */
+	for (i = 1; i <= 3000; i++) {
+		fdata = frame_data_sequence_find(fds, i);
+		frame_data_destroy(fdata);
+	}
+
+	for (i = 1; i <= 3000; i++) {
+		frame_data_sequence_get_shift_offset(fds, i, &got);
+		if (i % 3 == 0 && i % 6 != 0) {
+			if (got.secs != (time_t)i || got.nsecs != 0) {
+				printf("Failed: frame %u isn't shifted by %u s\n", i, i);
+				failed = TRUE;
+			}
+		} else if (!nstime_is_zero(&got)) {
+			printf("Failed: frame %u is shifted\n", i);
+			failed = TRUE;
+		}
+	}
+
+	/* Past the last frame, and frame 0, aren't shifted. */
+	frame_data_sequence_get_shift_offset(fds, 3001, &got);
+	if (!nstime_is_zero(&got)) {
+		printf("Failed: frame 3001 is shifted\n");
+		failed = TRUE;
+	}
+	frame_data_sequence_get_shift_offset(fds, 0, &got);
+	if (!nstime_is_zero(&got)) {
+		printf("Failed: frame 0 is shifted\n");
+		failed = TRUE;
+	}
+
+	/* Frees the offsets, too. */
+	free_frame_data_sequence(fds);
+}
+
+static void
+report_memory(guint32 count)
+{
+	frame_data_sequence *fds = make_sequence(count);
+	gsize bytes = frame_data_sequence_memory_size(fds);
+
+	printf("%u frames: %" G_GSIZE_FORMAT " bytes, %.2f bytes/frame (sizeof(frame_data) %u)\n",
+	       count, bytes, (double)bytes / count, (guint)sizeof(frame_data));
+	free_frame_data_sequence(fds);
+}
+
+int
+main(int argc, char **argv)
+{
+	/* One, two and three levels of nodes, and their edges. */
+	guint32 counts[] = { 0, 1, 1023, 1024, 1025, 1024 * 1024, 1024 * 1024 + 1 };
+	guint32 count = 0;
+	guint i;
+
+	if (argc > 1)
+		count = (guint32)strtoul(argv[1], NULL, 10);
+
+	for (i = 0; i < G_N_ELEMENTS(counts); i++)
+		test_count(counts[i]);
+	test_shift_offset();
+	if (failed)
+		exit(1);
+	printf("Passed frame_data_sequence tests\n");
+
+	if (count != 0)
+		report_memory(count);
+
+	return failed ? 1 : 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
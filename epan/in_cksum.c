@@ -1,7 +1,7 @@
 /* in_cksum.c
  * 4.4-Lite-2 Internet checksum routine, modified to take a vector of
- * pointers/lengths giving the pieces to be checksummed.  Also using
- * Tahoe/CGI version of ADDCARRY(x) macro instead of from portable version.
+ * pointers/lengths giving the pieces to be checksummed, and to do the
+ * summing with ws_cksum_sum16().
  *
  * Copyright (c) 1988, 1992, 1993
  *	The Regents of the University of California.  All rights reserved.
@@ -18,107 +18,36 @@
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
 
+#include <wsutil/ws_cksum.h>
+
 /*
- * Checksum routine for Internet Protocol family headers (Portable Version).
+ * Checksum routine for Internet Protocol family headers.
  *
- * This routine is very heavily used in the network
- * code and should be modified for each CPU to be as fast as possible.
+ * Each chunk is summed by ws_cksum_sum16(), which uses SIMD where it
+ * can, as if it started on a 16-bit boundary. A chunk that really starts
+ * at an odd offset in the data has all its bytes in the other half of
+ * their words, so, as RFC 1071 section 2(B) says, its sum is just
+ * byte-swapped before it's added in.
  */
-
-#define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
-#define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
-
 int
 in_cksum(const vec_t *vec, int veclen)
 {
-	register const guint16 *w;
-	register int sum = 0;
-	register int mlen = 0;
-	int byte_swapped = 0;
-
-	union {
-		guint8	c[2];
-		guint16	s;
-	} s_util;
-	union {
-		guint16 s[2];
-		guint32	l;
-	} l_util;
+	guint32 sum = 0;
+	guint16 partial;
+	gboolean odd = FALSE;
 
 	for (; veclen != 0; vec++, veclen--) {
-		if (vec->len == 0)
-			continue;
-		w = (const guint16 *)(const void *)vec->ptr;
-		if (mlen == -1) {
-			/*
-			 * The first byte of this chunk is the continuation
-			 * of a word spanning between this chunk and the
-			 * last chunk.
-			 *
-			 * s_util.c[0] is already saved when scanning previous
-			 * chunk.
-			 */
-			s_util.c[1] = *(const guint8 *)w;
-			sum += s_util.s;
-			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
-			mlen = vec->len - 1;
-		} else
-			mlen = vec->len;
-		/*
-		 * Force to even boundary.
-		 */
-		if ((1 & (gintptr)w) && (mlen > 0)) {
-			REDUCE;
-			sum <<= 8;
-			s_util.c[0] = *(const guint8 *)w;
-			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
-			mlen--;
-			byte_swapped = 1;
-		}
-		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
-		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
-		}
-		mlen += 32;
-		while ((mlen -= 8) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			w += 4;
-		}
-		mlen += 8;
-		if (mlen == 0 && byte_swapped == 0)
+		if (vec->len <= 0)
 			continue;
-		REDUCE;
-		while ((mlen -= 2) >= 0) {
-			sum += *w++;
-		}
-		if (byte_swapped) {
-			REDUCE;
-			sum <<= 8;
-			byte_swapped = 0;
-			if (mlen == -1) {
-				s_util.c[1] = *(const guint8 *)w;
-				sum += s_util.s;
-				mlen = 0;
-			} else
-				mlen = -1;
-		} else if (mlen == -1)
-			s_util.c[0] = *(const guint8 *)w;
-	}
-	if (mlen == -1) {
-		/* The last mbuf has odd # of bytes. Follow the
-		   standard (the odd byte may be shifted left by 8 bits
-		   or not as determined by endian-ness of the machine) */
-		s_util.c[1] = 0;
-		sum += s_util.s;
+		partial = ws_cksum_sum16(vec->ptr, vec->len);
+		if (odd)
+			partial = GUINT16_SWAP_LE_BE(partial);
+		sum += partial;
+		if (vec->len & 1)
+			odd = !odd;
 	}
-	REDUCE;
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
 	return (~sum & 0xffff);
 }
 
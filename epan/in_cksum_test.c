@@ -0,0 +1,257 @@
+/* in_cksum_test.c
+ * Standalone program to test in_cksum() against the original 4.4BSD
+ * routine, with random data split into random chunks, and, given a number
+ * of megabytes, to report its throughput over that much data.
+ *
+ * in_cksum() uses the fastest implementation the CPU supports; set
+ * WIRESHARK_CKSUM to "sse2" or "portable" to test a slower one.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tvbuff.h"
+#include "in_cksum.h"
+
+#define BUF_SIZE	(64 * 1024)
+#define MAX_VECS	8
+
+static gboolean failed = FALSE;
+
+/*
+ * The scalar routine in_cksum() used to be, from 4.4BSD-Lite-2, as the
+ * reference.
+ *
+ * Copyright (c) 1988, 1992, 1993
+ *	The Regents of the University of California.  All rights reserved.
+ */
+
+#define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
+#define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
+
+static int
+in_cksum_bsd(const vec_t *vec, int veclen)
+{
+	register const guint16 *w;
+	register int sum = 0;
+	register int mlen = 0;
+	int byte_swapped = 0;
+
+	union {
+		guint8	c[2];
+		guint16	s;
+	} s_util;
+	union {
+		guint16 s[2];
+		guint32	l;
+	} l_util;
+
+	for (; veclen != 0; vec++, veclen--) {
+		if (vec->len == 0)
+			continue;
+		w = (const guint16 *)(const void *)vec->ptr;
+		if (mlen == -1) {
+			/*
+			 * The first byte of this chunk is the continuation
+			 * of a word spanning between this chunk and the
+			 * last chunk.
+			 *
+			 * s_util.c[0] is already saved when scanning previous
+			 * chunk.
+			 */
+			s_util.c[1] = *(const guint8 *)w;
+			sum += s_util.s;
+			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
+			mlen = vec->len - 1;
+		} else
+			mlen = vec->len;
+		/*
+		 * Force to even boundary.
+		 */
+		if ((1 & (gintptr)w) && (mlen > 0)) {
+			REDUCE;
+			sum <<= 8;
+			s_util.c[0] = *(const guint8 *)w;
+			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
+			mlen--;
+			byte_swapped = 1;
+		}
+		/*
+		 * Unroll the loop to make overhead from
+		 * branches &c small.
+		 */
+		while ((mlen -= 32) >= 0) {
+			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
+			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
+			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
+			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
+			w += 16;
+		}
+		mlen += 32;
+		while ((mlen -= 8) >= 0) {
+			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
+			w += 4;
+		}
+		mlen += 8;
+		if (mlen == 0 && byte_swapped == 0)
+			continue;
+		REDUCE;
+		while ((mlen -= 2) >= 0) {
+			sum += *w++;
+		}
+		if (byte_swapped) {
+			REDUCE;
+			sum <<= 8;
+			byte_swapped = 0;
+			if (mlen == -1) {
+				s_util.c[1] = *(const guint8 *)w;
+				sum += s_util.s;
+				mlen = 0;
+			} else
+				mlen = -1;
+		} else if (mlen == -1)
+			s_util.c[0] = *(const guint8 *)w;
+	}
+	if (mlen == -1) {
+		/* The last mbuf has odd # of bytes. Follow the
+		   standard (the odd byte may be shifted left by 8 bits
+		   or not as determined by endian-ness of the machine) */
+		s_util.c[1] = 0;
+		sum += s_util.s;
+	}
+	REDUCE;
+	return (~sum & 0xffff);
+}
+
+static void
+check(const vec_t *vec, int veclen)
+{
+	int actual = in_cksum(vec, veclen);
+	int expected = in_cksum_bsd(vec, veclen);
+	int i;
+
+	if (actual != expected) {
+		printf("Failed in_cksum: 0x%04x, expected 0x%04x; chunks", actual, expected);
+		for (i = 0; i < veclen; i++)
+			printf(" %p+%d", (const void *)vec[i].ptr, vec[i].len);
+		printf("\n");
+		failed = TRUE;
+	}
+}
+
+/*
+ * Every alignment and length up to a few blocks in one chunk, then
+ * random splits, with odd lengths and gaps between the chunks, of random
+ * data, all-zero data, and all-ones data (whose sums are the two
+ * representations of zero).
+ */
+static void
+test_correctness(guint8 *buf)
+{
+	GRand  *rand = g_rand_new_with_seed(1);
+	vec_t   vec[MAX_VECS];
+	guint   offset, len;
+	int     i, j, veclen;
+
+	for (offset = 0; offset < 32; offset++) {
+		for (len = 0; len <= 300; len++) {
+			SET_CKSUM_VEC_PTR(vec[0], buf + offset, len);
+			check(vec, 1);
+		}
+	}
+
+	for (i = 0; i < 20000; i++) {
+		guint8 *p = buf + g_rand_int_range(rand, 0, 64);
+		guint   max_len = (i % 10 == 0) ? (BUF_SIZE - 128) / MAX_VECS : 200;
+
+		veclen = g_rand_int_range(rand, 1, MAX_VECS + 1);
+		for (j = 0; j < veclen; j++) {
+			len = (g_rand_int_range(rand, 0, 3) == 0) ?
+			    g_rand_int_range(rand, 0, 8) :
+			    g_rand_int_range(rand, 0, max_len);
+			SET_CKSUM_VEC_PTR(vec[j], p, len);
+			p += len + g_rand_int_range(rand, 0, 3);
+		}
+		check(vec, veclen);
+
+		/* The same chunks over data that sums to zero. */
+		if (i % 100 == 0) {
+			memset(buf, (i / 100) % 2 ? 0xff : 0x00, BUF_SIZE);
+			check(vec, veclen);
+			for (j = 0; j < BUF_SIZE; j++)
+				buf[j] = (guint8)g_rand_int(rand);
+		}
+	}
+
+	g_rand_free(rand);
+}
+
+static void
+report_throughput(const guint8 *buf, guint len, guint mbytes)
+{
+	guint64 iterations = ((guint64)mbytes * 1024 * 1024 + len - 1) / len;
+	guint64 i;
+	gint64  start;
+	double  seconds;
+	guint32 sum = 0;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+		sum += ip_checksum(buf, len);
+	seconds = (g_get_monotonic_time() - start) / 1e6;
+	printf("ip_checksum %6u bytes: %8.0f MB/s (%08x)\n", len,
+	       iterations * len / seconds / 1e6, sum);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const guint sizes[] = { 20, 64, 576, 1500, 9000, BUF_SIZE };
+	guint8 *buf = (guint8 *)g_malloc(BUF_SIZE);
+	guint   mbytes = 0;
+	guint   i;
+
+	if (argc > 1)
+		mbytes = (guint)strtoul(argv[1], NULL, 10);
+
+	for (i = 0; i < BUF_SIZE; i++)
+		buf[i] = (guint8)(i * 2654435761U >> 24);
+
+	test_correctness(buf);
+	if (failed)
+		exit(1);
+	printf("Passed in_cksum tests (WIRESHARK_CKSUM=%s)\n",
+	       g_getenv("WIRESHARK_CKSUM") ? g_getenv("WIRESHARK_CKSUM") : "");
+
+	if (mbytes != 0) {
+		for (i = 0; i < G_N_ELEMENTS(sizes); i++)
+			report_throughput(buf, sizes[i], mbytes);
+	}
+
+	g_free(buf);
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
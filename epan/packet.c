@@ -28,6 +28,7 @@
 #include "addr_resolv.h"
 #include "tvbuff.h"
 #include "epan_dissect.h"
+#include "uint_dtbl.h"
 
 #include "wmem/wmem.h"
 
@@ -37,8 +38,10 @@
 #include <epan/expert.h>
 #include <epan/prefs.h>
 #include <epan/range.h>
+#include <epan/conversation.h>
 
 #include <wsutil/str_util.h>
+#include <wsutil/time_util.h>
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 
 static gint proto_malformed = -1;
@@ -62,6 +65,10 @@ struct data_source {
  * a "struct dtbl_entry"; it records what dissector is assigned to
  * that uint or string value in that table.
  *
+ * "uint_index" is, for uint and FT_NONE tables, a copy of "hash_table"
+ * that's quicker to search; it's what dissector_try_uint() and
+ * friends look in. It's NULL for other tables.
+ *
  * "dissector_handles" is a list of all dissectors that *could* be
  * used in that table; not all of them are necessarily in the table,
  * as they may be for protocols that don't have a fixed uint value,
@@ -82,6 +89,7 @@ struct data_source {
  */
 struct dissector_table {
 	GHashTable	*hash_table;
+	uint_dtbl_t	*uint_index;
 	GSList		*dissector_handles;
 	const char	*ui_name;
 	ftenum_t	type;
@@ -153,14 +161,84 @@ destroy_depend_dissector_list(void *data)
 
 /*
  * A heuristics dissector list.
+ *
+ * "tries" counts the first-pass calls of dissector_try_heuristic() for
+ * the list since it was last sorted, if the "protocols.reorder_heuristics"
+ * preference is set.
  */
 struct heur_dissector_list {
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	guint		tries;
 };
 
 static GHashTable *heur_dissector_lists = NULL;
 
+/*
+ * With "protocols.reorder_heuristics" set, a list is sorted by the
+ * success rate of its entries after this many tries. A heuristic
+ * dissector can call dissector_try_heuristic() on the list it's in, so
+ * the list can't be sorted while it's being walked; the sorting is put
+ * off until the start of the next frame that's dissected for the first
+ * time, when none is.
+ */
+#define HEUR_REORDER_INTERVAL	1024
+
+static gboolean heur_reorder_due = FALSE;
+
+/*
+ * With "protocols.remember_heuristics" set, the entry that accepted a
+ * packet is remembered for the conversation and the list, and is tried
+ * first for later packets of that conversation. Conversation -> chain
+ * of heur_conversation_match_t.
+ *
+ * "generation" is bumped whenever an entry is deleted, so that a match
+ * recorded before that isn't used.
+ *
+ * The conversation's match is only looked up and updated on the first
+ * pass. With either preference set, the entry that accepted a frame on
+ * the first pass is recorded for the frame, list and layer, and is tried
+ * first when the frame is revisited, so that it's dissected the same
+ * way whatever later frames of the conversation did and however the
+ * list has been sorted since. Frame number -> chain of
+ * heur_frame_match_t.
+ */
+typedef struct heur_conversation_match {
+	heur_dissector_list_t	list;
+	heur_dtbl_entry_t	*entry;
+	guint			generation;
+	struct heur_conversation_match *next;
+} heur_conversation_match_t;
+
+typedef struct heur_frame_match {
+	heur_dissector_list_t	list;
+	guint8			layer_num;
+	heur_dtbl_entry_t	*entry;
+	guint			generation;
+	struct heur_frame_match *next;
+} heur_frame_match_t;
+
+static wmem_map_t *heur_conversation_matches = NULL;
+static wmem_map_t *heur_frame_matches = NULL;
+static guint heur_generation = 0;
+
+/*
+ * A heuristic dissector entry, with the counts used to reorder the
+ * lists; heur_dissector_add() allocates these, so every
+ * heur_dtbl_entry_t in a list is the first member of one.
+ */
+typedef struct heur_dtbl_entry_priv {
+	heur_dtbl_entry_t	pub;
+	guint64			hits;	/* times the dissector accepted the data */
+	guint64			misses;	/* times it was tried and rejected the data */
+	dissector_prof_t	*prof;	/* profile, if it's been tried while profiling */
+} heur_dtbl_entry_priv_t;
+
+#define HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)	((heur_dtbl_entry_priv_t *)(hdtbl_entry))
+
+static void reorder_heur_dissector_lists(void);
+static void dissector_prof_cleanup(void);
+
 /* Name hashtables for fast detection of duplicate names */
 static GHashTable* heuristic_short_names  = NULL;
 
@@ -170,7 +248,7 @@ destroy_heuristic_dissector_entry(gpointer data)
 	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)data;
 	g_free(hdtbl_entry->list_name);
 	g_free(hdtbl_entry->short_name);
-	g_slice_free(heur_dtbl_entry_t, data);
+	g_slice_free(heur_dtbl_entry_priv_t, HEUR_DTBL_ENTRY_PRIV(hdtbl_entry));
 }
 
 static void
@@ -189,6 +267,7 @@ destroy_dissector_table(void *data)
 	struct dissector_table *table = (struct dissector_table *)data;
 
 	g_hash_table_destroy(table->hash_table);
+	uint_dtbl_free(table->uint_index);
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
 }
@@ -269,6 +348,7 @@ packet_cleanup(void)
 		}
 		g_array_free(postdissectors, TRUE);
 	}
+	dissector_prof_cleanup();
 }
 
 /*
@@ -324,6 +404,11 @@ init_dissection(void)
 	/* Initialize the table of conversations. */
 	epan_conversation_init();
 
+	heur_conversation_matches = wmem_map_new(wmem_file_scope(),
+			g_direct_hash, g_direct_equal);
+	heur_frame_matches = wmem_map_new(wmem_file_scope(),
+			g_direct_hash, g_direct_equal);
+
 	/* Initialize protocol-specific variables. */
 	g_slist_foreach(init_routines, &call_routine, NULL);
 
@@ -346,6 +431,9 @@ cleanup_dissection(void)
 	/* Cleanup the expert infos */
 	expert_packet_cleanup();
 
+	heur_conversation_matches = NULL;
+	heur_frame_matches = NULL;
+
 	wmem_leave_file_scope();
 
 	/*
@@ -512,6 +600,9 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 		break;
 	}
 
+	if (heur_reorder_due && !fd->visited)
+		reorder_heur_dissector_lists();
+
 	if (cinfo != NULL)
 		col_init(cinfo, edt->session);
 	edt->pi.epan = edt->session;
@@ -599,6 +690,9 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 {
 	file_data_t file_dissector_data;
 
+	if (heur_reorder_due && !fd->visited)
+		reorder_heur_dissector_lists();
+
 	if (cinfo != NULL)
 		col_init(cinfo, edt->session);
 	edt->pi.epan = edt->session;
@@ -676,8 +770,155 @@ struct dissector_handle {
 	void		*dissector_func;
 	void		*dissector_data;
 	protocol_t	*protocol;
+	dissector_prof_t *prof;		/* profile, if it's been called while profiling */
 };
 
+/*
+ * While profiling, each call through a handle, and each try of a
+ * heuristic dissector, pushes a frame on dissector_prof_stack; when the
+ * call returns or throws, its time and allocations less those of the
+ * calls it made are charged to it.
+ */
+typedef struct {
+	dissector_prof_t *prof;
+	guint64 start_ns;
+	guint64 start_bytes;
+	guint64 child_ns;
+	guint64 child_bytes;
+} dissector_prof_frame_t;
+
+static gboolean dissector_prof_on = FALSE;
+static GArray *dissector_prof_stack = NULL;
+static GPtrArray *dissector_prof_entries = NULL;
+
+static guint64
+dissector_prof_bytes(packet_info *pinfo)
+{
+	return wmem_allocated_bytes(pinfo->pool) +
+	    wmem_allocated_bytes(wmem_packet_scope());
+}
+
+static dissector_prof_t *
+dissector_prof_new(const char *name, protocol_t *protocol)
+{
+	dissector_prof_t *prof;
+	const char *protocol_name = NULL;
+
+	if (protocol != NULL)
+		protocol_name = proto_get_protocol_filter_name(proto_get_id(protocol));
+	prof = g_new0(dissector_prof_t, 1);
+	prof->protocol = protocol_name;
+	prof->name = name ? name : protocol_name;
+	if (prof->name == NULL)
+		prof->name = "(unnamed)";
+	g_ptr_array_add(dissector_prof_entries, prof);
+	return prof;
+}
+
+/* Returns the depth of the new frame. */
+static guint
+dissector_prof_push(dissector_prof_t *prof, packet_info *pinfo)
+{
+	dissector_prof_frame_t frame;
+
+	frame.prof = prof;
+	frame.start_bytes = dissector_prof_bytes(pinfo);
+	frame.child_ns = 0;
+	frame.child_bytes = 0;
+	frame.start_ns = get_monotonic_time_ns();
+	g_array_append_val(dissector_prof_stack, frame);
+	return dissector_prof_stack->len;
+}
+
+/* Pops the frame at depth, and any above it. */
+static void
+dissector_prof_pop(guint depth, packet_info *pinfo)
+{
+	guint64 now_ns = get_monotonic_time_ns();
+	guint64 now_bytes = dissector_prof_bytes(pinfo);
+	dissector_prof_frame_t *frame;
+	dissector_prof_t *prof;
+	guint64 elapsed_ns, elapsed_bytes;
+
+	while (dissector_prof_stack->len >= depth && dissector_prof_stack->len > 0) {
+		frame = &g_array_index(dissector_prof_stack, dissector_prof_frame_t,
+		    dissector_prof_stack->len - 1);
+		elapsed_ns = now_ns - frame->start_ns;
+		elapsed_bytes = now_bytes - frame->start_bytes;
+
+		prof = frame->prof;
+		prof->calls++;
+		prof->inclusive_ns += elapsed_ns;
+		prof->exclusive_ns += elapsed_ns - frame->child_ns;
+		prof->alloc_bytes += elapsed_bytes - frame->child_bytes;
+
+		g_array_set_size(dissector_prof_stack, dissector_prof_stack->len - 1);
+		if (dissector_prof_stack->len > 0) {
+			frame = &g_array_index(dissector_prof_stack, dissector_prof_frame_t,
+			    dissector_prof_stack->len - 1);
+			frame->child_ns += elapsed_ns;
+			frame->child_bytes += elapsed_bytes;
+		}
+	}
+}
+
+void
+dissector_prof_set_enabled(gboolean enabled)
+{
+	if (dissector_prof_stack == NULL) {
+		dissector_prof_stack = g_array_new(FALSE, FALSE, sizeof(dissector_prof_frame_t));
+		dissector_prof_entries = g_ptr_array_new_with_free_func(g_free);
+	}
+	g_array_set_size(dissector_prof_stack, 0);
+	dissector_prof_on = enabled;
+}
+
+gboolean
+dissector_prof_is_enabled(void)
+{
+	return dissector_prof_on;
+}
+
+void
+dissector_prof_reset(void)
+{
+	dissector_prof_t *prof;
+	guint i;
+
+	if (dissector_prof_entries == NULL)
+		return;
+	for (i = 0; i < dissector_prof_entries->len; i++) {
+		prof = (dissector_prof_t *)g_ptr_array_index(dissector_prof_entries, i);
+		prof->calls = 0;
+		prof->inclusive_ns = 0;
+		prof->exclusive_ns = 0;
+		prof->alloc_bytes = 0;
+	}
+}
+
+static void
+dissector_prof_cleanup(void)
+{
+	if (dissector_prof_stack == NULL)
+		return;
+	g_array_free(dissector_prof_stack, TRUE);
+	dissector_prof_stack = NULL;
+	g_ptr_array_free(dissector_prof_entries, TRUE);
+	dissector_prof_entries = NULL;
+	dissector_prof_on = FALSE;
+}
+
+void
+dissector_prof_foreach(dissector_prof_func func, gpointer user_data)
+{
+	guint i;
+
+	if (dissector_prof_entries == NULL)
+		return;
+	for (i = 0; i < dissector_prof_entries->len; i++)
+		func((const dissector_prof_t *)g_ptr_array_index(dissector_prof_entries, i), user_data);
+}
+
 /* This function will return
  * old style dissector :
  *   length of the payload or 1 of the payload is empty
@@ -688,6 +929,41 @@ struct dissector_handle {
  * The only time this function will return 0 is if it is a new style dissector
  * and if the dissector rejected the packet.
  */
+static int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data)
+{
+	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
+		return ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
+		return ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	}
+	g_assert_not_reached();
+	return 0;
+}
+
+static int
+call_dissector_profiled(dissector_handle_t handle, tvbuff_t *tvb,
+			packet_info *pinfo, proto_tree *tree, void *data)
+{
+	volatile int len = 0;
+	guint        prof_depth;
+
+	if (handle->prof == NULL)
+		handle->prof = dissector_prof_new(handle->name, handle->protocol);
+	prof_depth = dissector_prof_push(handle->prof, pinfo);
+	TRY {
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
+	}
+	FINALLY {
+		dissector_prof_pop(prof_depth, pinfo);
+	}
+	ENDTRY;
+
+	return len;
+}
+
 static int
 call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			      packet_info *pinfo, proto_tree *tree, void *data)
@@ -702,15 +978,10 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
-		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
-	}
-	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
-		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
-	}
-	else {
-		g_assert_not_reached();
-	}
+	if (G_UNLIKELY(dissector_prof_on))
+		len = call_dissector_profiled(handle, tvb, pinfo, tree, data);
+	else
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
 	pinfo->current_proto = saved_proto;
 
 	return len;
@@ -959,33 +1230,55 @@ find_dissector_table(const char *name)
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 {
-	switch (sub_dissectors->type) {
-
-	case FT_UINT8:
-	case FT_UINT16:
-	case FT_UINT24:
-	case FT_UINT32:
-		/*
-		 * You can do a uint lookup in these tables.
-		 */
-		break;
-	case FT_NONE:
-		/* For now treat as uint */
-		break;
-
-	default:
-		/*
-		 * But you can't do a uint lookup in any other types
-		 * of tables.
-		 */
+	/*
+	 * Only uint and FT_NONE tables have an index; you can't do a
+	 * uint lookup in any other types of tables.
+	 */
+	if (sub_dissectors->uint_index == NULL)
 		g_assert_not_reached();
-	}
 
 	/*
 	 * Find the entry.
 	 */
-	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
-				   GUINT_TO_POINTER(pattern));
+	return (dtbl_entry_t *)uint_dtbl_lookup(sub_dissectors->uint_index, pattern);
+}
+
+/* Add, or replace, an entry in a uint dissector table. */
+static void
+insert_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern,
+    dtbl_entry_t *dtbl_entry)
+{
+	g_hash_table_insert(sub_dissectors->hash_table,
+			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	uint_dtbl_insert(sub_dissectors->uint_index, pattern, dtbl_entry);
+}
+
+/* Remove an entry from a uint dissector table. */
+static void
+remove_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
+{
+	uint_dtbl_remove(sub_dissectors->uint_index, pattern);
+	g_hash_table_remove(sub_dissectors->hash_table,
+			    GUINT_TO_POINTER(pattern));
+}
+
+static void
+reindex_uint_dtbl_entry(gpointer key, gpointer value, gpointer user_data)
+{
+	uint_dtbl_insert((uint_dtbl_t *)user_data, GPOINTER_TO_UINT(key), value);
+}
+
+/* Rebuild the index of a uint dissector table after entries have been
+   removed from its hash table behind its back. */
+static void
+reindex_uint_dtbl(dissector_table_t sub_dissectors)
+{
+	if (sub_dissectors->uint_index == NULL)
+		return;
+
+	uint_dtbl_clear(sub_dissectors->uint_index);
+	g_hash_table_foreach(sub_dissectors->hash_table, reindex_uint_dtbl_entry,
+			     sub_dissectors->uint_index);
 }
 
 #if 0
@@ -1065,8 +1358,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	dtbl_entry->initial = dtbl_entry->current;
 
 	/* do the table insertion */
-	g_hash_table_insert(sub_dissectors->hash_table,
-			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	insert_uint_dtbl_entry(sub_dissectors, pattern, dtbl_entry);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1226,8 +1518,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		/*
 		 * Found - remove it.
 		 */
-		g_hash_table_remove(sub_dissectors->hash_table,
-				    GUINT_TO_POINTER(pattern));
+		remove_uint_dtbl_entry(sub_dissectors, pattern);
 	}
 }
 
@@ -1268,7 +1559,8 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	dissector_table_t sub_dissectors = find_dissector_table(name);
 	g_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	if (g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle) != 0)
+		reindex_uint_dtbl(sub_dissectors);
 }
 
 static void
@@ -1277,7 +1569,8 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	dissector_table_t sub_dissectors = (dissector_table_t) value;
 	g_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	if (g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data) != 0)
+		reindex_uint_dtbl(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1321,8 +1614,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	dtbl_entry->current = handle;
 
 	/* do the table insertion */
-	g_hash_table_insert(sub_dissectors->hash_table,
-			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	insert_uint_dtbl_entry(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1349,8 +1641,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	if (dtbl_entry->initial != NULL) {
 		dtbl_entry->current = dtbl_entry->initial;
 	} else {
-		g_hash_table_remove(sub_dissectors->hash_table,
-				    GUINT_TO_POINTER(pattern));
+		remove_uint_dtbl_entry(sub_dissectors, pattern);
 	}
 }
 
@@ -2433,6 +2724,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 							       g_direct_equal,
 							       NULL,
 							       &g_free);
+		sub_dissectors->uint_index = uint_dtbl_new();
 		break;
 
 	case FT_STRING:
@@ -2443,12 +2735,14 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 							       g_str_equal,
 							       &g_free,
 							       &g_free);
+		sub_dissectors->uint_index = NULL;
 		break;
 	case FT_GUID:
 		sub_dissectors->hash_table = g_hash_table_new_full(uuid_hash,
 							       uuid_equal,
 							       NULL,
 							       &g_free);
+		sub_dissectors->uint_index = NULL;
 		break;
 
 	case FT_NONE:
@@ -2460,6 +2754,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 							       g_direct_equal,
 							       NULL,
 							       &g_free);
+		sub_dissectors->uint_index = uint_dtbl_new();
 		break;
 
 	default:
@@ -2494,6 +2789,7 @@ dissector_table_t register_custom_dissector_table(const char *name,
 							       key_equal_func,
 							       &g_free,
 							       &g_free);
+	sub_dissectors->uint_index = NULL;
 
 	sub_dissectors->dissector_handles = NULL;
 	sub_dissectors->ui_name = ui_name;
@@ -2636,13 +2932,16 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 			" This might be caused by an inappropriate plugin or a development error.", short_name);
 	}
 
-	hdtbl_entry = g_slice_new(heur_dtbl_entry_t);
+	hdtbl_entry = &g_slice_new(heur_dtbl_entry_priv_t)->pub;
 	hdtbl_entry->dissector = dissector;
 	hdtbl_entry->protocol  = find_protocol_by_id(proto);
 	hdtbl_entry->display_name = display_name;
 	hdtbl_entry->short_name = g_strdup(short_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)->hits   = 0;
+	HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)->misses = 0;
+	HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)->prof   = NULL;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2688,15 +2987,249 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 
 	if (found_entry) {
 		heur_dtbl_entry_t *found_hdtbl_entry = (heur_dtbl_entry_t *)(found_entry->data);
+		/* Forget the conversations it matched. */
+		heur_generation++;
+		/* Its profile is named after it. */
+		if (HEUR_DTBL_ENTRY_PRIV(found_hdtbl_entry)->prof != NULL)
+			g_ptr_array_remove(dissector_prof_entries, HEUR_DTBL_ENTRY_PRIV(found_hdtbl_entry)->prof);
 		g_free(found_hdtbl_entry->list_name);
 		g_hash_table_remove(heuristic_short_names, found_hdtbl_entry->short_name);
 		g_free(found_hdtbl_entry->short_name);
-		g_slice_free(heur_dtbl_entry_t, found_entry->data);
+		g_slice_free(heur_dtbl_entry_priv_t, HEUR_DTBL_ENTRY_PRIV(found_hdtbl_entry));
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors,
 		    found_entry);
 	}
 }
 
+/* Tries, including the ones that are rejected, are charged to the entry's
+   short name. */
+static int
+call_heur_dissector_profiled(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			     packet_info *pinfo, proto_tree *tree, void *data)
+{
+	heur_dtbl_entry_priv_t *priv = HEUR_DTBL_ENTRY_PRIV(hdtbl_entry);
+	volatile int len = 0;
+	guint        prof_depth;
+
+	if (priv->prof == NULL)
+		priv->prof = dissector_prof_new(hdtbl_entry->short_name, hdtbl_entry->protocol);
+	prof_depth = dissector_prof_push(priv->prof, pinfo);
+	TRY {
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	FINALLY {
+		dissector_prof_pop(prof_depth, pinfo);
+	}
+	ENDTRY;
+
+	return len;
+}
+
+/*
+ * Try one entry of a heuristic dissector list; "saved_layers_len" and
+ * "saved_tree_count" are as they were before the list was tried.
+ * Returns what the dissector returned, or 0 if it's disabled.
+ */
+static int
+try_heur_dtbl_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			packet_info *pinfo, proto_tree *tree, void *data,
+			guint saved_layers_len, int saved_tree_count)
+{
+	int proto_id;
+	int len;
+
+	if (hdtbl_entry->protocol != NULL &&
+		(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		/*
+		 * No - don't try this dissector.
+		 */
+		return 0;
+	}
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		pinfo->curr_layer_num++;
+		wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	if (G_UNLIKELY(dissector_prof_on))
+		len = call_heur_dissector_profiled(hdtbl_entry, tvb, pinfo, tree, data);
+	else
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			if (len == 0) {
+				/*
+				 * Only reduce the layer number if the dissector
+				 * rejected the data. Since tree can be NULL on
+				 * the first pass, we cannot check it or it will
+				 * break dissectors that rely on a stable value.
+				 */
+				pinfo->curr_layer_num--;
+			}
+			wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
+		}
+	}
+
+	/* Revisits would count the same frames again. */
+	if (!pinfo->fd->visited) {
+		if (len)
+			HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)->hits++;
+		else
+			HEUR_DTBL_ENTRY_PRIV(hdtbl_entry)->misses++;
+	}
+	return len;
+}
+
+/* Find the match remembered for this packet's conversation and the list,
+   if any; "conversation" is set to the conversation, if it was looked up.
+   Until some conversation has a match, there's nothing to look up. */
+static heur_conversation_match_t *
+find_heur_conversation_match(heur_dissector_list_t sub_dissectors,
+			     packet_info *pinfo, conversation_t **conversation)
+{
+	heur_conversation_match_t *match;
+
+	*conversation = NULL;
+	if (heur_conversation_matches == NULL ||
+	    wmem_map_size(heur_conversation_matches) == 0)
+		return NULL;
+	*conversation = find_conversation_pinfo(pinfo, 0);
+	if (*conversation == NULL)
+		return NULL;
+
+	match = (heur_conversation_match_t *)wmem_map_lookup(heur_conversation_matches, *conversation);
+	for (; match != NULL; match = match->next) {
+		if (match->list == sub_dissectors)
+			return match;
+	}
+	return NULL;
+}
+
+/* "conversation" is NULL if it wasn't looked up, or there isn't one. */
+static void
+remember_heur_conversation_match(heur_dissector_list_t sub_dissectors,
+				 packet_info *pinfo,
+				 conversation_t *conversation,
+				 heur_conversation_match_t *match,
+				 heur_dtbl_entry_t *hdtbl_entry)
+{
+	if (heur_conversation_matches == NULL)
+		return;
+	if (conversation == NULL)
+		conversation = find_conversation_pinfo(pinfo, 0);
+	if (conversation == NULL)
+		return;
+
+	if (match == NULL) {
+		match = wmem_new(wmem_file_scope(), heur_conversation_match_t);
+		match->list = sub_dissectors;
+		match->next = (heur_conversation_match_t *)wmem_map_lookup(heur_conversation_matches, conversation);
+		wmem_map_insert(heur_conversation_matches, conversation, match);
+	}
+	match->entry = hdtbl_entry;
+	match->generation = heur_generation;
+}
+
+/* Find the entry that accepted this frame for the list and layer on the
+   first pass, if any. */
+static heur_dtbl_entry_t *
+find_heur_frame_match(heur_dissector_list_t sub_dissectors, packet_info *pinfo,
+		      guint8 layer_num)
+{
+	heur_frame_match_t *match;
+
+	if (heur_frame_matches == NULL)
+		return NULL;
+	match = (heur_frame_match_t *)wmem_map_lookup(heur_frame_matches, GUINT_TO_POINTER(pinfo->num));
+	for (; match != NULL; match = match->next) {
+		if (match->list == sub_dissectors &&
+		    match->layer_num == layer_num)
+			return match->generation == heur_generation ? match->entry : NULL;
+	}
+	return NULL;
+}
+
+static void
+remember_heur_frame_match(heur_dissector_list_t sub_dissectors,
+			  packet_info *pinfo, guint8 layer_num,
+			  heur_dtbl_entry_t *hdtbl_entry)
+{
+	heur_frame_match_t *match;
+
+	if (heur_frame_matches == NULL)
+		return;
+	/* If the list is tried again at the same layer, e.g. for another PDU
+	   in the frame, the first entry to accept the frame is the one kept. */
+	if (find_heur_frame_match(sub_dissectors, pinfo, layer_num) != NULL)
+		return;
+	match = wmem_new(wmem_file_scope(), heur_frame_match_t);
+	match->list = sub_dissectors;
+	match->layer_num = layer_num;
+	match->entry = hdtbl_entry;
+	match->generation = heur_generation;
+	match->next = (heur_frame_match_t *)wmem_map_lookup(heur_frame_matches, GUINT_TO_POINTER(pinfo->num));
+	wmem_map_insert(heur_frame_matches, GUINT_TO_POINTER(pinfo->num), match);
+}
+
+/* Entries with the higher share of successful tries come first; ties,
+   including entries that have never matched, keep their order. */
+static gint
+compare_heur_success_rate(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_priv_t *hdtbl_entry_a = (const heur_dtbl_entry_priv_t *)a;
+	const heur_dtbl_entry_priv_t *hdtbl_entry_b = (const heur_dtbl_entry_priv_t *)b;
+	double rate_a = 0.0, rate_b = 0.0;
+
+	if (hdtbl_entry_a->hits != 0)
+		rate_a = (double)hdtbl_entry_a->hits / (double)(hdtbl_entry_a->hits + hdtbl_entry_a->misses);
+	if (hdtbl_entry_b->hits != 0)
+		rate_b = (double)hdtbl_entry_b->hits / (double)(hdtbl_entry_b->hits + hdtbl_entry_b->misses);
+
+	if (rate_a > rate_b)
+		return -1;
+	if (rate_a < rate_b)
+		return 1;
+	return 0;
+}
+
+static void
+reorder_heur_dissector_list(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+
+	if (sub_dissectors->tries >= HEUR_REORDER_INTERVAL) {
+		/* g_slist_sort() is a stable merge sort. */
+		sub_dissectors->dissectors = g_slist_sort(sub_dissectors->dissectors,
+		    compare_heur_success_rate);
+		sub_dissectors->tries = 0;
+	}
+}
+
+static void
+reorder_heur_dissector_lists(void)
+{
+	heur_reorder_due = FALSE;
+	g_hash_table_foreach(heur_dissector_lists, reorder_heur_dissector_list, NULL);
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2708,8 +3241,11 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
+	heur_dtbl_entry_t *tried_entry = NULL;
+	heur_conversation_match_t *match = NULL;
+	conversation_t    *conversation = NULL;
+	gboolean           reordered;
+	guint8             saved_layer_num = pinfo->curr_layer_num;
 	int                saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -2734,65 +3270,60 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
+	if (prefs.reorder_heuristics && !pinfo->fd->visited &&
+	    ++sub_dissectors->tries >= HEUR_REORDER_INTERVAL)
+		heur_reorder_due = TRUE;
+
+	/*
+	 * With either preference set, entries can be tried in a different
+	 * order than they were the last time the frame was dissected, so
+	 * a revisited frame has the entry that accepted it on the first
+	 * pass try it first. On the first pass, try the entry that took an
+	 * earlier packet of this conversation first; if it doesn't take
+	 * this one, try the rest as usual. With fewer than two entries, the
+	 * order can't change.
+	 */
+	reordered = (prefs.remember_heuristics || prefs.reorder_heuristics) &&
+	    sub_dissectors->dissectors != NULL &&
+	    sub_dissectors->dissectors->next != NULL;
+	if (reordered) {
+		if (pinfo->fd->visited) {
+			tried_entry = find_heur_frame_match(sub_dissectors, pinfo, saved_layer_num);
+		} else if (prefs.remember_heuristics) {
+			match = find_heur_conversation_match(sub_dissectors, pinfo, &conversation);
+			if (match != NULL && match->generation == heur_generation)
+				tried_entry = match->entry;
+		}
+		if (tried_entry != NULL &&
+		    try_heur_dtbl_entry(tried_entry, tvb, pinfo, tree, data,
+					saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = tried_entry;
+			status = TRUE;
+		}
+	}
+
+	for (entry = sub_dissectors->dissectors; entry != NULL && !status;
 	    entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
 		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
-
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
-			/*
-			 * No - don't try this dissector.
-			 */
+		if (hdtbl_entry == tried_entry)
 			continue;
-		}
-
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			pinfo->curr_layer_num++;
-			wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
-		}
 
-		pinfo->heur_list_name = hdtbl_entry->list_name;
-
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				if (len == 0) {
-					/*
-					 * Only reduce the layer number if the dissector
-					 * rejected the data. Since tree can be NULL on
-					 * the first pass, we cannot check it or it will
-					 * break dissectors that rely on a stable value.
-					 */
-					pinfo->curr_layer_num--;
-				}
-				wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
-			}
-		}
-		if (len) {
+		if (try_heur_dtbl_entry(hdtbl_entry, tvb, pinfo, tree, data,
+					saved_layers_len, saved_tree_count)) {
 			*heur_dtbl_entry = hdtbl_entry;
 			status = TRUE;
-			break;
+			if (prefs.remember_heuristics && reordered && !pinfo->fd->visited)
+				remember_heur_conversation_match(sub_dissectors,
+				    pinfo, conversation, match, hdtbl_entry);
 		}
 	}
 
+	if (reordered && status && !pinfo->fd->visited)
+		remember_heur_frame_match(sub_dissectors, pinfo, saved_layer_num,
+		    *heur_dtbl_entry);
+
 	pinfo->current_proto = saved_curr_proto;
 	pinfo->heur_list_name = saved_heur_list_name;
 	pinfo->can_desegment = saved_can_desegment;
@@ -2947,6 +3478,7 @@ register_heur_dissector_list(const char *name, const int proto)
 	sub_dissectors = g_slice_new(struct heur_dissector_list);
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->dissectors = NULL;	/* initially empty */
+	sub_dissectors->tries = 0;
 	g_hash_table_insert(heur_dissector_lists, (gpointer)name,
 			    (gpointer) sub_dissectors);
 	return sub_dissectors;
@@ -3053,6 +3585,7 @@ new_dissector_handle(enum dissector_e type, void *dissector, const int proto, co
 	handle->dissector_func	= dissector;
 	handle->dissector_data	= cb_data;
 	handle->protocol	= find_protocol_by_id(proto);
+	handle->prof		= NULL;
 	return handle;
 }
 
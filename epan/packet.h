@@ -836,6 +836,35 @@ WS_DLL_PUBLIC gboolean postdissectors_want_hfids(void);
 WS_DLL_PUBLIC void
 prime_epan_dissect_with_postdissector_wanted_hfids(epan_dissect_t *edt);
 
+/*
+ * Dissector profiling.  While it's enabled, every call through a
+ * dissector handle and every try of a heuristic dissector is counted
+ * and timed, and the memory the call allocates from the packet's pools
+ * is added up.  Inclusive time covers the dissectors the call made in
+ * turn, exclusive time and the allocated bytes don't.  Handles with no
+ * name of their own are reported under the filter name of their
+ * protocol, heuristic dissectors under their short name.
+ */
+typedef struct {
+	const char *name;
+	const char *protocol;
+	guint64     calls;
+	guint64     inclusive_ns;
+	guint64     exclusive_ns;
+	guint64     alloc_bytes;
+} dissector_prof_t;
+
+WS_DLL_PUBLIC void dissector_prof_set_enabled(gboolean enabled);
+WS_DLL_PUBLIC gboolean dissector_prof_is_enabled(void);
+
+/* Zero the figures for every handle. */
+WS_DLL_PUBLIC void dissector_prof_reset(void);
+
+typedef void (*dissector_prof_func)(const dissector_prof_t *prof, gpointer user_data);
+
+/* Call func for every handle called since profiling was enabled. */
+WS_DLL_PUBLIC void dissector_prof_foreach(dissector_prof_func func, gpointer user_data);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -72,6 +72,7 @@ typedef struct _packet_info {
   const char *match_string;         /**< matched string for calling subdissector from table */
   gboolean use_endpoint;            /**< TRUE if endpoint member should be used for conversations */
   struct endpoint* conv_endpoint;   /**< Data that can be used for conversations */
+  struct conversation_pinfo_cache *conv_cache; /**< Last find_conversation_pinfo() result, private to conversation.c */
   guint16 can_desegment;            /**< >0 if this segment could be desegmented.
                                          A dissector that can offer this API (e.g.
                                          TCP) sets can_desegment=2, then
@@ -3521,6 +3521,12 @@ prefs_register_modules(void)
     prefs_register_bool_preference(capture_module, "show_info", "Show capture information dialog while capturing",
         "Show capture information dialog while capturing?", &prefs.capture_show_info);
 
+    prefs_register_uint_preference(capture_module, "shm_size", "Shared memory for new packets (MiB)",
+        "Have the capture child copy the last this many MiB of the capture file to shared memory, "
+        "so that new packets can be read from there rather than from the file; 0 to read them "
+        "from the file. Not supported on all platforms.",
+        10, &prefs.capture_shm_size);
+
     prefs_register_obsolete_preference(capture_module, "syntax_check_filter");
 
     custom_cbs.free_cb = capture_column_free_cb;
@@ -3659,6 +3665,20 @@ prefs_register_modules(void)
                                    "Currently only ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_bool_preference(protocols_module, "reorder_heuristics",
+                                   "Try heuristic dissectors in order of success",
+                                   "Every so often, sort each list of heuristic dissectors so that the ones that "
+                                   "have accepted the largest share of the packets they were tried on come first. "
+                                   "This makes finding the right one quicker, but if two dissectors would accept "
+                                   "a packet, which one gets it can change during a capture.",
+                                   &prefs.reorder_heuristics);
+
+    prefs_register_bool_preference(protocols_module, "remember_heuristics",
+                                   "Remember which heuristic dissector took a conversation",
+                                   "Try the heuristic dissector that accepted an earlier packet of the same "
+                                   "conversation first, before the others in its list.",
+                                   &prefs.remember_heuristics);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4142,6 +4162,7 @@ pre_init_prefs(void)
     prefs.capture_no_extcap             = FALSE;
     prefs.capture_auto_scroll           = TRUE;
     prefs.capture_show_info             = FALSE;
+    prefs.capture_shm_size              = 0;
 
     if (!prefs.capture_columns) {
         /* First time through */
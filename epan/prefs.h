@@ -195,6 +195,7 @@ typedef struct _e_prefs {
   gboolean     capture_no_interface_load;
   gboolean     capture_no_extcap;
   gboolean     capture_show_info;
+  guint        capture_shm_size;
   GList       *capture_columns;
   guint        tap_update_interval;
   gboolean     display_hidden_proto_items;
@@ -202,6 +203,8 @@ typedef struct _e_prefs {
   gboolean     enable_incomplete_dissectors_check;
   gboolean     incomplete_dissectors_check_debug;
   gboolean     strict_conversation_tracking_heuristics;
+  gboolean     reorder_heuristics;
+  gboolean     remember_heuristics;
   gboolean     filter_expressions_old;  /* TRUE if old filter expressions preferences were loaded. */
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
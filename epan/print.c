@@ -28,6 +28,7 @@
 #include <epan/print.h>
 #include <epan/charsets.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/arrow_ipc.h>
 #include <wsutil/filesystem.h>
 #include <version_info.h>
 #include <wsutil/utf8_entities.h>
@@ -81,6 +82,10 @@ struct _output_fields {
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    guint         arrow_batch_rows;
+    arrow_ipc_writer_t *arrow;
+    arrow_ipc_type_e   *arrow_types;
+    gboolean           *arrow_seen;     /* typed column already set for this packet */
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -101,13 +106,20 @@ static void print_escaped_xml(FILE *fh, const char *unescaped_string);
 static void print_escaped_csv(FILE *fh, const char *unescaped_string);
 
 typedef void (*proto_node_value_writer)(proto_node *, write_json_data *);
+
+typedef enum {
+    JSON_KEY,
+    JSON_KEY_RAW,       /* key with a "_raw" suffix */
+    JSON_KEY_TREE       /* key with a "_tree" suffix */
+} json_key_suffix_e;
+
 static void write_json_index(json_dumper *dumper, epan_dissect_t *edt);
-static void write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *data);
-static void write_json_proto_node(GSList *node_values_head,
-                                  const char *suffix,
+static void write_json_proto_node_list(guint first_sibling, write_json_data *data);
+static void write_json_proto_node(guint sibling,
+                                  json_key_suffix_e suffix,
                                   proto_node_value_writer value_writer,
                                   write_json_data *data);
-static void write_json_proto_node_value_list(GSList *node_values_head,
+static void write_json_proto_node_value_list(guint sibling,
                                              proto_node_value_writer value_writer,
                                              write_json_data *data);
 static void write_json_proto_node_filtered(proto_node *node, write_json_data *data);
@@ -762,63 +774,189 @@ write_json_proto_tree(output_fields_t* fields,
     json_dumper_end_object(dumper);
 }
 
+/*
+ * The children of a node are written in one pass, without building lists
+ * of them. The children are appended to json_siblings and those with the
+ * same key are chained, so that each key is written once, where it first
+ * occurs, followed by all of its values. The array is used as a stack:
+ * the children of a node being written are appended after its siblings
+ * and removed again once written, so it is only allocated once.
+ */
+typedef struct {
+    proto_node *node;
+    guint       next;   /* Next sibling with the same key, or 0 */
+    guint       last;   /* For the first sibling with a key: the last one */
+    guint       count;  /* For the first sibling with a key: the number of them, otherwise 0 */
+} json_sibling_t;
+
+static GArray *json_siblings;
+
+#define JSON_SIBLING(i) (&g_array_index(json_siblings, json_sibling_t, (i)))
+
+/* Above this many siblings, keys are matched with a hash table rather than
+ * by comparing them with every earlier key. */
+#define JSON_SIBLINGS_SCAN_MAX 16
+
+static guint
+json_siblings_mark(void)
+{
+    if (json_siblings == NULL) {
+        json_siblings = g_array_sized_new(FALSE, FALSE, sizeof(json_sibling_t), 256);
+    }
+    return json_siblings->len;
+}
+
+static guint
+json_siblings_push(proto_node *node)
+{
+    json_sibling_t sibling;
+
+    sibling.node = node;
+    sibling.next = 0;
+    sibling.last = json_siblings->len;
+    sibling.count = 1;
+    g_array_append_val(json_siblings, sibling);
+    return sibling.last;
+}
+
+/* Appends a node to the chain of the sibling "first". */
+static void
+json_siblings_chain(guint first, guint sibling)
+{
+    JSON_SIBLING(JSON_SIBLING(first)->last)->next = sibling;
+    JSON_SIBLING(first)->last = sibling;
+    JSON_SIBLING(first)->count++;
+    JSON_SIBLING(sibling)->count = 0;
+}
+
+/*
+ * Chains the siblings from "first" on that have the same key. The hash
+ * and equality functions are called with sibling indices as keys.
+ */
+static void
+json_siblings_group(guint first, GHashFunc hash_func, GEqualFunc equal_func)
+{
+    guint end = json_siblings->len;
+    GHashTable *first_by_key = NULL;
+    gpointer key_first;
+    guint i, j;
+
+    if (end - first > JSON_SIBLINGS_SCAN_MAX) {
+        first_by_key = g_hash_table_new(hash_func, equal_func);
+    }
+
+    for (i = first; i < end; i++) {
+        if (first_by_key != NULL) {
+            if (g_hash_table_lookup_extended(first_by_key, GUINT_TO_POINTER(i), NULL, &key_first)) {
+                json_siblings_chain(GPOINTER_TO_UINT(key_first), i);
+            } else {
+                g_hash_table_insert(first_by_key, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+            }
+        } else {
+            for (j = first; j < i; j++) {
+                if (JSON_SIBLING(j)->count != 0 && equal_func(GUINT_TO_POINTER(j), GUINT_TO_POINTER(i))) {
+                    json_siblings_chain(j, i);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (first_by_key != NULL) {
+        g_hash_table_destroy(first_by_key);
+    }
+}
+
+static void
+json_siblings_pop(guint first)
+{
+    g_array_set_size(json_siblings, first);
+}
+
+static guint
+json_sibling_key_hash(gconstpointer sibling)
+{
+    return g_str_hash(proto_node_to_json_key(JSON_SIBLING(GPOINTER_TO_UINT(sibling))->node));
+}
+
+static gboolean
+json_sibling_key_equal(gconstpointer sibling_a, gconstpointer sibling_b)
+{
+    proto_node *a = JSON_SIBLING(GPOINTER_TO_UINT(sibling_a))->node;
+    proto_node *b = JSON_SIBLING(GPOINTER_TO_UINT(sibling_b))->node;
+
+    if (a->finfo->hfinfo == b->finfo->hfinfo && a->finfo->hfinfo->id != hf_text_only) {
+        return TRUE;
+    }
+    return strcmp(proto_node_to_json_key(a), proto_node_to_json_key(b)) == 0;
+}
+
+/* Whether fvalue_to_string_repr() would return a string for the value,
+ * without formatting it. */
+static gboolean
+json_node_has_value(field_info *fi)
+{
+    return fi->value.ftype->val_to_string_repr != NULL &&
+           fvalue_string_repr_len(&fi->value, FTREPR_DISPLAY, fi->hfinfo->display) >= 0;
+}
+
 /**
  * Write a json object containing a list of key:value pairs where each key:value pair corresponds to a different json
  * key and its associated nodes in the proto_tree.
- * @param proto_node_list_head A 2-dimensional list containing a list of values for each different node json key. The
- * elements themselves are a linked list of values associated with the same json key.
+ * @param first_sibling Index in json_siblings of the first node of the object. Nodes with the same json key are
+ * chained; only the first node of each chain is written as a key.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
+write_json_proto_node_list(guint first_sibling, write_json_data *pdata)
 {
-    GSList *current_node = proto_node_list_head;
+    guint end = json_siblings->len;
+    guint sibling;
 
     json_dumper_begin_object(pdata->dumper);
 
     // Loop over each list of nodes (differentiated by json key) and write the associated json key:value pair in the
     // output.
-    while (current_node != NULL) {
-        // Get the list of values for the current json key.
-        GSList *node_values_list = (GSList *) current_node->data;
+    for (sibling = first_sibling; sibling < end; sibling++) {
+        if (JSON_SIBLING(sibling)->count == 0) {
+            // Written with the first node with this key.
+            continue;
+        }
 
         // Retrieve the json key from the first value.
-        proto_node *first_value = (proto_node *) node_values_list->data;
+        proto_node *first_value = JSON_SIBLING(sibling)->node;
         const char *json_key = proto_node_to_json_key(first_value);
         // Check if the current json key is filtered from the output with the "-j" cli option.
         gboolean is_filtered = pdata->filter != NULL && !check_protocolfilter(pdata->filter, json_key);
 
         field_info *fi = first_value->finfo;
-        char *value_string_repr = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
 
         // We assume all values of a json key have roughly the same layout. Thus we can use the first value to derive
         // attributes of all the values.
-        gboolean has_value = value_string_repr != NULL;
+        gboolean has_value = json_node_has_value(fi);
         gboolean has_children = first_value->first_child != NULL;
         gboolean is_pseudo_text_field = fi->hfinfo->id == 0;
 
-        wmem_free(NULL, value_string_repr); // fvalue_to_string_repr returns allocated buffer
-
         // "-x" command line option. A "_raw" suffix is added to the json key so the textual value can be printed
         // with the original json key. If both hex and text writing are enabled the raw information of fields whose
         // length is equal to 0 is not written to the output. If the field is a special text pseudo field no raw
         // information is written either.
         if (pdata->print_hex && (!pdata->print_text || fi->length > 0) && !is_pseudo_text_field) {
-            write_json_proto_node(node_values_list, "_raw", write_json_proto_node_hex_dump, pdata);
+            write_json_proto_node(sibling, JSON_KEY_RAW, write_json_proto_node_hex_dump, pdata);
         }
 
         if (pdata->print_text && has_value) {
-            write_json_proto_node(node_values_list, "", write_json_proto_node_value, pdata);
+            write_json_proto_node(sibling, JSON_KEY, write_json_proto_node_value, pdata);
         }
 
         if (has_children) {
             // If a node has both a value and a set of children we print the value and the children in separate
             // key:value pairs. These can't have the same key so whenever a value is already printed with the node
             // json key we print the children with the same key with a "_tree" suffix added.
-            char *suffix = has_value ? "_tree": "";
+            json_key_suffix_e suffix = has_value ? JSON_KEY_TREE : JSON_KEY;
 
             if (is_filtered) {
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_filtered, pdata);
+                write_json_proto_node(sibling, suffix, write_json_proto_node_filtered, pdata);
             } else {
                 // Remove protocol filter for children, if children should be included. This functionality is enabled
                 // with the "-J" command line option. We save the filter so it can be reenabled when we are done with
@@ -829,7 +967,7 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
                     pdata->filter = NULL;
                 }
 
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_children, pdata);
+                write_json_proto_node(sibling, suffix, write_json_proto_node_children, pdata);
 
                 // Put protocol filter back
                 if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
@@ -839,57 +977,106 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
         }
 
         if (!has_value && !has_children && (pdata->print_text || (pdata->print_hex && is_pseudo_text_field))) {
-            write_json_proto_node(node_values_list, "", write_json_proto_node_no_value, pdata);
+            write_json_proto_node(sibling, JSON_KEY, write_json_proto_node_no_value, pdata);
         }
-
-        current_node = current_node->next;
     }
     json_dumper_end_object(pdata->dumper);
 }
 
+typedef struct {
+    const header_field_info *hfinfo;
+    gchar                   *key;
+} json_suffixed_key_t;
+
+/* The "_raw" and "_tree" keys of each field, by field id, made once rather
+ * than for every node. */
+static GArray *json_suffixed_keys[2];
+
+/**
+ * Returns the json key of a node with a suffix. If the key had to be allocated, it's also returned in "allocated",
+ * to be freed by the caller.
+ */
+static const char *
+json_key_with_suffix(proto_node *node, json_key_suffix_e suffix, gchar **allocated)
+{
+    static const char *suffixes[] = { "", "_raw", "_tree" };
+    header_field_info *hfinfo = node->finfo->hfinfo;
+    GArray *cache;
+    json_suffixed_key_t *cached;
+
+    *allocated = NULL;
+    if (suffix == JSON_KEY) {
+        return proto_node_to_json_key(node);
+    }
+    if (hfinfo->id == hf_text_only) {
+        // The key is the text of the item.
+        *allocated = g_strconcat(proto_node_to_json_key(node), suffixes[suffix], NULL);
+        return *allocated;
+    }
+
+    if (json_suffixed_keys[suffix - 1] == NULL) {
+        json_suffixed_keys[suffix - 1] = g_array_new(FALSE, TRUE, sizeof(json_suffixed_key_t));
+    }
+    cache = json_suffixed_keys[suffix - 1];
+    if ((guint)hfinfo->id >= cache->len) {
+        g_array_set_size(cache, hfinfo->id + 1);
+    }
+    cached = &g_array_index(cache, json_suffixed_key_t, hfinfo->id);
+    if (cached->hfinfo != hfinfo) {
+        // Not made yet, or the fields were registered again.
+        g_free(cached->key);
+        cached->hfinfo = hfinfo;
+        cached->key = g_strconcat(hfinfo->abbrev, suffixes[suffix], NULL);
+    }
+    return cached->key;
+}
+
 /**
  * Writes a single node as a key:value pair. The value_writer param can be used to specify how the node's value should
  * be written.
- * @param node_values_head Linked list containing all nodes associated with the same json key in this object.
+ * @param sibling Index in json_siblings of the first node with this json key in this object.
  * @param suffix Suffix that should be added to the json key.
  * @param value_writer A function which writes the actual values of the node json key.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node(GSList *node_values_head,
-                      const char *suffix,
+write_json_proto_node(guint sibling,
+                      json_key_suffix_e suffix,
                       proto_node_value_writer value_writer,
                       write_json_data *pdata)
 {
-    // Retrieve json key from first value.
-    proto_node *first_value = (proto_node *) node_values_head->data;
-    const char *json_key = proto_node_to_json_key(first_value);
-    gchar* json_key_suffix = g_strdup_printf("%s%s", json_key, suffix);
-    json_dumper_set_member_name(pdata->dumper, json_key_suffix);
-    g_free(json_key_suffix);
-    write_json_proto_node_value_list(node_values_head, value_writer, pdata);
+    gchar *allocated;
+
+    json_dumper_set_member_name(pdata->dumper, json_key_with_suffix(JSON_SIBLING(sibling)->node, suffix, &allocated));
+    g_free(allocated);
+    write_json_proto_node_value_list(sibling, value_writer, pdata);
 }
 
 /**
  * Writes a list of values of a single json key. If multiple values are passed they are wrapped in a json array.
- * @param node_values_head Linked list containing all values that should be written.
+ * @param sibling Index in json_siblings of the first node with the key; the others are chained from it.
  * @param value_writer Function which writes the separate values.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node_value_list(GSList *node_values_head, proto_node_value_writer value_writer, write_json_data *pdata)
+write_json_proto_node_value_list(guint sibling, proto_node_value_writer value_writer, write_json_data *pdata)
 {
-    GSList *current_value = node_values_head;
+    guint count = JSON_SIBLING(sibling)->count;
+    guint next;
+    proto_node *node;
 
     // Write directly if only a single value is passed. Wrap in json array otherwise.
-    if (current_value->next == NULL) {
-        value_writer((proto_node *) current_value->data, pdata);
+    if (count == 1) {
+        value_writer(JSON_SIBLING(sibling)->node, pdata);
     } else {
         json_dumper_begin_array(pdata->dumper);
 
-        while (current_value != NULL) {
-            value_writer((proto_node *) current_value->data, pdata);
-            current_value = current_value->next;
+        // The value writers may append to json_siblings, which may move it.
+        while (count-- > 0) {
+            node = JSON_SIBLING(sibling)->node;
+            next = JSON_SIBLING(sibling)->next;
+            value_writer(node, pdata);
+            sibling = next;
         }
         json_dumper_end_array(pdata->dumper);
     }
@@ -971,9 +1158,36 @@ write_json_proto_node_hex_dump(proto_node *node, write_json_data *pdata)
 static void
 write_json_proto_node_children(proto_node *node, write_json_data *data)
 {
-    GSList *grouped_children_list = data->node_children_grouper(node);
-    write_json_proto_node_list(grouped_children_list, data);
-    g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    guint first_sibling = json_siblings_mark();
+    proto_node *child;
+
+    if (data->node_children_grouper == proto_node_group_children_by_unique) {
+        for (child = node->first_child; child != NULL; child = child->next) {
+            json_siblings_push(child);
+        }
+    } else if (data->node_children_grouper == proto_node_group_children_by_json_key) {
+        for (child = node->first_child; child != NULL; child = child->next) {
+            json_siblings_push(child);
+        }
+        json_siblings_group(first_sibling, json_sibling_key_hash, json_sibling_key_equal);
+    } else {
+        // Another grouping; chain the nodes of each of its groups.
+        GSList *grouped_children_list = data->node_children_grouper(node);
+        GSList *group, *value;
+        guint first;
+
+        for (group = grouped_children_list; group != NULL; group = group->next) {
+            value = (GSList *) group->data;
+            first = json_siblings_push((proto_node *) value->data);
+            for (value = value->next; value != NULL; value = value->next) {
+                json_siblings_chain(first, json_siblings_push((proto_node *) value->data));
+            }
+        }
+        g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    }
+
+    write_json_proto_node_list(first_sibling, data);
+    json_siblings_pop(first_sibling);
 }
 
 /**
@@ -983,12 +1197,22 @@ static void
 write_json_proto_node_value(proto_node *node, write_json_data *pdata)
 {
     field_info *fi = node->finfo;
-    // Get the actual value of the node as a string.
-    char *value_string_repr = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
+    char buf[256];
+    int len = fvalue_string_repr_len(&fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
+
+    // Get the actual value of the node as a string; most fit in buf.
+    if (len >= 0 && len < (int)sizeof buf) {
+        // As fvalue_to_string_repr() does, give it a zeroed buffer.
+        memset(buf, 0, len + 1);
+        fi->value.ftype->val_to_string_repr(&fi->value, FTREPR_DISPLAY, fi->hfinfo->display, buf, (unsigned int)len + 1);
+        json_dumper_value_string(pdata->dumper, buf);
+    } else {
+        char *value_string_repr = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
 
-    json_dumper_value_string(pdata->dumper, value_string_repr);
+        json_dumper_value_string(pdata->dumper, value_string_repr);
 
-    wmem_free(NULL, value_string_repr);
+        wmem_free(NULL, value_string_repr);
+    }
 }
 
 /**
@@ -1143,42 +1367,103 @@ write_ek_summary(column_info *cinfo, write_json_data* pdata)
     }
 }
 
-/* Write out a tree's data, and any child nodes, as JSON for EK */
+/*
+ * The name of an EK attribute is the abbreviation of its field, prefixed by
+ * that of its parent and an underscore, if it has one. Attributes with the
+ * same name are grouped.
+ */
+typedef struct {
+    const char *part[3];
+} ek_attr_name_t;
+
+static void
+ek_attr_name(proto_node *node, ek_attr_name_t *name)
+{
+    field_info *fi        = PNODE_FINFO(node);
+    field_info *fi_parent = PNODE_FINFO(node->parent);
+
+    if (fi_parent == NULL) {
+        name->part[0] = fi->hfinfo->abbrev;
+        name->part[1] = "";
+        name->part[2] = "";
+    }
+    else {
+        name->part[0] = fi_parent->hfinfo->abbrev;
+        name->part[1] = "_";
+        name->part[2] = fi->hfinfo->abbrev;
+    }
+}
+
+static guint
+ek_attr_name_hash(gconstpointer sibling)
+{
+    ek_attr_name_t name;
+    const char *p;
+    guint hash = 5381;
+    int i;
+
+    ek_attr_name(JSON_SIBLING(GPOINTER_TO_UINT(sibling))->node, &name);
+    for (i = 0; i < 3; i++) {
+        for (p = name.part[i]; *p != '\0'; p++) {
+            hash = (hash << 5) + hash + (guchar)*p;
+        }
+    }
+    return hash;
+}
+
+static gboolean
+ek_attr_name_equal(gconstpointer sibling_a, gconstpointer sibling_b)
+{
+    proto_node *a = JSON_SIBLING(GPOINTER_TO_UINT(sibling_a))->node;
+    proto_node *b = JSON_SIBLING(GPOINTER_TO_UINT(sibling_b))->node;
+    ek_attr_name_t name_a, name_b;
+    const char *pa, *pb;
+    int ia = 0, ib = 0;
+
+    if (PNODE_FINFO(a)->hfinfo == PNODE_FINFO(b)->hfinfo &&
+        PNODE_FINFO(a->parent) != NULL && PNODE_FINFO(b->parent) != NULL &&
+        PNODE_FINFO(a->parent)->hfinfo == PNODE_FINFO(b->parent)->hfinfo) {
+        return TRUE;
+    }
+
+    /* Compare the concatenated names part by part */
+    ek_attr_name(a, &name_a);
+    ek_attr_name(b, &name_b);
+    pa = name_a.part[0];
+    pb = name_b.part[0];
+    for (;;) {
+        while (*pa == '\0' && ia < 2) {
+            pa = name_a.part[++ia];
+        }
+        while (*pb == '\0' && ib < 2) {
+            pb = name_b.part[++ib];
+        }
+        if (*pa != *pb) {
+            return FALSE;
+        }
+        if (*pa == '\0') {
+            return TRUE;
+        }
+        pa++;
+        pb++;
+    }
+}
+
+/* Appends the attributes of a node, and of the children of those that
+ * aren't protocols, to json_siblings */
 static void
-ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write_json_data *pdata)
+ek_fill_attr(proto_node *node, write_json_data *pdata)
 {
     field_info *fi         = NULL;
-    field_info *fi_parent  = NULL;
-    gchar *node_name       = NULL;
-    GSList *attr_instances = NULL;
 
     proto_node *current_node = node->first_child;
     while (current_node != NULL) {
         fi        = PNODE_FINFO(current_node);
-        fi_parent = PNODE_FINFO(current_node->parent);
 
         /* dissection with an invisible proto tree? */
         g_assert(fi);
 
-        if (fi_parent == NULL) {
-            node_name = g_strdup(fi->hfinfo->abbrev);
-        }
-        else {
-            node_name = g_strconcat(fi_parent->hfinfo->abbrev, "_", fi->hfinfo->abbrev, NULL);
-        }
-
-        attr_instances = (GSList *) g_hash_table_lookup(attr_table, node_name);
-        // First time we encounter this attr
-        if (attr_instances == NULL) {
-            attr_instances = g_slist_append(attr_instances, current_node);
-            *attr_list = g_slist_prepend(*attr_list, attr_instances);
-        }
-        else {
-            attr_instances = g_slist_append(attr_instances, current_node);
-        }
-
-        // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, node_name, attr_instances);
+        json_siblings_push(current_node);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1191,7 +1476,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
                         pdata->filter = NULL;
                     }
 
-                    ek_fill_attr(current_node, attr_list, attr_table, pdata);
+                    ek_fill_attr(current_node, pdata);
 
                     /* Put protocol filter back */
                     if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
@@ -1203,7 +1488,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
                 }
             }
             else {
-                ek_fill_attr(current_node, attr_list, attr_table, pdata);
+                ek_fill_attr(current_node, pdata);
             }
         }
         else {
@@ -1314,56 +1599,60 @@ ek_write_field_value(field_info *fi, write_json_data* pdata)
 }
 
 static void
-ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
+ek_write_attr_hex(guint sibling, write_json_data *pdata)
 {
-    GSList *current_node = attr_instances;
-    proto_node *pnode    = (proto_node *) current_node->data;
+    guint count          = JSON_SIBLING(sibling)->count;
+    proto_node *pnode    = JSON_SIBLING(sibling)->node;
     field_info *fi       = NULL;
+    gboolean is_array    = count > 1;
 
     // Raw name
     ek_write_name(pnode, "_raw", pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (is_array) {
         json_dumper_begin_array(pdata->dumper);
     }
 
     // Raw value(s)
-    while (current_node != NULL) {
-        pnode = (proto_node *) current_node->data;
+    while (count-- > 0) {
+        pnode = JSON_SIBLING(sibling)->node;
         fi    = PNODE_FINFO(pnode);
 
         ek_write_hex(fi, pdata);
 
-        current_node = current_node->next;
+        sibling = JSON_SIBLING(sibling)->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (is_array) {
         json_dumper_end_array(pdata->dumper);
     }
 }
 
 static void
-ek_write_attr(GSList *attr_instances, write_json_data *pdata)
+ek_write_attr(guint sibling, write_json_data *pdata)
 {
-    GSList *current_node = attr_instances;
-    proto_node *pnode    = (proto_node *) current_node->data;
+    guint count          = JSON_SIBLING(sibling)->count;
+    gboolean is_array    = count > 1;
+    proto_node *pnode    = JSON_SIBLING(sibling)->node;
     field_info *fi       = PNODE_FINFO(pnode);
 
     // Hex dump -x
     if (pdata->print_hex && fi && fi->length > 0 && fi->hfinfo->id != hf_text_only) {
-        ek_write_attr_hex(attr_instances, pdata);
+        ek_write_attr_hex(sibling, pdata);
     }
 
     // Print attr name
     ek_write_name(pnode, NULL, pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (is_array) {
         json_dumper_begin_array(pdata->dumper);
     }
 
-    while (current_node != NULL) {
-        pnode = (proto_node *) current_node->data;
-        fi    = PNODE_FINFO(pnode);
+    while (count-- > 0) {
+        /* Objects append to json_siblings, which may move it */
+        pnode   = JSON_SIBLING(sibling)->node;
+        sibling = JSON_SIBLING(sibling)->next;
+        fi      = PNODE_FINFO(pnode);
 
         /* Field */
         if (fi->hfinfo->type != FT_PROTOCOL) {
@@ -1409,11 +1698,9 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
 
             json_dumper_end_object(pdata->dumper);
         }
-
-        current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (is_array) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1422,25 +1709,21 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
 static void
 proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
-    GSList *attr_list  = NULL;
-    GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    guint first_sibling = json_siblings_mark();
+    guint end, sibling;
 
-    ek_fill_attr(node, &attr_list, attr_table, pdata);
-
-    g_hash_table_destroy(attr_table);
+    ek_fill_attr(node, pdata);
+    json_siblings_group(first_sibling, ek_attr_name_hash, ek_attr_name_equal);
 
     // Print attributes
-    attr_list = g_slist_reverse(attr_list);
-    GSList *current_attr = attr_list;
-    while (current_attr != NULL) {
-        GSList *attr_instances = (GSList *) current_attr->data;
-
-        ek_write_attr(attr_instances, pdata);
-
-        current_attr = current_attr->next;
+    end = json_siblings->len;
+    for (sibling = first_sibling; sibling < end; sibling++) {
+        if (JSON_SIBLING(sibling)->count != 0) {
+            ek_write_attr(sibling, pdata);
+        }
     }
 
-    g_slist_free_full(attr_list, (GDestroyNotify) g_slist_free);
+    json_siblings_pop(first_sibling);
 }
 
 /* Print info for a 'geninfo' pseudo-protocol. This is required by
@@ -2031,6 +2314,9 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        g_free(fields->arrow_types);
+        g_free(fields->arrow_seen);
+
         for(i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2192,6 +2478,16 @@ gboolean output_fields_set_option(output_fields_t *info, gchar *option)
         }
         return TRUE;
     }
+    else if (0 == strcmp(option_name, "batch")) {
+        gchar *end;
+        guint64 rows = g_ascii_strtoull(option_value, &end, 10);
+
+        if (*end != '\0' || rows == 0 || rows > G_MAXINT32) {
+            return FALSE;
+        }
+        info->arrow_batch_rows = (guint)rows;
+        return TRUE;
+    }
     else if (0 == strcmp(option_name, "bom")) {
         switch (*option_value) {
         case 'n':
@@ -2218,6 +2514,7 @@ void output_fields_list_options(FILE *fh)
     fputs("occurrence=f|l|a  Select the occurrence of a field to use;\n     \"f\" = first, \"l\" = last, \"a\" = all (def: a: all)\n", fh);
     fputs("aggregator=,|/s|<character>   Set the aggregator to use;\n     \",\" = comma, \"/s\" = space (def: ,: comma)\n", fh);
     fputs("quote=d|s|n   Print either d: double-quotes, s: single quotes or \n     n: no quotes around field values (def: n: none)\n", fh);
+    fputs("batch=<rows>  Number of rows per record batch with -T arrow (def: 65536)\n", fh);
 }
 
 gboolean output_fields_has_cols(output_fields_t* fields)
@@ -2343,27 +2640,9 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
-static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
+static void output_fields_prepare(output_fields_t *fields)
 {
-    gsize     i;
-    gint      col;
-    gchar    *col_name;
-    gpointer  field_index;
-
-    write_field_data_t data;
-
-    g_assert(fields);
-    g_assert(fields->fields);
-    g_assert(edt);
-    /* JSON formats must go through json_dumper */
-    if (format == FORMAT_JSON || format == FORMAT_EK) {
-        g_assert(!fh && dumper);
-    } else {
-        g_assert(fh && !dumper);
-    }
-
-    data.fields = fields;
-    data.edt = edt;
+    guint i;
 
     if (NULL == fields->field_indicies) {
         /* Prepare a lookup table from string abbreviation for field to its index. */
@@ -2388,24 +2667,56 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     /* XXX: ToDo: use packet-scope'd memory & (if/when implemented) wmem ptr_array */
     if (NULL == fields->field_values)
         fields->field_values = g_new0(GPtrArray*, fields->fields->len);  /* free'd in output_fields_free() */
+}
+
+static void output_fields_add_columns(output_fields_t *fields, column_info *cinfo)
+{
+    gint      col;
+    gchar    *col_name;
+    gpointer  field_index;
+
+    if (!fields->includes_col_fields)
+        return;
+
+    for (col = 0; col < cinfo->num_cols; col++) {
+        if (!get_column_visible(col)) continue;
+        /* Prepend COLUMN_FIELD_FILTER as the field name */
+        col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
+        field_index = g_hash_table_lookup(fields->field_indicies, col_name);
+        g_free(col_name);
+
+        if (NULL != field_index) {
+            format_field_values(fields, field_index, g_strdup(cinfo->columns[col].col_data));
+        }
+    }
+}
+
+static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
+{
+    gsize     i;
+
+    write_field_data_t data;
+
+    g_assert(fields);
+    g_assert(fields->fields);
+    g_assert(edt);
+    /* JSON formats must go through json_dumper */
+    if (format == FORMAT_JSON || format == FORMAT_EK) {
+        g_assert(!fh && dumper);
+    } else {
+        g_assert(fh && !dumper);
+    }
+
+    data.fields = fields;
+    data.edt = edt;
+
+    output_fields_prepare(fields);
 
     proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
                                 &data);
 
     /* Add columns to fields */
-    if (fields->includes_col_fields) {
-        for (col = 0; col < cinfo->num_cols; col++) {
-            if (!get_column_visible(col)) continue;
-            /* Prepend COLUMN_FIELD_FILTER as the field name */
-            col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
-            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
-            g_free(col_name);
-
-            if (NULL != field_index) {
-                format_field_values(fields, field_index, g_strdup(cinfo->columns[col].col_data));
-            }
-        }
-    }
+    output_fields_add_columns(fields, cinfo);
 
     switch (format) {
     case FORMAT_CSV:
@@ -2530,6 +2841,218 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+static arrow_ipc_type_e arrow_type_for_ftype(enum ftenum ftype)
+{
+    switch (ftype) {
+    case FT_CHAR:
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_FRAMENUM:
+    case FT_IPv4:
+        return ARROW_IPC_UINT32;
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        return ARROW_IPC_UINT64;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return ARROW_IPC_INT32;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return ARROW_IPC_INT64;
+    case FT_BOOLEAN:
+        return ARROW_IPC_BOOL;
+    case FT_FLOAT:
+        return ARROW_IPC_FLOAT;
+    case FT_DOUBLE:
+        return ARROW_IPC_DOUBLE;
+    case FT_ABSOLUTE_TIME:
+        return ARROW_IPC_TIMESTAMP;
+    case FT_RELATIVE_TIME:
+        return ARROW_IPC_DURATION;
+    default:
+        return ARROW_IPC_STRING;
+    }
+}
+
+/*
+ * The column type of a field. Several fields can share an abbreviation;
+ * if their types don't map to the same column type, the column holds the
+ * values as text, as -T fields would print them.
+ */
+static arrow_ipc_type_e arrow_type_for_field(const gchar *field)
+{
+    header_field_info *hfinfo;
+    arrow_ipc_type_e   type;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+        return ARROW_IPC_STRING;
+
+    hfinfo = proto_registrar_get_byname(field);
+    if (hfinfo == NULL)
+        return ARROW_IPC_STRING;
+    while (hfinfo->same_name_prev_id != -1)
+        hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+
+    type = arrow_type_for_ftype(hfinfo->type);
+    for (hfinfo = hfinfo->same_name_next; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+        if (arrow_type_for_ftype(hfinfo->type) != type)
+            return ARROW_IPC_STRING;
+    }
+    return type;
+}
+
+static void arrow_set_field_value(output_fields_t *fields, guint col, field_info *fi)
+{
+    const nstime_t *ts;
+
+    switch (fields->arrow_types[col]) {
+    case ARROW_IPC_UINT32:
+        if (fi->hfinfo->type == FT_IPv4) {
+            /* The value is in network byte order */
+            arrow_ipc_set_uint(fields->arrow, col, g_ntohl(fvalue_get_uinteger(&fi->value)));
+        } else {
+            arrow_ipc_set_uint(fields->arrow, col, fvalue_get_uinteger(&fi->value));
+        }
+        break;
+    case ARROW_IPC_UINT64:
+    case ARROW_IPC_BOOL:
+        arrow_ipc_set_uint(fields->arrow, col, fvalue_get_uinteger64(&fi->value));
+        break;
+    case ARROW_IPC_INT32:
+        arrow_ipc_set_int(fields->arrow, col, fvalue_get_sinteger(&fi->value));
+        break;
+    case ARROW_IPC_INT64:
+        arrow_ipc_set_int(fields->arrow, col, fvalue_get_sinteger64(&fi->value));
+        break;
+    case ARROW_IPC_FLOAT:
+    case ARROW_IPC_DOUBLE:
+        arrow_ipc_set_double(fields->arrow, col, fvalue_get_floating(&fi->value));
+        break;
+    case ARROW_IPC_TIMESTAMP:
+    case ARROW_IPC_DURATION:
+        ts = (const nstime_t *)fvalue_get(&fi->value);
+        arrow_ipc_set_int(fields->arrow, col, (gint64)ts->secs * 1000000000 + ts->nsecs);
+        break;
+    case ARROW_IPC_STRING:
+        g_assert_not_reached();
+        break;
+    }
+}
+
+static void proto_tree_get_node_arrow_values(proto_node *node, gpointer data)
+{
+    write_field_data_t *call_data;
+    field_info *fi;
+    gpointer    field_index;
+    guint       col;
+
+    call_data = (write_field_data_t *)data;
+    fi = PNODE_FINFO(node);
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        col = GPOINTER_TO_UINT(field_index) - 1;
+        if (call_data->fields->arrow_types[col] == ARROW_IPC_STRING) {
+            format_field_values(call_data->fields, field_index,
+                                get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
+                );
+        } else if (call_data->fields->occurrence == 'l' || !call_data->fields->arrow_seen[col]) {
+            /* A typed column holds one value; "all" keeps the first */
+            arrow_set_field_value(call_data->fields, col, fi);
+            call_data->fields->arrow_seen[col] = TRUE;
+        }
+    }
+
+    /* Recurse here. */
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_arrow_values,
+                                    call_data);
+    }
+}
+
+void write_arrow_preamble(output_fields_t* fields, FILE *fh)
+{
+    guint i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    output_fields_prepare(fields);
+
+    fields->arrow = arrow_ipc_writer_new(fh, fields->arrow_batch_rows);
+    fields->arrow_types = g_new(arrow_ipc_type_e, fields->fields->len);
+    fields->arrow_seen = g_new0(gboolean, fields->fields->len);
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        fields->arrow_types[i] = arrow_type_for_field(field);
+        arrow_ipc_writer_add_column(fields->arrow, field, fields->arrow_types[i]);
+    }
+}
+
+void write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo)
+{
+    write_field_data_t data;
+    guint i, j;
+
+    g_assert(fields);
+    g_assert(fields->arrow);
+    g_assert(edt);
+
+    data.fields = fields;
+    data.edt = edt;
+
+    memset(fields->arrow_seen, 0, fields->fields->len * sizeof(gboolean));
+    proto_tree_children_foreach(edt->tree, proto_tree_get_node_arrow_values,
+                                &data);
+    output_fields_add_columns(fields, cinfo);
+
+    /* The text columns, joined with the aggregator as for -T fields */
+    for (i = 0; i < fields->fields->len; i++) {
+        GPtrArray *fv_p = fields->field_values[i];
+        GString   *value;
+
+        if (NULL == fv_p)
+            continue;
+
+        value = g_string_new(NULL);
+        for (j = 0; j < g_ptr_array_len(fv_p); j++) {
+            gchar *str = (gchar *)g_ptr_array_index(fv_p, j);
+
+            g_string_append(value, str);
+            g_free(str);
+        }
+        arrow_ipc_set_string(fields->arrow, i, value->str);
+        g_string_free(value, TRUE);
+        g_ptr_array_free(fv_p, TRUE);  /* get ready for the next packet */
+        fields->field_values[i] = NULL;
+    }
+
+    arrow_ipc_end_row(fields->arrow);
+}
+
+void write_arrow_finale(output_fields_t* fields)
+{
+    g_assert(fields);
+
+    if (fields->arrow) {
+        arrow_ipc_writer_finish(fields->arrow);
+        fields->arrow = NULL;
+    }
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2667,6 +3190,10 @@ output_fields_t* output_fields_new(void)
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->arrow_batch_rows    = 65536;
+    fields->arrow               = NULL;
+    fields->arrow_types         = NULL;
+    fields->arrow_seen          = NULL;
     return fields;
 }
 
@@ -397,6 +397,44 @@ free_fragments(gpointer data, gpointer user_data _U_)
 	g_slice_free(fragment_item, fd_head);
 }
 
+/*
+ * Index over the fragment list of one reassembly, for tables using
+ * REASSEMBLY_STORE_INDEXED.
+ *
+ * The list stays the authoritative, sorted store; the index remembers,
+ * for every offset, the last fragment in the list with that offset, so
+ * that the insertion point of a new fragment can be found without
+ * walking the list.  It also tracks how many bytes are available
+ * contiguously from offset 0, together with the last fragment that was
+ * taken into account for that, so the "have we got everything" check
+ * only needs to look at fragments past that one.
+ */
+typedef struct {
+	wmem_tree_t   *by_offset;	/* offset -> last fragment with that offset */
+	fragment_item *contig_last;	/* last fragment folded into contig_len */
+	guint32        contig_len;	/* bytes available contiguously from 0 */
+} fragment_index;
+
+static void
+fragment_index_free(gpointer data)
+{
+	fragment_index *idx = (fragment_index *)data;
+
+	wmem_tree_destroy(idx->by_offset, FALSE, FALSE);
+	g_free(idx);
+}
+
+/*
+ * Drop the index of a reassembly, if it has one.  Must be called before
+ * the fragment_head is freed, or it is removed from the fragment table.
+ */
+static void
+fragment_index_remove(reassembly_table *table, fragment_head *fd_head)
+{
+	if (table->fragment_indexes != NULL)
+		g_hash_table_remove(table->fragment_indexes, fd_head);
+}
+
 typedef struct register_reassembly_table {
 	reassembly_table *table;
 	const reassembly_table_functions *funcs;
@@ -447,6 +485,8 @@ reassembly_table_init(reassembly_table *table,
 		 */
 		g_hash_table_foreach_remove(table->fragment_table,
 					    free_all_fragments, NULL);
+		if (table->fragment_indexes != NULL)
+			g_hash_table_remove_all(table->fragment_indexes);
 	} else {
 		/* The fragment table does not exist. Create it */
 		table->fragment_table = g_hash_table_new_full(funcs->hash_func,
@@ -507,6 +547,10 @@ reassembly_table_destroy(reassembly_table *table)
 		g_hash_table_destroy(table->fragment_table);
 		table->fragment_table = NULL;
 	}
+	if (table->fragment_indexes != NULL) {
+		g_hash_table_destroy(table->fragment_indexes);
+		table->fragment_indexes = NULL;
+	}
 	if (table->reassembled_table != NULL) {
 		GPtrArray *allocated_fragments;
 
@@ -532,6 +576,16 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+/*
+ * Select how the fragments of the table's reassemblies are stored.
+ */
+void
+reassembly_table_set_fragment_store(reassembly_table *table,
+				    reassembly_fragment_store store)
+{
+	table->fragment_store = store;
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -614,6 +668,7 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		g_slice_free(fragment_item, fd);
 		fd=tmp_fd;
 	}
+	fragment_index_remove(table, fd_head);
 	g_slice_free(fragment_head, fd_head);
 	g_hash_table_remove(table->fragment_table, key);
 
@@ -854,6 +909,14 @@ fragment_set_partial_reassembly(reassembly_table *table,
 static void
 fragment_unhash(reassembly_table *table, gpointer key)
 {
+	/*
+	 * Nothing adds fragments to a reassembly that's no longer in
+	 * the fragment table, so its index, if any, can go.
+	 */
+	if (table->fragment_indexes != NULL)
+		fragment_index_remove(table,
+		    (fragment_head *)g_hash_table_lookup(table->fragment_table, key));
+
 	/*
 	 * Remove the entry from the fragment table.
 	 */
@@ -968,6 +1031,96 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	fd_i->next = fd;
 }
 
+/*
+ * Take fragments that start within the contiguous data into account,
+ * continuing from the last fragment that was.  As the list is sorted,
+ * this stops at the first gap, exactly like the loop computing "max" in
+ * fragment_add_work(); every fragment is passed over only once.
+ */
+static void
+fragment_index_advance(fragment_index *idx)
+{
+	fragment_item *fd;
+
+	while ((fd = idx->contig_last->next) != NULL &&
+	    fd->offset <= idx->contig_len) {
+		if (fd->offset + fd->len > idx->contig_len)
+			idx->contig_len = fd->offset + fd->len;
+		idx->contig_last = fd;
+	}
+}
+
+/*
+ * Get the index of a reassembly, creating it from the fragment list if
+ * it doesn't exist yet.  Returns NULL if the table doesn't use indexed
+ * fragment storage, or if the reassembly is complete and isn't to be
+ * extended, as then no fragments will be linked in.
+ */
+static fragment_index *
+fragment_index_get(reassembly_table *table, fragment_head *fd_head)
+{
+	fragment_index *idx;
+	fragment_item *fd;
+
+	if (table->fragment_store != REASSEMBLY_STORE_INDEXED)
+		return NULL;
+
+	if ((fd_head->flags & (FD_DEFRAGMENTED|FD_PARTIAL_REASSEMBLY)) ==
+	    FD_DEFRAGMENTED) {
+		/* in case reassembly threw before the index could go */
+		fragment_index_remove(table, fd_head);
+		return NULL;
+	}
+
+	if (table->fragment_indexes == NULL) {
+		table->fragment_indexes = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, NULL, fragment_index_free);
+	} else {
+		idx = (fragment_index *)g_hash_table_lookup(table->fragment_indexes, fd_head);
+		if (idx != NULL)
+			return idx;
+	}
+
+	idx = g_new(fragment_index, 1);
+	idx->by_offset = wmem_tree_new(NULL);
+	for (fd = fd_head->next; fd != NULL; fd = fd->next)
+		wmem_tree_insert32(idx->by_offset, fd->offset, fd);
+	idx->contig_last = fd_head;
+	idx->contig_len = 0;
+	fragment_index_advance(idx);
+	g_hash_table_insert(table->fragment_indexes, fd_head, idx);
+	return idx;
+}
+
+/*
+ * Like LINK_FRAG(), but finds the insertion point with the index, and
+ * keeps the index up to date.
+ */
+static void
+fragment_index_link(fragment_index *idx, fragment_head *fd_head,
+		    fragment_item *fd)
+{
+	fragment_item *fd_i;
+
+	/* insert after the last fragment with an offset <= ours */
+	fd_i = (fragment_item *)wmem_tree_lookup32_le(idx->by_offset, fd->offset);
+	if (fd_i == NULL)
+		fd_i = fd_head;
+	fd->next = fd_i->next;
+	fd_i->next = fd;
+	wmem_tree_insert32(idx->by_offset, fd->offset, fd);
+
+	/*
+	 * A fragment starting within the contiguous data may have been
+	 * linked in before contig_last, where fragment_index_advance()
+	 * won't see it.
+	 */
+	if (fd->offset <= idx->contig_len &&
+	    fd->offset + fd->len > idx->contig_len)
+		idx->contig_len = fd->offset + fd->len;
+	fragment_index_advance(idx);
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -990,9 +1143,10 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
  * are lowered when a new extension process is started.
  */
 static gboolean
-fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
-		 const packet_info *pinfo, const guint32 frag_offset,
-		 const guint32 frag_data_len, const gboolean more_frags)
+fragment_add_work(fragment_head *fd_head, fragment_index *idx, tvbuff_t *tvb,
+		 const int offset, const packet_info *pinfo,
+		 const guint32 frag_offset, const guint32 frag_data_len,
+		 const gboolean more_frags)
 {
 	fragment_item *fd;
 	fragment_item *fd_i;
@@ -1127,7 +1281,10 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 			fd_head->flags |= FD_OVERLAPCONFLICT;
 		}
 		/* it was just an overlap, link it and return */
-		LINK_FRAG(fd_head,fd);
+		if (idx)
+			fragment_index_link(idx, fd_head, fd);
+		else
+			LINK_FRAG(fd_head,fd);
 		return TRUE;
 	}
 
@@ -1141,7 +1298,10 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		THROW(BoundsError);
 	}
 	fd->tvb_data = tvb_clone_offset_len(tvb, offset, fd->len);
-	LINK_FRAG(fd_head,fd);
+	if (idx)
+		fragment_index_link(idx, fd_head, fd);
+	else
+		LINK_FRAG(fd_head,fd);
 
 
 	if( !(fd_head->flags & FD_DATALEN_SET) ){
@@ -1162,11 +1322,15 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 * previous fragment, i.e. fragments that have a gap between
 	 * them and the previous fragment.)
 	 */
-	max = 0;
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if ( ((fd_i->offset)<=max) &&
-			((fd_i->offset+fd_i->len)>max) ){
-			max = fd_i->offset+fd_i->len;
+	if (idx) {
+		max = idx->contig_len;
+	} else {
+		max = 0;
+		for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+			if ( ((fd_i->offset)<=max) &&
+				((fd_i->offset+fd_i->len)>max) ){
+				max = fd_i->offset+fd_i->len;
+			}
 		}
 	}
 
@@ -1498,11 +1662,14 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
-	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+	if (fragment_add_work(fd_head, fragment_index_get(table, fd_head),
+		tvb, offset, pinfo, frag_offset, frag_data_len, more_frags)) {
 		/*
-		 * Reassembly is complete.
+		 * Reassembly is complete.  The reassembly stays in the
+		 * fragment table, but its index is only needed again if
+		 * it is extended, and is then rebuilt from the list.
 		 */
+		fragment_index_remove(table, fd_head);
 		return fd_head;
 	} else {
 		/*
@@ -1581,8 +1748,8 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	if (tvb_reported_length(tvb) > tvb_captured_length(tvb))
 		return NULL;
 
-	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+	if (fragment_add_work(fd_head, fragment_index_get(table, fd_head),
+		tvb, offset, pinfo, frag_offset, frag_data_len, more_frags)) {
 		/*
 		 * Reassembly is complete.
 		 * Remove this from the table of in-progress
@@ -121,6 +121,28 @@ typedef gpointer (*fragment_temporary_key)(const packet_info *pinfo,
 typedef gpointer (*fragment_persistent_key)(const packet_info *pinfo,
     const guint32 id, const void *data);
 
+/*
+ * How the fragments of an in-progress reassembly are stored.
+ *
+ * The fragments are always available to dissectors as a list sorted by
+ * offset, hanging off the fragment_head.  With REASSEMBLY_STORE_LIST,
+ * that list is all there is, and adding a fragment with fragment_add()
+ * and friends walks it, which is fine for the handful of fragments an
+ * IP datagram has but quadratic for long, out-of-order byte streams.
+ *
+ * With REASSEMBLY_STORE_INDEXED, each reassembly also gets a tree
+ * keyed by fragment offset and keeps track of how much data is
+ * available contiguously from the start, so adding a fragment costs
+ * O(log n) regardless of arrival order.  This costs a tree node per
+ * fragment for as long as the reassembly is in the fragment table.
+ * Only the byte-offset routines (fragment_add, fragment_add_check,
+ * fragment_add_multiple_ok) use the index.
+ */
+typedef enum {
+	REASSEMBLY_STORE_LIST,		/* sorted list only (default) */
+	REASSEMBLY_STORE_INDEXED	/* sorted list plus offset index */
+} reassembly_fragment_store;
+
 /*
  * Data structure to keep track of fragments and reassemblies.
  */
@@ -130,6 +152,8 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	reassembly_fragment_store fragment_store;	/* see reassembly_table_set_fragment_store() */
+	GHashTable *fragment_indexes;			/* fragment_head -> index, for REASSEMBLY_STORE_INDEXED */
 } reassembly_table;
 
 /*
@@ -175,6 +199,16 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Select how the fragments of the table's reassemblies are stored; see
+ * reassembly_fragment_store.  The choice survives re-initialization of
+ * the table, so it only needs to be made once, typically right after
+ * reassembly_table_register().
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_fragment_store(reassembly_table *table,
+				    reassembly_fragment_store store);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
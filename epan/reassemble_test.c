@@ -43,6 +43,7 @@
 #include "config.h"
 
 #include <epan/packet.h>
+#include <epan/exceptions.h>
 #include <epan/packet_info.h>
 #include <epan/proto.h>
 #include <epan/tvbuff.h>
@@ -1511,6 +1512,240 @@ test_missing_data_fragment_add_seq_next_3(void)
 #endif
 
 
+/**********************************************************************************
+ *
+ * fragment_add with the indexed fragment store
+ *
+ *********************************************************************************/
+
+/* A fragment to add: the data comes from "tvb_offset" in the test tvb, so
+ * that overlapping fragments can carry the same or different data. */
+typedef struct {
+    guint32 frag_offset;
+    guint32 len;
+    guint32 tvb_offset;
+    gboolean more_frags;
+} test_frag_t;
+
+/* Adds "frags" to datagram "id" with the given fragment store, checking
+ * that only the last one completes the reassembly, and returns what that
+ * one returned.
+ */
+static fragment_head *
+add_test_frags(reassembly_fragment_store store, guint32 id,
+               const test_frag_t *frags, guint num_frags)
+{
+    fragment_head *fd_head = NULL;
+    guint i;
+
+    reassembly_table_set_fragment_store(&test_reassembly_table, store);
+    for (i = 0; i < num_frags; i++) {
+        pinfo.num = i + 1;
+        fd_head=fragment_add(&test_reassembly_table, tvb, frags[i].tvb_offset,
+                             &pinfo, id, NULL, frags[i].frag_offset,
+                             frags[i].len, frags[i].more_frags);
+        if (i != num_frags - 1) {
+            ASSERT_EQ_POINTER(NULL,fd_head);
+        }
+    }
+    ASSERT_NE_POINTER(NULL,fd_head);
+    reassembly_table_set_fragment_store(&test_reassembly_table,
+                                        REASSEMBLY_STORE_LIST);
+    return fd_head;
+}
+
+/* Checks that the index of a reassembly is gone once it is complete. */
+static void
+assert_no_fragment_indexes(void)
+{
+    if (test_reassembly_table.fragment_indexes != NULL) {
+        ASSERT_EQ(0,g_hash_table_size(test_reassembly_table.fragment_indexes));
+    }
+}
+
+/* Overlapping fragments, arriving out of order, some with the same data
+ * as what they overlap and one with different data, must give the same
+ * result with both stores.
+ */
+static void
+test_fragment_add_indexed_overlap(void)
+{
+    static const test_frag_t frags[] = {
+        { 100, 20, 100, FALSE },   /* the tail */
+        {  30, 50,  30, TRUE },    /* overlaps the next one, same data */
+        {   0, 50,   0, TRUE },
+        {  30, 10,  30, TRUE },    /* a duplicate within the data */
+        {  80, 30,  81, TRUE },    /* overlaps the tail, different data */
+    };
+    fragment_head *list_head, *indexed_head;
+    fragment_item *list_fd, *indexed_fd;
+
+    printf("Starting test test_fragment_add_indexed_overlap\n");
+
+    list_head = add_test_frags(REASSEMBLY_STORE_LIST, 12, frags,
+                               G_N_ELEMENTS(frags));
+    indexed_head = add_test_frags(REASSEMBLY_STORE_INDEXED, 13, frags,
+                                  G_N_ELEMENTS(frags));
+    assert_no_fragment_indexes();
+
+    ASSERT_EQ(120,indexed_head->datalen);
+    ASSERT_EQ(5,indexed_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP|FD_OVERLAPCONFLICT,
+              indexed_head->flags);
+    ASSERT(!tvb_memeql(indexed_head->tvb_data, 0, data, 80));
+    ASSERT(!tvb_memeql(indexed_head->tvb_data, 80, data+81, 30));
+    ASSERT(!tvb_memeql(indexed_head->tvb_data, 110, data+110, 10));
+
+    /* the fragments are listed in the same order, with the same flags */
+    ASSERT_EQ(list_head->flags,indexed_head->flags);
+    ASSERT(!tvb_memeql(indexed_head->tvb_data, 0,
+                       tvb_get_ptr(list_head->tvb_data, 0, 120), 120));
+    for (list_fd = list_head->next, indexed_fd = indexed_head->next;
+         list_fd != NULL && indexed_fd != NULL;
+         list_fd = list_fd->next, indexed_fd = indexed_fd->next) {
+        ASSERT_EQ(list_fd->frame,indexed_fd->frame);
+        ASSERT_EQ(list_fd->offset,indexed_fd->offset);
+        ASSERT_EQ(list_fd->flags,indexed_fd->flags);
+    }
+    ASSERT_EQ_POINTER(NULL,list_fd);
+    ASSERT_EQ_POINTER(NULL,indexed_fd);
+}
+
+/* A completed reassembly is extended with fragment_set_partial_reassembly();
+ * its index is rebuilt from the fragment list, and dropped again once the
+ * extended reassembly completes.
+ */
+static void
+test_fragment_add_indexed_partial_reassembly(void)
+{
+    static const test_frag_t first[] = {
+        {  50, 50,  50, FALSE },
+        {   0, 50,   0, TRUE },
+    };
+    fragment_head *fd_head;
+    volatile gboolean thrown;
+
+    printf("Starting test test_fragment_add_indexed_partial_reassembly\n");
+
+    fd_head = add_test_frags(REASSEMBLY_STORE_INDEXED, 12, first,
+                             G_N_ELEMENTS(first));
+    ASSERT_EQ(100,fd_head->datalen);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    assert_no_fragment_indexes();
+
+    fragment_set_partial_reassembly(&test_reassembly_table, &pinfo, 12, NULL);
+    reassembly_table_set_fragment_store(&test_reassembly_table,
+                                        REASSEMBLY_STORE_INDEXED);
+
+    /* a new tail, leaving a gap */
+    pinfo.num = 3;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 150, &pinfo, 12, NULL,
+                         150, 50, FALSE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_indexes));
+
+    /* filling the gap completes it */
+    pinfo.num = 4;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 100, &pinfo, 12, NULL,
+                         100, 50, TRUE);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(200,fd_head->datalen);
+    ASSERT_EQ(4,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    ASSERT(!tvb_memeql(fd_head->tvb_data, 0, data, 200));
+    assert_no_fragment_indexes();
+
+    /* a retransmission within the data, with no extension asked for,
+     * is rejected without building an index, and leaves the reassembly
+     * as it was */
+    pinfo.num = 5;
+    thrown = FALSE;
+    TRY {
+        fragment_add(&test_reassembly_table, tvb, 20, &pinfo, 12, NULL,
+                     20, 10, TRUE);
+    }
+    CATCH(ReassemblyError) {
+        thrown = TRUE;
+    }
+    ENDTRY;
+    ASSERT(thrown);
+    fd_head=fragment_get(&test_reassembly_table, &pinfo, 12, NULL);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(200,fd_head->datalen);
+    ASSERT_EQ(4,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    assert_no_fragment_indexes();
+
+    reassembly_table_set_fragment_store(&test_reassembly_table,
+                                        REASSEMBLY_STORE_LIST);
+}
+
+#define STRESS_FRAGMENTS 100000
+
+/* Adds num_frags one-byte fragments of datagram "id" in a scrambled order,
+ * using the given fragment store, and checks that the datagram is complete
+ * exactly when the last one has been added, with the right contents.
+ */
+static void
+stress_fragment_add(reassembly_fragment_store store, guint32 id,
+                    guint32 num_frags)
+{
+    fragment_head *fd_head = NULL;
+    guint32 i, frag_offset;
+
+    reassembly_table_set_fragment_store(&test_reassembly_table, store);
+
+    for (i = 0; i < num_frags; i++) {
+        /* 7919 is prime, so this visits every offset once */
+        frag_offset = (guint32)(((guint64)i * 7919) % num_frags);
+        pinfo.num = i + 1;
+        fd_head=fragment_add(&test_reassembly_table, tvb, frag_offset % DATA_LEN,
+                             &pinfo, id, NULL, frag_offset, 1,
+                             frag_offset != num_frags - 1);
+        if (i != num_frags - 1) {
+            ASSERT_EQ_POINTER(NULL,fd_head);
+        }
+    }
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(num_frags,fd_head->datalen);
+    ASSERT_EQ(num_frags,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    for (i = 0; i < num_frags; i++) {
+        ASSERT_EQ(i & 0xFF,tvb_get_guint8(fd_head->tvb_data, i));
+    }
+
+    reassembly_table_set_fragment_store(&test_reassembly_table,
+                                        REASSEMBLY_STORE_LIST);
+}
+
+/* Reassembles a long datagram from fragments arriving out of order, as
+ * with a long TCP stream with losses, once with each fragment store.
+ * The list store is quadratic in the number of fragments, so it only
+ * gets a tenth of them.
+ */
+static void
+test_fragment_add_out_of_order_stress(void)
+{
+    tvbuff_t *reassembled;
+
+    printf("Starting test test_fragment_add_out_of_order_stress\n");
+
+    stress_fragment_add(REASSEMBLY_STORE_LIST, 12, STRESS_FRAGMENTS / 10);
+    ASSERT_EQ_POINTER(NULL,test_reassembly_table.fragment_indexes);
+
+    stress_fragment_add(REASSEMBLY_STORE_INDEXED, 13, STRESS_FRAGMENTS);
+    ASSERT_NE_POINTER(NULL,test_reassembly_table.fragment_indexes);
+    assert_no_fragment_indexes();
+
+    pinfo.num = STRESS_FRAGMENTS;
+    reassembled = fragment_delete(&test_reassembly_table, &pinfo, 13, NULL);
+    ASSERT_NE_POINTER(NULL,reassembled);
+    tvb_free(reassembled);
+    assert_no_fragment_indexes();
+}
+
+
 /**********************************************************************************
  *
  * main
@@ -1535,6 +1770,9 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_seq_802_11_0,
         test_fragment_add_seq_802_11_1,
         test_simple_fragment_add_seq_next,
+        test_fragment_add_indexed_overlap,
+        test_fragment_add_indexed_partial_reassembly,
+        test_fragment_add_out_of_order_stress,
 #if 0
         test_missing_data_fragment_add_seq_next,
         test_missing_data_fragment_add_seq_next_2,
@@ -84,6 +84,7 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	guint filter_index;	/* index of "code" in tap_filters */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -93,6 +94,12 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/* The filters of all tap listeners, tested together so that fields
+ * used by several of them are read only once per packet; rebuilt from
+ * tap_listener_queue whenever a listener or its filter changes. */
+static dfilter_multi_t *tap_filters=NULL;
+static gboolean tap_filters_changed=TRUE;
+
 #ifdef HAVE_PLUGINS
 static GSList *tap_plugins = NULL;
 
@@ -278,6 +285,24 @@ tap_queue_init(epan_dissect_t *edt)
 	tap_build_interesting (edt);
 }
 
+static void
+tap_filters_rebuild(void)
+{
+	tap_listener_t *tl;
+
+	if(!tap_filters){
+		tap_filters=dfilter_multi_new();
+	} else {
+		dfilter_multi_clear(tap_filters);
+	}
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->code){
+			tl->filter_index=dfilter_multi_add(tap_filters, tl->code);
+		}
+	}
+	tap_filters_changed=FALSE;
+}
+
 /* this function is called after a packet has been fully dissected to push the tapped
    data to all extensions that has callbacks registered.
 */
@@ -300,6 +325,12 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	if(tap_filters_changed){
+		tap_filters_rebuild();
+	} else {
+		dfilter_multi_reset(tap_filters);
+	}
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -330,7 +361,12 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 * packet passes.
 					 */
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						/* A listener callback may have
+						 * changed a filter meanwhile. */
+						if(tap_filters_changed){
+							tap_filters_rebuild();
+						}
+						if (!dfilter_multi_apply_one(tap_filters, edt, tl->filter_index)){
 							/* The packet didn't
 							 * pass the filter. */
 							continue;
@@ -554,6 +590,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	tap_filters_changed=TRUE;
 
 	return NULL;
 }
@@ -590,6 +627,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 			tl->code=NULL;
 		}
 		tl->needs_redraw=TRUE;
+		tap_filters_changed=TRUE;
 		g_free(tl->fstring);
 		if(fstring){
 			if(!dfilter_compile(fstring, &code, &err_msg)){
@@ -636,6 +674,7 @@ tap_listeners_dfilter_recompile(void)
 		}
 		tl->code=code;
 	}
+	tap_filters_changed=TRUE;
 }
 
 /* this function removes a tap listener
@@ -667,6 +706,7 @@ remove_tap_listener(void *tapdata)
 		}
 	}
 	free_tap_listener(tl);
+	tap_filters_changed=TRUE;
 }
 
 /*
@@ -749,6 +789,9 @@ void tap_cleanup(void)
 		head_lq = head_lq->next;
 		free_tap_listener(elem_lq);
 	}
+	dfilter_multi_free(tap_filters);
+	tap_filters=NULL;
+	tap_filters_changed=TRUE;
 
 	while(head_dl){
 		elem_dl = head_dl;
@@ -485,6 +485,151 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+/* The byte-at-a-time equivalents of the line scanning functions, for
+ * the line in data[offset, offset + len). */
+static gint
+scan_line_end(const guint8 *data, gint offset, gint len, gint *next_offset,
+	      gboolean desegment, gboolean unquoted)
+{
+	gboolean quoted = FALSE;
+	gint     eob_offset = offset + len;
+	gint     i;
+
+	for (i = offset; i < eob_offset; i++) {
+		if (unquoted && data[i] == '"') {
+			quoted = !quoted;
+			continue;
+		}
+		if (quoted || (data[i] != '\r' && data[i] != '\n'))
+			continue;
+		if (data[i] == '\r') {
+			if (i + 1 >= eob_offset) {
+				if (desegment)
+					return -1;
+			} else if (data[i + 1] == '\n') {
+				*next_offset = i + 2;
+				return i - offset;
+			}
+		}
+		*next_offset = i + 1;
+		return i - offset;
+	}
+	if (desegment)
+		return -1;
+	*next_offset = eob_offset;
+	return len;
+}
+
+static gint
+scan_guint16(const guint8 *data, gint offset, gint len, guint16 needle)
+{
+	gint i;
+
+	for (i = offset; i + 1 < offset + len; i++) {
+		if (data[i] == (needle >> 8) && data[i + 1] == (needle & 0xFF))
+			return i;
+	}
+	return -1;
+}
+
+/* Checks the scanning functions at every offset of a tvbuff, with and
+ * without a maximum length. */
+static void
+test_scan_tvb(tvbuff_t *tvb, const gchar *name, const guint8 *data, gint length)
+{
+	static const guint16 needles[] = { 0x0d0a, 0x0b1c, 0x2222, 0x6100 };
+	gint offset, len, i;
+
+	for (offset = 0; offset <= length; offset++) {
+		for (len = -1; len <= length - offset; len += (len < 4 ? 1 : 7)) {
+			gint window = len == -1 ? length - offset : len;
+			gint expected, actual, expected_next = -1, actual_next = -1;
+			int desegment;
+
+			for (desegment = 0; desegment < 2; desegment++) {
+				expected = scan_line_end(data, offset, window, &expected_next, desegment, FALSE);
+				actual = tvb_find_line_end(tvb, offset, len, &actual_next, desegment);
+				if (actual != expected || (expected != -1 && actual_next != expected_next)) {
+					printf("03: Failed TVB=%s tvb_find_line_end(%d, %d, %d) = %d/%d, expected %d/%d\n",
+					       name, offset, len, desegment, actual, actual_next, expected, expected_next);
+					failed = TRUE;
+					return;
+				}
+			}
+
+			expected = scan_line_end(data, offset, window, &expected_next, FALSE, TRUE);
+			actual = tvb_find_line_end_unquoted(tvb, offset, len, &actual_next);
+			if (actual != expected || actual_next != expected_next) {
+				printf("03: Failed TVB=%s tvb_find_line_end_unquoted(%d, %d) = %d/%d, expected %d/%d\n",
+				       name, offset, len, actual, actual_next, expected, expected_next);
+				failed = TRUE;
+				return;
+			}
+
+			for (i = 0; i < (gint) G_N_ELEMENTS(needles); i++) {
+				expected = scan_guint16(data, offset, window, needles[i]);
+				actual = tvb_find_guint16(tvb, offset, len, needles[i]);
+				if (actual != expected) {
+					printf("03: Failed TVB=%s tvb_find_guint16(%d, %d, 0x%04x) = %d, expected %d\n",
+					       name, offset, len, needles[i], actual, expected);
+					failed = TRUE;
+					return;
+				}
+			}
+		}
+	}
+}
+
+/* Runs the scanning functions over text with line terminators, quotes
+ * and NULs scattered through it at various densities, in real, subset
+ * and composite tvbuffs, so that the vectorized scanners start and end
+ * at every alignment. */
+static void
+run_scan_tests(void)
+{
+	static const guint8 specials[] = { '\r', '\n', '"', '\0', 0x0b, 0x1c };
+	GRand    *rand = g_rand_new_with_seed(1);
+	tvbuff_t *tvb_parent = tvb_new_real_data("", 0, 0);
+	int       round;
+
+	for (round = 0; round < 40; round++) {
+		gint      length = g_rand_int_range(rand, 1, 160);
+		gint      density = g_rand_int_range(rand, 2, 64);
+		guint8   *data = (guint8 *)g_malloc(length);
+		tvbuff_t *tvb, *tvb_subset, *tvb_comp;
+		gint      i, split;
+
+		for (i = 0; i < length; i++) {
+			if (g_rand_int_range(rand, 0, density) == 0)
+				data[i] = specials[g_rand_int_range(rand, 0, G_N_ELEMENTS(specials))];
+			else
+				data[i] = (guint8)g_rand_int_range(rand, 'a', 'd');
+		}
+
+		tvb = tvb_new_child_real_data(tvb_parent, data, length, length);
+		tvb_set_free_cb(tvb, g_free);
+		test_scan_tvb(tvb, "Scan real", data, length);
+
+		split = g_rand_int_range(rand, 0, length);
+		tvb_subset = tvb_new_subset_remaining(tvb, split);
+		test_scan_tvb(tvb_subset, "Scan subset", data + split, length - split);
+
+		if (split > 0) {
+			tvb_comp = tvb_new_composite();
+			tvb_composite_append(tvb_comp, tvb_new_subset_length(tvb, 0, split));
+			tvb_composite_append(tvb_comp, tvb_subset);
+			tvb_composite_finalize(tvb_comp);
+			test_scan_tvb(tvb_comp, "Scan composite", data, length);
+		}
+	}
+
+	if (!failed)
+		printf("Passed scanning tests\n");
+
+	tvb_free_chain(tvb_parent);
+	g_rand_free(rand);
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
 main(void)
@@ -495,6 +640,7 @@ main(void)
 
 	except_init();
 	run_tests();
+	run_scan_tests();
 	except_deinit();
 	exit(failed?1:0);
 }
@@ -32,6 +32,7 @@
 #include "wsutil/unicode-utils.h"
 #include "wsutil/nstime.h"
 #include "wsutil/time_util.h"
+#include "wsutil/ws_memscan.h"
 #include "tvbuff.h"
 #include "tvbuff-int.h"
 #include "strutil.h"
@@ -2072,6 +2073,35 @@ tvb_get_bits(tvbuff_t *tvb, const guint bit_offset, const gint no_of_bits, const
 	return (guint32)_tvb_get_bits64(tvb, bit_offset, no_of_bits);
 }
 
+/*
+ * Returns a pointer to the bytes that the functions below that scan for
+ * a delimiter look at: those from offset on, but no more than maxlength
+ * of them, if it's not -1, and none past the end of the tvbuff. Sets
+ * *abs_offset to the offset of the first and *limit to their number, and
+ * returns NULL if there are none.
+ * Throws an exception only if offset itself is out of bounds.
+ */
+static const guint8 *
+tvb_scan_ptr(tvbuff_t *tvb, const gint offset, const gint maxlength, guint *abs_offset, guint *limit)
+{
+	int exception;
+
+	exception = compute_offset_and_remaining(tvb, offset, abs_offset, limit);
+	if (exception)
+		THROW(exception);
+
+	if (maxlength >= 0 && *limit > (guint) maxlength)
+		*limit = (guint) maxlength;
+
+	if (*limit == 0)
+		return NULL;
+
+	if (tvb->real_data)
+		return tvb->real_data + *abs_offset;
+
+	return ensure_contiguous(tvb, *abs_offset, *limit); /* tvb_get_ptr() */
+}
+
 static gint
 tvb_find_guint8_generic(tvbuff_t *tvb, guint abs_offset, guint limit, guint8 needle)
 {
@@ -2137,41 +2167,22 @@ gint
 tvb_find_guint16(tvbuff_t *tvb, const gint offset, const gint maxlength,
 		 const guint16 needle)
 {
-	const guint8 needle1 = ((needle & 0xFF00) >> 8);
-	const guint8 needle2 = ((needle & 0x00FF) >> 0);
-	gint searched_bytes = 0;
-	gint pos = offset;
-
-	do {
-		gint offset1 =
-			tvb_find_guint8(tvb, pos, maxlength - searched_bytes, needle1);
-		gint offset2 = -1;
-
-		if (offset1 == -1) {
-			return -1;
-		}
-
-		searched_bytes = offset - pos + 1;
-
-		if ((maxlength != -1) && (searched_bytes >= maxlength)) {
-			return -1;
-		}
-
-		offset2 = tvb_find_guint8(tvb, offset1 + 1, 1, needle2);
+	const guint8 *ptr;
+	const guint8 *result;
+	guint	      abs_offset = 0;
+	guint	      limit = 0;
 
-		searched_bytes += 1;
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
 
-		if (offset2 != -1) {
-			if ((maxlength != -1) && (searched_bytes > maxlength)) {
-				return -1;
-			}
-			return offset1;
-		}
+	ptr = tvb_scan_ptr(tvb, offset, maxlength, &abs_offset, &limit);
+	if (ptr == NULL)
+		return -1;
 
-		pos = offset1 + 1;
-	} while (searched_bytes < maxlength);
+	result = ws_memscan_pair(ptr, limit, (guint8) (needle >> 8), (guint8) (needle & 0xFF));
+	if (result == NULL)
+		return -1;
 
-	return -1;
+	return (gint) ((result - ptr) + abs_offset);
 }
 
 static inline gint
@@ -3403,7 +3414,6 @@ gboolean tvb_ascii_isprint(tvbuff_t *tvb, const gint offset, const gint length)
 }
 
 
-static ws_mempbrk_pattern pbrk_crlf;
 /*
  * Given a tvbuff, an offset into the tvbuff, and a length that starts
  * at that offset (which may be -1 for "all the way to the end of the
@@ -3426,11 +3436,14 @@ static ws_mempbrk_pattern pbrk_crlf;
 gint
 tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset, const gboolean desegment)
 {
-	gint   eob_offset;
-	gint   eol_offset;
-	int    linelen;
-	guchar found_needle = 0;
-	static gboolean compiled = FALSE;
+	gint          eob_offset;
+	gint          eol_offset;
+	int           linelen;
+	guchar        found_needle = 0;
+	const guint8 *ptr;
+	const guint8 *eol = NULL;
+	guint         abs_offset = 0;
+	guint         limit = 0;
 
 	DISSECTOR_ASSERT(tvb && tvb->initialized);
 
@@ -3441,16 +3454,13 @@ tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset,
 
 	eob_offset = offset + len;
 
-	if (!compiled) {
-		ws_mempbrk_compile(&pbrk_crlf, "\r\n");
-		compiled = TRUE;
-	}
-
 	/*
 	 * Look either for a CR or an LF.
 	 */
-	eol_offset = tvb_ws_mempbrk_pattern_guint8(tvb, offset, len, &pbrk_crlf, &found_needle);
-	if (eol_offset == -1) {
+	ptr = tvb_scan_ptr(tvb, offset, len, &abs_offset, &limit);
+	if (ptr)
+		eol = ws_memscan_crlf(ptr, limit);
+	if (eol == NULL) {
 		/*
 		 * No CR or LF - line is presumably continued in next packet.
 		 */
@@ -3470,6 +3480,9 @@ tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset,
 				*next_offset = eob_offset;
 		}
 	} else {
+		eol_offset = (gint) ((eol - ptr) + abs_offset);
+		found_needle = *eol;
+
 		/*
 		 * Find the number of bytes between the starting offset
 		 * and the CR or LF.
@@ -3527,7 +3540,6 @@ tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset,
 	return linelen;
 }
 
-static ws_mempbrk_pattern pbrk_crlf_dquote;
 /*
  * Given a tvbuff, an offset into the tvbuff, and a length that starts
  * at that offset (which may be -1 for "all the way to the end of the
@@ -3549,133 +3561,73 @@ static ws_mempbrk_pattern pbrk_crlf_dquote;
 gint
 tvb_find_line_end_unquoted(tvbuff_t *tvb, const gint offset, int len, gint *next_offset)
 {
-	gint     cur_offset, char_offset;
-	gboolean is_quoted;
-	guchar   c = 0;
-	gint     eob_offset;
-	int      linelen;
-	static gboolean compiled = FALSE;
+	gint          char_offset;
+	gint          eob_offset;
+	int           linelen;
+	const guint8 *ptr;
+	const guint8 *eol = NULL;
+	guint         abs_offset = 0;
+	guint         limit = 0;
 
 	DISSECTOR_ASSERT(tvb && tvb->initialized);
 
 	if (len == -1)
 		len = _tvb_captured_length_remaining(tvb, offset);
 
-	if (!compiled) {
-		ws_mempbrk_compile(&pbrk_crlf_dquote, "\r\n\"");
-		compiled = TRUE;
-	}
-
 	/*
 	 * XXX - what if "len" is still -1, meaning "offset is past the
 	 * end of the tvbuff"?
 	 */
 	eob_offset = offset + len;
 
-	cur_offset = offset;
-	is_quoted  = FALSE;
-	for (;;) {
-			/*
-		 * Is this part of the string quoted?
+	/*
+	 * Look for a CR or an LF that isn't inside a quoted string.
+	 */
+	ptr = tvb_scan_ptr(tvb, offset, len, &abs_offset, &limit);
+	if (ptr)
+		eol = ws_memscan_crlf_unquoted(ptr, limit);
+	if (eol == NULL) {
+		/*
+		 * Not found - line is presumably continued in
+		 * next packet.
+		 * We pretend the line runs to the end of the tvbuff.
 		 */
-		if (is_quoted) {
-			/*
-			 * Yes - look only for the terminating quote.
-			 */
-			char_offset = tvb_find_guint8(tvb, cur_offset, len,
-				'"');
-		} else {
-			/*
-			 * Look either for a CR, an LF, or a '"'.
-			 */
-			char_offset = tvb_ws_mempbrk_pattern_guint8(tvb, cur_offset, len, &pbrk_crlf_dquote, &c);
-		}
-		if (char_offset == -1) {
-			/*
-			 * Not found - line is presumably continued in
-			 * next packet.
-			 * We pretend the line runs to the end of the tvbuff.
-			 */
-			linelen = eob_offset - offset;
-			if (next_offset)
-				*next_offset = eob_offset;
-			break;
-		}
-
-		if (is_quoted) {
-			/*
-			 * We're processing a quoted string.
-			 * We only looked for ", so we know it's a ";
-			 * as we're processing a quoted string, it's a
-			 * closing quote.
-			 */
-			is_quoted = FALSE;
-		} else {
-			/*
-			 * OK, what is it?
-			 */
-			if (c == '"') {
-				/*
-				 * Un-quoted "; it begins a quoted
-				 * string.
-				 */
-				is_quoted = TRUE;
-			} else {
-				/*
-				 * It's a CR or LF; we've found a line
-				 * terminator.
-				 *
-				 * Find the number of bytes between the
-				 * starting offset and the CR or LF.
-				 */
-				linelen = char_offset - offset;
-
-				/*
-				 * Is it a CR?
-				 */
-				if (c == '\r') {
-					/*
-					 * Yes; is it followed by an LF?
-					 */
-					if (char_offset + 1 < eob_offset &&
-						tvb_get_guint8(tvb, char_offset + 1)
-						  == '\n') {
-						/*
-						 * Yes; skip over the CR.
-						 */
-						char_offset++;
-					}
-				}
+		linelen = eob_offset - offset;
+		if (next_offset)
+			*next_offset = eob_offset;
+		return linelen;
+	}
 
-				/*
-				 * Return the offset of the character after
-				 * the last character in the line, skipping
-				 * over the last character in the line
-				 * terminator, and quit.
-				 */
-				if (next_offset)
-					*next_offset = char_offset + 1;
-				break;
-			}
-		}
+	/*
+	 * Find the number of bytes between the starting offset and the
+	 * CR or LF.
+	 */
+	char_offset = (gint) ((eol - ptr) + abs_offset);
+	linelen = char_offset - offset;
 
+	/*
+	 * Is it a CR?
+	 */
+	if (*eol == '\r') {
 		/*
-		 * Step past the character we found.
+		 * Yes; is it followed by an LF?
 		 */
-		cur_offset = char_offset + 1;
-		if (cur_offset >= eob_offset) {
+		if (char_offset + 1 < eob_offset &&
+			tvb_get_guint8(tvb, char_offset + 1) == '\n') {
 			/*
-			 * The character we found was the last character
-			 * in the tvbuff - line is presumably continued in
-			 * next packet.
-			 * We pretend the line runs to the end of the tvbuff.
+			 * Yes; skip over the CR.
 			 */
-			linelen = eob_offset - offset;
-			if (next_offset)
-				*next_offset = eob_offset;
-			break;
+			char_offset++;
 		}
 	}
+
+	/*
+	 * Return the offset of the character after the last character
+	 * in the line, skipping over the last character in the line
+	 * terminator.
+	 */
+	if (next_offset)
+		*next_offset = char_offset + 1;
 	return linelen;
 }
 
@@ -498,7 +498,9 @@ WS_DLL_PUBLIC const guint8 *tvb_get_ptr(tvbuff_t *tvb, const gint offset,
 WS_DLL_PUBLIC gint tvb_find_guint8(tvbuff_t *tvb, const gint offset,
     const gint maxlength, const guint8 needle);
 
-/** Same as tvb_find_guint8() with 16bit needle. */
+/** Same as tvb_find_guint8() with 16bit needle, which is looked for in
+ * network byte order. Both of its bytes must be within maxlength bytes
+ * of offset. */
 WS_DLL_PUBLIC gint tvb_find_guint16(tvbuff_t *tvb, const gint offset,
     const gint maxlength, const guint16 needle);
 
@@ -0,0 +1,173 @@
+/* uint_dtbl.c
+ * Compact maps from integers to pointers, used to look up entries in
+ * uint dissector tables
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "uint_dtbl.h"
+
+#define UINT_DTBL_MIN_DENSE 16
+#define UINT_DTBL_MIN_SLOTS 8
+
+uint_dtbl_t *
+uint_dtbl_new(void)
+{
+    return g_new0(uint_dtbl_t, 1);
+}
+
+void
+uint_dtbl_free(uint_dtbl_t *map)
+{
+    if (map == NULL)
+        return;
+    g_free(map->dense);
+    g_free(map->slots);
+    g_free(map);
+}
+
+void
+uint_dtbl_clear(uint_dtbl_t *map)
+{
+    g_free(map->dense);
+    g_free(map->slots);
+    memset(map, 0, sizeof *map);
+}
+
+static void
+uint_dtbl_grow_dense(uint_dtbl_t *map, guint32 key)
+{
+    guint32 size = map->dense_size ? map->dense_size : UINT_DTBL_MIN_DENSE;
+
+    while (size <= key)
+        size *= 2;
+    map->dense = (void **)g_realloc(map->dense, size * sizeof *map->dense);
+    memset(map->dense + map->dense_size, 0, (size - map->dense_size) * sizeof *map->dense);
+    map->dense_size = size;
+}
+
+/* Puts key in the first free slot from its home slot on; the key must
+ * not be there already, and there must be a free slot. */
+static void
+uint_dtbl_place(uint_dtbl_t *map, guint32 key, void *value)
+{
+    guint32 i;
+
+    for (i = UINT_DTBL_HASH(map, key); map->slots[i].value != NULL; i = (i + 1) & map->mask)
+        ;
+    map->slots[i].key = key;
+    map->slots[i].value = value;
+}
+
+static void
+uint_dtbl_resize(uint_dtbl_t *map, guint32 nslots)
+{
+    uint_dtbl_slot_t *old_slots = map->slots;
+    guint32 old_nslots = map->slots ? map->mask + 1 : 0;
+    guint32 i;
+
+    map->slots = g_new0(uint_dtbl_slot_t, nslots);
+    map->mask = nslots - 1;
+    map->shift = 32;
+    while (nslots > 1) {
+        nslots >>= 1;
+        map->shift--;
+    }
+    for (i = 0; i < old_nslots; i++) {
+        if (old_slots[i].value != NULL)
+            uint_dtbl_place(map, old_slots[i].key, old_slots[i].value);
+    }
+    g_free(old_slots);
+}
+
+void
+uint_dtbl_insert(uint_dtbl_t *map, guint32 key, void *value)
+{
+    guint32 i;
+
+    g_assert(value != NULL);
+
+    if (key < UINT_DTBL_DENSE_MAX) {
+        if (key >= map->dense_size)
+            uint_dtbl_grow_dense(map, key);
+        map->dense[key] = value;
+        return;
+    }
+
+    map->hot_value = NULL;
+    if (map->slots != NULL) {
+        for (i = UINT_DTBL_HASH(map, key); map->slots[i].value != NULL; i = (i + 1) & map->mask) {
+            if (map->slots[i].key == key) {
+                map->slots[i].value = value;
+                return;
+            }
+        }
+    }
+
+    /* Keep it at most half full, so that probe sequences stay short. */
+    if (map->slots == NULL)
+        uint_dtbl_resize(map, UINT_DTBL_MIN_SLOTS);
+    else if ((map->count + 1) * 2 > map->mask + 1)
+        uint_dtbl_resize(map, (map->mask + 1) * 2);
+    uint_dtbl_place(map, key, value);
+    map->count++;
+}
+
+void
+uint_dtbl_remove(uint_dtbl_t *map, guint32 key)
+{
+    guint32 i, j, home;
+
+    if (key < map->dense_size) {
+        map->dense[key] = NULL;
+        return;
+    }
+    if (map->count == 0)
+        return;
+
+    map->hot_value = NULL;
+    for (i = UINT_DTBL_HASH(map, key); map->slots[i].value != NULL; i = (i + 1) & map->mask) {
+        if (map->slots[i].key == key)
+            break;
+    }
+    if (map->slots[i].value == NULL)
+        return;
+
+    /*
+     * Rather than leave a tombstone, move back any later key in the run
+     * whose home slot isn't between the hole and it, so that no key is
+     * cut off from its home slot.
+     */
+    for (j = (i + 1) & map->mask; map->slots[j].value != NULL; j = (j + 1) & map->mask) {
+        home = UINT_DTBL_HASH(map, map->slots[j].key);
+        if (((j - home) & map->mask) >= ((j - i) & map->mask)) {
+            map->slots[i] = map->slots[j];
+            i = j;
+        }
+    }
+    map->slots[i].value = NULL;
+    map->count--;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,100 @@
+/* uint_dtbl.h
+ * Compact maps from integers to pointers, used to look up entries in
+ * uint dissector tables
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __UINT_DTBL_H__
+#define __UINT_DTBL_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Every uint dissector table is searched on every packet that reaches
+ * it (ethertype, ip.proto, tcp.port, udp.port and so on), so packet.c
+ * keeps one of these alongside each table's GHashTable, which is still
+ * used for everything else.
+ *
+ * Small keys, which is all of them in tables such as ip.proto and most
+ * of the busy ones in port tables, are looked up in a dense array that
+ * grows to cover the largest one seen, up to UINT_DTBL_DENSE_MAX. The
+ * rest are kept in an open-addressing table with linear probing, which
+ * is never more than half full, and whose slots hold the key next to
+ * the value, so a lookup is usually a single cache miss. The last key
+ * found in it is remembered, as a port is usually looked up for many
+ * packets in a row.
+ *
+ * Values may not be NULL; NULL marks an empty slot.
+ */
+
+#define UINT_DTBL_DENSE_MAX 1024
+
+typedef struct {
+    guint32  key;
+    void    *value;
+} uint_dtbl_slot_t;
+
+typedef struct {
+    void   **dense;         /* values for keys below dense_size */
+    guint32  dense_size;
+    uint_dtbl_slot_t *slots;    /* open addressing, for the other keys */
+    guint32  mask;          /* number of slots - 1 */
+    guint32  shift;         /* 32 - log2(number of slots) */
+    guint32  count;         /* keys in slots */
+    guint32  hot_key;       /* last key found in slots, if hot_value */
+    void    *hot_value;
+} uint_dtbl_t;
+
+uint_dtbl_t *uint_dtbl_new(void);
+
+void uint_dtbl_free(uint_dtbl_t *map);
+
+/* Removes every key. */
+void uint_dtbl_clear(uint_dtbl_t *map);
+
+/* Sets the value for key, replacing any value it has. */
+void uint_dtbl_insert(uint_dtbl_t *map, guint32 key, void *value);
+
+void uint_dtbl_remove(uint_dtbl_t *map, guint32 key);
+
+/* Fibonacci hashing: the top bits of the product are well mixed even for
+ * runs of consecutive ports. */
+#define UINT_DTBL_HASH(map, key) (((key) * 0x9E3779B1U) >> (map)->shift)
+
+/* Returns the value for key, or NULL if it has none. */
+static inline void *
+uint_dtbl_lookup(uint_dtbl_t *map, guint32 key)
+{
+    guint32 i;
+
+    if (key < map->dense_size)
+        return map->dense[key];
+    if (map->count == 0)
+        return NULL;
+    if (map->hot_value != NULL && map->hot_key == key)
+        return map->hot_value;
+
+    for (i = UINT_DTBL_HASH(map, key); map->slots[i].value != NULL; i = (i + 1) & map->mask) {
+        if (map->slots[i].key == key) {
+            map->hot_key = key;
+            map->hot_value = map->slots[i].value;
+            return map->hot_value;
+        }
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __UINT_DTBL_H__ */
@@ -0,0 +1,204 @@
+/* uint_dtbl_test.c
+ * Standalone program to test the uint dissector table maps against a
+ * GHashTable, and to compare the cost of a lookup in each.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "uint_dtbl.h"
+
+#define LOOKUPS		(1 << 20)
+
+static gboolean failed = FALSE;
+
+static void
+check(const char *op, guint32 key, void *actual, void *expected)
+{
+	if (actual != expected) {
+		printf("Failed %s of %u: %p, expected %p\n", op, key, actual, expected);
+		failed = TRUE;
+	}
+}
+
+/* A key from a mix of small and large ones, clustered the way ports are. */
+static guint32
+random_key(GRand *rand)
+{
+	switch (g_rand_int_range(rand, 0, 4)) {
+	case 0:
+		return g_rand_int_range(rand, 0, 64);
+	case 1:
+		return g_rand_int_range(rand, 0, 2048);
+	case 2:
+		return g_rand_int_range(rand, 0, 65536);
+	default:
+		return g_rand_int(rand);
+	}
+}
+
+/* Random inserts, replacements and removals, with every key looked up in
+ * both after each one that changes the map. */
+static void
+test_correctness(void)
+{
+	GRand       *rand = g_rand_new_with_seed(1);
+	GHashTable  *reference = g_hash_table_new(g_direct_hash, g_direct_equal);
+	uint_dtbl_t *map = uint_dtbl_new();
+	guint32      keys[512];
+	guint        nkeys = 0;
+	int          i;
+	guint        j;
+
+	for (i = 0; i < 100000 && !failed; i++) {
+		guint32 key;
+		void   *value = GUINT_TO_POINTER(g_rand_int(rand) | 1);
+
+		if (nkeys > 0 && g_rand_int_range(rand, 0, 2) == 0)
+			key = keys[g_rand_int_range(rand, 0, nkeys)];
+		else
+			key = random_key(rand);
+
+		switch (g_rand_int_range(rand, 0, 5)) {
+		case 0:
+		case 1:
+			uint_dtbl_insert(map, key, value);
+			g_hash_table_insert(reference, GUINT_TO_POINTER(key), value);
+			if (nkeys < G_N_ELEMENTS(keys))
+				keys[nkeys++] = key;
+			break;
+		case 2:
+			uint_dtbl_remove(map, key);
+			g_hash_table_remove(reference, GUINT_TO_POINTER(key));
+			break;
+		default:
+			check("lookup", key, uint_dtbl_lookup(map, key),
+			      g_hash_table_lookup(reference, GUINT_TO_POINTER(key)));
+			continue;
+		}
+
+		for (j = 0; j < nkeys; j++)
+			check("lookup", keys[j], uint_dtbl_lookup(map, keys[j]),
+			      g_hash_table_lookup(reference, GUINT_TO_POINTER(keys[j])));
+
+		/* Start over now and then, so that small maps are tested too. */
+		if (i % 5000 == 4999) {
+			uint_dtbl_clear(map);
+			g_hash_table_remove_all(reference);
+			nkeys = 0;
+		}
+	}
+
+	uint_dtbl_free(map);
+	g_hash_table_destroy(reference);
+	g_rand_free(rand);
+}
+
+/*
+ * Key sets like those of some busy tables, looked up with a mix of keys
+ * that are in the table and keys that aren't.
+ */
+typedef struct {
+	const char *name;
+	guint       nkeys;
+	guint32     max_key;
+} table_profile_t;
+
+static const table_profile_t profiles[] = {
+	{ "ip.proto",    140,   256 },
+	{ "ethertype",   250,   65536 },
+	{ "tcp.port",    1600,  65536 },
+	{ "udp.port",    1200,  65536 },
+	{ "sctp.ppi",    60,    0x10000000 },
+};
+
+static void
+report_lookup_cost(const table_profile_t *profile)
+{
+	GRand       *rand = g_rand_new_with_seed(2);
+	GHashTable  *hash_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+	uint_dtbl_t *map = uint_dtbl_new();
+	guint32     *lookups = g_new(guint32, LOOKUPS);
+	guint32     *keys = g_new(guint32, profile->nkeys);
+	gint64       start;
+	double       hash_ns, map_ns;
+	guintptr     hits = 0;
+	guint        i;
+
+	for (i = 0; i < profile->nkeys; i++) {
+		keys[i] = g_rand_int_range(rand, 0, profile->max_key);
+		g_hash_table_insert(hash_table, GUINT_TO_POINTER(keys[i]), GUINT_TO_POINTER(i + 1));
+		uint_dtbl_insert(map, keys[i], GUINT_TO_POINTER(i + 1));
+	}
+	/* Runs of the same key, as consecutive packets of a flow give. */
+	for (i = 0; i < LOOKUPS; i++) {
+		if (i % 4 != 0)
+			lookups[i] = lookups[i - 1];
+		else if (g_rand_boolean(rand))
+			lookups[i] = keys[g_rand_int_range(rand, 0, profile->nkeys)];
+		else
+			lookups[i] = g_rand_int_range(rand, 0, profile->max_key);
+	}
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUPS; i++)
+		hits += GPOINTER_TO_UINT(g_hash_table_lookup(hash_table, GUINT_TO_POINTER(lookups[i])));
+	hash_ns = (g_get_monotonic_time() - start) * 1e3 / LOOKUPS;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUPS; i++)
+		hits -= GPOINTER_TO_UINT(uint_dtbl_lookup(map, lookups[i]));
+	map_ns = (g_get_monotonic_time() - start) * 1e3 / LOOKUPS;
+
+	if (hits != 0) {
+		printf("Failed: %s lookups disagree\n", profile->name);
+		failed = TRUE;
+	}
+	printf("%-10s %5u keys: GHashTable %6.2f ns, uint_dtbl %6.2f ns per lookup\n",
+	       profile->name, profile->nkeys, hash_ns, map_ns);
+
+	g_free(keys);
+	g_free(lookups);
+	uint_dtbl_free(map);
+	g_hash_table_destroy(hash_table);
+	g_rand_free(rand);
+}
+
+int
+main(void)
+{
+	guint i;
+
+	test_correctness();
+	if (failed)
+		exit(1);
+	printf("Passed uint dissector table tests\n");
+
+	for (i = 0; i < G_N_ELEMENTS(profiles); i++)
+		report_lookup_cost(&profiles[i]);
+
+	return failed ? 1 : 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -41,6 +41,7 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    allocator->bytes_allocated += size;
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,9 +94,16 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     g_assert(allocator->in_scope);
 
+    allocator->bytes_allocated += size;
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
+guint64
+wmem_allocated_bytes(wmem_allocator_t *allocator)
+{
+    return allocator->bytes_allocated;
+}
+
 static void
 wmem_free_all_real(wmem_allocator_t *allocator, gboolean final)
 {
@@ -142,6 +150,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = TRUE;
+    allocator->bytes_allocated = 0;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -166,6 +166,18 @@ WS_DLL_PUBLIC
 void
 wmem_free_all(wmem_allocator_t *allocator);
 
+/** Returns the total number of bytes that have been asked of the allocator
+ * since it was created, whether or not they have been freed since. A
+ * reallocation counts its full new size. Comparing this before and after
+ * some work tells how much that work allocated.
+ *
+ * @param allocator The allocator to ask.
+ * @return The number of bytes.
+ */
+WS_DLL_PUBLIC
+guint64
+wmem_allocated_bytes(wmem_allocator_t *allocator);
+
 /** Triggers a garbage-collection in the allocator. This does not free any
  * memory, but it can return unused blocks to the operating system or perform
  * other optimizations.
@@ -43,6 +43,7 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
     allocator->type = type;
     allocator->callbacks = NULL;
     allocator->in_scope = TRUE;
+    allocator->bytes_allocated = 0;
 
     switch (type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -235,6 +236,7 @@ wmem_test_allocator_jumbo(wmem_allocator_type_t type, wmem_verify_func verify)
     wmem_free(allocator, ptr);
     wmem_gc(allocator);
     ptr = (char*)wmem_alloc0(allocator, 4*1024*1024);
+    g_assert(wmem_allocated_bytes(allocator) == 8*1024*1024);
 
     if (verify) (*verify)(allocator);
     wmem_free(allocator, ptr);
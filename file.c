@@ -50,6 +50,7 @@
 #include "frame_tvbuff.h"
 
 #include "ui/alert_box.h"
+#include "ui/filter_cache.h"
 #include "ui/simple_dialog.h"
 #include "ui/main_statusbar.h"
 #include "ui/progress_dlg.h"
@@ -116,6 +117,12 @@ static void ref_time_packets(capture_file *cf);
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
+/* Memory kept for the results of earlier display filters. */
+#define FILTER_CACHE_SIZE (64 * 1024 * 1024)
+
+/* Records read ahead, in another thread, while loading a file. */
+#define READ_AHEAD_COUNT 256
+
 /*
  * We could probably use g_signal_...() instead of the callbacks below but that
  * would require linking our CLI programs to libgobject and creating an object
@@ -394,6 +401,8 @@ cf_close(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  filter_cache_free(cf->filter_cache);
+  cf->filter_cache = NULL;
   if (cf->provider.frames != NULL) {
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
@@ -578,6 +587,9 @@ cf_read(capture_file *cf, gboolean reloading)
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
 
+  /* Let another thread read and decompress the file while we dissect. */
+  wtap_read_ahead_start(cf->provider.wth, READ_AHEAD_COUNT);
+
   TRY {
     int     count             = 0;
 
@@ -678,7 +690,8 @@ cf_read(capture_file *cf, gboolean reloading)
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
-  /* Close the sequential I/O side, to free up memory it requires. */
+  /* Close the sequential I/O side, to free up memory it requires;
+     this also stops reading ahead. */
   wtap_sequential_close(cf->provider.wth);
 
   /* Allow the protocol dissectors to free up memory that they
@@ -1541,6 +1554,8 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 void
 cf_reftime_packets(capture_file *cf)
 {
+  /* frame.time_relative and frame.ref_time change. */
+  filter_cache_clear(cf->filter_cache);
   ref_time_packets(cf);
 }
 
@@ -1624,6 +1639,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  const frame_bitmap_t *cached_matches = NULL;
+  frame_bitmap_t *matches = NULL;
+  gboolean    known_unmatched;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1637,7 +1655,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
    * We assume this will not fail since cf->dfilter is only set in
    * cf_filter IFF the filter was valid.
    */
-  compiled = dfilter_compile(cf->dfilter, &dfcode, NULL);
+  compiled = dfilter_compile_parts(cf->dfilter, &dfcode, NULL);
   g_assert(!cf->dfilter || (compiled && dfcode));
 
   /* Get the union of the flags for all tap listeners. */
@@ -1699,6 +1717,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     cf->epan = ws_epan_new(cf);
     cf->cinfo.epan = cf->epan;
 
+    /* Earlier filter results may no longer hold. */
+    filter_cache_clear(cf->filter_cache);
+
     /* A new Lua tap listener may be registered in lua_prime_all_fields()
        called via epan_new() / init_dissection() when reloading Lua plugins. */
     if (!create_proto_tree && have_filtering_tap_listeners()) {
@@ -1750,6 +1771,20 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
   frames_count = cf->count;
 
+  /*
+   * If earlier filters tell which frames match this one, and no tap
+   * listener needs to see every frame, only the matching frames have
+   * to be dissected. Otherwise note which frames match, for next time.
+   */
+  if (dfcode != NULL) {
+    if (cf->filter_cache == NULL)
+      cf->filter_cache = filter_cache_new(FILTER_CACHE_SIZE);
+    if (!redissect && !tap_listeners_require_dissection())
+      cached_matches = filter_cache_lookup(cf->filter_cache, dfcode, frames_count);
+    if (cached_matches == NULL)
+      matches = frame_bitmap_new();
+  }
+
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
 
   if (redissect) {
@@ -1837,7 +1872,11 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
+    /* Reference frames are displayed whether or not they match. */
+    known_unmatched = cached_matches != NULL && !fdata->ref_time &&
+                      !frame_bitmap_contains(cached_matches, framenum);
+
+    if (!known_unmatched && !cf_read_record(cf, fdata, &rec, &buf))
       break; /* error reading the frame */
 
     /* If the previous frame is displayed, and we haven't yet seen the
@@ -1848,9 +1887,18 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (known_unmatched) {
+      frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                    &cf->provider.ref, cf->provider.prev_dis);
+      cf->provider.prev_cap = fdata;
+      fdata->passed_dfilter = 0;
+    } else {
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
+      if (matches != NULL && fdata->passed_dfilter)
+        frame_bitmap_add(matches, framenum);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1876,6 +1924,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
+  /* Keep the results only if every frame was filtered. */
+  if (matches != NULL) {
+    if (framenum > frames_count)
+      filter_cache_insert(cf->filter_cache, dfcode, frames_count, matches);
+    else
+      frame_bitmap_free(matches);
+  }
+
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
 
@@ -3902,6 +3958,7 @@ cf_mark_frame(capture_file *cf, frame_data *frame)
     frame->marked = TRUE;
     if (cf->count > cf->marked_count)
       cf->marked_count++;
+    filter_cache_clear(cf->filter_cache);
   }
 }
 
@@ -3915,6 +3972,7 @@ cf_unmark_frame(capture_file *cf, frame_data *frame)
     frame->marked = FALSE;
     if (cf->marked_count > 0)
       cf->marked_count--;
+    filter_cache_clear(cf->filter_cache);
   }
 }
 
@@ -3928,6 +3986,7 @@ cf_ignore_frame(capture_file *cf, frame_data *frame)
     frame->ignored = TRUE;
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
+    filter_cache_clear(cf->filter_cache);
   }
 }
 
@@ -3941,6 +4000,7 @@ cf_unignore_frame(capture_file *cf, frame_data *frame)
     frame->ignored = FALSE;
     if (cf->ignored_count > 0)
       cf->ignored_count--;
+    filter_cache_clear(cf->filter_cache);
   }
 }
 
@@ -4052,6 +4112,7 @@ cf_set_user_packet_comment(capture_file *cf, frame_data *fd, const gchar *new_co
     cf->packet_comment_count++;
 
   cap_file_provider_set_user_comment(&cf->provider, fd, new_comment);
+  filter_cache_clear(cf->filter_cache);
 
   expert_update_comment_count(cf->packet_comment_count);
 
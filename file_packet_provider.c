@@ -26,16 +26,10 @@ frame_cmp(gconstpointer a, gconstpointer b, gpointer user_data _U_)
 const char *
 cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32 interface_id)
 {
-  wtapng_iface_descriptions_t *idb_info;
-  wtap_block_t wtapng_if_descr = NULL;
+  wtap_block_t wtapng_if_descr;
   char* interface_name;
 
-  idb_info = wtap_file_get_idb_info(prov->wth);
-
-  if (interface_id < idb_info->interface_data->len)
-    wtapng_if_descr = g_array_index(idb_info->interface_data, wtap_block_t, interface_id);
-
-  g_free(idb_info);
+  wtapng_if_descr = wtap_file_get_idb(prov->wth, interface_id);
 
   if (wtapng_if_descr) {
     if (wtap_block_get_string_option_value(wtapng_if_descr, OPT_IDB_NAME, &interface_name) == WTAP_OPTTYPE_SUCCESS)
@@ -51,16 +45,10 @@ cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32
 const char *
 cap_file_provider_get_interface_description(struct packet_provider_data *prov, guint32 interface_id)
 {
-  wtapng_iface_descriptions_t *idb_info;
-  wtap_block_t wtapng_if_descr = NULL;
+  wtap_block_t wtapng_if_descr;
   char* interface_name;
 
-  idb_info = wtap_file_get_idb_info(prov->wth);
-
-  if (interface_id < idb_info->interface_data->len)
-    wtapng_if_descr = g_array_index(idb_info->interface_data, wtap_block_t, interface_id);
-
-  g_free(idb_info);
+  wtapng_if_descr = wtap_file_get_idb(prov->wth, interface_id);
 
   if (wtapng_if_descr) {
     if (wtap_block_get_string_option_value(wtapng_if_descr, OPT_IDB_DESCR, &interface_name) == WTAP_OPTTYPE_SUCCESS)
@@ -72,6 +72,7 @@ print_usage(FILE *output)
   fprintf(output, "                    an empty \"-F\" option will list the file types.\n");
   fprintf(output, "  -I <IDB merge mode> set the merge mode for Interface Description Blocks; default is 'all'.\n");
   fprintf(output, "                    an empty \"-I\" option will list the merge modes.\n");
+  fprintf(output, "  --compress <type> compress the output file with the given method.\n");
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
   fprintf(output, "  -h                display this help and exit.\n");
@@ -161,6 +162,17 @@ list_idb_merge_modes(void) {
   }
 }
 
+static void
+list_compression_types(void) {
+  GSList *names, *name;
+
+  fprintf(stderr, "mergecap: The available compression types for the \"--compress\" flag are:\n");
+  names = wtap_get_all_output_compression_type_names_list();
+  for (name = names; name != NULL; name = g_slist_next(name))
+    fprintf(stderr, "    %s\n", (const char *)name->data);
+  g_slist_free(names);
+}
+
 static gboolean
 merge_callback(merge_event event, int num,
                const merge_in_file_t in_files[], const guint in_file_count,
@@ -231,9 +243,11 @@ main(int argc, char *argv[])
 {
   char               *init_progfile_dir_error;
   int                 opt;
+#define LONGOPT_COMPRESS 0x8100
   static const struct option long_options[] = {
       {"help", no_argument, NULL, 'h'},
       {"version", no_argument, NULL, 'V'},
+      {"compress", required_argument, NULL, LONGOPT_COMPRESS},
       {0, 0, 0, 0 }
   };
   gboolean            do_append          = FALSE;
@@ -252,6 +266,7 @@ main(int argc, char *argv[])
   char               *out_filename       = NULL;
   merge_result        status             = MERGE_OK;
   idb_merge_mode      mode               = IDB_MERGE_MODE_MAX;
+  wtap_compression_type compression_type = WTAP_UNCOMPRESSED;
   merge_progress_callback_t cb;
 
   cmdarg_err_init(mergecap_cmdarg_err, mergecap_cmdarg_err_cont);
@@ -325,6 +340,17 @@ main(int argc, char *argv[])
       snaplen = get_nonzero_guint32(optarg, "snapshot length");
       break;
 
+    case LONGOPT_COMPRESS:
+      compression_type = wtap_name_to_compression_type(optarg);
+      if (compression_type == WTAP_UNKNOWN_COMPRESSION) {
+        fprintf(stderr, "mergecap: \"%s\" isn't a valid compression type\n",
+                optarg);
+        list_compression_types();
+        status = MERGE_ERR_INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+
     case 'v':
       verbose = TRUE;
       break;
@@ -388,7 +414,7 @@ main(int argc, char *argv[])
   /* open the outfile */
   if (strcmp(out_filename, "-") == 0) {
     /* merge the files to the standard output */
-    status = merge_files_to_stdout(file_type,
+    status = merge_files_to_stdout(file_type, compression_type,
                                    (const char *const *) &argv[optind],
                                    in_file_count, do_append, mode, snaplen,
                                    get_appname_and_version(),
@@ -396,7 +422,7 @@ main(int argc, char *argv[])
                                    &err, &err_info, &err_fileno, &err_framenum);
   } else {
     /* merge the files to the outfile */
-    status = merge_files(out_filename, file_type,
+    status = merge_files(out_filename, file_type, compression_type,
                          (const char *const *) &argv[optind], in_file_count,
                          do_append, mode, snaplen, get_appname_and_version(),
                          verbose ? &cb : NULL,
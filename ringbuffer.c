@@ -43,13 +43,22 @@
 
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
+#include <writecap/pcapio_writer.h>
+#include <writecap/compress_file.h>
 
 
 /* Ringbuffer file structure */
 typedef struct _rb_file {
   gchar         *name;
+  guint          compress_pending;   /**< Number of this slot's files not yet compressed */
 } rb_file;
 
+/* A file handed to the compression pool */
+typedef struct _rb_compress_job {
+  rb_file       *rfile;              /**< The slot the file was in */
+  gchar         *name;               /**< The file's uncompressed name */
+} rb_compress_job;
+
 /** Ringbuffer data structure */
 typedef struct _ringbuf_data {
   rb_file      *files;
@@ -60,14 +69,100 @@ typedef struct _ringbuf_data {
   gboolean      unlimited;           /**< TRUE if unlimited number of files */
 
   int           fd;                  /**< Current ringbuffer file descriptor */
-  FILE         *pdh;
-  char         *io_buffer;              /**< The IO buffer used to write to the file */
+  pcapio_writer_t *writer;           /**< Writes to fd */
+  guint         writer_flags;        /**< PCAPIO_WRITER_ flags for each file's writer */
+  guint64       preallocate;         /**< Bytes to allocate up front for each file */
+  pcapio_writer_stats_t *writer_stats; /**< Statistics of all the files' writers */
   gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
+
+  compress_file_type_t compress_type; /**< Compression for the files once they are complete */
+  GThreadPool  *compress_pool;       /**< Compresses the complete files, one at a time */
+  GMutex        compress_mutex;      /**< Protects the files' compress_pending */
+  GCond         compress_cond;       /**< Signalled when a file has been compressed */
 } ringbuf_data;
 
 static ringbuf_data rb_data;
 
 
+/*
+ * Compress a complete ringbuffer file, in a thread of the compression
+ * pool, and remove the uncompressed file if that worked.
+ */
+static void ringbuf_compress_file(gpointer data, gpointer user_data _U_)
+{
+  rb_compress_job *job = (rb_compress_job *)data;
+  gchar *compressed_name;
+  int    fd;
+  int    err;
+
+  compressed_name = g_strconcat(job->name, ".",
+                                compress_file_type_extension(rb_data.compress_type),
+                                NULL);
+  fd = ws_open(compressed_name, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
+               rb_data.group_read_access ? 0640 : 0600);
+  if (fd == -1) {
+    g_warning("Can't create %s: %s", compressed_name, g_strerror(errno));
+  } else if ((err = compress_file(job->name, fd, rb_data.compress_type)) != 0) {
+    g_warning("Can't compress %s: %s", job->name, g_strerror(err));
+    ws_unlink(compressed_name);
+  } else {
+    ws_unlink(job->name);
+  }
+  g_free(compressed_name);
+
+  g_mutex_lock(&rb_data.compress_mutex);
+  job->rfile->compress_pending--;
+  g_cond_broadcast(&rb_data.compress_cond);
+  g_mutex_unlock(&rb_data.compress_mutex);
+
+  g_free(job->name);
+  g_free(job);
+}
+
+/*
+ * Hand the file that was just closed to the compression pool; its name
+ * is changed to that of the compressed file.
+ */
+static void ringbuf_start_compress_file(rb_file *rfile)
+{
+  rb_compress_job *job = g_new(rb_compress_job, 1);
+
+  if (rb_data.compress_pool == NULL)
+    rb_data.compress_pool = g_thread_pool_new(ringbuf_compress_file, NULL, 1, FALSE, NULL);
+  job->rfile = rfile;
+  job->name = rfile->name;
+  rfile->name = g_strconcat(job->name, ".",
+                            compress_file_type_extension(rb_data.compress_type),
+                            NULL);
+  g_mutex_lock(&rb_data.compress_mutex);
+  rfile->compress_pending++;
+  g_mutex_unlock(&rb_data.compress_mutex);
+  g_thread_pool_push(rb_data.compress_pool, job, NULL);
+}
+
+/*
+ * Wait until the file in a ringbuffer slot is compressed; the files in
+ * the other slots can still be in the compression pool.
+ */
+static void ringbuf_wait_compress_file(rb_file *rfile)
+{
+  g_mutex_lock(&rb_data.compress_mutex);
+  while (rfile->compress_pending != 0)
+    g_cond_wait(&rb_data.compress_cond, &rb_data.compress_mutex);
+  g_mutex_unlock(&rb_data.compress_mutex);
+}
+
+/*
+ * Wait until all the files handed to the compression pool are compressed.
+ */
+static void ringbuf_wait_compress(void)
+{
+  if (rb_data.compress_pool != NULL) {
+    g_thread_pool_free(rb_data.compress_pool, FALSE, TRUE);
+    rb_data.compress_pool = NULL;
+  }
+}
+
 /*
  * create the next filename and open a new binary file with that name
  */
@@ -120,7 +215,8 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
  * Initialize the ringbuffer data structures
  */
 int
-ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access)
+ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access,
+             compress_file_type_t compress_type)
 {
   unsigned int i;
   char        *pfx, *last_pathsep;
@@ -132,9 +228,15 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.fsuffix = NULL;
   rb_data.unlimited = FALSE;
   rb_data.fd = -1;
-  rb_data.pdh = NULL;
-  rb_data.io_buffer = NULL;
+  rb_data.writer = NULL;
+  rb_data.writer_flags = 0;
+  rb_data.preallocate = 0;
+  rb_data.writer_stats = NULL;
   rb_data.group_read_access = group_read_access;
+  rb_data.compress_type = compress_type;
+  rb_data.compress_pool = NULL;
+  g_mutex_init(&rb_data.compress_mutex);
+  g_cond_init(&rb_data.compress_cond);
 
   /* just to be sure ... */
   if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -193,6 +295,7 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
 
   for (i=0; i < rb_data.num_files; i++) {
     rb_data.files[i].name = NULL;
+    rb_data.files[i].compress_pending = 0;
   }
 
   /* create the first file */
@@ -221,105 +324,103 @@ const gchar *ringbuf_current_filename(void)
 }
 
 /*
- * Calls ws_fdopen() for the current ringbuffer file
+ * Sets up a writer for the current ringbuffer file; the files we switch
+ * to later get writers with the same flags, preallocation and statistics.
  */
-FILE *
-ringbuf_init_libpcap_fdopen(int *err)
+pcapio_writer_t *
+ringbuf_init_writer(guint writer_flags, guint64 preallocate,
+                    pcapio_writer_stats_t *writer_stats)
 {
-  rb_data.pdh = ws_fdopen(rb_data.fd, "wb");
-  if (rb_data.pdh == NULL) {
-    if (err != NULL) {
-      *err = errno;
-    }
-  } else {
-    size_t buffsize = IO_BUF_SIZE;
-#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
-    ws_statb64 statb;
-
-    if (ws_fstat64(rb_data.fd, &statb) == 0) {
-      if (statb.st_blksize > IO_BUF_SIZE) {
-        buffsize = statb.st_blksize;
-      }
-    }
-#endif
-    /* Increase the size of the IO buffer */
-    rb_data.io_buffer = (char *)g_realloc(rb_data.io_buffer, buffsize);
-    setvbuf(rb_data.pdh, rb_data.io_buffer, _IOFBF, buffsize);
-  }
-
-  return rb_data.pdh;
+  rb_data.writer_flags = writer_flags;
+  rb_data.preallocate = preallocate;
+  rb_data.writer_stats = writer_stats;
+  rb_data.writer = pcapio_writer_open(rb_data.fd, writer_flags, 0,
+                                      preallocate, writer_stats);
+  return rb_data.writer;
 }
 
 /*
  * Switches to the next ringbuffer file
  */
 gboolean
-ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
+ringbuf_switch_file(pcapio_writer_t **writer, gchar **save_file, int *save_file_fd, int *err)
 {
   int     next_file_index;
   rb_file *next_rfile = NULL;
+  int     close_err;
 
   /* close current file */
 
-  if (fclose(rb_data.pdh) == EOF) {
+  if (!pcapio_writer_close(rb_data.writer, &close_err)) {
     if (err != NULL) {
-      *err = errno;
+      *err = close_err;
     }
-    ws_close(rb_data.fd);  /* XXX - the above should have closed this already */
-    rb_data.pdh = NULL;    /* it's still closed, we just got an error while closing */
+    rb_data.writer = NULL; /* it's still closed, we just got an error while closing */
     rb_data.fd = -1;
-    g_free(rb_data.io_buffer);
-    rb_data.io_buffer = NULL;
     return FALSE;
   }
 
-  rb_data.pdh = NULL;
+  rb_data.writer = NULL;
   rb_data.fd  = -1;
 
   /* get the next file number and open it */
 
-  rb_data.curr_file_num++ /* = next_file_num*/;
-  next_file_index = (rb_data.curr_file_num) % rb_data.num_files;
+  next_file_index = (rb_data.curr_file_num + 1) % rb_data.num_files;
   next_rfile = &rb_data.files[next_file_index];
 
-  if (ringbuf_open_file(next_rfile, err) == -1) {
-    return FALSE;
+  if (rb_data.compress_type != COMPRESS_FILE_NONE) {
+    /* The oldest file is about to be removed; make sure it is done
+       being compressed, so the compressed file is what is removed.
+       It was closed a whole ring ago, so this should not wait, and
+       the files closed since then can go on being compressed. */
+    if (next_rfile->name != NULL && !rb_data.unlimited)
+      ringbuf_wait_compress_file(next_rfile);
+    ringbuf_start_compress_file(&rb_data.files[rb_data.curr_file_num % rb_data.num_files]);
   }
 
-  if (ringbuf_init_libpcap_fdopen(err) == NULL) {
+  rb_data.curr_file_num++ /* = next_file_num*/;
+
+  if (ringbuf_open_file(next_rfile, err) == -1) {
     return FALSE;
   }
 
+  ringbuf_init_writer(rb_data.writer_flags, rb_data.preallocate,
+                      rb_data.writer_stats);
+
   /* switch to the new file */
   *save_file = next_rfile->name;
   *save_file_fd = rb_data.fd;
-  (*pdh) = rb_data.pdh;
+  (*writer) = rb_data.writer;
 
   return TRUE;
 }
 
 /*
- * Calls fclose() for the current ringbuffer file
+ * Closes the writer of the current ringbuffer file
  */
 gboolean
 ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 {
   gboolean  ret_val = TRUE;
+  int       close_err;
 
   /* close current file, if it's open */
-  if (rb_data.pdh != NULL) {
-    if (fclose(rb_data.pdh) == EOF) {
+  if (rb_data.writer != NULL) {
+    if (!pcapio_writer_close(rb_data.writer, &close_err)) {
       if (err != NULL) {
-        *err = errno;
+        *err = close_err;
       }
-      ws_close(rb_data.fd);
       ret_val = FALSE;
     }
-    rb_data.pdh = NULL;
+    rb_data.writer = NULL;
     rb_data.fd  = -1;
-    g_free(rb_data.io_buffer);
-    rb_data.io_buffer = NULL;
 
+    if (ret_val && rb_data.compress_type != COMPRESS_FILE_NONE) {
+      /* Compress the last file too, and report the compressed files
+         only once they all exist. */
+      ringbuf_start_compress_file(&rb_data.files[rb_data.curr_file_num % rb_data.num_files]);
+      ringbuf_wait_compress();
+    }
   }
 
   /* set the save file name to the current file */
@@ -335,6 +436,10 @@ ringbuf_free(void)
 {
   unsigned int i;
 
+  ringbuf_wait_compress();
+  g_mutex_clear(&rb_data.compress_mutex);
+  g_cond_clear(&rb_data.compress_cond);
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -363,12 +468,13 @@ ringbuf_error_cleanup(void)
 {
   unsigned int i;
 
-  /* try to close via wtap */
-  if (rb_data.pdh != NULL) {
-    if (fclose(rb_data.pdh) == 0) {
-      rb_data.fd = -1;
-    }
-    rb_data.pdh = NULL;
+  /* the writer closes the file whether or not that works */
+  if (rb_data.writer != NULL) {
+    int close_err;
+
+    pcapio_writer_close(rb_data.writer, &close_err);
+    rb_data.writer = NULL;
+    rb_data.fd = -1;
   }
 
   /* close directly if still open */
@@ -377,6 +483,9 @@ ringbuf_error_cleanup(void)
     rb_data.fd = -1;
   }
 
+  /* let the compressed files be written before removing them */
+  ringbuf_wait_compress();
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -384,9 +493,6 @@ ringbuf_error_cleanup(void)
       }
     }
   }
-  g_free(rb_data.io_buffer);
-  rb_data.io_buffer = NULL;
-
   /* free the memory */
   ringbuf_free();
 }
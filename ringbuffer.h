@@ -13,6 +13,8 @@
 
 #include <stdio.h>
 #include "wiretap/wtap.h"
+#include "writecap/pcapio_writer.h"
+#include "writecap/compress_file.h"
 
 #define RINGBUFFER_UNLIMITED_FILES 0
 /* Minimum number of ringbuffer files */
@@ -23,11 +25,13 @@
 /* Maximum number for FAT filesystems */
 #define RINGBUFFER_WARN_NUM_FILES 65535
 
-int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access);
+int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access,
+                 compress_file_type_t compress_type);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
-FILE *ringbuf_init_libpcap_fdopen(int *err);
-gboolean ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd,
+pcapio_writer_t *ringbuf_init_writer(guint writer_flags, guint64 preallocate,
+                                     pcapio_writer_stats_t *writer_stats);
+gboolean ringbuf_switch_file(pcapio_writer_t **writer, gchar **save_file, int *save_file_fd,
                              int *err);
 gboolean ringbuf_libpcap_dump_close(gchar **save_file, int *err);
 void ringbuf_free(void);
@@ -701,10 +701,18 @@ sharkd_retap(void)
   return 0;
 }
 
+/*
+ * Sets "*result" to the frames matching "dftext", or to NULL if every
+ * frame matches. The frames are dissected only if "cache" cannot answer
+ * from earlier results; in that case every operand of the filter that is
+ * not cached yet is evaluated in the same pass. "*result" belongs to
+ * "cache" and is valid until it is next used.
+ */
 int
-sharkd_filter(const char *dftext, guint8 **result)
+sharkd_filter(const char *dftext, filter_cache_t *cache, const frame_bitmap_t **result)
 {
   dfilter_t  *dfcode = NULL;
+  filter_cache_eval_t *eval;
 
   guint32 framenum, prev_dis_num = 0;
   guint32 frames_count;
@@ -713,12 +721,9 @@ sharkd_filter(const char *dftext, guint8 **result)
   int err;
   char *err_info = NULL;
 
-  guint8 *result_bits;
-  guint8  passed_bits;
-
   epan_dissect_t edt;
 
-  if (!dfilter_compile(dftext, &dfcode, &err_info)) {
+  if (!dfilter_compile_parts(dftext, &dfcode, &err_info)) {
     g_free(err_info);
     return -1;
   }
@@ -731,26 +736,26 @@ sharkd_filter(const char *dftext, guint8 **result)
 
   frames_count = cfile.count;
 
+  *result = filter_cache_lookup(cache, dfcode, frames_count);
+  if (*result) {
+    dfilter_free(dfcode);
+    return 0;
+  }
+
+  eval = filter_cache_eval_new(cache, dfcode, frames_count);
+
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
   epan_dissect_init(&edt, cfile.epan, TRUE, FALSE);
 
-  passed_bits = 0;
-  result_bits = (guint8 *) g_malloc(2 + (frames_count / 8));
-
   for (framenum = 1; framenum <= frames_count; framenum++) {
     frame_data *fdata = sharkd_get_frame(framenum);
 
-    if ((framenum & 7) == 0) {
-      result_bits[(framenum / 8) - 1] = passed_bits;
-      passed_bits = 0;
-    }
-
     if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
       break;
 
     /* frame_data_set_before_dissect */
-    epan_dissect_prime_with_dfilter(&edt, dfcode);
+    filter_cache_eval_prime(eval, &edt);
 
     fdata->ref_time = FALSE;
     fdata->frame_ref_num = (framenum != 1) ? 1 : 0;
@@ -759,29 +764,30 @@ sharkd_filter(const char *dftext, guint8 **result)
                      frame_tvbuff_new_buffer(&cfile.provider, fdata, &buf),
                      fdata, NULL);
 
-    if (dfilter_apply_edt(dfcode, &edt)) {
-      passed_bits |= (1 << (framenum % 8));
+    if (filter_cache_eval_frame(eval, &edt, framenum))
       prev_dis_num = framenum;
-    }
 
     /* if passed or ref -> frame_data_set_after_dissect */
 
     epan_dissect_reset(&edt);
   }
 
-  if ((framenum & 7) == 0)
-      framenum--;
-  result_bits[framenum / 8] = passed_bits;
-
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
   epan_dissect_cleanup(&edt);
 
-  dfilter_free(dfcode);
+  if (framenum <= frames_count) {
+    /* Don't keep results for part of the file. */
+    g_free(err_info);
+    filter_cache_eval_abort(eval);
+    dfilter_free(dfcode);
+    return -1;
+  }
 
-  *result = result_bits;
+  *result = filter_cache_eval_finish(eval);
+  dfilter_free(dfcode);
 
-  return framenum;
+  return 0;
 }
 
 const char *
@@ -13,6 +13,7 @@
 #define __SHARKD_H
 
 #include <file.h>
+#include <ui/filter_cache.h>
 
 #define SHARKD_DISSECT_FLAG_NULL       0x00u
 #define SHARKD_DISSECT_FLAG_BYTES      0x01u
@@ -26,7 +27,7 @@ typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, str
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
 int sharkd_retap(void);
-int sharkd_filter(const char *dftext, guint8 **result);
+int sharkd_filter(const char *dftext, filter_cache_t *cache, const frame_bitmap_t **result);
 frame_data *sharkd_get_frame(guint32 framenum);
 int sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_dis_num, column_info *cinfo, gboolean dissect_color);
 int sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev_dis_num, sharkd_dissect_func_t cb, guint32 dissect_flags, void *data);
@@ -37,9 +38,17 @@ const char *sharkd_version(void);
 /* sharkd_daemon.c */
 int sharkd_init(int argc, char **argv);
 int sharkd_loop(void);
+#ifndef _WIN32
+int sharkd_send_session(int control_fd, int client_fd, const char *data, guint32 len);
+int sharkd_recv_session(int control_fd, GString *data);
+#endif
 
 /* sharkd_session.c */
 int sharkd_session_main(void);
+#ifndef _WIN32
+int sharkd_session_resume(char *first_request);
+int sharkd_session_worker(int control_fd, int linger);
+#endif
 
 #endif /* __SHARKD_H */
 
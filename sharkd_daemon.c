@@ -29,16 +29,20 @@
 #endif
 
 #include <wsutil/socket.h>
+#include <wsutil/file_util.h>
 #include <wsutil/inet_addr.h>
 #include <wsutil/please_report_bug.h>
 
 #ifndef _WIN32
 #include <sys/un.h>
+#include <sys/stat.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #endif
 
 #include <wsutil/strtoi.h>
 #include <wsutil/win32-utils.h>
+#include <wsutil/wsjson.h>
 
 #include "sharkd.h"
 
@@ -51,8 +55,50 @@
 #endif
 
 static int _use_stdinout = 0;
+static int _use_shared_workers = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
 
+#ifndef _WIN32
+/*
+ * Shared workers ("-s").
+ *
+ * Instead of forking a new process for every connection, sessions whose
+ * first request loads a capture file are handed over to a worker process
+ * that already has that file (same path, modification time and size)
+ * loaded. The worker keeps the frame list and the filter results and
+ * serves all of its sessions, one request at a time, so opening the same
+ * capture again does not pay for another first pass.
+ *
+ * Dissection state is per process, so a worker never holds more than one
+ * capture; sessions that start with anything else are served by a process
+ * of their own, as they are without "-s".
+ */
+
+/* How long a shared worker keeps its capture after its last session */
+#define SHARKD_WORKER_LINGER_SECS	300
+
+typedef struct {
+	pid_t	pid;
+	int	control_fd;	/* our end of the socketpair */
+} sharkd_worker_t;
+
+/* capture key (see sharkd_capture_key()) -> sharkd_worker_t */
+static GHashTable *_workers = NULL;
+
+/* Our ends of the socketpairs of session processes that may still hand
+ * their session back to us (see sharkd_session_start()) */
+static GArray *_pending = NULL;
+
+static void
+sharkd_worker_free(gpointer data)
+{
+	sharkd_worker_t *worker = (sharkd_worker_t *) data;
+
+	close(worker->control_fd);
+	g_free(worker);
+}
+#endif
+
 static socket_handle_t
 socket_init(char *path)
 {
@@ -165,10 +211,27 @@ sharkd_init(int argc, char **argv)
 #endif
 	socket_handle_t fd;
 
-	if (argc != 2)
+#ifndef _WIN32
+	if (argc == 3 && !strcmp(argv[1], "-s"))
+	{
+		_use_shared_workers = 1;
+		argc--;
+		argv++;
+	}
+#endif
+
+	if (argc != 2 || (_use_shared_workers && !strcmp(argv[1], "-")))
 	{
+#ifndef _WIN32
+		fprintf(stderr, "Usage: %s <-|[-s] socket>\n", argv[0]);
+#else
 		fprintf(stderr, "Usage: %s <-|socket>\n", argv[0]);
+#endif
 		fprintf(stderr, "\n");
+#ifndef _WIN32
+		fprintf(stderr, " -s - serve all sessions of a capture file from one shared process\n");
+		fprintf(stderr, "\n");
+#endif
 
 		fprintf(stderr, "<socket> examples:\n");
 #ifdef SHARKD_UNIX_SUPPORT
@@ -216,6 +279,463 @@ sharkd_init(int argc, char **argv)
 	return 0;
 }
 
+#ifndef _WIN32
+/*
+ * Hands a session over to a worker: the client socket travels as
+ * SCM_RIGHTS ancillary data, followed by the length and contents of
+ * the request that was already read from it.
+ */
+int
+sharkd_send_session(int control_fd, int client_fd, const char *data, guint32 len)
+{
+	struct msghdr msg;
+	struct iovec iov[2];
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct cmsghdr *cmsg;
+	ssize_t sent;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&control, 0, sizeof(control));
+
+	iov[0].iov_base = &len;
+	iov[0].iov_len = sizeof(len);
+	iov[1].iov_base = (void *) data;
+	iov[1].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &client_fd, sizeof(int));
+
+	do
+		sent = sendmsg(control_fd, &msg, 0);
+	while (sent == -1 && errno == EINTR);
+
+	if (sent < (ssize_t) sizeof(len))
+		return -1;
+
+	/* Finish a short send of an unusually long first request. */
+	sent -= sizeof(len);
+	while ((size_t) sent < len)
+	{
+		ssize_t ret = write(control_fd, data + sent, len - sent);
+
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		sent += ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Receives a session sent with sharkd_send_session(). Returns the client
+ * socket, or -1 if the parent went away.
+ */
+int
+sharkd_recv_session(int control_fd, GString *data)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct cmsghdr *cmsg;
+	guint32 len;
+	int client_fd = -1;
+	ssize_t ret;
+	char chunk[1024];
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &len;
+	iov.iov_len = sizeof(len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do
+		ret = recvmsg(control_fd, &msg, 0);
+	while (ret == -1 && errno == EINTR);
+
+	if (ret != (ssize_t) sizeof(len))
+		return -1;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			memcpy(&client_fd, CMSG_DATA(cmsg), sizeof(int));
+	}
+
+	if (client_fd == -1)
+		return -1;
+
+	while (len > 0)
+	{
+		ret = read(control_fd, chunk, MIN(len, sizeof(chunk)));
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+		{
+			close(client_fd);
+			return -1;
+		}
+		g_string_append_len(data, chunk, ret);
+		len -= (guint32) ret;
+	}
+
+	return client_fd;
+}
+
+/*
+ * Reads the first request of a new session, up to and including its
+ * newline, or until the client closes. It's read a byte at a time so
+ * that nothing after it is taken from the socket.
+ */
+static GString *
+sharkd_read_first_request(int fd)
+{
+	GString *data = g_string_new(NULL);
+	char c;
+	ssize_t ret;
+
+	for (;;)
+	{
+		ret = read(fd, &c, 1);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			break;
+		g_string_append_c(data, c);
+		if (c == '\n')
+			break;
+	}
+
+	return data;
+}
+
+/*
+ * Returns the key under which the capture loaded by "request" is shared,
+ * or NULL if the request is not a "load" of an existing file.
+ */
+static char *
+sharkd_capture_key(const GString *request)
+{
+	const char *newline = (const char *) memchr(request->str, '\n', request->len);
+	char *line;
+	char *file = NULL;
+	char *path;
+	char *key = NULL;
+	jsmntok_t *tokens;
+	ws_statb64 st;
+	int count, i;
+
+	line = g_strndup(request->str, newline ? (gsize) (newline - request->str) : request->len);
+
+	count = json_parse(line, NULL, 0);
+	if (count <= 0)
+	{
+		g_free(line);
+		return NULL;
+	}
+
+	tokens = g_new0(jsmntok_t, count);
+	count = json_parse(line, tokens, count);
+
+	if (count > 0 && tokens[0].type == JSMN_OBJECT)
+	{
+		gboolean is_load = FALSE;
+
+		for (i = 1; i + 1 < count; i += 2)
+		{
+			if (tokens[i].type != JSMN_STRING || tokens[i + 1].type != JSMN_STRING)
+				continue;
+
+			line[tokens[i].end] = '\0';
+			line[tokens[i + 1].end] = '\0';
+			if (!json_decode_string_inplace(&line[tokens[i + 1].start]))
+				continue;
+
+			if (!strcmp(&line[tokens[i].start], "req"))
+				is_load = !strcmp(&line[tokens[i + 1].start], "load");
+			else if (!strcmp(&line[tokens[i].start], "file"))
+				file = &line[tokens[i + 1].start];
+		}
+
+		if (!is_load)
+			file = NULL;
+	}
+
+	if (file && (path = realpath(file, NULL)) != NULL)
+	{
+		if (ws_stat64(path, &st) == 0 && S_ISREG(st.st_mode))
+			key = g_strdup_printf("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+					      path, (gint64) st.st_mtime, (gint64) st.st_size);
+		free(path);
+	}
+
+	g_free(tokens);
+	g_free(line);
+	return key;
+}
+
+static gboolean
+sharkd_worker_is_gone(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	sharkd_worker_t *worker = (sharkd_worker_t *) value;
+	struct pollfd pfd;
+
+	pfd.fd = worker->control_fd;
+	pfd.events = 0;
+	pfd.revents = 0;
+
+	return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR));
+}
+
+static void
+sharkd_close_worker_fd(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	close(((sharkd_worker_t *) value)->control_fd);
+}
+
+static void
+sharkd_close_parent_fds(void)
+{
+	guint i;
+
+	closesocket(_server_fd);
+	g_hash_table_foreach(_workers, sharkd_close_worker_fd, NULL);
+	for (i = 0; i < _pending->len; i++)
+		close(g_array_index(_pending, int, i));
+}
+
+static sharkd_worker_t *
+sharkd_worker_spawn(int linger)
+{
+	sharkd_worker_t *worker;
+	int fds[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+	{
+		fprintf(stderr, "cannot socketpair(): %s\n", g_strerror(errno));
+		return NULL;
+	}
+
+	pid = fork();
+	if (pid == -1)
+	{
+		fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return NULL;
+	}
+
+	if (pid == 0)
+	{
+		/* Don't hold on to anything that belongs to the parent. */
+		sharkd_close_parent_fds();
+		close(fds[0]);
+
+		exit(sharkd_session_worker(fds[1], linger));
+	}
+
+	close(fds[1]);
+
+	worker = g_new(sharkd_worker_t, 1);
+	worker->pid = pid;
+	worker->control_fd = fds[0];
+	return worker;
+}
+
+/*
+ * Starts a process for a new connection. It reads the first request, so
+ * that a client that is slow to send it holds up nobody else. A session
+ * that loads a capture file is handed back to us on "handoff_fd", along
+ * with its capture key, to be passed on to the worker for that capture;
+ * any other session is served by the process itself.
+ */
+static void
+sharkd_session_start(int fd)
+{
+	GString *request;
+	char *key;
+	int fds[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+	{
+		fprintf(stderr, "cannot socketpair(): %s\n", g_strerror(errno));
+		return;
+	}
+
+	pid = fork();
+	if (pid == -1)
+	{
+		fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return;
+	}
+
+	if (pid != 0)
+	{
+		close(fds[1]);
+		g_array_append_val(_pending, fds[0]);
+		return;
+	}
+
+	sharkd_close_parent_fds();
+	close(fds[0]);
+
+	request = sharkd_read_first_request(fd);
+	key = sharkd_capture_key(request);
+	if (key)
+	{
+		GString *handoff = g_string_new(key);
+
+		/* The key, a NUL, then the request. */
+		g_string_append_len(handoff, "", 1);
+		g_string_append_len(handoff, request->str, request->len);
+		if (sharkd_send_session(fds[1], fd, handoff->str, (guint32) handoff->len) != 0)
+			fprintf(stderr, "cannot hand over session: %s\n", g_strerror(errno));
+		exit(0);
+	}
+	close(fds[1]);
+
+	/* A private session, served by this process. */
+	dup2(fd, 0);
+	dup2(fd, 1);
+	close(fd);
+
+	if (request->len == 0)
+		exit(0);
+	exit(sharkd_session_resume(request->str));
+}
+
+/*
+ * Passes a session that a session process handed back on "handoff_fd"
+ * to the worker for its capture, starting the worker if need be.
+ */
+static void
+sharkd_dispatch_session(int handoff_fd)
+{
+	GString *data = g_string_new(NULL);
+	sharkd_worker_t *worker;
+	const char *request;
+	guint32 request_len;
+	char *key;
+	int fd;
+
+	fd = sharkd_recv_session(handoff_fd, data);
+	if (fd == -1)
+	{
+		/* The session is served by its own process. */
+		g_string_free(data, TRUE);
+		return;
+	}
+
+	key = g_strdup(data->str);
+	request = data->str + strlen(key) + 1;
+	request_len = (guint32) (data->len - strlen(key) - 1);
+
+	/* Forget the workers that have exited. */
+	g_hash_table_foreach_remove(_workers, sharkd_worker_is_gone, NULL);
+
+	worker = (sharkd_worker_t *) g_hash_table_lookup(_workers, key);
+	if (!worker || sharkd_send_session(worker->control_fd, fd, request, request_len) != 0)
+	{
+		/* No worker for this capture yet, or it is shutting down. */
+		g_hash_table_remove(_workers, key);
+		worker = sharkd_worker_spawn(SHARKD_WORKER_LINGER_SECS);
+		if (worker)
+		{
+			g_hash_table_insert(_workers, g_strdup(key), worker);
+			if (sharkd_send_session(worker->control_fd, fd, request, request_len) != 0)
+				fprintf(stderr, "cannot hand over session: %s\n", g_strerror(errno));
+		}
+	}
+
+	close(fd);
+	g_free(key);
+	g_string_free(data, TRUE);
+}
+
+/*
+ * Accepts connections and passes sessions on, never waiting for any one
+ * client.
+ */
+static void
+sharkd_shared_loop(void)
+{
+	struct pollfd *pfds = NULL;
+	guint i;
+
+	/* A worker that exits must not take the parent down with it. */
+	signal(SIGPIPE, SIG_IGN);
+	_workers = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_worker_free);
+	_pending = g_array_new(FALSE, FALSE, sizeof(int));
+
+	while (1)
+	{
+		pfds = g_renew(struct pollfd, pfds, _pending->len + 1);
+		pfds[0].fd = _server_fd;
+		pfds[0].events = POLLIN;
+		pfds[0].revents = 0;
+		for (i = 0; i < _pending->len; i++)
+		{
+			pfds[i + 1].fd = g_array_index(_pending, int, i);
+			pfds[i + 1].events = POLLIN;
+			pfds[i + 1].revents = 0;
+		}
+
+		if (poll(pfds, _pending->len + 1, -1) == -1)
+		{
+			if (errno != EINTR)
+				fprintf(stderr, "poll() failed: %s\n", g_strerror(errno));
+			continue;
+		}
+
+		/* Backwards, as handled sessions are removed. */
+		for (i = _pending->len; i > 0; i--)
+		{
+			if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+
+			sharkd_dispatch_session(pfds[i].fd);
+			close(pfds[i].fd);
+			g_array_remove_index(_pending, i - 1);
+		}
+
+		if (pfds[0].revents & POLLIN)
+		{
+			socket_handle_t fd;
+
+			fd = accept(_server_fd, NULL, NULL);
+			if (fd == INVALID_SOCKET)
+			{
+				fprintf(stderr, "cannot accept(): %s\n", g_strerror(errno));
+				continue;
+			}
+
+			sharkd_session_start(fd);
+			closesocket(fd);
+		}
+	}
+}
+#endif
+
 int
 sharkd_loop(void)
 {
@@ -224,6 +744,14 @@ sharkd_loop(void)
 		return sharkd_session_main();
 	}
 
+#ifndef _WIN32
+	if (_use_shared_workers)
+	{
+		sharkd_shared_loop();
+		return 0;
+	}
+#endif
+
 	while (1)
 	{
 #ifndef _WIN32
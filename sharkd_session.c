@@ -16,6 +16,14 @@
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
 
 #include <glib.h>
 
@@ -68,20 +76,30 @@
 
 #include <wsutil/pint.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/file_util.h>
 
 #include "globals.h"
 
 #include "sharkd.h"
 
-struct sharkd_filter_item
-{
-	guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
-};
+/* Results of the display filters used by the session's requests */
+#define SHARKD_FILTER_CACHE_SIZE (256 * 1024 * 1024)
 
-static GHashTable *filter_table = NULL;
+static filter_cache_t *filter_cache = NULL;
 
 static json_dumper dumper = {0};
 
+/* Set when this process serves several sessions (see sharkd_session_worker()) */
+static gboolean shared_worker = FALSE;
+
+/* Set by a "bye" request in a shared worker */
+static gboolean session_bye = FALSE;
+
+#ifndef _WIN32
+/* Standard output of a shared worker between requests */
+static int worker_devnull = -1;
+#endif
+
 static const char *
 json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *attr)
 {
@@ -180,37 +198,14 @@ sharkd_json_simple_reply(int err, const char *errmsg)
 	json_dumper_finish(&dumper);
 }
 
-static void
-sharkd_session_filter_free(gpointer data)
-{
-	struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
-
-	g_free(l->filtered);
-	g_free(l);
-}
-
-static const struct sharkd_filter_item *
-sharkd_session_filter_data(const char *filter)
+/*
+ * Sets "*matches" to the frames matching "filter", or to NULL if all
+ * frames match. Returns FALSE if the filter is not valid.
+ */
+static gboolean
+sharkd_session_filter_data(const char *filter, const frame_bitmap_t **matches)
 {
-	struct sharkd_filter_item *l;
-
-	l = (struct sharkd_filter_item *) g_hash_table_lookup(filter_table, filter);
-	if (!l)
-	{
-		guint8 *filtered = NULL;
-
-		int ret = sharkd_filter(filter, &filtered);
-
-		if (ret == -1)
-			return NULL;
-
-		l = (struct sharkd_filter_item *) g_malloc(sizeof(struct sharkd_filter_item));
-		l->filtered = filtered;
-
-		g_hash_table_insert(filter_table, g_strdup(filter), l);
-	}
-
-	return l;
+	return sharkd_filter(filter, filter_cache, matches) != -1;
 }
 
 static gboolean
@@ -531,6 +526,7 @@ sharkd_session_process_info(void)
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) prof - "1" to profile the dissectors from now on, "0" to stop
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -539,6 +535,7 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_file = json_find_attr(buf, tokens, count, "file");
+	const char *tok_prof = json_find_attr(buf, tokens, count, "prof");
 	int err = 0;
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
@@ -546,6 +543,31 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	if (!tok_file)
 		return;
 
+	if (tok_prof)
+	{
+		dissector_prof_set_enabled(!strcmp(tok_prof, "1"));
+		dissector_prof_reset();
+	}
+
+#ifndef _WIN32
+	if (shared_worker && cfile.filename)
+	{
+		/* The capture is shared with other sessions, so it stays. */
+		char *loaded_path = realpath(cfile.filename, NULL);
+		char *path = realpath(tok_file, NULL);
+
+		if (loaded_path && path && !strcmp(loaded_path, path))
+			sharkd_json_simple_reply(0, NULL);
+		else
+			sharkd_json_simple_reply(EBUSY, "another capture is loaded in this shared session; reconnect to load a different one");
+		free(loaded_path);
+		free(path);
+		return;
+	}
+#endif
+
+	filter_cache_clear(filter_cache);
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -566,6 +588,23 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	sharkd_json_simple_reply(err, NULL);
 }
 
+static void
+sharkd_session_process_status_prof_cb(const dissector_prof_t *prof, gpointer user_data _U_)
+{
+	if (prof->calls == 0)
+		return;
+
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_string("name", prof->name);
+	if (prof->protocol)
+		sharkd_json_value_string("protocol", prof->protocol);
+	sharkd_json_value_anyf("calls", "%" G_GUINT64_FORMAT, prof->calls);
+	sharkd_json_value_anyf("incl_ns", "%" G_GUINT64_FORMAT, prof->inclusive_ns);
+	sharkd_json_value_anyf("excl_ns", "%" G_GUINT64_FORMAT, prof->exclusive_ns);
+	sharkd_json_value_anyf("bytes", "%" G_GUINT64_FORMAT, prof->alloc_bytes);
+	json_dumper_end_object(&dumper);
+}
+
 /**
  * sharkd_session_process_status()
  *
@@ -576,6 +615,13 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (m) duration - time difference between time of first frame, and last loaded frame
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
+ *   (o) dissector_prof - when the dissectors are being profiled, for each dissector called:
+ *                  (m) name      - dissector name, or protocol filter name if it has none
+ *                  (o) protocol  - protocol filter name
+ *                  (m) calls     - number of calls
+ *                  (m) incl_ns   - time spent in it, including the dissectors it called
+ *                  (m) excl_ns   - time spent in it alone
+ *                  (m) bytes     - bytes it allocated from the per-packet memory pools
  */
 static void
 sharkd_session_process_status(void)
@@ -601,6 +647,13 @@ sharkd_session_process_status(void)
 			sharkd_json_value_anyf("filesize", "%" G_GINT64_FORMAT, file_size);
 	}
 
+	if (dissector_prof_is_enabled())
+	{
+		sharkd_json_array_open("dissector_prof");
+		dissector_prof_foreach(sharkd_session_process_status_prof_cb, NULL);
+		sharkd_json_array_close();
+	}
+
 	json_dumper_end_object(&dumper);
 	json_dumper_finish(&dumper);
 }
@@ -792,7 +845,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
 	const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
 
-	const guint8 *filter_data = NULL;
+	const frame_bitmap_t *filter_data = NULL;
 
 	int col;
 
@@ -814,12 +867,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	if (tok_filter)
 	{
-		const struct sharkd_filter_item *filter_item;
-
-		filter_item = sharkd_session_filter_data(tok_filter);
-		if (!filter_item)
+		if (!sharkd_session_filter_data(tok_filter, &filter_data))
 			return;
-		filter_data = filter_item->filtered;
 	}
 
 	skip = 0;
@@ -848,7 +897,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		frame_data *fdata;
 		guint32 ref_frame = (framenum != 1) ? 1 : 0;
 
-		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+		if (filter_data && !frame_bitmap_contains(filter_data, framenum))
 			continue;
 
 		if (skip)
@@ -3151,7 +3200,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 	const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
 	const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
 
-	const guint8 *filter_data = NULL;
+	const frame_bitmap_t *filter_data = NULL;
 
 	struct
 	{
@@ -3178,12 +3227,8 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 
 	if (tok_filter)
 	{
-		const struct sharkd_filter_item *filter_item;
-
-		filter_item = sharkd_session_filter_data(tok_filter);
-		if (!filter_item)
+		if (!sharkd_session_filter_data(tok_filter, &filter_data))
 			return;
-		filter_data = filter_item->filtered;
 	}
 
 	st_total.frames = 0;
@@ -3205,7 +3250,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 		gint64 msec_rel;
 		gint64 new_idx;
 
-		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+		if (filter_data && !frame_bitmap_contains(filter_data, framenum))
 			continue;
 
 		fdata = sharkd_get_frame(framenum);
@@ -3586,6 +3631,9 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = sharkd_set_user_comment(fdata, tok_comment);
 
+	/* frame.comment may now match differently */
+	filter_cache_clear(filter_cache);
+
 	sharkd_json_simple_reply(ret, NULL);
 }
 
@@ -3614,10 +3662,22 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 	if (!tok_name || tok_name[0] == '\0' || !tok_value)
 		return;
 
+	if (shared_worker)
+	{
+		/* Preferences are per process, so they would change the capture
+		 * for every other session too. */
+		sharkd_json_simple_reply(EPERM, "preferences can't be changed in a shared session; connect to a sharkd without -s to change them");
+		return;
+	}
+
 	ws_snprintf(pref, sizeof(pref), "%s:%s", tok_name, tok_value);
 
 	ret = prefs_set_pref(pref, &errmsg);
 
+	/* Preferences can change what the dissectors produce. */
+	if (ret == PREFS_SET_OK)
+		filter_cache_clear(filter_cache);
+
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
 }
@@ -4224,7 +4284,12 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 		else if (!strcmp(tok_req, "download"))
 			sharkd_session_process_download(buf, tokens, count);
 		else if (!strcmp(tok_req, "bye"))
-			exit(0);
+		{
+			if (!shared_worker)
+				exit(0);
+			session_bye = TRUE;
+			return;
+		}
 		else
 			fprintf(stderr, "::: req = %s\n", tok_req);
 
@@ -4249,66 +4314,322 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 	}
 }
 
-int
-sharkd_session_main(void)
+static jsmntok_t *session_tokens = NULL;
+static int session_tokens_max = -1;
+
+/*
+ * Processes one line of input. Returns 0, or an exit code if the input
+ * is not valid JSON.
+ */
+static int
+sharkd_session_process_line(char *buf)
+{
+	/* every command is line seperated JSON */
+	int ret;
+
+	ret = json_parse(buf, NULL, 0);
+	if (ret < 0)
+	{
+		fprintf(stderr, "invalid JSON -> closing\n");
+		return 1;
+	}
+
+	/* fprintf(stderr, "JSON: %d tokens\n", ret); */
+	ret += 1;
+
+	if (session_tokens == NULL || session_tokens_max < ret)
+	{
+		session_tokens_max = ret;
+		session_tokens = (jsmntok_t *) g_realloc(session_tokens, sizeof(jsmntok_t) * session_tokens_max);
+	}
+
+	memset(session_tokens, 0, ret * sizeof(jsmntok_t));
+
+	ret = json_parse(buf, session_tokens, ret);
+	if (ret < 0)
+	{
+		fprintf(stderr, "invalid JSON(2) -> closing\n");
+		return 2;
+	}
+
+#if defined(HAVE_C_ARES) || defined(HAVE_MAXMINDDB)
+	host_name_lookup_process();
+#endif
+
+	sharkd_session_process(buf, session_tokens, ret);
+	return 0;
+}
+
+/*
+ * Serves requests from standard input until it's closed, starting with
+ * "first_request" if that's not NULL.
+ */
+static int
+sharkd_session_serve(char *first_request)
 {
 	char buf[2 * 1024];
-	jsmntok_t *tokens = NULL;
-	int tokens_max = -1;
+	int ret;
 
 	fprintf(stderr, "Hello in child.\n");
 
 	dumper.output_file = stdout;
 
-	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	filter_cache = filter_cache_new(SHARKD_FILTER_CACHE_SIZE);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
 	uat_get_table_by_name("MaxMind Database Paths")->post_update_cb();
 #endif
 
+	if (first_request)
+	{
+		ret = sharkd_session_process_line(first_request);
+		if (ret != 0)
+			return ret;
+	}
+
 	while (fgets(buf, sizeof(buf), stdin))
 	{
-		/* every command is line seperated JSON */
-		int ret;
+		ret = sharkd_session_process_line(buf);
+		if (ret != 0)
+			return ret;
+	}
+
+	filter_cache_free(filter_cache);
+	g_free(session_tokens);
 
-		ret = json_parse(buf, NULL, 0);
-		if (ret < 0)
+	return 0;
+}
+
+int
+sharkd_session_main(void)
+{
+	return sharkd_session_serve(NULL);
+}
+
+#ifndef _WIN32
+/*
+ * Serves a session on standard input and output whose first request was
+ * already read from it, as a process of its own.
+ */
+int
+sharkd_session_resume(char *first_request)
+{
+	return sharkd_session_serve(first_request);
+}
+#endif
+
+#ifndef _WIN32
+struct sharkd_client
+{
+	int fd;
+	GString *input;	/* received, not yet processed */
+};
+
+static void
+sharkd_client_free(gpointer data)
+{
+	struct sharkd_client *client = (struct sharkd_client *) data;
+
+	close(client->fd);
+	g_string_free(client->input, TRUE);
+	g_free(client);
+}
+
+/*
+ * Runs the complete requests received from "client", with its socket as
+ * standard output. Returns FALSE when the session is over.
+ */
+static gboolean
+sharkd_client_process(struct sharkd_client *client)
+{
+	const char *newline;
+	gboolean keep = TRUE;
+
+	if (dup2(client->fd, STDOUT_FILENO) == -1)
+		return FALSE;
+
+	while (keep && (newline = (const char *) memchr(client->input->str, '\n', client->input->len)) != NULL)
+	{
+		gsize line_len = (gsize) (newline - client->input->str) + 1;
+		char *line = g_strndup(client->input->str, line_len);
+
+		g_string_erase(client->input, 0, line_len);
+		keep = (sharkd_session_process_line(line) == 0 && !session_bye);
+		g_free(line);
+	}
+
+	fflush(stdout);
+	if (ferror(stdout))
+	{
+		/* The client went away mid-reply. */
+		clearerr(stdout);
+		keep = FALSE;
+	}
+	session_bye = FALSE;
+
+	/* Don't keep the socket open through our standard output. */
+	dup2(worker_devnull, STDOUT_FILENO);
+
+	return keep;
+}
+
+/*
+ * Serves the sessions handed over by the parent on "control_fd", all
+ * sharing the capture the first of them loads. Requests are run one at
+ * a time as they arrive. Once no session is left, the worker waits
+ * "linger" seconds for a new one before it exits.
+ */
+int
+sharkd_session_worker(int control_fd, int linger)
+{
+	GPtrArray *clients;
+	struct pollfd *pfds = NULL;
+	gboolean control_open = TRUE;
+	gboolean control_shut = FALSE;
+	gint64 idle_since;
+	char chunk[4096];
+	guint i;
+
+	fprintf(stderr, "Hello in shared worker.\n");
+
+	shared_worker = TRUE;
+	signal(SIGPIPE, SIG_IGN);
+	dumper.output_file = stdout;
+
+	filter_cache = filter_cache_new(SHARKD_FILTER_CACHE_SIZE);
+	clients = g_ptr_array_new_with_free_func(sharkd_client_free);
+
+#ifdef HAVE_MAXMINDDB
+	/* mmdbresolve was stopped before fork(), force starting it */
+	uat_get_table_by_name("MaxMind Database Paths")->post_update_cb();
+#endif
+
+	worker_devnull = ws_open("/dev/null", O_WRONLY, 0);
+
+	/* The session we were started for. */
+	{
+		struct sharkd_client *client = g_new(struct sharkd_client, 1);
+
+		client->input = g_string_new(NULL);
+		client->fd = sharkd_recv_session(control_fd, client->input);
+		if (client->fd == -1)
+		{
+			g_string_free(client->input, TRUE);
+			g_free(client);
+		}
+		else
 		{
-			fprintf(stderr, "invalid JSON -> closing\n");
-			return 1;
+			g_ptr_array_add(clients, client);
+			if (!sharkd_client_process(client))
+				g_ptr_array_remove_index(clients, 0);
 		}
+	}
 
-		/* fprintf(stderr, "JSON: %d tokens\n", ret); */
-		ret += 1;
+	idle_since = g_get_monotonic_time();
+
+	while (control_open || clients->len > 0)
+	{
+		int timeout = -1;
+		int ret;
 
-		if (tokens == NULL || tokens_max < ret)
+		if (clients->len == 0 && !control_shut)
 		{
-			tokens_max = ret;
-			tokens = (jsmntok_t *) g_realloc(tokens, sizeof(jsmntok_t) * tokens_max);
+			gint64 idle_ms = (g_get_monotonic_time() - idle_since) / 1000;
+
+			if (idle_ms >= (gint64) linger * 1000)
+			{
+				/*
+				 * Refuse new sessions; the parent notices on its next
+				 * handover and starts a new worker. Sessions already
+				 * queued on the socket are still read below.
+				 */
+				shutdown(control_fd, SHUT_RD);
+				control_shut = TRUE;
+			}
+			else
+				timeout = (int) ((gint64) linger * 1000 - idle_ms);
 		}
 
-		memset(tokens, 0, ret * sizeof(jsmntok_t));
+		pfds = g_renew(struct pollfd, pfds, clients->len + 1);
+		pfds[0].fd = control_open ? control_fd : -1;
+		pfds[0].events = POLLIN;
+		pfds[0].revents = 0;
+		for (i = 0; i < clients->len; i++)
+		{
+			pfds[i + 1].fd = ((struct sharkd_client *) g_ptr_array_index(clients, i))->fd;
+			pfds[i + 1].events = POLLIN;
+			pfds[i + 1].revents = 0;
+		}
 
-		ret = json_parse(buf, tokens, ret);
-		if (ret < 0)
+		ret = poll(pfds, clients->len + 1, timeout);
+		if (ret == -1 && errno != EINTR)
 		{
-			fprintf(stderr, "invalid JSON(2) -> closing\n");
-			return 2;
+			fprintf(stderr, "poll() failed: %s\n", g_strerror(errno));
+			break;
 		}
+		if (ret <= 0)
+			continue;
 
-#if defined(HAVE_C_ARES) || defined(HAVE_MAXMINDDB)
-		host_name_lookup_process();
-#endif
+		/* Existing sessions first, as new ones are appended. */
+		for (i = clients->len; i > 0; i--)
+		{
+			struct sharkd_client *client = (struct sharkd_client *) g_ptr_array_index(clients, i - 1);
+			ssize_t len;
+
+			if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+
+			len = read(client->fd, chunk, sizeof(chunk));
+			if (len == -1 && errno == EINTR)
+				continue;
+			if (len > 0)
+				g_string_append_len(client->input, chunk, len);
+			else if (client->input->len > 0)
+			{
+				/* The client closed after a last request without a newline. */
+				g_string_append_c(client->input, '\n');
+			}
 
-		sharkd_session_process(buf, tokens, ret);
+			if (!sharkd_client_process(client) || len <= 0)
+				g_ptr_array_remove_index(clients, i - 1);
+		}
+
+		if (pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			struct sharkd_client *client = g_new(struct sharkd_client, 1);
+
+			client->input = g_string_new(NULL);
+			client->fd = sharkd_recv_session(control_fd, client->input);
+			if (client->fd == -1)
+			{
+				/* The parent is gone, or we shut the socket down. */
+				g_string_free(client->input, TRUE);
+				g_free(client);
+				close(control_fd);
+				control_open = FALSE;
+			}
+			else
+			{
+				g_ptr_array_add(clients, client);
+				if (!sharkd_client_process(client))
+					g_ptr_array_remove_index(clients, clients->len - 1);
+			}
+		}
+
+		if (clients->len == 0)
+			idle_since = g_get_monotonic_time();
 	}
 
-	g_hash_table_destroy(filter_table);
-	g_free(tokens);
+	g_free(pfds);
+	g_ptr_array_free(clients, TRUE);
+	filter_cache_free(filter_cache);
+	g_free(session_tokens);
+	ws_close(worker_devnull);
 
 	return 0;
 }
+#endif
 
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
@@ -284,6 +284,108 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('Chats'))
 
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_z_io_stat(subprocesstest.SubprocessTestCase):
+    def io_stat_counts(self, cmd_tshark, capture_file, filters, capture='dns+icmp.pcapng.gz'):
+        # Frame and byte counts of the single whole-capture interval,
+        # two cells per filter.
+        proc = self.assertRun((cmd_tshark, '-q', '-z', 'io,stat,0,' + ','.join(filters),
+            '-r', capture_file(capture)))
+        for line in proc.stdout_str.splitlines():
+            if '<>' in line:
+                cells = [cell.strip() for cell in line.split('|')]
+                return [int(cell) for cell in cells[2:] if cell]
+        self.fail('No interval row in io,stat output')
+
+    def test_tshark_z_io_stat_shared_filters(self, cmd_tshark, capture_file):
+        # Tap listener filters are evaluated together; repeated and
+        # overlapping filters must still count like separate runs.
+        filters = ('udp', 'dns', 'udp', 'icmp', 'dns || icmp')
+        combined = self.io_stat_counts(cmd_tshark, capture_file, filters)
+        self.assertEqual(len(combined), 2 * len(filters))
+        for i, dfilter in enumerate(filters):
+            single = self.io_stat_counts(cmd_tshark, capture_file, (dfilter,))
+            self.assertEqual(combined[2 * i:2 * i + 2], single)
+        self.assertEqual(combined[0:2], combined[4:6])
+
+    def test_tshark_z_io_stat_prefix_filters(self, cmd_tshark, capture_file):
+        # Filters that differ only in a prefix length or netmask compile
+        # to different programs and must not share results.
+        for capture, filters in (
+                ('ipv6.pcap', ('ipv6.dst == ff05::/16', 'ipv6.dst == ff05::')),
+                ('nfs.pcap', ('ip.src == 172.25.0.0/16', 'ip.src == 172.25.0.0'))):
+            combined = self.io_stat_counts(cmd_tshark, capture_file, filters, capture)
+            self.assertGreater(combined[0], 0)
+            self.assertEqual(combined[2], 0)
+            for i, dfilter in enumerate(filters):
+                single = self.io_stat_counts(cmd_tshark, capture_file, (dfilter,), capture)
+                self.assertEqual(combined[2 * i:2 * i + 2], single)
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_z_dissector_prof(subprocesstest.SubprocessTestCase):
+    def test_tshark_z_dissector_prof(self, cmd_tshark, capture_file):
+        proc = self.assertRun((cmd_tshark, '-q', '-z', 'dissector,prof',
+            '-r', capture_file('dhcp.pcap')))
+        calls = {}
+        for line in proc.stdout_str.splitlines():
+            cells = line.split()
+            if len(cells) == 6 and cells[1].isdigit():
+                calls[cells[0]] = int(cells[1])
+        # Every one of the four packets goes through each of these.
+        for name in ('frame', 'eth', 'ip', 'udp', 'dhcp'):
+            self.assertEqual(calls.get(name), 4, name)
+
+    def test_tshark_z_dissector_prof_heuristic(self, cmd_tshark, capture_file):
+        proc = self.assertRun((cmd_tshark, '-q', '-z', 'dissector,prof',
+            '-o', 'udp.try_heuristic_first:TRUE',
+            '-r', capture_file('dhcp.pcap')))
+        calls = {}
+        for line in proc.stdout_str.splitlines():
+            cells = line.split()
+            if len(cells) == 6 and cells[1].isdigit():
+                calls[cells[0]] = int(cells[1])
+        # The UDP heuristic dissectors are each tried, and reject, every
+        # one of the four packets before DHCP gets them.
+        heuristic_calls = [calls[name] for name in calls if name.endswith('_udp')]
+        self.assertTrue(heuristic_calls)
+        self.assertIn(4, heuristic_calls)
+
+    def test_tshark_z_dissector_prof_invalid(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-q', '-z', 'dissector,prof,udp',
+            '-r', capture_file('dhcp.pcap')),
+            expected_return=self.exit_command_line)
+        self.assertTrue(self.grepOutput('invalid "-z dissector,prof" argument'))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_editcap_dedup(subprocesstest.SubprocessTestCase):
+    def doubled_capture(self, cmd_mergecap, capture_file):
+        # Two back-to-back copies of the same four packets.
+        doubled_file = self.filename_from_id('doubled.pcap')
+        self.assertRun((cmd_mergecap, '-a', '-F', 'pcap', '-w', doubled_file,
+            capture_file('dhcp.pcap'), capture_file('dhcp.pcap')))
+        return doubled_file
+
+    def test_editcap_dedup_window(self, cmd_editcap, cmd_mergecap, capture_file):
+        doubled_file = self.doubled_capture(cmd_mergecap, capture_file)
+        self.assertRun((cmd_editcap, '-D', '5', doubled_file, self.filename_from_id(testout_pcap)))
+        self.assertTrue(self.grepOutput('8 packets seen, 4 packets skipped'))
+
+    def test_editcap_dedup_window_too_small(self, cmd_editcap, cmd_mergecap, capture_file):
+        doubled_file = self.doubled_capture(cmd_mergecap, capture_file)
+        self.assertRun((cmd_editcap, '-D', '4', doubled_file, self.filename_from_id(testout_pcap)))
+        self.assertTrue(self.grepOutput('8 packets seen, 0 packets skipped'))
+
+    def test_editcap_dedup_fast_hash(self, cmd_editcap, cmd_mergecap, capture_file):
+        doubled_file = self.doubled_capture(cmd_mergecap, capture_file)
+        self.assertRun((cmd_editcap, '--fast-dedup-hash', '-D', '5', doubled_file, self.filename_from_id(testout_pcap)))
+        self.assertTrue(self.grepOutput('8 packets seen, 4 packets skipped'))
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_tshark_extcap(subprocesstest.SubprocessTestCase):
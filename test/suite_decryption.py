@@ -369,6 +369,19 @@ class case_decrypt_tls(subprocesstest.SubprocessTestCase):
             )).stdout_str.replace('\r\n', '\n')
         self.assertEqual('example.com\t\n\t200\nexample.net\t\n\t200\n', output)
 
+    def test_tls12_dsb_read_ahead(self, cmd_tshark, capture_file):
+        '''TLS 1.2 with DSBs on the first pass of -2, read ahead or not.'''
+        for read_ahead in ('0', '1', '256'):
+            output = self.assertRun((cmd_tshark,
+                    '-r', capture_file('tls12-dsb.pcapng'),
+                    '-2', '--read-ahead', read_ahead,
+                    '-Tfields',
+                    '-e', 'http.host',
+                    '-e', 'http.response.code',
+                    '-Y', 'http',
+                )).stdout_str.replace('\r\n', '\n')
+            self.assertEqual('example.com\t\n\t200\nexample.net\t\n\t200\n', output)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -199,3 +199,58 @@ class case_dissect_tls(subprocesstest.SubprocessTestCase):
         '''Verify that TCP and TLS handshake reassembly works (second pass).'''
         self.check_tls_handshake_reassembly(
             cmd_tshark, capture_file, extraArgs=['-2'])
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_dissect_heuristics(subprocesstest.SubprocessTestCase):
+    def check_heuristic_prefs(self, cmd_tshark, capture_file, extraArgs=[]):
+        # UDT and DTLS over UDP are both found by heuristic dissectors.
+        args = ['-r', capture_file('udt-dtls.pcapng.gz'),
+                '-Tfields', '-eframe.protocols'] + extraArgs
+        proc = self.assertRun([cmd_tshark] + args)
+        expected = proc.stdout_str
+        self.assertIn('udt', expected)
+        proc = self.assertRun([cmd_tshark,
+                               '-o', 'protocols.reorder_heuristics:TRUE',
+                               '-o', 'protocols.remember_heuristics:TRUE'] + args)
+        self.assertEqual(proc.stdout_str, expected)
+
+    def test_heuristic_prefs(self, cmd_tshark, capture_file):
+        '''Remembering and reordering heuristics gives the same dissection.'''
+        self.check_heuristic_prefs(cmd_tshark, capture_file)
+
+    def test_heuristic_prefs_2(self, cmd_tshark, capture_file):
+        '''Remembering and reordering heuristics gives the same dissection (second pass).'''
+        self.check_heuristic_prefs(cmd_tshark, capture_file, extraArgs=['-2'])
+
+    def heuristic_calls(self, cmd_tshark, capture_file, extraArgs=[]):
+        # Calls of the UDP heuristic dissectors, from their profiles.
+        proc = self.assertRun([cmd_tshark, '-q', '-z', 'dissector,prof',
+                               '-r', capture_file] + extraArgs)
+        calls = 0
+        for line in proc.stdout_str.splitlines():
+            cells = line.split()
+            if len(cells) == 6 and cells[1].isdigit() and cells[0].endswith('_udp'):
+                calls += int(cells[1])
+        return calls
+
+    def test_heuristic_reorder(self, cmd_tshark, cmd_mergecap, capture_file):
+        '''Reordered heuristics dissect a frame the same way on both passes.'''
+        # 64 copies of the 34 packets, so that the UDP heuristics list is
+        # tried more than HEUR_REORDER_INTERVAL (1024) times and sorted.
+        many_file = self.filename_from_id('udt-dtls-many.pcapng')
+        self.assertRun([cmd_mergecap, '-a', '-w', many_file] +
+                       [capture_file('udt-dtls.pcapng.gz')] * 64)
+        reorder = ['-o', 'protocols.reorder_heuristics:TRUE']
+        # Once the list has been sorted, UDT and DTLS are tried before the
+        # heuristics that reject every packet, which are called less.
+        self.assertLess(self.heuristic_calls(cmd_tshark, many_file, reorder),
+                        self.heuristic_calls(cmd_tshark, many_file))
+        args = ['-r', many_file, '-Tfields', '-eframe.protocols'] + reorder
+        proc = self.assertRun([cmd_tshark] + args)
+        expected = proc.stdout_str
+        self.assertIn('udt', expected)
+        # On the second pass, each frame goes to the heuristic that took it
+        # on the first, although the list was sorted in between.
+        proc = self.assertRun([cmd_tshark, '-2'] + args)
+        self.assertEqual(proc.stdout_str, expected)
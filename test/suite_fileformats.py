@@ -247,3 +247,56 @@ class case_fileformat_mime(subprocesstest.SubprocessTestCase):
                 '-Tfields', '-e', 'frame.len', '-e', 'pcapng.block.length',
             ))
         self.assertEqual(proc.stdout_str.strip(), '480\t128,128,88,88,132,132,132,132')
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_compressed(subprocesstest.SubprocessTestCase):
+    def check_compressed_roundtrip(self, cmd_editcap, cmd_tshark, capture_file, compress_type, magic):
+        '''Compress a capture with editcap and read it back with tshark.'''
+        outfile = self.filename_from_id('dhcp.pcapng.' + compress_type)
+        proc = self.runProcess((cmd_editcap,
+            '--compress', compress_type,
+            capture_file('dhcp.pcap'), outfile
+        ))
+        if "isn't a valid compression type" in proc.stderr_str:
+            self.skipTest('Requires %s support.' % compress_type)
+        self.assertEqual(proc.returncode, 0)
+        with open(outfile, 'rb') as f:
+            self.assertEqual(f.read(len(magic)), magic)
+        expected = self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcap'))).stdout_str
+        proc = self.assertRun((cmd_tshark, '-r', outfile))
+        self.assertEqual(proc.stdout_str, expected)
+
+    def test_compress_gzip(self, cmd_editcap, cmd_tshark, capture_file):
+        self.check_compressed_roundtrip(cmd_editcap, cmd_tshark, capture_file, 'gzip', b'\x1f\x8b')
+
+    def test_compress_zstd(self, cmd_editcap, cmd_tshark, capture_file):
+        self.check_compressed_roundtrip(cmd_editcap, cmd_tshark, capture_file, 'zstd', b'\x28\xb5\x2f\xfd')
+
+    def test_compress_lz4(self, cmd_editcap, cmd_tshark, capture_file):
+        self.check_compressed_roundtrip(cmd_editcap, cmd_tshark, capture_file, 'lz4', b'\x04\x22\x4d\x18')
+
+    def check_compressed_seek(self, cmd_tshark, capture_file, compressed_name):
+        '''Read a compressed capture in two passes, seeking to each frame read on the second.'''
+        # The compressed captures are rsasnakeoil2.pcap compressed in 2 KiB
+        # pieces, each a frame of its own, so that there are seek points
+        # within the file, and packets that span two frames.
+        compressed_file = capture_file(compressed_name)
+        proc = self.runProcess((cmd_tshark, '-r', compressed_file))
+        if "isn't supported" in proc.stderr_str:
+            self.skipTest('Requires %s support.' % compressed_name.rsplit('.', 1)[1])
+        self.assertEqual(proc.returncode, 0)
+        # The second pass goes back to the start, and then forward through
+        # every frame, or skips over the frames the read filter drops.
+        for extra_args in ([], ['-R', 'frame.number == 3 || frame.number == 20 || frame.number == 21 || frame.number == 40 || frame.number == 58']):
+            args = ['-2'] + extra_args
+            expected = self.assertRun([cmd_tshark, '-r', capture_file('rsasnakeoil2.pcap')] + args).stdout_str
+            proc = self.assertRun([cmd_tshark, '-r', compressed_file] + args)
+            self.assertEqual(proc.stdout_str, expected)
+
+    def test_seek_zstd(self, cmd_tshark, capture_file):
+        self.check_compressed_seek(cmd_tshark, capture_file, 'rsasnakeoil2.pcap.zst')
+
+    def test_seek_lz4(self, cmd_tshark, capture_file):
+        self.check_compressed_seek(cmd_tshark, capture_file, 'rsasnakeoil2.pcap.lz4')
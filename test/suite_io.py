@@ -9,6 +9,7 @@
 #
 '''File I/O tests'''
 
+import gzip
 import io
 import os.path
 import subprocesstest
@@ -70,6 +71,38 @@ class case_tshark_io(subprocesstest.SubprocessTestCase):
         '''Read direct and write direct using TShark'''
         check_io_4_packets(self, capture_file, cmd=cmd_tshark)
 
+    def test_tshark_io_gzip_seek_index(self, cmd_tshark, capture_file, test_env):
+        '''Write a seek index for a gzip file and read it back using TShark'''
+        # Enough copies of the DHCP packets for several seek points, which
+        # are about 1 MB apart in the uncompressed data.
+        with open(capture_file('dhcp.pcap'), 'rb') as f:
+            pcap = f.read()
+        gz_file = self.filename_from_id('testout.pcap.gz')
+        with gzip.open(gz_file, 'wb') as f:
+            f.write(pcap[:24] + pcap[24:] * 3000)
+        cache_dir = self.filename_from_id('cache')
+        index_dir = os.path.join(cache_dir, 'wireshark', 'seek-index')
+        env = dict(test_env, XDG_CACHE_HOME=cache_dir)
+        tshark_cmd = (cmd_tshark, '-2', '-r', gz_file,
+            '-T', 'fields', '-e', 'frame.number', '-e', 'frame.len',
+            '-Y', 'frame.number in {1 4001 8002 11999}')
+        first_proc = self.assertRun(tshark_cmd, env=env)
+        # The index goes to the cache directory, not next to the capture.
+        self.assertFalse(os.path.exists(gz_file + '.wsidx'))
+        if sys.platform.startswith('win32'):
+            return
+        self.assertEqual(len(os.listdir(index_dir)), 1)
+        second_proc = self.assertRun(tshark_cmd, env=env)
+        self.assertEqual(first_proc.stdout_str, second_proc.stdout_str)
+        self.assertEqual(len(first_proc.stdout_str.splitlines()), 4)
+
+        # A file rewritten with its old time stamp doesn't use the old index.
+        mtime = os.stat(gz_file).st_mtime
+        with gzip.open(gz_file, 'wb', compresslevel=1) as f:
+            f.write(pcap[:24] + pcap[24:] * 2000)
+        os.utime(gz_file, (mtime, mtime))
+        third_proc = self.assertRun(tshark_cmd, env=env)
+        self.assertEqual(len(third_proc.stdout_str.splitlines()), 2)
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -122,6 +122,19 @@ class case_mergecap_pcap(subprocesstest.SubprocessTestCase):
         ))
         check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62)
 
+    def test_mergecap_many_pcap_pcap(self, cmd_mergecap, capture_file):
+        '''Merge more pcap files than fit in one read-ahead batch to pcap'''
+        testout_file = self.filename_from_id(testout_pcap)
+        in_files = [capture_file('dhcp.pcap'), capture_file('dhcp-nanosecond.pcap')] * 20
+        mergecap_proc = self.assertRun([cmd_mergecap,
+            '-v',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ] + in_files)
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 160, 1, 160)
+        capinfos_testout = self.getCaptureInfo(capinfos_args=('-o',), cap_file=testout_file)
+        self.assertTrue(re.search(r'Strict time order:\s+True', capinfos_testout) is not None)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
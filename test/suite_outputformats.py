@@ -10,6 +10,7 @@
 
 import json
 import os.path
+import struct
 import subprocesstest
 import fixtures
 from matchers import *
@@ -44,6 +45,30 @@ def check_outputformat(cmd_tshark, request, dirs, capture_file):
     return check_outputformat_real
 
 
+def arrow_message_types(stream):
+    '''Returns the header types of the messages of an Arrow IPC stream.'''
+    types = []
+    offset = 0
+    while True:
+        continuation, metadata_len = struct.unpack_from('<Ii', stream, offset)
+        if continuation != 0xffffffff:
+            raise ValueError('missing continuation marker at {}'.format(offset))
+        offset += 8
+        if metadata_len == 0:
+            break
+        metadata = stream[offset:offset + metadata_len]
+        offset += metadata_len
+        # Message table: header_type is field 1, bodyLength field 3.
+        table = struct.unpack_from('<I', metadata, 0)[0]
+        vtable = table - struct.unpack_from('<i', metadata, table)[0]
+        field_offsets = struct.unpack_from('<HHHH', metadata, vtable + 4)
+        types.append(metadata[table + field_offsets[1]])
+        offset += struct.unpack_from('<q', metadata, table + field_offsets[3])[0]
+    if offset != len(stream):
+        raise ValueError('trailing data after end of stream')
+    return types
+
+
 @fixtures.mark_usefixtures('base_env')
 @fixtures.uses_fixtures
 class case_outputformats(subprocesstest.SubprocessTestCase):
@@ -84,3 +109,47 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
             {"index": {"_index": "packets-2004-12-05", "_type": "doc"}},
             {"timestamp": "1102274184317", "layers": {"frame_number": ["1"]}}
         ], multiline=True)
+
+    def test_outputformat_json_no_duplicate_keys(self, cmd_tshark, capture_file):
+        '''Checks that --no-duplicate-keys merges repeated keys into arrays.'''
+        tshark_proc = self.assertRun([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+                                      '-T', 'json', '--no-duplicate-keys', '-c1'])
+        packets = json.loads(tshark_proc.stdout_str)
+        self.assertEqual(len(packets), 1)
+        # The DHCP Discover carries several options, which share the key
+        # "dhcp.option.type" in the "dhcp" object.
+        options = packets[0]['_source']['layers']['dhcp']['dhcp.option.type']
+        self.assertIsInstance(options, list)
+        self.assertGreater(len(options), 1)
+
+    def run_tshark_arrow(self, cmd_tshark, capture_file, args):
+        '''Runs tshark -Tarrow and returns the stream, which isn't text.'''
+        arrow_file = self.filename_from_id('fields.arrows')
+        self.assertRun(' '.join([cmd_tshark, '-r', capture_file('dhcp.pcap'), '-T', 'arrow']
+                                + args + ['>', arrow_file]), shell=True)
+        with open(arrow_file, 'rb') as arrow_fd:
+            return arrow_fd.read()
+
+    def test_outputformat_arrow(self, cmd_tshark, capture_file):
+        '''Checks the framing of -Tarrow output.'''
+        schema, dictionary, record_batch = 1, 2, 3
+        fields = ['-e', 'frame.number', '-e', 'ip.src', '-e', 'frame.time', '-e', '_ws.col.Protocol']
+        stream = self.run_tshark_arrow(cmd_tshark, capture_file, fields)
+        self.assertEqual(arrow_message_types(stream), [schema, dictionary, record_batch])
+        stream = self.run_tshark_arrow(cmd_tshark, capture_file, ['-E', 'batch=1'] + fields)
+        self.assertEqual(arrow_message_types(stream), [schema] + [dictionary, record_batch] * 4)
+
+    def test_outputformat_arrow_values(self, cmd_tshark, capture_file):
+        '''Checks that -Tarrow columns are typed.'''
+        try:
+            import pyarrow
+        except ImportError:
+            self.skipTest('pyarrow is not available')
+        stream = self.run_tshark_arrow(cmd_tshark, capture_file,
+            ['-e', 'frame.number', '-e', 'ip.src', '-e', 'frame.time_delta', '-e', '_ws.col.Protocol'])
+        table = pyarrow.ipc.open_stream(stream).read_all()
+        self.assertEqual(str(table.schema.field('frame.number').type), 'uint32')
+        self.assertEqual(str(table.schema.field('frame.time_delta').type), 'duration[ns]')
+        self.assertEqual(table.column('frame.number').to_pylist(), [1, 2, 3, 4])
+        self.assertEqual(table.column('ip.src').to_pylist()[0], 0)
+        self.assertEqual(table.column('_ws.col.Protocol').to_pylist(), ['DHCP'] * 4)
@@ -10,7 +10,12 @@
 '''sharkd tests'''
 
 import json
+import os
+import signal
+import socket
 import subprocess
+import sys
+import time
 import unittest
 import subprocesstest
 import fixtures
@@ -59,6 +64,64 @@ def check_sharkd_session(run_sharkd_session, request):
     return check_sharkd_session_real
 
 
+@fixtures.fixture
+def sharkd_shared(cmd_sharkd, base_env, home_path):
+    '''Runs "sharkd -s" on a unix socket and returns a function that opens
+    a session on it.'''
+    if sys.platform.startswith('win32'):
+        fixtures.skip('sharkd -s is not available on Windows')
+    sock_path = os.path.join(home_path, 'sharkd.sock')
+    # sharkd goes into the background; its own session lets us kill every
+    # process it starts.
+    parent = subprocess.Popen((cmd_sharkd, '-s', 'unix:' + sock_path),
+        env=base_env, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+        stderr=subprocess.DEVNULL, start_new_session=True)
+    parent.wait(timeout=30)
+    for _ in range(300):
+        if os.path.exists(sock_path):
+            break
+        time.sleep(0.1)
+
+    class SharkdSession:
+        def __init__(self):
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.settimeout(60)
+            self.sock.connect(sock_path)
+            self.reader = self.sock.makefile('rb')
+
+        def send(self, request, newline=True):
+            data = json.dumps(request).encode('utf8')
+            self.sock.sendall(data + b'\n' if newline else data)
+
+        def recv(self):
+            line = self.reader.readline()
+            return json.loads(line) if line else None
+
+        def request(self, request):
+            self.send(request)
+            return self.recv()
+
+        def close(self):
+            self.reader.close()
+            self.sock.close()
+
+    sessions = []
+    def open_session():
+        session = SharkdSession()
+        sessions.append(session)
+        return session
+
+    try:
+        yield open_session
+    finally:
+        for session in sessions:
+            session.close()
+        try:
+            os.killpg(parent.pid, signal.SIGKILL)
+        except ProcessLookupError:
+            pass
+
+
 @fixtures.mark_usefixtures('base_env')
 @fixtures.uses_fixtures
 class case_sharkd(subprocesstest.SubprocessTestCase):
@@ -86,6 +149,17 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 "filename": "dhcp.pcap", "filesize": 1400},
         ))
 
+    def test_sharkd_req_status_dissector_prof(self, run_sharkd_session, capture_file):
+        outputs = run_sharkd_session((
+            json.dumps({"req": "load", "file": capture_file('dhcp.pcap'), "prof": "1"}),
+            json.dumps({"req": "status"}),
+        ))
+        self.assertEqual(outputs[0], {"err": 0})
+        calls = {prof["name"]: prof["calls"] for prof in outputs[1]["dissector_prof"]}
+        self.assertEqual(calls.get("dhcp"), 4)
+        for prof in outputs[1]["dissector_prof"]:
+            self.assertGreaterEqual(prof["incl_ns"], prof["excl_ns"])
+
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
@@ -170,6 +244,17 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             }),
         ))
 
+    def test_sharkd_req_frames_filter_prefix(self, run_sharkd_session, capture_file):
+        '''Cached filter results are not shared by filters that differ only in a netmask.'''
+        outputs = run_sharkd_session([json.dumps(x) for x in (
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames", "filter": "ip.src == 192.168.0.0/16"},
+            {"req": "frames", "filter": "ip.src == 192.168.0.0"},
+            {"req": "frames", "filter": "ip.src == 192.168.0.0/16 && !ip.src == 192.168.0.0"},
+        )])
+        self.assertEqual(outputs[0], {"err": 0})
+        self.assertEqual([len(frames) for frames in outputs[1:]], [2, 0, 2])
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -314,6 +399,29 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"intervals": [[0, 2, 656]], "last": 0, "frames": 2, "bytes": 656},
         ))
 
+    def test_sharkd_req_intervals_filter_combined(self, check_sharkd_session, capture_file):
+        # The later filters are answered from the results of the first two.
+        def frames(count, size):
+            return {"intervals": [[0, count, size]], "last": 0,
+                    "frames": count, "bytes": size}
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "intervals", "filter": "frame.number <= 2"},
+            {"req": "intervals", "filter": "frame.number >= 2"},
+            {"req": "intervals", "filter": "frame.number >= 2 && frame.number <= 2"},
+            {"req": "intervals", "filter": "frame.number<=2 || frame.number>=2"},
+            {"req": "intervals", "filter": "!(frame.number <= 2)"},
+            {"req": "intervals", "filter": "!frame.number >= 2 && frame.number <= 2"},
+        ), (
+            {"err": 0},
+            frames(2, 656),
+            frames(3, 998),
+            frames(1, 342),
+            frames(4, 1312),
+            frames(2, 656),
+            frames(1, 314),
+        ))
+
     def test_sharkd_req_frame_basic(self, check_sharkd_session, capture_file):
         # XXX add more tests for other options (ref_frame, prev_frame, columns, color, bytes, hidden)
         check_sharkd_session((
@@ -459,4 +567,48 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
         ), (
             {"err": 0},
             MatchAny(),
-        ))
\ No newline at end of file
+        ))
+
+
+@fixtures.mark_usefixtures('base_env')
+@fixtures.uses_fixtures
+class case_sharkd_shared(subprocesstest.SubprocessTestCase):
+    def test_sharkd_shared_load(self, sharkd_shared, capture_file):
+        '''Two sessions loading the same capture see the same frames.'''
+        first = sharkd_shared()
+        second = sharkd_shared()
+        for session in (first, second):
+            self.assertEqual(session.request({"req": "load", "file": capture_file('dhcp.pcap')}), {"err": 0})
+        for session in (first, second):
+            self.assertEqual(session.request({"req": "status"})['frames'], 4)
+
+    def test_sharkd_shared_private(self, sharkd_shared, capture_file):
+        '''A session that does not start with a load can still load a file.'''
+        session = sharkd_shared()
+        self.assertEqual(session.request({"req": "status"}), {"frames": 0, "duration": 0.0})
+        self.assertEqual(session.request({"req": "load", "file": capture_file('dhcp.pcap')}), {"err": 0})
+        self.assertEqual(session.request({"req": "status"})['frames'], 4)
+
+    def test_sharkd_shared_setconf(self, sharkd_shared, capture_file):
+        '''Preferences of a shared capture cannot be changed by one session.'''
+        session = sharkd_shared()
+        self.assertEqual(session.request({"req": "load", "file": capture_file('dhcp.pcap')}), {"err": 0})
+        reply = session.request({"req": "setconf", "name": "tcp.check_checksum", "value": "TRUE"})
+        self.assertIn('shared session', reply['errmsg'])
+
+    def test_sharkd_shared_unterminated(self, sharkd_shared, capture_file):
+        '''A last request without a newline is still answered.'''
+        session = sharkd_shared()
+        self.assertEqual(session.request({"req": "load", "file": capture_file('dhcp.pcap')}), {"err": 0})
+        session.send({"req": "status"}, newline=False)
+        session.sock.shutdown(socket.SHUT_WR)
+        self.assertEqual(session.recv()['frames'], 4)
+
+    def test_sharkd_shared_idle_client(self, sharkd_shared, capture_file):
+        '''A client that sends nothing does not hold up other sessions.'''
+        idle = sharkd_shared()
+        session = sharkd_shared()
+        session.sock.settimeout(3)
+        self.assertEqual(session.request({"req": "status"}), {"frames": 0, "duration": 0.0})
+        idle.send({"req": "status"})
+        self.assertEqual(idle.recv(), {"frames": 0, "duration": 0.0})
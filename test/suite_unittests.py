@@ -20,21 +20,67 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_column_utils_test(self, program, base_env):
+        '''column_utils_test'''
+        self.assertRun(program('column_utils_test'), env=base_env)
+
+    def test_unit_crc32_test(self, program, base_env):
+        '''crc32_test, with each CRC-32 implementation'''
+        for implementation in ('', 'slice8', 'bytewise'):
+            crc32_env = dict(base_env, WIRESHARK_CRC32=implementation)
+            self.assertRun(program('crc32_test'), env=crc32_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
 
+    def test_unit_frame_bitmap_test(self, program, base_env):
+        '''frame_bitmap_test'''
+        self.assertRun(program('frame_bitmap_test'), env=base_env)
+
+    def test_unit_frame_data_sequence_test(self, program, base_env):
+        '''frame_data_sequence_test'''
+        self.assertRun(program('frame_data_sequence_test'), env=base_env)
+
+    def test_unit_in_cksum_test(self, program, base_env):
+        '''in_cksum_test, with each checksum implementation'''
+        for implementation in ('', 'sse2', 'portable'):
+            cksum_env = dict(base_env, WIRESHARK_CKSUM=implementation)
+            self.assertRun(program('in_cksum_test'), env=cksum_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         self.assertRun(program('oids_test'), env=base_env)
 
+    def test_unit_packet_list_sort_test(self, program, base_env):
+        '''packet_list_sort_test'''
+        self.assertRun(program('packet_list_sort_test'), env=base_env)
+
+    def test_unit_pcapio_writer_test(self, program, base_env):
+        '''pcapio_writer_test'''
+        self.assertRun(program('pcapio_writer_test'), env=base_env)
+
     def test_unit_reassemble_test(self, program, base_env):
         '''reassemble_test'''
         self.assertRun(program('reassemble_test'), env=base_env)
 
+    def test_unit_shm_tail_test(self, program, base_env):
+        '''shm_tail_test'''
+        self.assertRun(program('shm_tail_test'), env=base_env)
+
+    def test_unit_spsc_ring_test(self, program, base_env):
+        '''spsc_ring_test'''
+        self.assertRun(program('spsc_ring_test'), env=base_env)
+
     def test_unit_tvbtest(self, program, base_env):
-        '''tvbtest'''
-        self.assertRun(program('tvbtest'), env=base_env)
+        '''tvbtest, with each ws_memscan implementation'''
+        for implementation in ('', 'sse2', 'portable'):
+            memscan_env = dict(base_env, WIRESHARK_MEMSCAN=implementation)
+            self.assertRun(program('tvbtest'), env=memscan_env)
+
+    def test_unit_uint_dtbl_test(self, program, base_env):
+        '''uint_dtbl_test'''
+        self.assertRun(program('uint_dtbl_test'), env=base_env)
 
     def test_unit_wmem_test(self, program, base_env):
         '''wmem_test'''
@@ -0,0 +1,91 @@
+#
+# Parts shared by the *-benchmark.py scripts
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Synthetic captures, timing and result columns for the benchmark scripts.'''
+
+import shutil
+import struct
+import subprocess
+import sys
+import time
+
+PCAP_MAGIC = 0xa1b2c3d4
+LINKTYPE_ETHERNET = 1
+
+ETHERNET_HEADER = b'\x00\x11\x22\x33\x44\x55' + b'\x00\x66\x77\x88\x99\xaa' + b'\x08\x00'
+
+
+def pcap_header():
+    return struct.pack('<IHHiIII', PCAP_MAGIC, 2, 4, 0, 0, 65535, LINKTYPE_ETHERNET)
+
+
+def pcap_record(n, frame, usecs_per_frame=10):
+    '''A record header and frame, time stamped usecs_per_frame apart.'''
+    usecs = n * usecs_per_frame
+    return struct.pack('<IIII', 1000000000 + usecs // 1000000, usecs % 1000000, len(frame), len(frame)) + frame
+
+
+def write_pcap(path, frames, opener=open, usecs_per_frame=10):
+    '''Write an Ethernet pcap file holding the given frames.'''
+    with opener(path, 'wb') as handle:
+        handle.write(pcap_header())
+        for n, frame in enumerate(frames):
+            handle.write(pcap_record(n, frame, usecs_per_frame))
+
+
+def ipv4_frame(ident, proto, src, dst, l4, flags_frag=0):
+    '''An Ethernet/IPv4 frame holding l4. The IP checksum is left zero.'''
+    ip = struct.pack('!BBHHHBBH4s4s', 0x45, 0, 20 + len(l4), ident & 0xffff, flags_frag, 64, proto, 0, src, dst)
+    return ETHERNET_HEADER + ip + l4
+
+
+def count_frames(tshark, capture):
+    out = subprocess.check_output([tshark, '-r', capture, '-T', 'fields', '-e', 'frame.number'])
+    return len(out.splitlines())
+
+
+def best_time(cmd, repeat, env=None):
+    '''Run cmd repeat times, throwing away its output, and return the
+    shortest run in seconds.'''
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.check_call(cmd, stdout=subprocess.DEVNULL, env=env)
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+
+def add_tshark_arguments(parser, baseline=True, repeat_help='runs per measurement'):
+    '''Add --tshark, --baseline-tshark and --repeat to an ArgumentParser.'''
+    parser.add_argument('--tshark', default=shutil.which('tshark') or 'tshark',
+                        help='tshark binary to run (default: tshark in PATH)')
+    if baseline:
+        parser.add_argument('--baseline-tshark',
+                            help='tshark binary to run on the same captures, to compare two builds')
+    add_repeat_argument(parser, repeat_help)
+
+
+def add_repeat_argument(parser, repeat_help='runs per measurement'):
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help=repeat_help + '; the best is reported (default: %(default)s)')
+
+
+def baseline_header(baseline_tshark):
+    return ' {:>12} {:>8}'.format('baseline', 'speedup') if baseline_tshark else ''
+
+
+def baseline_columns(baseline, best):
+    return ' {:>12.3f} {:>7.2f}x'.format(baseline, baseline / best) if baseline is not None else ''
+
+
+def print_line(line):
+    print(line)
+    sys.stdout.flush()
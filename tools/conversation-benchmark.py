@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+#
+# Time tshark over captures made of many short-lived UDP flows
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark over synthetic captures of short-lived UDP flows.
+
+Each flow is a DNS query from its own client address and port followed
+by the response, so nearly every query creates a new conversation and
+nearly every lookup for it misses the wildcard tables. This is the
+worst case for conversation lookups.
+
+Example:
+    tools/conversation-benchmark.py --tshark build/run/tshark -f 100000,1000000,2000000
+'''
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+DNS_PORT = 53
+
+DNS_QNAME = b'\x04host\x07example\x00'
+
+
+def dns_message(flow, response):
+    '''A query for host.example, or its NXDOMAIN response.'''
+    flags = 0x8183 if response else 0x0100
+    return struct.pack('!HHHHHH', flow & 0xffff, flags, 1, 0, 0, 0) + DNS_QNAME + struct.pack('!HH', 1, 1)
+
+
+def udp_frame(flow, response):
+    '''An Ethernet/IPv4/UDP frame of the given flow.'''
+    client = bytes((10, (flow >> 16) & 0xff, (flow >> 8) & 0xff, flow & 0xff))
+    server = bytes((192, 0, 2, 53))
+    client_port = 1024 + flow % 64512
+    payload = dns_message(flow, response)
+    if response:
+        src, dst, sport, dport = server, client, DNS_PORT, client_port
+    else:
+        src, dst, sport, dport = client, server, client_port, DNS_PORT
+    udp = struct.pack('!HHHH', sport, dport, 8 + len(payload), 0) + payload
+    return benchmark_common.ipv4_frame(flow, 17, src, dst, udp)
+
+
+def flow_frames(flow_count):
+    for flow in range(flow_count):
+        for response in (False, True):
+            yield udp_frame(flow, response)
+
+
+def time_tshark(tshark, capture, display_filter, repeat):
+    cmd = [tshark, '-q', '-r', capture]
+    if display_filter:
+        cmd += ['-Y', display_filter]
+    return benchmark_common.best_time(cmd, repeat)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser, repeat_help='runs per flow count')
+    parser.add_argument('-f', '--flows', default='100000,1000000,2000000',
+                        help='comma-separated list of flow counts (default: %(default)s)')
+    parser.add_argument('-Y', '--display-filter',
+                        help='display filter to apply, which makes tshark build trees')
+    args = parser.parse_args()
+
+    flow_counts = [int(f) for f in args.flows.split(',')]
+
+    print('{:>10} {:>10} {:>12} {:>14}'.format('flows', 'frames', 'seconds', 'frames/sec')
+          + benchmark_common.baseline_header(args.baseline_tshark))
+
+    work_dir = tempfile.mkdtemp(prefix='conversation-bench-')
+    try:
+        for flow_count in flow_counts:
+            capture = os.path.join(work_dir, 'flows-{}.pcap'.format(flow_count))
+            benchmark_common.write_pcap(capture, flow_frames(flow_count), usecs_per_frame=5)
+            frames = flow_count * 2
+            best = time_tshark(args.tshark, capture, args.display_filter, args.repeat)
+            baseline = None
+            if args.baseline_tshark:
+                baseline = time_tshark(args.baseline_tshark, capture, args.display_filter, args.repeat)
+            benchmark_common.print_line('{:>10} {:>10} {:>12.3f} {:>14.0f}'.format(flow_count, frames, best, frames / best)
+                                        + benchmark_common.baseline_columns(baseline, best))
+            os.remove(capture)
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
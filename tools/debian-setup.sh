@@ -75,6 +75,7 @@ ADDITIONAL_LIST="libnl-3-dev \
 	libparse-yapp-perl \
 	libcap-dev \
 	liblz4-dev \
+	libzstd-dev \
 	libsnappy-dev \
 	libspandsp-dev \
 	libxml2-dev \
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Time mergecap merging by timestamp over a growing number of input files
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Generate synthetic pcap files and time mergecap on them.
+
+For each file count k, the same total number of packets is spread
+round-robin over k files, so the time stamps of the inputs interleave
+and every record forces a fresh choice of input file. With a merge
+that scales well in k the run times should stay close to flat.
+
+Example:
+    tools/mergecap-benchmark.py --mergecap build/run/mergecap -k 2,16,128,512
+'''
+
+import argparse
+import os
+import shutil
+import sys
+import tempfile
+
+import benchmark_common
+
+
+def write_synthetic_pcaps(directory, file_count, packet_count, packet_len):
+    '''Write file_count pcap files holding packet_count packets between them.'''
+    frame = bytes(range(256)) * (packet_len // 256 + 1)
+    frame = frame[:packet_len]
+    paths = []
+    handles = []
+    for i in range(file_count):
+        path = os.path.join(directory, 'in-{:05d}.pcap'.format(i))
+        handle = open(path, 'wb')
+        handle.write(benchmark_common.pcap_header())
+        paths.append(path)
+        handles.append(handle)
+    for n in range(packet_count):
+        # One packet every 10 microseconds, dealt out to the files in turn.
+        handles[n % file_count].write(benchmark_common.pcap_record(n, frame))
+    for handle in handles:
+        handle.close()
+    return paths
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--mergecap', default=shutil.which('mergecap') or 'mergecap',
+                        help='mergecap binary to run (default: mergecap in PATH)')
+    parser.add_argument('-k', '--file-counts', default='1,2,8,32,128,512',
+                        help='comma-separated list of input file counts (default: %(default)s)')
+    parser.add_argument('-n', '--packets', type=int, default=1000000,
+                        help='total number of packets per run (default: %(default)s)')
+    parser.add_argument('-l', '--length', type=int, default=64,
+                        help='length of each packet in bytes (default: %(default)s)')
+    benchmark_common.add_repeat_argument(parser, 'runs per file count')
+    args = parser.parse_args()
+
+    file_counts = [int(k) for k in args.file_counts.split(',')]
+
+    print('{:>8} {:>12} {:>12} {:>14}'.format('files', 'packets', 'seconds', 'packets/sec'))
+    for file_count in file_counts:
+        work_dir = tempfile.mkdtemp(prefix='mergecap-bench-')
+        try:
+            in_files = write_synthetic_pcaps(work_dir, file_count, args.packets, args.length)
+            out_file = os.path.join(work_dir, 'out.pcap')
+            best = benchmark_common.best_time([args.mergecap, '-F', 'pcap', '-w', out_file] + in_files, args.repeat)
+            benchmark_common.print_line('{:>8} {:>12} {:>12.3f} {:>14.0f}'.format(
+                file_count, args.packets, best, args.packets / best))
+        finally:
+            shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -186,6 +186,8 @@ echo "snappy is unavailable" >&2
 add_package ADDITIONAL_LIST lz4-devel || add_package ADDITIONAL_LIST liblz4-devel ||
 echo "lz4 devel is unavailable" >&2
 
+add_package ADDITIONAL_LIST libzstd-devel || echo "zstd devel is unavailable" >&2
+
 add_package ADDITIONAL_LIST libcap-progs || echo "cap progs are unavailable" >&2
 
 add_package ADDITIONAL_LIST libmaxminddb-devel ||
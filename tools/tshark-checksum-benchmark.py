@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# Time tshark verifying IPv4, TCP and UDP checksums
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark verifying Internet checksums on large packets.
+
+The IP, TCP and UDP dissectors check their checksums with in_cksum(),
+which sums 16 or 32 bytes at a time when the CPU has SSE2 or AVX2. A
+synthetic capture is written for each transport. The TCP capture holds
+full-sized segments, and the UDP capture holds 8 KB jumbo datagrams. All
+the checksums are correct. Checksum checking is turned on with -o, as it
+is off by default.
+
+Each capture is read with every implementation the CPU supports, chosen
+with the WIRESHARK_CKSUM environment variable. The "default" one is the
+one tshark would pick. The baseline build runs with its default one.
+
+Example:
+    tools/tshark-checksum-benchmark.py --tshark build/run/tshark --baseline-tshark old/run/tshark
+'''
+
+import argparse
+import os
+import random
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+IMPLEMENTATIONS = ['default', 'sse2', 'portable']
+
+CHECKSUM_PREFS = ['-o', 'ip.check_checksum:TRUE',
+                  '-o', 'tcp.check_checksum:TRUE',
+                  '-o', 'udp.check_checksum:TRUE']
+
+
+def internet_checksum(data):
+    if len(data) % 2:
+        data += b'\x00'
+    total = sum(struct.unpack('!{}H'.format(len(data) // 2), data))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+
+def checksummed_frame(n, proto, src, dst, l4):
+    '''An Ethernet frame holding l4, whose checksum field is zero and is
+    filled in here from the pseudo-header.'''
+    pseudo = src + dst + struct.pack('!BBH', 0, proto, len(l4))
+    offset = 16 if proto == 6 else 6
+    l4 = l4[:offset] + struct.pack('!H', internet_checksum(pseudo + l4)) + l4[offset + 2:]
+    frame = benchmark_common.ipv4_frame(n, proto, src, dst, l4, flags_frag=0x4000)
+    ip_start = len(benchmark_common.ETHERNET_HEADER)
+    ip_sum = internet_checksum(frame[ip_start:ip_start + 20])
+    return frame[:ip_start + 10] + struct.pack('!H', ip_sum) + frame[ip_start + 12:]
+
+
+def payloads(size):
+    '''A few random payloads, reused to keep writing the capture quick.'''
+    rng = random.Random(size)
+    return [bytes(rng.getrandbits(8) for _ in range(size)) for _ in range(16)]
+
+
+def tcp_frames(count):
+    '''Full-sized segments, one way, on 64 connections.'''
+    data = payloads(1460)
+    seqs = {}
+    for n in range(count):
+        conn = n % 64
+        seq = seqs.get(conn, 1)
+        tcp = struct.pack('!HHIIBBHHH', 1024 + conn, 5001, seq, 1, 5 << 4, 0x10, 65535, 0, 0)
+        yield checksummed_frame(n, 6, bytes((10, 0, 0, conn)), bytes((10, 1, 0, 1)), tcp + data[n % len(data)])
+        seqs[conn] = seq + 1460
+
+
+def udp_frames(count):
+    # An odd length, so the last word is padded.
+    data = payloads(8191)
+    for n in range(count):
+        payload = data[n % len(data)]
+        udp = struct.pack('!HHHH', 40000 + n % 64, 9, 8 + len(payload), 0) + payload
+        yield checksummed_frame(n, 17, bytes((192, 0, 2, 10)), bytes((198, 51, 100, 20)), udp)
+
+
+CAPTURES = {'tcp': tcp_frames, 'udp': udp_frames}
+
+
+def time_tshark(tshark, capture, implementation, extra_args, repeat):
+    env = dict(os.environ)
+    env.pop('WIRESHARK_CKSUM', None)
+    if implementation != 'default':
+        env['WIRESHARK_CKSUM'] = implementation
+    return benchmark_common.best_time([tshark, '-r', capture] + CHECKSUM_PREFS + extra_args, repeat, env)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser)
+    parser.add_argument('-n', '--packets', type=int, default=100000,
+                        help='number of packets in each synthetic capture (default: %(default)s)')
+    args = parser.parse_args()
+
+    # Only the checksum fields are asked for, so that little else but
+    # dissection is timed.
+    extra_args = ['-T', 'fields', '-e', 'ip.checksum.status', '-e', 'tcp.checksum.status',
+                  '-e', 'udp.checksum.status']
+
+    work_dir = tempfile.mkdtemp(prefix='tshark-checksum-bench-')
+    try:
+        print('{:<6} {:<10} {:>10} {:>14}'.format('proto', 'cksum', 'seconds', 'frames/sec')
+              + benchmark_common.baseline_header(args.baseline_tshark))
+        for proto, frames in sorted(CAPTURES.items()):
+            capture = os.path.join(work_dir, proto + '.pcap')
+            benchmark_common.write_pcap(capture, frames(args.packets))
+            baseline = None
+            if args.baseline_tshark:
+                baseline = time_tshark(args.baseline_tshark, capture, 'default', extra_args, args.repeat)
+            for implementation in IMPLEMENTATIONS:
+                best = time_tshark(args.tshark, capture, implementation, extra_args, args.repeat)
+                benchmark_common.print_line('{:<6} {:<10} {:>10.3f} {:>14.0f}'.format(
+                    proto, implementation, best, args.packets / best)
+                    + benchmark_common.baseline_columns(baseline, best))
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# Time tshark -w with packet summaries, which needs the columns
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark writing a capture while it prints packet summaries.
+
+tshark only fills in the columns when it prints summary lines (or a tap
+or -T fields wants them), so each run uses -w together with -P. With a
+display filter, only the matching packets are printed. The other packets
+are dissected with columns enabled, but their column text is never
+shown. Without --capture-file a synthetic TCP capture is written: the
+TCP dissector builds most of its Info column from ports and numbers.
+
+Example:
+    tools/tshark-columns-benchmark.py --tshark build/run/tshark --baseline-tshark old/run/tshark
+'''
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+DEFAULT_FILTERS = ['', 'tcp.port == 1024', 'frame.number == 1']
+
+
+def tcp_frame(n, payload_len):
+    '''An Ethernet/IPv4/TCP data segment on one of 256 connections.'''
+    conn = n % 256
+    seq = 1 + (n // 256) * payload_len
+    payload = bytes((n + i) & 0xff for i in range(payload_len))
+    tcp = struct.pack('!HHIIBBHHH', 1024 + conn, 8080, seq, 1, 5 << 4, 0x18, 65535, 0, 0) + payload
+    return benchmark_common.ipv4_frame(n, 6, bytes((10, 0, 0, conn)), bytes((10, 1, 0, 1)), tcp)
+
+
+def time_tshark(tshark, capture, out_file, display_filter, repeat):
+    cmd = [tshark, '-r', capture, '-w', out_file, '-P']
+    if display_filter:
+        cmd += ['-Y', display_filter]
+    return benchmark_common.best_time(cmd, repeat)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser, repeat_help='runs per filter')
+    parser.add_argument('--capture-file',
+                        help='capture to read instead of a synthetic one')
+    parser.add_argument('-n', '--packets', type=int, default=500000,
+                        help='number of packets in the synthetic capture (default: %(default)s)')
+    parser.add_argument('-l', '--length', type=int, default=64,
+                        help='TCP payload length in bytes (default: %(default)s)')
+    parser.add_argument('-Y', '--display-filter', action='append',
+                        help='display filter to time; may be repeated (default: none, '
+                        + ', '.join("'{}'".format(f) for f in DEFAULT_FILTERS[1:]) + ')')
+    args = parser.parse_args()
+
+    filters = args.display_filter or DEFAULT_FILTERS
+
+    work_dir = tempfile.mkdtemp(prefix='tshark-columns-bench-')
+    try:
+        if args.capture_file:
+            capture = args.capture_file
+            frames = benchmark_common.count_frames(args.tshark, capture)
+        else:
+            capture = os.path.join(work_dir, 'in.pcap')
+            benchmark_common.write_pcap(capture, (tcp_frame(n, args.length) for n in range(args.packets)))
+            frames = args.packets
+        out_file = os.path.join(work_dir, 'out.pcapng')
+
+        width = max(len('filter'), max(len(f) for f in filters))
+        print('{:<{w}} {:>12} {:>14}'.format('filter', 'seconds', 'frames/sec', w=width)
+              + benchmark_common.baseline_header(args.baseline_tshark))
+        for display_filter in filters:
+            best = time_tshark(args.tshark, capture, out_file, display_filter, args.repeat)
+            baseline = None
+            if args.baseline_tshark:
+                baseline = time_tshark(args.baseline_tshark, capture, out_file, display_filter, args.repeat)
+            benchmark_common.print_line('{:<{w}} {:>12.3f} {:>14.0f}'.format(
+                display_filter or '(none)', best, frames / best, w=width)
+                + benchmark_common.baseline_columns(baseline, best))
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+# Time tshark writing packet details in each of its output formats
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark writing packet details as JSON, EK, PDML and text.
+
+Each format is run the way test/suite_outputformats.py runs it, with the
+output thrown away, so that the time is spent dissecting and formatting.
+The text detail output (-V) is included as a reference. Without
+--capture-file a synthetic capture of DNS queries and responses is
+written; DNS answers repeat the same fields, so the JSON writer has to
+group them.
+
+Example:
+    tools/tshark-outputformats-benchmark.py --tshark build/run/tshark --baseline-tshark old/run/tshark
+'''
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+FORMATS = {
+    'json': ['-T', 'json'],
+    'jsonraw': ['-T', 'jsonraw'],
+    'json-x': ['-T', 'json', '-x'],
+    'json-dedup': ['-T', 'json', '--no-duplicate-keys'],
+    'ek': ['-T', 'ek'],
+    'pdml': ['-T', 'pdml'],
+    'text': ['-V'],
+}
+DEFAULT_FORMATS = ['json', 'jsonraw', 'json-dedup', 'ek', 'pdml', 'text']
+
+
+def dns_message(n, response, answers):
+    '''A query for host<n>.example, or a response with several A records.'''
+    qname = b'\x04host' + bytes((48 + n % 10,)) + b'\x07example\x00'
+    if not response:
+        return struct.pack('!HHHHHH', n & 0xffff, 0x0100, 1, 0, 0, 0) + qname + struct.pack('!HH', 1, 1)
+    message = struct.pack('!HHHHHH', n & 0xffff, 0x8180, 1, answers, 0, 0) + qname + struct.pack('!HH', 1, 1)
+    for a in range(answers):
+        message += struct.pack('!HHHIH4s', 0xc00c, 1, 1, 300, 4, bytes((192, 0, 2, a + 1)))
+    return message
+
+
+def udp_frame(n, response, answers):
+    client = bytes((10, 0, (n >> 8) & 0xff, n & 0xff))
+    server = bytes((192, 0, 2, 53))
+    client_port = 1024 + n % 64512
+    payload = dns_message(n, response, answers)
+    if response:
+        src, dst, sport, dport = server, client, 53, client_port
+    else:
+        src, dst, sport, dport = client, server, client_port, 53
+    udp = struct.pack('!HHHH', sport, dport, 8 + len(payload), 0) + payload
+    return benchmark_common.ipv4_frame(n, 17, src, dst, udp)
+
+
+def dns_frames(packet_count, answers):
+    for n in range(packet_count):
+        yield udp_frame(n // 2, n % 2 == 1, answers)
+
+
+def time_tshark(tshark, capture, format_args, repeat):
+    return benchmark_common.best_time([tshark, '-r', capture] + format_args, repeat)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser, repeat_help='runs per format')
+    parser.add_argument('--capture-file',
+                        help='capture to read instead of a synthetic one')
+    parser.add_argument('-n', '--packets', type=int, default=100000,
+                        help='number of packets in the synthetic capture (default: %(default)s)')
+    parser.add_argument('-a', '--answers', type=int, default=8,
+                        help='A records in each DNS response (default: %(default)s)')
+    parser.add_argument('-f', '--format', action='append', choices=sorted(FORMATS),
+                        help='output format to time; may be repeated (default: '
+                        + ', '.join(DEFAULT_FORMATS) + ')')
+    args = parser.parse_args()
+
+    formats = args.format or DEFAULT_FORMATS
+
+    work_dir = tempfile.mkdtemp(prefix='tshark-outputformats-bench-')
+    try:
+        if args.capture_file:
+            capture = args.capture_file
+            frames = benchmark_common.count_frames(args.tshark, capture)
+        else:
+            capture = os.path.join(work_dir, 'dns.pcap')
+            benchmark_common.write_pcap(capture, dns_frames(args.packets, args.answers))
+            frames = args.packets
+
+        width = max(len('format'), max(len(f) for f in formats))
+        print('{:<{w}} {:>12} {:>14}'.format('format', 'seconds', 'frames/sec', w=width)
+              + benchmark_common.baseline_header(args.baseline_tshark))
+        for output_format in formats:
+            best = time_tshark(args.tshark, capture, FORMATS[output_format], args.repeat)
+            baseline = None
+            if args.baseline_tshark:
+                baseline = time_tshark(args.baseline_tshark, capture, FORMATS[output_format], args.repeat)
+            benchmark_common.print_line('{:<{w}} {:>12.3f} {:>14.0f}'.format(output_format, best, frames / best, w=width)
+                                        + benchmark_common.baseline_columns(baseline, best))
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
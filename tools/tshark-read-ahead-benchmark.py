@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Time the first pass of tshark -2 with and without reading ahead
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark -2 over a capture for a range of --read-ahead counts.
+
+A count of 0 reads the file from the dissecting thread; any other count
+reads it in a second thread. The gain is largest for compressed files,
+where decompression moves off the dissecting thread. Without
+--capture-file a synthetic UDP capture is written, gzip-compressed
+unless --uncompressed is given.
+
+Example:
+    tools/tshark-read-ahead-benchmark.py --tshark build/run/tshark -a 0,16,256,4096
+'''
+
+import argparse
+import gzip
+import os
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+
+def synthetic_frame(n, payload_len):
+    '''An Ethernet/IPv4/UDP syslog frame from one of 256 hosts.'''
+    payload = bytes((n + i) & 0xff for i in range(payload_len))
+    udp = struct.pack('!HHHH', 1024 + n % 256, 514, 8 + payload_len, 0) + payload
+    return benchmark_common.ipv4_frame(n, 17, bytes((10, 0, 0, n % 256)), bytes((10, 1, 0, 1)), udp)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser, baseline=False, repeat_help='runs per count')
+    parser.add_argument('--capture-file',
+                        help='capture to read instead of a synthetic one')
+    parser.add_argument('-a', '--read-ahead', default='0,16,256,4096',
+                        help='comma-separated list of --read-ahead counts (default: %(default)s)')
+    parser.add_argument('-n', '--packets', type=int, default=500000,
+                        help='number of packets in the synthetic capture (default: %(default)s)')
+    parser.add_argument('-l', '--length', type=int, default=256,
+                        help='UDP payload length in bytes (default: %(default)s)')
+    parser.add_argument('--uncompressed', action='store_true',
+                        help='do not gzip the synthetic capture')
+    parser.add_argument('-Y', '--display-filter',
+                        help='display filter to apply, which makes the first pass build trees')
+    args = parser.parse_args()
+
+    counts = [int(a) for a in args.read_ahead.split(',')]
+
+    work_dir = tempfile.mkdtemp(prefix='tshark-read-ahead-bench-')
+    try:
+        if args.capture_file:
+            capture = args.capture_file
+            frames = benchmark_common.count_frames(args.tshark, capture)
+        else:
+            capture = os.path.join(work_dir, 'in.pcap' if args.uncompressed else 'in.pcap.gz')
+            benchmark_common.write_pcap(capture, (synthetic_frame(n, args.length) for n in range(args.packets)),
+                                        opener=open if args.uncompressed else gzip.open)
+            frames = args.packets
+
+        print('{:>10} {:>8} {:>12} {:>12} {:>14} {:>8}'.format(
+            'read-ahead', 'threads', 'frames', 'seconds', 'frames/sec', 'speedup'))
+        baseline = None
+        for count in counts:
+            cmd = [args.tshark, '-2', '-q', '--read-ahead', str(count), '-r', capture]
+            if args.display_filter:
+                cmd += ['-Y', args.display_filter]
+            best = benchmark_common.best_time(cmd, args.repeat)
+            if baseline is None:
+                baseline = best
+            benchmark_common.print_line('{:>10} {:>8} {:>12} {:>12.3f} {:>14.0f} {:>7.2f}x'.format(
+                count, 1 if count == 0 else 2, frames, best, frames / best, baseline / best))
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+#
+# Time tshark dissecting line-oriented text protocols
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Time tshark dissecting HTTP and SIP, which are split into lines.
+
+The HTTP, SIP, SDP and line-based text dissectors find each line with
+tvb_find_line_end() and tvb_find_line_end_unquoted(), which scan 16 or
+32 bytes at a time when the CPU has SSE2 or AVX2. A synthetic capture
+is written for each protocol. The HTTP capture holds requests with long
+User-Agent and Cookie headers and responses with HTML bodies. The SIP
+capture holds INVITEs with quoted display names and an SDP body.
+
+Each capture is read with every scanner the CPU supports, chosen with
+the WIRESHARK_MEMSCAN environment variable. The "default" scanner is the
+one tshark would pick. The baseline build runs with its default scanner.
+
+Example:
+    tools/tshark-text-benchmark.py --tshark build/run/tshark --baseline-tshark old/run/tshark
+'''
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import tempfile
+
+import benchmark_common
+
+SCANNERS = ['default', 'sse2', 'portable']
+
+USER_AGENT = ('Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) '
+              'Chrome/76.0.3809.100 Safari/537.36')
+
+
+def http_request(n):
+    cookie = '; '.join('c{}={:032x}'.format(i, n * 31 + i) for i in range(12))
+    return ('GET /static/app/{}/bundle.js?v={} HTTP/1.1\r\n'
+            'Host: www.example.com\r\n'
+            'User-Agent: {}\r\n'
+            'Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n'
+            'Accept-Language: en-US,en;q=0.5\r\n'
+            'Accept-Encoding: identity\r\n'
+            'Referer: https://www.example.com/articles/{}/comments?page=2\r\n'
+            'Cookie: {}\r\n'
+            'Connection: keep-alive\r\n'
+            '\r\n').format(n % 97, n, USER_AGENT, n, cookie).encode()
+
+
+def http_response(n):
+    rows = ''.join('<tr><td class="name">item {0}-{1}</td><td class="value">{2}</td>'
+                   '<td><a href="/items/{0}/{1}">details</a></td></tr>\n'.format(n, i, n * i)
+                   for i in range(16))
+    body = ('<!DOCTYPE html>\n<html>\n<head><title>Items {}</title></head>\n'
+            '<body>\n<table>\n{}</table>\n</body>\n</html>\n').format(n, rows).encode()
+    return ('HTTP/1.1 200 OK\r\n'
+            'Date: Sun, 15 Sep 2019 10:00:00 GMT\r\n'
+            'Server: Apache/2.4.41 (Unix)\r\n'
+            'Cache-Control: private, max-age=0\r\n'
+            'Content-Type: text/html; charset=utf-8\r\n'
+            'Content-Length: {}\r\n'
+            '\r\n').format(len(body)).encode() + body
+
+
+def sip_invite(n):
+    sdp = ('v=0\r\n'
+           'o=alice {0} {0} IN IP4 192.0.2.10\r\n'
+           's=Call {0}\r\n'
+           'c=IN IP4 192.0.2.10\r\n'
+           't=0 0\r\n'
+           'm=audio {1} RTP/AVP 0 8 101\r\n'
+           'a=rtpmap:0 PCMU/8000\r\n'
+           'a=rtpmap:8 PCMA/8000\r\n'
+           'a=rtpmap:101 telephone-event/8000\r\n'
+           'a=fmtp:101 0-15\r\n'
+           'a=sendrecv\r\n').format(n, 10000 + 2 * (n % 5000)).encode()
+    return ('INVITE sip:bob@biloxi.example.com SIP/2.0\r\n'
+            'Via: SIP/2.0/UDP 192.0.2.10:5060;branch=z9hG4bK{0:08x}\r\n'
+            'Max-Forwards: 70\r\n'
+            'From: "Alice Example, Sales" <sip:alice@atlanta.example.com>;tag={0}\r\n'
+            'To: "Bob \\"The Builder\\"" <sip:bob@biloxi.example.com>\r\n'
+            'Call-ID: {0:016x}@192.0.2.10\r\n'
+            'CSeq: 1 INVITE\r\n'
+            'Contact: <sip:alice@192.0.2.10:5060>\r\n'
+            'User-Agent: Example SIP Phone 1.2.3\r\n'
+            'Allow: INVITE, ACK, CANCEL, BYE, OPTIONS, INFO, UPDATE, REFER, NOTIFY\r\n'
+            'Content-Type: application/sdp\r\n'
+            'Content-Length: {1}\r\n'
+            '\r\n').format(n, len(sdp)).encode() + sdp
+
+
+def http_frames(count):
+    '''Request and response pairs on 256 connections, one segment each.'''
+    seqs = {}
+    for n in range(count // 2):
+        conn = n % 256
+        client = bytes((10, 0, 0, conn))
+        server = bytes((10, 1, 0, 1))
+        client_seq, server_seq = seqs.get(conn, (1, 1))
+        request = http_request(n)
+        response = http_response(n)
+        tcp = struct.pack('!HHIIBBHHH', 1024 + conn, 80, client_seq, server_seq, 5 << 4, 0x18, 65535, 0, 0)
+        yield benchmark_common.ipv4_frame(2 * n, 6, client, server, tcp + request)
+        tcp = struct.pack('!HHIIBBHHH', 80, 1024 + conn, server_seq, client_seq + len(request), 5 << 4, 0x18, 65535, 0, 0)
+        yield benchmark_common.ipv4_frame(2 * n + 1, 6, server, client, tcp + response)
+        seqs[conn] = (client_seq + len(request), server_seq + len(response))
+
+
+def sip_frames(count):
+    for n in range(count):
+        payload = sip_invite(n)
+        udp = struct.pack('!HHHH', 5060, 5060, 8 + len(payload), 0) + payload
+        yield benchmark_common.ipv4_frame(n, 17, bytes((192, 0, 2, 10)), bytes((198, 51, 100, 20)), udp)
+
+
+CAPTURES = {'http': http_frames, 'sip': sip_frames}
+
+
+def time_tshark(tshark, capture, scanner, extra_args, repeat):
+    env = dict(os.environ)
+    env.pop('WIRESHARK_MEMSCAN', None)
+    if scanner != 'default':
+        env['WIRESHARK_MEMSCAN'] = scanner
+    return benchmark_common.best_time([tshark, '-r', capture] + extra_args, repeat, env)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    benchmark_common.add_tshark_arguments(parser)
+    parser.add_argument('-n', '--packets', type=int, default=50000,
+                        help='number of packets in each synthetic capture (default: %(default)s)')
+    parser.add_argument('-V', '--details', action='store_true',
+                        help='print packet details (-V) instead of summaries')
+    args = parser.parse_args()
+
+    extra_args = ['-V'] if args.details else []
+
+    work_dir = tempfile.mkdtemp(prefix='tshark-text-bench-')
+    try:
+        print('{:<6} {:<10} {:>10} {:>14}'.format('proto', 'scanner', 'seconds', 'frames/sec')
+              + benchmark_common.baseline_header(args.baseline_tshark))
+        for proto, frames in sorted(CAPTURES.items()):
+            capture = os.path.join(work_dir, proto + '.pcap')
+            benchmark_common.write_pcap(capture, frames(args.packets))
+            baseline = None
+            if args.baseline_tshark:
+                baseline = time_tshark(args.baseline_tshark, capture, 'default', extra_args, args.repeat)
+            for scanner in SCANNERS:
+                best = time_tshark(args.tshark, capture, scanner, extra_args, args.repeat)
+                benchmark_common.print_line('{:<6} {:<10} {:>10.3f} {:>14.0f}'.format(proto, scanner, best, args.packets / best)
+                                            + benchmark_common.baseline_columns(baseline, best))
+    finally:
+        shutil.rmtree(work_dir)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -144,6 +144,13 @@
 #define LONGOPT_COLOR (65536+1000)
 #define LONGOPT_NO_DUPLICATE_KEYS (65536+1001)
 #define LONGOPT_ELASTIC_MAPPING_FILTER (65536+1002)
+#define LONGOPT_READ_AHEAD (65536+1003)
+
+/*
+ * Number of records read ahead, in another thread, on the first pass
+ * of a two-pass analysis.
+ */
+#define DEFAULT_READ_AHEAD 256
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -159,6 +166,7 @@ static frame_data prev_dis_frame;
 static frame_data prev_cap_frame;
 
 static gboolean perform_two_pass_analysis;
+static guint read_ahead = DEFAULT_READ_AHEAD;
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
 
@@ -171,7 +179,8 @@ typedef enum {
   WRITE_FIELDS, /* User defined list of fields */
   WRITE_JSON,   /* JSON */
   WRITE_JSON_RAW,   /* JSON only raw hex */
-  WRITE_EK      /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,     /* JSON bulk insert to Elasticsearch */
+  WRITE_ARROW   /* User defined list of fields as an Arrow IPC stream */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -373,6 +382,9 @@ print_usage(FILE *output)
   fprintf(output, "Processing:\n");
   fprintf(output, "  -2                       perform a two-pass analysis\n");
   fprintf(output, "  -M <packet count>        perform session auto reset\n");
+  fprintf(output, "  --read-ahead <count>     read up to count records ahead of the first pass\n");
+  fprintf(output, "                           of -2 in another thread; 0 disables (def: %d)\n",
+          DEFAULT_READ_AHEAD);
   fprintf(output, "  -R <read filter>         packet Read filter in Wireshark display filter syntax\n");
   fprintf(output, "                           (requires -2)\n");
   fprintf(output, "  -Y <display filter>      packet displaY filter in Wireshark display filter\n");
@@ -414,14 +426,14 @@ print_usage(FILE *output)
   fprintf(output, "  -P                       print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|arrow|?\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
   fprintf(output, "                           nodes, unless child is specified also in the filter)\n");
   fprintf(output, "  -J <protocolfilter>      top level protocol filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"http tcp\", filter which expands all child nodes)\n");
-  fprintf(output, "  -e <field>               field to print if -Tfields selected (e.g. tcp.port,\n");
+  fprintf(output, "  -e <field>               field to print if -Tfields or -Tarrow selected (e.g. tcp.port,\n");
   fprintf(output, "                           _ws.col.Info)\n");
   fprintf(output, "                           this option can be repeated to print multiple fields\n");
   fprintf(output, "  -E<fieldsoption>=<value> set options for output when -Tfields selected:\n");
@@ -432,6 +444,7 @@ print_usage(FILE *output)
   fprintf(output, "     aggregator=,|/s|<char> select comma, space, printable character as\n");
   fprintf(output, "                           aggregator\n");
   fprintf(output, "     quote=d|s|n           select double, single, no quotes for values\n");
+  fprintf(output, "     batch=<rows>          rows per record batch with -Tarrow\n");
   fprintf(output, "  -t a|ad|d|dd|e|r|u|ud|?  output format of time stamps (def: r: rel. to first)\n");
   fprintf(output, "  -u s|hms                 output format of seconds (def: s: seconds)\n");
   fprintf(output, "  -l                       flush standard output after each packet\n");
@@ -694,6 +707,7 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"read-ahead", required_argument, NULL, LONGOPT_READ_AHEAD},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -1306,6 +1320,10 @@ main(int argc, char *argv[])
         output_action = WRITE_FIELDS;
         print_details = TRUE;   /* Need full tree info */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "arrow") == 0) {
+        output_action = WRITE_ARROW;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
       } else if (strcmp(optarg, "json") == 0) {
         output_action = WRITE_JSON;
         print_details = TRUE;   /* Need details */
@@ -1323,6 +1341,8 @@ main(int argc, char *argv[])
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+                        "\t\"arrow\"   The values of fields specified with the -e option as the\n"
+                        "\t          typed columns of an Apache Arrow IPC stream.\n"
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1447,6 +1467,9 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_READ_AHEAD:
+      read_ahead = get_natural_int(optarg, "read-ahead count");
+      break;
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -1478,14 +1501,14 @@ main(int argc, char *argv[])
   }
 
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_ARROW != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+            "but \"-Tarrow, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_ARROW == output_action) && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".", WRITE_ARROW == output_action ? "arrow" : "fields");
 
         exit_status = INVALID_OPTION;
         goto clean_exit;
@@ -1858,6 +1881,10 @@ main(int argc, char *argv[])
   /* Build the column format array */
   build_column_format_array(&cfile.cinfo, prefs_p->num_cols, TRUE);
 
+  /* Columns are only looked at once a packet has been dissected, and
+     only if it's printed, so don't put their text together until then. */
+  col_set_deferred(&cfile.cinfo, TRUE);
+
 #ifdef HAVE_LIBPCAP
   capture_opts_trim_snaplen(&global_capture_opts, MIN_PACKET_SIZE);
   capture_opts_trim_ring_num_files(&global_capture_opts);
@@ -1937,6 +1964,13 @@ main(int argc, char *argv[])
         g_assert_not_reached();
       }
     }
+
+    /* JSON is written a few bytes at a time; unless each packet is to be
+       flushed, have stdio write it out in large blocks. */
+    if (!line_buffered && (output_action == WRITE_JSON ||
+                           output_action == WRITE_JSON_RAW ||
+                           output_action == WRITE_EK))
+      setvbuf(stdout, NULL, _IOFBF, 1024 * 1024);
   }
 
   /* PDU export requested. Take the ownership of the '-w' file, apply tap
@@ -2484,6 +2518,11 @@ capture(void)
   fflush(stderr);
   g_string_free(str, TRUE);
 
+  /* If we're reading the packets dumpcap writes, get the new ones from
+     shared memory. */
+  if (do_dissection)
+    global_capture_opts.shm_tail_size = prefs.capture_shm_size;
+
   ret = sync_pipe_start(&global_capture_opts, &global_capture_session, &global_info_data, NULL);
 
   if (!ret)
@@ -2652,6 +2691,9 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
     /* Attempt to open the capture file and set up to read from it. */
     switch(cf_open(cap_session->cf, capture_opts->save_file, WTAP_TYPE_AUTO, is_tempfile, &err)) {
     case CF_OK:
+      /* Read what the child has just written from shared memory. */
+      if (cap_session->shm_tail != NULL)
+        wtap_set_shm_tail(cap_session->cf->provider.wth, cap_session->shm_tail);
       break;
     case CF_ERROR:
       /* Don't unlink (delete) the save file - leave it around,
@@ -3094,6 +3136,12 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
   }
 
   tshark_debug("tshark: reading records for first pass");
+  /*
+   * Nothing but wtap_read() touches the file until the end of this
+   * pass, so let another thread do the reading while we dissect.
+   */
+  if (read_ahead > 0)
+    wtap_read_ahead_start(cf->provider.wth, read_ahead);
   *err = 0;
   while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
     if (read_interrupted) {
@@ -3120,7 +3168,8 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
   if (edt)
     epan_dissect_free(edt);
 
-  /* Close the sequential I/O side, to free up memory it requires. */
+  /* Close the sequential I/O side, to free up memory it requires;
+     this also stops reading ahead. */
   wtap_sequential_close(cf->provider.wth);
 
   /* Allow the protocol dissectors to free up memory that they
@@ -3810,6 +3859,10 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+    write_arrow_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     jdumper = write_json_preamble(stdout);
@@ -4163,6 +4216,10 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
     }
     break;
 
+  case WRITE_ARROW:
+    write_arrow_proto_tree(output_fields, edt, &cf->cinfo);
+    return !ferror(stdout);
+
   case WRITE_JSON:
     if (print_summary)
       g_assert_not_reached();
@@ -4223,6 +4280,10 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+    write_arrow_finale(output_fields);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     write_json_finale(&jdumper);
@@ -439,6 +439,9 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
         /* Attempt to open the capture file and set up to read from it. */
         switch(cf_open((capture_file *)cap_session->cf, capture_opts->save_file, WTAP_TYPE_AUTO, is_tempfile, &err)) {
             case CF_OK:
+                /* Read what the child has just written from shared memory. */
+                if (cap_session->shm_tail != NULL)
+                    wtap_set_shm_tail(((capture_file *)cap_session->cf)->provider.wth, cap_session->shm_tail);
                 break;
             case CF_ERROR:
                 /* Don't unlink (delete) the save file - leave it around,
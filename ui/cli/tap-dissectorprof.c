@@ -0,0 +1,155 @@
+/* tap-dissectorprof.c
+ * Per-dissector call counts, time and allocations for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_dissectorprof(void);
+
+/* Handles that share a name, such as the anonymous handles of one
+ * protocol, are added up into one row. */
+static void
+dissectorprof_add(const dissector_prof_t *prof, gpointer user_data)
+{
+	GHashTable *rows = (GHashTable *)user_data;
+	dissector_prof_t *row;
+
+	if (prof->calls == 0)
+		return;
+
+	row = (dissector_prof_t *)g_hash_table_lookup(rows, prof->name);
+	if (row == NULL) {
+		row = g_new0(dissector_prof_t, 1);
+		row->name = prof->name;
+		row->protocol = prof->protocol;
+		g_hash_table_insert(rows, (gpointer)row->name, row);
+	}
+	row->calls += prof->calls;
+	row->inclusive_ns += prof->inclusive_ns;
+	row->exclusive_ns += prof->exclusive_ns;
+	row->alloc_bytes += prof->alloc_bytes;
+}
+
+static gint
+dissectorprof_compare(gconstpointer a, gconstpointer b)
+{
+	const dissector_prof_t *row_a = *(const dissector_prof_t * const *)a;
+	const dissector_prof_t *row_b = *(const dissector_prof_t * const *)b;
+
+	if (row_a->exclusive_ns > row_b->exclusive_ns)
+		return -1;
+	if (row_a->exclusive_ns < row_b->exclusive_ns)
+		return 1;
+	return strcmp(row_a->name, row_b->name);
+}
+
+static void
+dissectorprof_draw(void *tapdata _U_)
+{
+	GHashTable *rows = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+	GPtrArray *sorted = g_ptr_array_new();
+	GHashTableIter iter;
+	gpointer value;
+	dissector_prof_t *row;
+	guint64 total_ns = 0;
+	guint i;
+
+	dissector_prof_foreach(dissectorprof_add, rows);
+
+	g_hash_table_iter_init(&iter, rows);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		row = (dissector_prof_t *)value;
+		total_ns += row->exclusive_ns;
+		g_ptr_array_add(sorted, row);
+	}
+	g_ptr_array_sort(sorted, dissectorprof_compare);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Dissector Profile\n");
+	printf("%-24s %10s %14s %14s %7s %14s\n", "Dissector", "Calls",
+	       "Inclusive ms", "Exclusive ms", "Excl %", "Alloc bytes");
+	for (i = 0; i < sorted->len; i++) {
+		row = (dissector_prof_t *)g_ptr_array_index(sorted, i);
+		printf("%-24s %10" G_GINT64_MODIFIER "u %14.3f %14.3f %6.2f%% %14" G_GINT64_MODIFIER "u\n",
+		       row->name, row->calls,
+		       row->inclusive_ns / 1e6, row->exclusive_ns / 1e6,
+		       total_ns ? 100.0 * row->exclusive_ns / total_ns : 0.0,
+		       row->alloc_bytes);
+	}
+	printf("===================================================================\n");
+
+	g_ptr_array_free(sorted, TRUE);
+	g_hash_table_destroy(rows);
+}
+
+static void
+dissectorprof_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp("dissector,prof", opt_arg) != 0) {
+		cmdarg_err("invalid \"-z dissector,prof\" argument");
+		exit(1);
+	}
+
+	/*
+	 * The profile covers every dissector called, so there's no filter,
+	 * and nothing to do per packet; the tap is only there so that the
+	 * table is drawn at the end.
+	 */
+	error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, NULL, dissectorprof_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register dissector,prof tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+
+	dissector_prof_set_enabled(TRUE);
+	dissector_prof_reset();
+}
+
+static stat_tap_ui dissectorprof_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"dissector,prof",
+	dissectorprof_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_dissectorprof(void)
+{
+	register_stat_tap_ui(&dissectorprof_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
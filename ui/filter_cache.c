@@ -0,0 +1,406 @@
+/* filter_cache.c
+ * Cache of display filter results over a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/proto.h>
+
+#include "filter_cache.h"
+
+typedef struct {
+    gchar          *key;        /* dfilter_signature() of the filter, an
+                                 * exact serialization of its program */
+    frame_bitmap_t *result;
+    gsize           size;       /* bytes charged against the budget */
+    GList          *link;       /* in filter_cache::lru */
+} fc_entry_t;
+
+struct filter_cache {
+    GHashTable     *entries;    /* key -> fc_entry_t */
+    GQueue          lru;        /* fc_entry_t, most recently used first */
+    gsize           max_bytes;
+    gsize           bytes;
+    guint32         frame_count;
+    frame_bitmap_t *uncached;   /* last result that could not be cached */
+};
+
+struct filter_cache_eval {
+    filter_cache_t  *fc;
+    dfilter_multi_t *dfm;
+    GPtrArray       *filters;   /* dfilter_t; the one asked for comes first */
+    GPtrArray       *keys;      /* gchar, NULL if the filter is not cacheable */
+    GPtrArray       *results;   /* frame_bitmap_t */
+    guint32         *matches;
+};
+
+static void
+fc_entry_free(gpointer data)
+{
+    fc_entry_t *entry = (fc_entry_t *)data;
+
+    g_free(entry->key);
+    frame_bitmap_free(entry->result);
+    g_free(entry);
+}
+
+filter_cache_t *
+filter_cache_new(gsize max_bytes)
+{
+    filter_cache_t *fc;
+
+    fc = g_new0(filter_cache_t, 1);
+    fc->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, fc_entry_free);
+    g_queue_init(&fc->lru);
+    fc->max_bytes = max_bytes;
+    return fc;
+}
+
+void
+filter_cache_free(filter_cache_t *fc)
+{
+    if (!fc)
+        return;
+
+    filter_cache_clear(fc);
+    g_hash_table_destroy(fc->entries);
+    g_free(fc);
+}
+
+void
+filter_cache_clear(filter_cache_t *fc)
+{
+    if (!fc)
+        return;
+
+    g_queue_clear(&fc->lru);
+    g_hash_table_remove_all(fc->entries);
+    fc->bytes = 0;
+    frame_bitmap_free(fc->uncached);
+    fc->uncached = NULL;
+}
+
+gsize
+filter_cache_memory_size(const filter_cache_t *fc)
+{
+    return fc->bytes;
+}
+
+static void
+fc_set_frame_count(filter_cache_t *fc, guint32 frame_count)
+{
+    if (fc->frame_count != frame_count) {
+        filter_cache_clear(fc);
+        fc->frame_count = frame_count;
+    }
+    frame_bitmap_free(fc->uncached);
+    fc->uncached = NULL;
+}
+
+/* Returns the key under which the results of "df" are cached, or NULL
+ * if they must not be. */
+static gchar *
+fc_key(dfilter_t *df)
+{
+    /* These depend on the frames displayed, i.e. on the filter itself,
+     * or on the coloring rules. */
+    static const char *display_fields[] = {
+        "frame.time_delta_displayed",
+        "frame.coloring_rule.name",
+        "frame.coloring_rule.string",
+    };
+    int hf_id;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(display_fields); i++) {
+        hf_id = proto_registrar_get_id_byname(display_fields[i]);
+        if (hf_id != -1 && dfilter_uses_field(df, hf_id))
+            return NULL;
+    }
+    return dfilter_signature(df);
+}
+
+static void
+fc_remove(filter_cache_t *fc, fc_entry_t *entry)
+{
+    g_queue_delete_link(&fc->lru, entry->link);
+    fc->bytes -= entry->size;
+    g_hash_table_remove(fc->entries, entry->key);
+}
+
+/* Stores "result" under "key", taking over both. */
+static fc_entry_t *
+fc_store(filter_cache_t *fc, gchar *key, frame_bitmap_t *result)
+{
+    fc_entry_t *entry;
+
+    entry = (fc_entry_t *)g_hash_table_lookup(fc->entries, key);
+    if (entry)
+        fc_remove(fc, entry);
+
+    entry = g_new(fc_entry_t, 1);
+    entry->key = key;
+    entry->result = result;
+    entry->size = sizeof(fc_entry_t) + strlen(key) + 1 + frame_bitmap_memory_size(result);
+    g_queue_push_head(&fc->lru, entry);
+    entry->link = fc->lru.head;
+    g_hash_table_insert(fc->entries, key, entry);
+    fc->bytes += entry->size;
+    return entry;
+}
+
+/* Drops the least recently used results, except "keep", until the cache
+ * fits its budget. */
+static void
+fc_trim(filter_cache_t *fc, const frame_bitmap_t *keep)
+{
+    GList *link, *prev;
+    fc_entry_t *entry;
+
+    for (link = fc->lru.tail; link && fc->bytes > fc->max_bytes; link = prev) {
+        prev = link->prev;
+        entry = (fc_entry_t *)link->data;
+        if (entry->result != keep)
+            fc_remove(fc, entry);
+    }
+}
+
+/* Finds or derives the result of "df". Nothing is evicted, so results
+ * found earlier stay valid until the next fc_trim(). */
+static frame_bitmap_t *
+fc_lookup(filter_cache_t *fc, dfilter_t *df)
+{
+    fc_entry_t *entry;
+    dfilter_t *part1, *part2;
+    frame_bitmap_t *r1, *r2 = NULL;
+    frame_bitmap_t *result = NULL;
+    gchar *key;
+
+    key = fc_key(df);
+    if (!key)
+        return NULL;
+
+    entry = (fc_entry_t *)g_hash_table_lookup(fc->entries, key);
+    if (entry) {
+        g_queue_unlink(&fc->lru, entry->link);
+        g_queue_push_head_link(&fc->lru, entry->link);
+        g_free(key);
+        return entry->result;
+    }
+
+    switch (dfilter_get_parts(df, &part1, &part2)) {
+        case DFILTER_PART_NOT:
+            r1 = fc_lookup(fc, part1);
+            if (r1)
+                result = frame_bitmap_complement(r1, 1, fc->frame_count);
+            break;
+
+        case DFILTER_PART_AND:
+            /* Either side matching nothing is enough. */
+            r1 = fc_lookup(fc, part1);
+            if (!r1 || frame_bitmap_cardinality(r1) > 0)
+                r2 = fc_lookup(fc, part2);
+            if ((r1 && frame_bitmap_cardinality(r1) == 0) ||
+                (r2 && frame_bitmap_cardinality(r2) == 0))
+                result = frame_bitmap_new();
+            else if (r1 && r2)
+                result = frame_bitmap_and(r1, r2);
+            break;
+
+        case DFILTER_PART_OR:
+            /* Either side matching everything is enough. */
+            r1 = fc_lookup(fc, part1);
+            if (!r1 || frame_bitmap_cardinality(r1) < fc->frame_count)
+                r2 = fc_lookup(fc, part2);
+            if (r1 && frame_bitmap_cardinality(r1) == fc->frame_count)
+                result = frame_bitmap_copy(r1);
+            else if (r2 && frame_bitmap_cardinality(r2) == fc->frame_count)
+                result = frame_bitmap_copy(r2);
+            else if (r1 && r2)
+                result = frame_bitmap_or(r1, r2);
+            break;
+
+        default:
+            break;
+    }
+
+    if (!result) {
+        g_free(key);
+        return NULL;
+    }
+    return fc_store(fc, key, result)->result;
+}
+
+const frame_bitmap_t *
+filter_cache_lookup(filter_cache_t *fc, dfilter_t *df, guint32 frame_count)
+{
+    frame_bitmap_t *result;
+
+    fc_set_frame_count(fc, frame_count);
+    result = fc_lookup(fc, df);
+    fc_trim(fc, result);
+    return result;
+}
+
+void
+filter_cache_insert(filter_cache_t *fc, dfilter_t *df, guint32 frame_count,
+        frame_bitmap_t *result)
+{
+    gchar *key;
+
+    fc_set_frame_count(fc, frame_count);
+    key = fc_key(df);
+    if (!key) {
+        frame_bitmap_free(result);
+        return;
+    }
+    fc_store(fc, key, result);
+    fc_trim(fc, result);
+}
+
+/* Adds "df" and, recursively, those of its operands whose results are
+ * not known yet to the filters evaluated by "ev". */
+static void
+fc_eval_add(filter_cache_eval_t *ev, dfilter_t *df, GHashTable *seen)
+{
+    dfilter_t *part1, *part2;
+    gchar *key;
+
+    key = fc_key(df);
+    if (key && ev->filters->len > 0 &&
+        (g_hash_table_contains(seen, key) || fc_lookup(ev->fc, df))) {
+        g_free(key);
+        return;
+    }
+
+    g_ptr_array_add(ev->filters, df);
+    g_ptr_array_add(ev->keys, key);
+    g_ptr_array_add(ev->results, frame_bitmap_new());
+    dfilter_multi_add(ev->dfm, df);
+    if (key)
+        g_hash_table_add(seen, key);
+
+    switch (dfilter_get_parts(df, &part1, &part2)) {
+        case DFILTER_PART_NOT:
+            fc_eval_add(ev, part1, seen);
+            break;
+        case DFILTER_PART_AND:
+        case DFILTER_PART_OR:
+            fc_eval_add(ev, part1, seen);
+            fc_eval_add(ev, part2, seen);
+            break;
+        default:
+            break;
+    }
+}
+
+filter_cache_eval_t *
+filter_cache_eval_new(filter_cache_t *fc, dfilter_t *df, guint32 frame_count)
+{
+    filter_cache_eval_t *ev;
+    GHashTable *seen;
+
+    fc_set_frame_count(fc, frame_count);
+
+    ev = g_new(filter_cache_eval_t, 1);
+    ev->fc = fc;
+    ev->dfm = dfilter_multi_new();
+    ev->filters = g_ptr_array_new();
+    ev->keys = g_ptr_array_new_with_free_func(g_free);
+    ev->results = g_ptr_array_new_with_free_func((GDestroyNotify)frame_bitmap_free);
+
+    /* The keys belong to ev->keys. */
+    seen = g_hash_table_new(g_str_hash, g_str_equal);
+    fc_eval_add(ev, df, seen);
+    g_hash_table_destroy(seen);
+
+    ev->matches = g_new0(guint32, DFILTER_MULTI_MASK_WORDS(ev->filters->len));
+    return ev;
+}
+
+void
+filter_cache_eval_prime(filter_cache_eval_t *ev, epan_dissect_t *edt)
+{
+    guint i;
+
+    for (i = 0; i < ev->filters->len; i++)
+        epan_dissect_prime_with_dfilter(edt, (dfilter_t *)g_ptr_array_index(ev->filters, i));
+}
+
+gboolean
+filter_cache_eval_frame(filter_cache_eval_t *ev, epan_dissect_t *edt, guint32 framenum)
+{
+    guint i;
+
+    dfilter_multi_apply_edt(ev->dfm, edt, ev->matches);
+    for (i = 0; i < ev->results->len; i++) {
+        if (DFILTER_MULTI_MASK_TEST(ev->matches, i))
+            frame_bitmap_add((frame_bitmap_t *)g_ptr_array_index(ev->results, i), framenum);
+    }
+    return DFILTER_MULTI_MASK_TEST(ev->matches, 0);
+}
+
+void
+filter_cache_eval_abort(filter_cache_eval_t *ev)
+{
+    if (!ev)
+        return;
+
+    dfilter_multi_free(ev->dfm);
+    g_ptr_array_free(ev->filters, TRUE);
+    g_ptr_array_free(ev->keys, TRUE);
+    g_ptr_array_free(ev->results, TRUE);
+    g_free(ev->matches);
+    g_free(ev);
+}
+
+const frame_bitmap_t *
+filter_cache_eval_finish(filter_cache_eval_t *ev)
+{
+    filter_cache_t *fc = ev->fc;
+    frame_bitmap_t *result;
+    gchar *key;
+    guint i;
+
+    result = (frame_bitmap_t *)g_ptr_array_index(ev->results, 0);
+    for (i = 0; i < ev->results->len; i++) {
+        key = (gchar *)g_ptr_array_index(ev->keys, i);
+        if (key) {
+            fc_store(fc, key, (frame_bitmap_t *)g_ptr_array_index(ev->results, i));
+        } else if (i == 0) {
+            fc->uncached = result;
+        } else {
+            continue;
+        }
+        /* Now owned by the cache */
+        g_ptr_array_index(ev->keys, i) = NULL;
+        g_ptr_array_index(ev->results, i) = NULL;
+    }
+
+    fc_trim(fc, result);
+    filter_cache_eval_abort(ev);
+    return result;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,103 @@
+/* filter_cache.h
+ * Cache of display filter results over a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FILTER_CACHE_H__
+#define __FILTER_CACHE_H__
+
+#include <glib.h>
+
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+#include <wsutil/frame_bitmap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Remembers which frames of a capture file matched the display filters
+ * applied to it, as compressed bitmaps keyed by the compiled program of
+ * each filter rather than its text, within a memory budget; the least
+ * recently used results are dropped first.
+ *
+ * Filters compiled with dfilter_compile_parts() can be answered without
+ * dissecting anything when their operands are cached: "!a" from "a",
+ * "a && b" and "a || b" from "a" and "b". When dissection is needed,
+ * filter_cache_eval_new() sets up one pass that evaluates the filter
+ * along with all of its operands that are not yet cached.
+ *
+ * All results are for frames 1 to "frame_count"; asking with a
+ * different frame count empties the cache first. Filters whose result
+ * depends on which frames are displayed (frame.time_delta_displayed) or
+ * on the coloring rules are evaluated but never cached.
+ */
+typedef struct filter_cache filter_cache_t;
+typedef struct filter_cache_eval filter_cache_eval_t;
+
+/* Creates a cache that keeps at most about "max_bytes" of results. */
+filter_cache_t *filter_cache_new(gsize max_bytes);
+
+void filter_cache_free(filter_cache_t *fc);
+
+/* Forgets all results, e.g. after the packets were redissected or
+ * marked. "fc" may be NULL. */
+void filter_cache_clear(filter_cache_t *fc);
+
+/* Returns the frames matching "df", from the cache or by combining
+ * cached results, or NULL if "df" has to be evaluated. The result
+ * belongs to the cache and is valid until the cache is next used. */
+const frame_bitmap_t *filter_cache_lookup(filter_cache_t *fc, dfilter_t *df,
+        guint32 frame_count);
+
+/* Stores "result", which the cache takes over, as the frames matching
+ * "df". */
+void filter_cache_insert(filter_cache_t *fc, dfilter_t *df,
+        guint32 frame_count, frame_bitmap_t *result);
+
+/* Bytes of memory used by the cached results */
+gsize filter_cache_memory_size(const filter_cache_t *fc);
+
+/* Starts a pass over frames 1 to "frame_count" that evaluates "df".
+ * For each frame in turn, prime the tree with filter_cache_eval_prime(),
+ * dissect it and call filter_cache_eval_frame(). */
+filter_cache_eval_t *filter_cache_eval_new(filter_cache_t *fc, dfilter_t *df,
+        guint32 frame_count);
+
+void filter_cache_eval_prime(filter_cache_eval_t *ev, epan_dissect_t *edt);
+
+/* Records the results for "framenum" and returns whether "df" matched. */
+gboolean filter_cache_eval_frame(filter_cache_eval_t *ev, epan_dissect_t *edt,
+        guint32 framenum);
+
+/* Ends the pass, caches what was learned and returns the frames that
+ * matched "df", which belong to the cache as for filter_cache_lookup(). */
+const frame_bitmap_t *filter_cache_eval_finish(filter_cache_eval_t *ev);
+
+/* Ends an incomplete pass without caching anything. */
+void filter_cache_eval_abort(filter_cache_eval_t *ev);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FILTER_CACHE_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,296 @@
+/* packet_list_sort.c
+ * Sorting the packet list by the text of a column
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wsutil/inet_addr.h>
+
+#include "packet_list_sort.h"
+
+/*
+ * Each row's text is turned into a kind, which is compared first, and
+ * two 64-bit values, which are compared next.  Only strings whose first
+ * 16 bytes are the same have to be compared with strcmp().
+ *
+ * The kinds are those of one type of column, so they never mix.
+ */
+#define KEY_NUMBER_NONE     0   /* numeric: no number */
+#define KEY_NUMBER          1   /* numeric: primary is the number */
+#define KEY_IPV4            0   /* address: primary is the address */
+#define KEY_IPV6            1   /* address: primary and secondary are the address */
+#define KEY_STRING          2   /* primary and secondary are the first 16 bytes */
+
+/* Fewest rows worth handing to a thread of their own */
+#define ROWS_PER_THREAD     65536
+
+/* Most threads we use */
+#define MAX_THREADS         16
+
+/* A double as an unsigned integer with the same order. */
+static guint64
+double_key(double val)
+{
+    guint64 bits;
+
+    if (val == 0)
+        val = 0;                /* -0 and 0 are equal */
+    memcpy(&bits, &val, sizeof bits);
+    if (bits & G_GUINT64_CONSTANT(0x8000000000000000))
+        return ~bits;
+    return bits | G_GUINT64_CONSTANT(0x8000000000000000);
+}
+
+/* Up to 8 bytes of str, big-endian and padded with zeroes; *str is
+   advanced past them, but not past the terminating '\0'. */
+static guint64
+string_prefix(const char **str)
+{
+    const guint8 *p = (const guint8 *)*str;
+    guint64 val = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        val <<= 8;
+        if (*p != '\0')
+            val |= *p++;
+    }
+    *str = (const char *)p;
+    return val;
+}
+
+static guint64
+bytes_to_guint64(const guint8 *bytes)
+{
+    guint64 val = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        val = (val << 8) | bytes[i];
+    return val;
+}
+
+static void
+make_key(packet_list_sort_key_t *key, packet_list_sort_type_e type)
+{
+    const char *str = key->str ? key->str : "";
+    gchar *end;
+    double val;
+    ws_in4_addr ipv4;
+    ws_in6_addr ipv6;
+
+    key->primary = 0;
+    key->secondary = 0;
+
+    switch (type) {
+
+    case PACKET_LIST_SORT_NUMERIC:
+        /* Handles suffixes ("12ms"), negative values ("-1.23") and fields
+           with multiple occurrences ("1,2"). */
+        val = g_ascii_strtod(str, &end);
+        if (end == str) {
+            key->kind = KEY_NUMBER_NONE;
+        } else {
+            key->kind = KEY_NUMBER;
+            key->primary = double_key(val);
+        }
+        return;
+
+    case PACKET_LIST_SORT_ADDRESS:
+        if (ws_inet_pton4(str, &ipv4)) {
+            key->kind = KEY_IPV4;
+            key->primary = g_ntohl(ipv4);
+            return;
+        }
+        if (ws_inet_pton6(str, &ipv6)) {
+            key->kind = KEY_IPV6;
+            key->primary = bytes_to_guint64(ipv6.bytes);
+            key->secondary = bytes_to_guint64(ipv6.bytes + 8);
+            return;
+        }
+        /* Names, and anything else, sort after the addresses. */
+        /* FALL THROUGH */
+
+    case PACKET_LIST_SORT_STRING:
+    default:
+        key->kind = KEY_STRING;
+        key->primary = string_prefix(&str);
+        key->secondary = string_prefix(&str);
+        return;
+    }
+}
+
+int
+packet_list_sort_key_compare(const packet_list_sort_key_t *a,
+                             const packet_list_sort_key_t *b)
+{
+    int cmp;
+
+    if (a->kind != b->kind)
+        return a->kind < b->kind ? -1 : 1;
+    if (a->primary != b->primary)
+        return a->primary < b->primary ? -1 : 1;
+    if (a->secondary != b->secondary)
+        return a->secondary < b->secondary ? -1 : 1;
+    if (a->kind == KEY_STRING && a->str != b->str && a->str && b->str) {
+        cmp = strcmp(a->str, b->str);
+        if (cmp != 0)
+            return cmp;
+    }
+    if (a->num != b->num)
+        return a->num < b->num ? -1 : 1;
+    return 0;
+}
+
+static int
+compare_keys(const void *a, const void *b)
+{
+    return packet_list_sort_key_compare((const packet_list_sort_key_t *)a,
+                                        (const packet_list_sort_key_t *)b);
+}
+
+typedef struct {
+    packet_list_sort_key_t *keys;
+    guint                   count;
+    packet_list_sort_type_e type;
+} sort_run_t;
+
+/* Make the keys of a run of rows, and sort the run. */
+static gpointer
+sort_run(gpointer data)
+{
+    sort_run_t *run = (sort_run_t *)data;
+    guint i;
+
+    for (i = 0; i < run->count; i++)
+        make_key(&run->keys[i], run->type);
+    qsort(run->keys, run->count, sizeof *run->keys, compare_keys);
+    return NULL;
+}
+
+typedef struct {
+    const packet_list_sort_key_t *a;
+    guint                         a_count;
+    const packet_list_sort_key_t *b;
+    guint                         b_count;
+    packet_list_sort_key_t       *out;
+} merge_run_t;
+
+/* Merge two sorted runs of rows. */
+static gpointer
+merge_runs(gpointer data)
+{
+    merge_run_t *merge = (merge_run_t *)data;
+    const packet_list_sort_key_t *a = merge->a, *a_end = a + merge->a_count;
+    const packet_list_sort_key_t *b = merge->b, *b_end = b + merge->b_count;
+    packet_list_sort_key_t *out = merge->out;
+
+    while (a < a_end && b < b_end) {
+        if (packet_list_sort_key_compare(b, a) < 0)
+            *out++ = *b++;
+        else
+            *out++ = *a++;
+    }
+    memcpy(out, a, (a_end - a) * sizeof *a);
+    out += a_end - a;
+    memcpy(out, b, (b_end - b) * sizeof *b);
+    return NULL;
+}
+
+void
+packet_list_sort_keys(packet_list_sort_key_t *keys, guint count,
+                      packet_list_sort_type_e type, gboolean descending)
+{
+    sort_run_t runs[MAX_THREADS];
+    merge_run_t merges[MAX_THREADS / 2];
+    GThread *threads[MAX_THREADS];
+    guint starts[MAX_THREADS + 1];
+    packet_list_sort_key_t *from = keys, *to, *tmp, *swap;
+    guint nruns, nmerges, i;
+
+    if (count == 0)
+        return;
+
+    nruns = MIN((guint)g_get_num_processors(), MAX_THREADS);
+    nruns = MIN(nruns, count / ROWS_PER_THREAD);
+    if (nruns < 2) {
+        runs[0].keys = keys;
+        runs[0].count = count;
+        runs[0].type = type;
+        sort_run(&runs[0]);
+    } else {
+        /* Sort a run in each thread... */
+        for (i = 0; i <= nruns; i++)
+            starts[i] = (guint)((guint64)count * i / nruns);
+        for (i = 0; i < nruns; i++) {
+            runs[i].keys = keys + starts[i];
+            runs[i].count = starts[i + 1] - starts[i];
+            runs[i].type = type;
+            threads[i] = g_thread_new("packet list sort", sort_run, &runs[i]);
+        }
+        for (i = 0; i < nruns; i++)
+            g_thread_join(threads[i]);
+
+        /* ...and merge them in pairs until there's only one. */
+        tmp = g_new(packet_list_sort_key_t, count);
+        to = tmp;
+        while (nruns > 1) {
+            nmerges = nruns / 2;
+            for (i = 0; i < nmerges; i++) {
+                merges[i].a = from + starts[2 * i];
+                merges[i].a_count = starts[2 * i + 1] - starts[2 * i];
+                merges[i].b = from + starts[2 * i + 1];
+                merges[i].b_count = starts[2 * i + 2] - starts[2 * i + 1];
+                merges[i].out = to + starts[2 * i];
+                threads[i] = g_thread_new("packet list merge", merge_runs, &merges[i]);
+            }
+            if (nruns % 2)
+                memcpy(to + starts[nruns - 1], from + starts[nruns - 1],
+                       (count - starts[nruns - 1]) * sizeof *keys);
+            for (i = 0; i < nmerges; i++)
+                g_thread_join(threads[i]);
+
+            for (i = 0; i <= (nruns + 1) / 2; i++)
+                starts[i] = starts[MIN(2 * i, nruns)];
+            nruns = (nruns + 1) / 2;
+            swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from != keys)
+            memcpy(keys, from, count * sizeof *keys);
+        g_free(tmp);
+    }
+
+    if (descending) {
+        packet_list_sort_key_t key;
+
+        for (i = 0; i < count / 2; i++) {
+            key = keys[i];
+            keys[i] = keys[count - 1 - i];
+            keys[count - 1 - i] = key;
+        }
+    }
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,79 @@
+/* packet_list_sort.h
+ * Sorting the packet list by the text of a column
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __PACKET_LIST_SORT_H__
+#define __PACKET_LIST_SORT_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** How a column's text is ordered. */
+typedef enum {
+    PACKET_LIST_SORT_STRING,    /**< byte by byte, as strcmp() does */
+    PACKET_LIST_SORT_NUMERIC,   /**< by the number it starts with; text without one sorts first */
+    PACKET_LIST_SORT_ADDRESS    /**< IPv4, then IPv6 addresses, then anything else as a string */
+} packet_list_sort_type_e;
+
+/**
+ * A row of the packet list, as it's sorted.  The caller fills in str,
+ * num and data; the rest is filled in from str when the rows are sorted,
+ * so that comparing two rows rarely has to look at the text at all.
+ */
+typedef struct {
+    guint64     primary;
+    guint64     secondary;
+    const char *str;            /**< the column's text */
+    guint32     num;            /**< frame number, which orders rows that are otherwise equal */
+    guint8      kind;
+    gpointer    data;           /**< the caller's */
+} packet_list_sort_key_t;
+
+/**
+ * Sort rows by the text of a column of the given type, and then by frame
+ * number.  The keys are made, and the rows sorted, in several threads
+ * when there are enough of them.
+ *
+ * @param [in,out] keys The rows.
+ * @param [in] count The number of rows.
+ * @param [in] type How the text is ordered.
+ * @param [in] descending TRUE to sort in descending order.
+ */
+void packet_list_sort_keys(packet_list_sort_key_t *keys, guint count,
+                           packet_list_sort_type_e type, gboolean descending);
+
+/**
+ * Compare two rows whose keys have been made by packet_list_sort_keys().
+ *
+ * @return <0, 0 or >0, as strcmp() does.
+ */
+int packet_list_sort_key_compare(const packet_list_sort_key_t *a,
+                                 const packet_list_sort_key_t *b);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PACKET_LIST_SORT_H__ */
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
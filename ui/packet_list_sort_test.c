@@ -0,0 +1,267 @@
+/* packet_list_sort_test.c
+ * Standalone program to test sorting the packet list by column text
+ * against comparing the text itself.  Given a number of rows, it also
+ * times both on a list that long, e.g. "packet_list_sort_test 5000000".
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/inet_addr.h>
+
+#include "packet_list_sort.h"
+
+#define TEST_ROWS	300000
+
+static gboolean failed = FALSE;
+
+/*
+ * Column text like that of a large capture: strings repeat a lot, and
+ * the packet list keeps one copy of each distinct string.
+ */
+static const char *
+random_text(GRand *rand, GStringChunk *pool, packet_list_sort_type_e type)
+{
+	char buf[64];
+	guint8 addr[16];
+	guint i;
+
+	switch (type) {
+
+	case PACKET_LIST_SORT_NUMERIC:
+		switch (g_rand_int_range(rand, 0, 6)) {
+		case 0:
+			g_snprintf(buf, sizeof buf, "%u", g_rand_int_range(rand, 0, 65536));
+			break;
+		case 1:
+			g_snprintf(buf, sizeof buf, "%.6f", g_rand_double_range(rand, -1000, 1000));
+			break;
+		case 2:
+			g_snprintf(buf, sizeof buf, "%ums", g_rand_int_range(rand, 0, 100));
+			break;
+		case 3:
+			g_snprintf(buf, sizeof buf, "%u,%u", g_rand_int_range(rand, 0, 100), g_rand_int_range(rand, 0, 100));
+			break;
+		case 4:
+			g_strlcpy(buf, g_rand_boolean(rand) ? "Unknown" : "", sizeof buf);
+			break;
+		default:
+			g_snprintf(buf, sizeof buf, "%u", g_rand_int(rand));
+			break;
+		}
+		break;
+
+	case PACKET_LIST_SORT_ADDRESS:
+		switch (g_rand_int_range(rand, 0, 4)) {
+		case 0:
+		case 1:
+			g_snprintf(buf, sizeof buf, "%u.%u.%u.%u", g_rand_int_range(rand, 0, 4) * 64,
+				   g_rand_int_range(rand, 0, 256), g_rand_int_range(rand, 0, 256),
+				   g_rand_int_range(rand, 0, 256));
+			break;
+		case 2:
+			for (i = 0; i < sizeof addr; i++)
+				addr[i] = (i < 14 && g_rand_boolean(rand)) ? 0 : (guint8)g_rand_int(rand);
+			ws_inet_ntop6(addr, buf, sizeof buf);
+			break;
+		default:
+			g_snprintf(buf, sizeof buf, "host%u.example.com", g_rand_int_range(rand, 0, 1000));
+			break;
+		}
+		break;
+
+	case PACKET_LIST_SORT_STRING:
+	default:
+		/* Long common prefixes, to get past the first 16 bytes. */
+		g_snprintf(buf, sizeof buf, "%s %u",
+			   g_rand_boolean(rand) ? "Standard query response 0x" : "GET /",
+			   g_rand_int_range(rand, 0, g_rand_boolean(rand) ? 100 : 100000));
+		break;
+	}
+	return g_string_chunk_insert_const(pool, buf);
+}
+
+static void
+make_rows(packet_list_sort_key_t *keys, guint count, packet_list_sort_type_e type,
+	  GStringChunk *pool, guint32 seed)
+{
+	GRand *rand = g_rand_new_with_seed(seed);
+	guint i;
+
+	for (i = 0; i < count; i++) {
+		keys[i].str = random_text(rand, pool, type);
+		/* Not in the order of the rows. */
+		keys[i].num = (guint32)((guint64)i * 2654435761U % count) + 1;
+		keys[i].data = GUINT_TO_POINTER(i);
+	}
+	g_rand_free(rand);
+}
+
+static packet_list_sort_type_e reference_type;
+
+/* The comparison the packet list used to do, on the text itself. */
+static int
+reference_compare(const void *p1, const void *p2)
+{
+	const packet_list_sort_key_t *r1 = (const packet_list_sort_key_t *)p1;
+	const packet_list_sort_key_t *r2 = (const packet_list_sort_key_t *)p2;
+	ws_in4_addr a4_1, a4_2;
+	ws_in6_addr a6_1, a6_2;
+	int rank1, rank2;
+	int cmp = 0;
+
+	switch (reference_type) {
+
+	case PACKET_LIST_SORT_NUMERIC:
+	{
+		gchar *end1, *end2;
+		double num1 = g_ascii_strtod(r1->str, &end1);
+		double num2 = g_ascii_strtod(r2->str, &end2);
+		gboolean ok1 = end1 != r1->str, ok2 = end2 != r2->str;
+
+		if (!ok1 && !ok2)
+			cmp = 0;
+		else if (!ok1 || (ok2 && num1 < num2))
+			cmp = -1;
+		else if (!ok2 || (ok1 && num1 > num2))
+			cmp = 1;
+		break;
+	}
+
+	case PACKET_LIST_SORT_ADDRESS:
+		rank1 = ws_inet_pton4(r1->str, &a4_1) ? 0 : ws_inet_pton6(r1->str, &a6_1) ? 1 : 2;
+		rank2 = ws_inet_pton4(r2->str, &a4_2) ? 0 : ws_inet_pton6(r2->str, &a6_2) ? 1 : 2;
+		if (rank1 != rank2)
+			cmp = rank1 - rank2;
+		else if (rank1 == 0)
+			cmp = g_ntohl(a4_1) < g_ntohl(a4_2) ? -1 : g_ntohl(a4_1) > g_ntohl(a4_2);
+		else if (rank1 == 1)
+			cmp = memcmp(a6_1.bytes, a6_2.bytes, sizeof a6_1.bytes);
+		else
+			cmp = strcmp(r1->str, r2->str);
+		break;
+
+	case PACKET_LIST_SORT_STRING:
+	default:
+		cmp = strcmp(r1->str, r2->str);
+		break;
+	}
+
+	if (cmp == 0)
+		cmp = r1->num < r2->num ? -1 : r1->num > r2->num;
+	return cmp;
+}
+
+static void
+test_type(packet_list_sort_type_e type, const char *name)
+{
+	GStringChunk *pool = g_string_chunk_new(65536);
+	packet_list_sort_key_t *keys = g_new0(packet_list_sort_key_t, TEST_ROWS);
+	packet_list_sort_key_t *expected = g_new0(packet_list_sort_key_t, TEST_ROWS);
+	guint counts[] = { 0, 1, 2, 1000, TEST_ROWS };
+	guint c, i;
+	gboolean descending;
+
+	for (c = 0; c < G_N_ELEMENTS(counts); c++) {
+		for (descending = FALSE; descending <= TRUE; descending++) {
+			make_rows(keys, counts[c], type, pool, c + 1);
+			memcpy(expected, keys, counts[c] * sizeof *keys);
+			reference_type = type;
+			qsort(expected, counts[c], sizeof *expected, reference_compare);
+
+			packet_list_sort_keys(keys, counts[c], type, descending);
+			for (i = 0; i < counts[c]; i++) {
+				const packet_list_sort_key_t *want = descending ? &expected[counts[c] - 1 - i] : &expected[i];
+
+				if (keys[i].data != want->data) {
+					printf("Failed %s sort of %u rows%s: row %u is frame %u \"%s\", expected frame %u \"%s\"\n",
+					       name, counts[c], descending ? ", descending" : "", i,
+					       keys[i].num, keys[i].str, want->num, want->str);
+					failed = TRUE;
+					break;
+				}
+			}
+		}
+	}
+
+	g_free(expected);
+	g_free(keys);
+	g_string_chunk_free(pool);
+}
+
+static void
+report_sort_cost(packet_list_sort_type_e type, const char *name, guint count)
+{
+	GStringChunk *pool = g_string_chunk_new(65536);
+	packet_list_sort_key_t *keys = g_new0(packet_list_sort_key_t, count);
+	packet_list_sort_key_t *text_keys = g_new0(packet_list_sort_key_t, count);
+	gint64 start;
+	double text_s, keys_s;
+
+	make_rows(keys, count, type, pool, 42);
+	memcpy(text_keys, keys, count * sizeof *keys);
+
+	reference_type = type;
+	start = g_get_monotonic_time();
+	qsort(text_keys, count, sizeof *text_keys, reference_compare);
+	text_s = (g_get_monotonic_time() - start) / 1e6;
+
+	start = g_get_monotonic_time();
+	packet_list_sort_keys(keys, count, type, FALSE);
+	keys_s = (g_get_monotonic_time() - start) / 1e6;
+
+	printf("%-8s %u rows: comparing text %7.3f s, sort keys %7.3f s (%u threads available)\n",
+	       name, count, text_s, keys_s, g_get_num_processors());
+
+	g_free(text_keys);
+	g_free(keys);
+	g_string_chunk_free(pool);
+}
+
+int
+main(int argc, char **argv)
+{
+	guint count = 0;
+
+	if (argc > 1)
+		count = (guint)strtoul(argv[1], NULL, 10);
+
+	test_type(PACKET_LIST_SORT_STRING, "string");
+	test_type(PACKET_LIST_SORT_NUMERIC, "numeric");
+	test_type(PACKET_LIST_SORT_ADDRESS, "address");
+	if (failed)
+		exit(1);
+	printf("Passed packet list sort tests\n");
+
+	if (count != 0) {
+		report_sort_cost(PACKET_LIST_SORT_STRING, "string", count);
+		report_sort_cost(PACKET_LIST_SORT_NUMERIC, "numeric", count);
+		report_sort_cost(PACKET_LIST_SORT_ADDRESS, "address", count);
+	}
+
+	return failed ? 1 : 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
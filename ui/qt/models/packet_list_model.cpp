@@ -18,6 +18,7 @@
 #include <epan/column.h>
 #include <epan/prefs.h>
 
+#include "ui/packet_list_sort.h"
 #include "ui/packet_list_utils.h"
 #include "ui/recent.h"
 
@@ -293,7 +294,6 @@ void PacketListModel::setMaximiumRowHeight(int height)
 // to do in the future.
 
 int PacketListModel::sort_column_;
-int PacketListModel::sort_column_is_numeric_;
 int PacketListModel::text_sort_column_;
 Qt::SortOrder PacketListModel::sort_order_;
 capture_file *PacketListModel::sort_cap_file_;
@@ -318,7 +318,7 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     emit pushProgressStatus(tr("Dissecting"), true, true, &stop_flag);
     int row_num = 0;
     foreach (PacketListRecord *row, physical_rows_) {
-        row->columnString(sort_cap_file_, column);
+        row->columnText(sort_cap_file_, column);
         row_num++;
         if (busy_timer_.elapsed() > busy_timeout_) {
             if (stop_flag) {
@@ -342,8 +342,31 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
 
     busy_timer_.restart();
-    sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    if (text_sort_column_ < 0) {
+        // Column comes directly from frame data
+        std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    } else {
+        // Make a key for each row from its text, which we just dissected,
+        // and sort the keys; see ui/packet_list_sort.c.
+        packet_list_sort_type_e sort_type = PACKET_LIST_SORT_STRING;
+        if (isNumericColumn(sort_column_)) {
+            sort_type = PACKET_LIST_SORT_NUMERIC;
+        } else if (isAddressColumn(sort_column_)) {
+            sort_type = PACKET_LIST_SORT_ADDRESS;
+        }
+
+        QVector<packet_list_sort_key_t> sort_keys(physical_rows_.count());
+        for (int i = 0; i < physical_rows_.count(); i++) {
+            PacketListRecord *record = physical_rows_[i];
+            sort_keys[i].str = record->columnText(sort_cap_file_, sort_column_);
+            sort_keys[i].num = record->frameData()->num;
+            sort_keys[i].data = record;
+        }
+        packet_list_sort_keys(sort_keys.data(), sort_keys.count(), sort_type, order == Qt::DescendingOrder);
+        for (int i = 0; i < sort_keys.count(); i++) {
+            physical_rows_[i] = static_cast<PacketListRecord *>(sort_keys[i].data);
+        }
+    }
 
     beginResetModel();
     visible_rows_.resize(0);
@@ -437,14 +460,56 @@ bool PacketListModel::isNumericColumn(int column)
     return true;
 }
 
+// Columns whose text is usually an IPv4 or IPv6 address, which sort by
+// address rather than by text. Anything else in them, e.g. a resolved name,
+// sorts after the addresses.
+bool PacketListModel::isAddressColumn(int column)
+{
+    if (column < 0) {
+        return false;
+    }
+    switch (sort_cap_file_->cinfo.columns[column].col_fmt) {
+    case COL_DEF_SRC:
+    case COL_RES_SRC:
+    case COL_UNRES_SRC:
+    case COL_DEF_NET_SRC:
+    case COL_RES_NET_SRC:
+    case COL_UNRES_NET_SRC:
+    case COL_DEF_DST:
+    case COL_RES_DST:
+    case COL_UNRES_DST:
+    case COL_DEF_NET_DST:
+    case COL_RES_NET_DST:
+    case COL_UNRES_NET_DST:
+        return true;
+
+    case COL_CUSTOM:
+        /* handle custom columns below. */
+        break;
+
+    default:
+        return false;
+    }
+
+    guint num_fields = g_slist_length(sort_cap_file_->cinfo.columns[column].col_custom_fields_ids);
+    for (guint i = 0; i < num_fields; i++) {
+        guint *field_idx = (guint *) g_slist_nth_data(sort_cap_file_->cinfo.columns[column].col_custom_fields_ids, i);
+        header_field_info *hfi = proto_registrar_get_nth(*field_idx);
+
+        if (!hfi || (hfi->type != FT_IPv4 && hfi->type != FT_IPv6)) {
+            return false;
+        }
+    }
+
+    return num_fields > 0;
+}
+
+// Only used for columns that come directly from frame data; columns with
+// text are sorted by packet_list_sort_keys.
 bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
 {
     int cmp_val = 0;
 
-    // Wherein we try to cram the logic of packet_list_compare_records,
-    // _packet_list_compare_records, and packet_list_compare_custom from
-    // gtk/packet_list_store.c into one function
-
     if (busy_timer_.elapsed() > busy_timeout_) {
         // What's the least amount of processing that we can do which will draw
         // the busy indicator?
@@ -454,33 +519,8 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     if (sort_column_ < 0) {
         // No column.
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
-        // Column comes directly from frame data
+    } else {
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        if (r1->columnString(sort_cap_file_, sort_column_).constData() == r2->columnString(sort_cap_file_, sort_column_).constData()) {
-            cmp_val = 0;
-        } else if (sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this?
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1->columnString(sort_cap_file_, sort_column_), &ok_r1);
-            double num_r2 = parseNumericColumn(r2->columnString(sort_cap_file_, sort_column_), &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (ok_r1 && num_r1 > num_r2)) {
-                cmp_val = 1;
-            }
-        } else {
-            cmp_val = strcmp(r1->columnString(sort_cap_file_, sort_column_).constData(), r2->columnString(sort_cap_file_, sort_column_).constData());
-        }
-
         if (cmp_val == 0) {
             // All else being equal, compare column numbers.
             cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
@@ -494,19 +534,6 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     }
 }
 
-// Parses a field as a double. Handle values with suffixes ("12ms"), negative
-// values ("-1.23") and fields with multiple occurrences ("1,2"). Marks values
-// that do not contain any numeric value ("Unknown") as invalid.
-double PacketListModel::parseNumericColumn(const QString &val, bool *ok)
-{
-    QByteArray ba = val.toUtf8();
-    const char *strval = ba.constData();
-    gchar *end = NULL;
-    double num = g_ascii_strtod(strval, &end);
-    *ok = strval != end;
-    return num;
-}
-
 // ::data is const so we have to make changes here.
 void PacketListModel::emitItemHeightChanged(const QModelIndex &ih_index)
 {
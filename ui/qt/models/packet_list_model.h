@@ -101,12 +101,10 @@ private:
     int max_line_count_;
 
     static int sort_column_;
-    static int sort_column_is_numeric_;
     static int text_sort_column_;
     static Qt::SortOrder sort_order_;
     static capture_file *sort_cap_file_;
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
-    static double parseNumericColumn(const QString &val, bool *ok);
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
@@ -114,6 +112,7 @@ private:
     struct _GStringChunk *string_cache_pool_;
 
     bool isNumericColumn(int column);
+    bool isAddressColumn(int column);
 
 private slots:
     void emitItemHeightChanged(const QModelIndex &ih_index);
@@ -53,15 +53,18 @@ void *PacketListRecord::operator new(size_t size)
     return wmem_alloc(wmem_file_scope(), size);
 }
 
-// We might want to return a const char * instead. This would keep us from
-// creating excessive QByteArrays, e.g. in PacketListModel::recordLessThan.
 const QByteArray PacketListRecord::columnString(capture_file *cap_file, int column, bool colorized)
+{
+    return QByteArray(columnText(cap_file, column, colorized));
+}
+
+const char *PacketListRecord::columnText(capture_file *cap_file, int column, bool colorized)
 {
     // packet_list_store.c:packet_list_get_value
     g_assert(fdata_);
 
     if (!cap_file || column < 0 || column > cap_file->cinfo.num_cols) {
-        return QByteArray();
+        return NULL;
     }
 
     bool dissect_color = colorized && !colorized_;
@@ -69,7 +72,7 @@ const QByteArray PacketListRecord::columnString(capture_file *cap_file, int colu
         dissect(cap_file, dissect_color);
     }
 
-    return col_text_->value(column, QByteArray());
+    return col_text_->value(column, NULL);
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
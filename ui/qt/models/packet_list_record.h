@@ -39,6 +39,9 @@ public:
 
     // Return the string value for a column. Data is cached if possible.
     const QByteArray columnString(capture_file *cap_file, int column, bool colorized = false);
+    // As columnString, without the copy. The text is valid until the string
+    // cache is cleared; NULL if there's none.
+    const char *columnText(capture_file *cap_file, int column, bool colorized = false);
     frame_data *frameData() const { return fdata_; }
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
@@ -17,6 +17,7 @@
 #include <config.h>
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include "wtap-int.h"
 #include "file_wrappers.h"
@@ -27,12 +28,28 @@
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif /* HAVE_LZ4FRAME_H */
+
 /*
  * See RFC 1952:
  *
  *      https://tools.ietf.org/html/rfc1952
  *
- * for a description of the gzip file format.
+ * for a description of the gzip file format, RFC 8878:
+ *
+ *      https://tools.ietf.org/html/rfc8878
+ *
+ * for a description of the Zstandard format, and
+ *
+ *      https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * for a description of the LZ4 frame format.
  *
  * Some other compressed file formats we might want to support:
  *
@@ -48,22 +65,28 @@
  */
 static struct compression_type {
     wtap_compression_type  type;
+    const char            *name;
     const char            *extension;
     const char            *description;
 } compression_types[] = {
 #ifdef HAVE_ZLIB
-    { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+    { WTAP_GZIP_COMPRESSED, "gzip", "gz", "gzip compressed" },
+#endif
+#ifdef HAVE_ZSTD
+    { WTAP_ZSTD_COMPRESSED, "zstd", "zst", "zstd compressed" },
 #endif
-    { WTAP_UNCOMPRESSED, NULL, NULL }
+#ifdef HAVE_LZ4FRAME_H
+    { WTAP_LZ4_COMPRESSED, "lz4", "lz4", "LZ4 compressed" },
+#endif
+    { WTAP_UNCOMPRESSED, NULL, NULL, NULL }
 };
 
+static wtap_compression_type file_get_compression_type(FILE_T stream);
+
 wtap_compression_type
 wtap_get_compression_type(wtap *wth)
 {
-	gboolean is_compressed;
-
-	is_compressed = file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
-	return is_compressed ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+	return file_get_compression_type((wth->fh == NULL) ? wth->random_fh : wth->fh);
 }
 
 const char *
@@ -102,6 +125,33 @@ wtap_get_all_compression_type_extensions_list(void)
 	return extensions;
 }
 
+wtap_compression_type
+wtap_name_to_compression_type(const char *name)
+{
+	if (g_ascii_strcasecmp(name, "none") == 0)
+		return WTAP_UNCOMPRESSED;
+	for (struct compression_type *p = compression_types;
+	    p->type != WTAP_UNCOMPRESSED; p++) {
+		if (g_ascii_strcasecmp(name, p->name) == 0)
+			return p->type;
+	}
+	return WTAP_UNKNOWN_COMPRESSION;
+}
+
+GSList *
+wtap_get_all_output_compression_type_names_list(void)
+{
+	GSList *names;
+
+	names = NULL;	/* empty list, to start with */
+
+	for (struct compression_type *p = compression_types;
+	    p->type != WTAP_UNCOMPRESSED; p++)
+		names = g_slist_prepend(names, (gpointer)p->name);
+
+	return g_slist_reverse(names);
+}
+
 /* #define GZBUFSIZE 8192 */
 #define GZBUFSIZE 4096
 
@@ -111,7 +161,13 @@ typedef enum {
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD,          /* decompress a zstd frame */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4,           /* decompress an LZ4 frame */
 #endif
 } compression_t;
 
@@ -135,6 +191,7 @@ struct wtap_reader {
     gint64 raw;                 /* where the raw data started, for seeking */
     compression_t compression;  /* type of compression, if any */
     gboolean is_compressed;     /* FALSE if completely uncompressed, TRUE otherwise */
+    wtap_compression_type compression_type; /* type of the first compressed data found */
 
     /* seek request */
     gint64 skip;                /* amount to skip (already rewound if backwards) */
@@ -148,10 +205,27 @@ struct wtap_reader {
     /* zlib inflate stream */
     z_stream strm;              /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx *zstd_dctx;       /* zstd decompression context */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_dctx *lz4_dctx;        /* LZ4 frame decompression context */
 #endif
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+    char *seek_index_path;      /* sidecar to write the seek points to once read, or NULL */
+    gboolean seek_index_loaded; /* TRUE if the seek points came from the sidecar */
+    gint64 seek_index_size;     /* the file, as the sidecar describes it */
+    gint64 seek_index_mtime;
+    guint32 seek_index_tail_crc;
+
+    /* end of the file in shared memory, if it's being written */
+    shm_tail_t *shm_tail;
+    guint64 shm_dev;            /* the file, as shm_tail knows it */
+    guint64 shm_ino;
+    gboolean fd_behind;         /* fd isn't at raw_pos, as we read from shm_tail */
 };
 
 /* Current read offset within a buffer. */
@@ -215,14 +289,31 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         to_read = space_left;
     }
 
-    ret = ws_read(state->fd, read_ptr, to_read);
-    if (ret < 0) {
-        state->err = errno;
-        state->err_info = NULL;
-        return -1;
+    ret = 0;
+    if (state->shm_tail != NULL)
+        ret = (ssize_t)shm_tail_read(state->shm_tail, state->shm_dev,
+                                     state->shm_ino, (guint64)state->raw_pos,
+                                     read_ptr, to_read);
+    if (ret != 0) {
+        state->fd_behind = TRUE;
+    } else {
+        if (state->fd_behind) {
+            if (ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+                state->err = errno;
+                state->err_info = NULL;
+                return -1;
+            }
+            state->fd_behind = FALSE;
+        }
+        ret = ws_read(state->fd, read_ptr, to_read);
+        if (ret < 0) {
+            state->err = errno;
+            state->err_info = NULL;
+            return -1;
+        }
+        if (ret == 0)
+            state->eof = TRUE;
     }
-    if (ret == 0)
-        state->eof = TRUE;
     state->raw_pos += ret;
     buf->avail += ret;
     return 0;
@@ -240,6 +331,25 @@ fill_in_buffer(FILE_T state)
     return 0;
 }
 
+/* Get at least "n" bytes into the input buffer, unless the input ends
+   first, moving what is already there to the start of the buffer. */
+static int
+fill_in_buffer_min(FILE_T state, guint n)
+{
+    if (state->err != 0)
+        return -1;
+    if (state->in.next != state->in.buf) {
+        if (state->in.avail != 0)
+            memmove(state->in.buf, state->in.next, state->in.avail);
+        state->in.next = state->in.buf;
+    }
+    while (state->in.avail < n && !state->eof) {
+        if (buf_read(state, &state->in) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 #define ZLIB_WINSIZE 32768
 
 struct fast_seek_point {
@@ -642,18 +752,105 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#ifdef HAVE_ZSTD
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    ZSTD_outBuffer output = { buf, count, 0 };
+    ZSTD_inBuffer input;
+    size_t ret;
+
+    /* Decompress until the output buffer is full or the frame ends;
+       call ZSTD_decompressStream() before asking for more input, as
+       it may still hold output from the previous call. */
+    for (;;) {
+        input.src = state->in.next;
+        input.size = state->in.avail;
+        input.pos = 0;
+        ret = ZSTD_decompressStream(state->zstd_dctx, &output, &input);
+        state->in.next += input.pos;
+        state->in.avail -= (guint)input.pos;
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            break;
+        }
+        if (ret == 0 || output.pos == output.size)
+            break;
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                break;
+            if (state->in.avail == 0) {
+                /* EOF in the middle of a frame */
+                state->err = WTAP_ERR_SHORT_READ;
+                state->err_info = NULL;
+                break;
+            }
+        }
+    }
+
+    state->out.next = buf;
+    state->out.avail = (guint)output.pos;
+
+    if (ret == 0)
+        state->compression = UNKNOWN;   /* look for another frame */
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+static void
+lz4_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    size_t have = 0;
+    size_t ret;
+
+    /* As for zstd_read(). */
+    for (;;) {
+        size_t out_len = count - have;
+        size_t in_len = state->in.avail;
+
+        ret = LZ4F_decompress(state->lz4_dctx, buf + have, &out_len,
+                              state->in.next, &in_len, NULL);
+        state->in.next += in_len;
+        state->in.avail -= (guint)in_len;
+        have += out_len;
+        if (LZ4F_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = LZ4F_getErrorName(ret);
+            break;
+        }
+        if (ret == 0 || have == count)
+            break;
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                break;
+            if (state->in.avail == 0) {
+                /* EOF in the middle of a frame */
+                state->err = WTAP_ERR_SHORT_READ;
+                state->err_info = NULL;
+                break;
+            }
+        }
+    }
+
+    state->out.next = buf;
+    state->out.avail = (guint)have;
+
+    if (ret == 0)
+        state->compression = UNKNOWN;   /* look for another frame */
+}
+#endif /* HAVE_LZ4FRAME_H */
+
 static int
 gz_head(FILE_T state)
 {
     guint already_read;
 
-    /* get some data in the input buffer */
-    if (state->in.avail == 0) {
-        if (fill_in_buffer(state) == -1)
-            return -1;
-        if (state->in.avail == 0)
-            return 0;
-    }
+    /* get enough data in the input buffer to check for the magic numbers */
+    if (fill_in_buffer_min(state, 4) == -1)
+        return -1;
+    if (state->in.avail == 0)
+        return 0;
 
     /* look for the gzip magic header bytes 31 and 139 */
     if (state->in.next[0] == 31) {
@@ -735,8 +932,12 @@ gz_head(FILE_T state)
             state->strm.adler = crc32(0L, Z_NULL, 0);
             state->compression = ZLIB;
             state->is_compressed = TRUE;
+            if (state->compression_type == WTAP_UNCOMPRESSED)
+                state->compression_type = WTAP_GZIP_COMPRESSED;
 #ifdef Z_BLOCK
-            if (state->fast_seek) {
+            /* No need to track the window if the seek points
+               were loaded from the sidecar. */
+            if (state->fast_seek && !state->seek_index_loaded) {
                 struct zlib_cur_seek_point *cur = g_new(struct zlib_cur_seek_point,1);
 
                 cur->pos = cur->have = 0;
@@ -753,6 +954,49 @@ gz_head(FILE_T state)
 #endif /* HAVE_ZLIB */
         }
     }
+    /* look for the zstd frame magic number 0xFD2FB528, little-endian */
+    if (state->in.avail >= 4 && state->in.next[0] == 0x28 &&
+        state->in.next[1] == 0xB5 && state->in.next[2] == 0x2F &&
+        state->in.next[3] == 0xFD) {
+#ifdef HAVE_ZSTD
+        /* Each frame can be decompressed on its own, so each one
+           is a seek point. */
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, ZSTD);
+        ZSTD_DCtx_reset(state->zstd_dctx, ZSTD_reset_session_only);
+        state->compression = ZSTD;
+        state->is_compressed = TRUE;
+        if (state->compression_type == WTAP_UNCOMPRESSED)
+            state->compression_type = WTAP_ZSTD_COMPRESSED;
+        return 0;
+#else /* HAVE_ZSTD */
+        state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+        state->err_info = "reading zstd-compressed files isn't supported";
+        return -1;
+#endif /* HAVE_ZSTD */
+    }
+
+    /* look for the LZ4 frame magic number 0x184D2204, little-endian */
+    if (state->in.avail >= 4 && state->in.next[0] == 0x04 &&
+        state->in.next[1] == 0x22 && state->in.next[2] == 0x4D &&
+        state->in.next[3] == 0x18) {
+#ifdef HAVE_LZ4FRAME_H
+        /* As for zstd, each frame is a seek point. */
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, LZ4);
+        LZ4F_resetDecompressionContext(state->lz4_dctx);
+        state->compression = LZ4;
+        state->is_compressed = TRUE;
+        if (state->compression_type == WTAP_UNCOMPRESSED)
+            state->compression_type = WTAP_LZ4_COMPRESSED;
+        return 0;
+#else /* HAVE_LZ4FRAME_H */
+        state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+        state->err_info = "reading LZ4-compressed files isn't supported";
+        return -1;
+#endif /* HAVE_LZ4FRAME_H */
+    }
+
 #ifdef HAVE_LIBXZ
     /* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
     /* FD 37 7A 58 5A 00 */
@@ -797,6 +1041,16 @@ fill_out_buffer(FILE_T state)
     else if (state->compression == ZLIB) {      /* decompress */
         zlib_read(state, state->out.buf, state->size << 1);
     }
+#endif
+#ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD) {
+        zstd_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    else if (state->compression == LZ4) {
+        lz4_read(state, state->out.buf, state->size << 1);
+    }
 #endif
     return 0;
 }
@@ -851,6 +1105,27 @@ gz_reset(FILE_T state)
     buf_reset(&state->in);        /* no input data yet */
 }
 
+/* Free the buffers and decompression state of a stream, and the stream. */
+static void
+file_close_streams(FILE_T state)
+{
+#ifdef HAVE_ZLIB
+    inflateEnd(&(state->strm));
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeDCtx(state->zstd_dctx);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (state->lz4_dctx != NULL)
+        LZ4F_freeDecompressionContext(state->lz4_dctx);
+#endif
+    shm_tail_unref(state->shm_tail);
+    g_free(state->out.buf);
+    g_free(state->in.buf);
+    g_free(state->fast_seek_cur);
+    g_free(state);
+}
+
 FILE_T
 file_fdopen(int fd)
 {
@@ -951,6 +1226,22 @@ file_fdopen(int fd)
 
     /* for now, assume we should check the crc */
     state->dont_check_crc = FALSE;
+#endif
+#ifdef HAVE_ZSTD
+    state->zstd_dctx = ZSTD_createDCtx();
+    if (state->zstd_dctx == NULL) {
+        file_close_streams(state);
+        errno = ENOMEM;
+        return NULL;
+    }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&state->lz4_dctx, LZ4F_VERSION))) {
+        state->lz4_dctx = NULL;
+        file_close_streams(state);
+        errno = ENOMEM;
+        return NULL;
+    }
 #endif
     /* return stream */
     return state;
@@ -1014,6 +1305,410 @@ file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
     stream->fast_seek = seek;
 }
 
+#ifdef HAVE_ZLIB
+/*
+ * Seek index sidecar files.
+ *
+ * Seeking in a compressed file is only fast once the whole file has
+ * been read sequentially, which builds the fast_seek table as it goes.
+ * So that the next reader of the file has the table right away, it is
+ * written to a sidecar when a sequential read reaches the end. Sidecars
+ * live in the user's cache directory, in "wireshark/seek-index", named
+ * after a hash of the file's absolute path; nothing is written next to
+ * the capture file. A sidecar holds
+ *
+ *      8 bytes    magic "WSSEEKIX"
+ *      4 bytes    version
+ *      8 bytes    size of the compressed file
+ *      8 bytes    modification time of the compressed file
+ *      4 bytes    CRC-32 of the last SEEK_INDEX_TAIL_LEN bytes of the file
+ *      4 bytes    number of seek points
+ *
+ * followed by the seek points:
+ *
+ *      8 bytes    offset in the uncompressed data
+ *      8 bytes    offset in the compressed file
+ *      1 byte     type (SEEK_INDEX_xxx)
+ *      1 byte     bits from the preceding byte, for SEEK_INDEX_ZLIB
+ *      4 bytes    Adler/CRC value so far, for SEEK_INDEX_ZLIB
+ *      4 bytes    total_out so far, for SEEK_INDEX_ZLIB
+ *      4 bytes    length of the window, for SEEK_INDEX_ZLIB
+ *      n bytes    the preceding 32K of uncompressed data, deflated
+ *
+ * all integers little-endian. The size, modification time and tail CRC
+ * must match the file for the sidecar to be used, and every seek point
+ * must lie within the file; any problem with the sidecar just means it
+ * is ignored.
+ */
+#define SEEK_INDEX_DIR          "seek-index"
+#define SEEK_INDEX_SUFFIX       ".wsidx"
+#define SEEK_INDEX_MAGIC        "WSSEEKIX"
+#define SEEK_INDEX_VERSION      2
+#define SEEK_INDEX_HDR_LEN      36
+#define SEEK_INDEX_POINT_LEN    30
+#define SEEK_INDEX_TAIL_LEN     65536
+
+#define SEEK_INDEX_UNCOMPRESSED         0
+#define SEEK_INDEX_ZLIB                 1
+#define SEEK_INDEX_GZIP_AFTER_HEADER    2
+#define SEEK_INDEX_ZSTD                 3
+#define SEEK_INDEX_LZ4                  4
+
+static void
+seek_index_free_points(GPtrArray *fast_seek)
+{
+    guint i;
+
+    for (i = 0; i < fast_seek->len; i++)
+        g_free(fast_seek->pdata[i]);
+    g_ptr_array_set_size(fast_seek, 0);
+}
+
+static gboolean
+seek_index_read_points(FILE *fp, GPtrArray *fast_seek, guint32 count, gint64 file_size)
+{
+    guint8 hdr[SEEK_INDEX_POINT_LEN];
+    guint8 *packed = NULL;
+    uLong packed_max = compressBound(ZLIB_WINSIZE);
+    gint64 prev_out = -1;
+    gint64 prev_in = 0;
+    guint32 i;
+
+    packed = (guint8 *)g_malloc(packed_max);
+    for (i = 0; i < count; i++) {
+        struct fast_seek_point *val;
+        guint32 packed_len;
+        uLongf window_len;
+
+        if (fread(hdr, 1, sizeof hdr, fp) != sizeof hdr)
+            break;
+        val = g_new(struct fast_seek_point, 1);
+        val->out = (gint64)pletoh64(&hdr[0]);
+        val->in = (gint64)pletoh64(&hdr[8]);
+        packed_len = pletoh32(&hdr[26]);
+        if (val->out <= prev_out || val->in < prev_in || val->in > file_size) {
+            g_free(val);
+            break;
+        }
+        prev_out = val->out;
+        prev_in = val->in;
+
+        switch (hdr[16]) {
+
+        case SEEK_INDEX_UNCOMPRESSED:
+            val->compression = UNCOMPRESSED;
+            break;
+
+        case SEEK_INDEX_GZIP_AFTER_HEADER:
+            val->compression = GZIP_AFTER_HEADER;
+            break;
+
+#ifdef HAVE_ZSTD
+        case SEEK_INDEX_ZSTD:
+            val->compression = ZSTD;
+            break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+        case SEEK_INDEX_LZ4:
+            val->compression = LZ4;
+            break;
+#endif
+
+        case SEEK_INDEX_ZLIB:
+            val->compression = ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            val->data.zlib.bits = hdr[17];
+#else
+            if (hdr[17] != 0) {
+                /* We can't resume inflating in the middle of a byte. */
+                g_free(val);
+                if (packed_len > packed_max ||
+                    fseek(fp, packed_len, SEEK_CUR) != 0)
+                    break;
+                continue;
+            }
+#endif
+            val->data.zlib.adler = pletoh32(&hdr[18]);
+            val->data.zlib.total_out = pletoh32(&hdr[22]);
+            window_len = ZLIB_WINSIZE;
+            if (packed_len > packed_max ||
+                fread(packed, 1, packed_len, fp) != packed_len ||
+                uncompress(val->data.zlib.window, &window_len, packed, packed_len) != Z_OK ||
+                window_len != ZLIB_WINSIZE) {
+                g_free(val);
+                goto done;
+            }
+            break;
+
+        default:
+            g_free(val);
+            goto done;
+        }
+        g_ptr_array_add(fast_seek, val);
+    }
+done:
+    g_free(packed);
+    return i == count;
+}
+
+/* Returns the sidecar for the file at "path", creating the directory
+ * for it if need be, or NULL if there is nowhere to put it. */
+static gchar *
+seek_index_sidecar_path(const char *path)
+{
+    gchar *abs_path;
+    gchar *dir;
+    gchar *digest;
+    gchar *index_name;
+    gchar *index_path;
+#ifndef _WIN32
+    char *resolved;
+
+    resolved = realpath(path, NULL);
+    if (resolved == NULL)
+        return NULL;
+    abs_path = g_strdup(resolved);
+    free(resolved);
+#else
+    if (g_path_is_absolute(path)) {
+        abs_path = g_strdup(path);
+    } else {
+        gchar *cwd = g_get_current_dir();
+
+        abs_path = g_build_filename(cwd, path, NULL);
+        g_free(cwd);
+    }
+#endif
+
+    dir = g_build_filename(g_get_user_cache_dir(), "wireshark", SEEK_INDEX_DIR, NULL);
+    if (g_mkdir_with_parents(dir, 0700) != 0) {
+        g_free(dir);
+        g_free(abs_path);
+        return NULL;
+    }
+    digest = g_compute_checksum_for_string(G_CHECKSUM_SHA256, abs_path, -1);
+    index_name = g_strconcat(digest, SEEK_INDEX_SUFFIX, NULL);
+    index_path = g_build_filename(dir, index_name, NULL);
+    g_free(index_name);
+    g_free(digest);
+    g_free(dir);
+    g_free(abs_path);
+    return index_path;
+}
+
+/* Computes the CRC-32 of the last SEEK_INDEX_TAIL_LEN bytes of the file
+ * at "path", which is "size" bytes long. A rewritten file with the same
+ * size and modification time will almost certainly differ there, if only
+ * in its compressed data's checksum. */
+static gboolean
+seek_index_tail_crc(const char *path, gint64 size, guint32 *crc)
+{
+    FILE *fp;
+    guint8 *buf;
+    size_t len = (size_t)MIN(size, SEEK_INDEX_TAIL_LEN);
+    gboolean ok;
+
+    fp = ws_fopen(path, "rb");
+    if (fp == NULL)
+        return FALSE;
+    buf = (guint8 *)g_malloc(len > 0 ? len : 1);
+    ok = ws_fseek64(fp, size - (gint64)len, SEEK_SET) == 0 &&
+         fread(buf, 1, len, fp) == len;
+    if (ok)
+        *crc = (guint32)crc32(crc32(0L, Z_NULL, 0), buf, (uInt)len);
+    g_free(buf);
+    fclose(fp);
+    return ok;
+}
+
+static gboolean
+seek_index_load(FILE_T stream, const char *index_path)
+{
+    FILE *fp;
+    guint8 hdr[SEEK_INDEX_HDR_LEN];
+    guint32 count;
+    gboolean ok = FALSE;
+
+    fp = ws_fopen(index_path, "rb");
+    if (fp == NULL)
+        return FALSE;
+
+    if (fread(hdr, 1, sizeof hdr, fp) == sizeof hdr &&
+        memcmp(hdr, SEEK_INDEX_MAGIC, 8) == 0 &&
+        pletoh32(&hdr[8]) == SEEK_INDEX_VERSION &&
+        (gint64)pletoh64(&hdr[12]) == stream->seek_index_size &&
+        (gint64)pletoh64(&hdr[20]) == stream->seek_index_mtime &&
+        pletoh32(&hdr[28]) == stream->seek_index_tail_crc) {
+        count = pletoh32(&hdr[32]);
+        ok = seek_index_read_points(fp, stream->fast_seek, count,
+                                    stream->seek_index_size);
+        if (!ok)
+            seek_index_free_points(stream->fast_seek);
+    }
+    fclose(fp);
+    return ok;
+}
+
+static void
+seek_index_save(FILE_T stream)
+{
+    ws_statb64 st;
+    gchar *tmp_path;
+    FILE *fp;
+    guint8 hdr[SEEK_INDEX_HDR_LEN];
+    guint8 point[SEEK_INDEX_POINT_LEN];
+    guint8 *packed;
+    uLong packed_max = compressBound(ZLIB_WINSIZE);
+    gboolean ok = TRUE;
+    gboolean any_window = FALSE;
+    guint i;
+
+    for (i = 0; i < stream->fast_seek->len; i++) {
+        if (((struct fast_seek_point *)stream->fast_seek->pdata[i])->compression == ZLIB)
+            any_window = TRUE;
+    }
+    if (!any_window) {
+        /* Too small to benefit, or zstd or LZ4 frames only, whose
+           seek points cost nothing to find while reading. */
+        return;
+    }
+    /* Don't describe a file that changed while it was being read. */
+    if (ws_fstat64(stream->fd, &st) == -1 ||
+        (gint64)st.st_size != stream->seek_index_size ||
+        (gint64)st.st_mtime != stream->seek_index_mtime)
+        return;
+
+    /* Write a temporary file and rename it, so readers never see half
+       an index; if the directory isn't writable, so be it. */
+    tmp_path = g_strdup_printf("%s.tmp", stream->seek_index_path);
+    fp = ws_fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        g_free(tmp_path);
+        return;
+    }
+
+    memcpy(hdr, SEEK_INDEX_MAGIC, 8);
+    phtole32(&hdr[8], SEEK_INDEX_VERSION);
+    phtole64(&hdr[12], (guint64)stream->seek_index_size);
+    phtole64(&hdr[20], (guint64)stream->seek_index_mtime);
+    phtole32(&hdr[28], stream->seek_index_tail_crc);
+    phtole32(&hdr[32], stream->fast_seek->len);
+    if (fwrite(hdr, 1, sizeof hdr, fp) != sizeof hdr)
+        ok = FALSE;
+
+    packed = (guint8 *)g_malloc(packed_max);
+    for (i = 0; ok && i < stream->fast_seek->len; i++) {
+        struct fast_seek_point *item = (struct fast_seek_point *)stream->fast_seek->pdata[i];
+        uLongf packed_len = 0;
+
+        memset(point, 0, sizeof point);
+        phtole64(&point[0], (guint64)item->out);
+        phtole64(&point[8], (guint64)item->in);
+        switch (item->compression) {
+
+        case ZLIB:
+            point[16] = SEEK_INDEX_ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            point[17] = (guint8)item->data.zlib.bits;
+#endif
+            phtole32(&point[18], item->data.zlib.adler);
+            phtole32(&point[22], item->data.zlib.total_out);
+            packed_len = packed_max;
+            if (compress2(packed, &packed_len, item->data.zlib.window,
+                          ZLIB_WINSIZE, Z_BEST_SPEED) != Z_OK)
+                ok = FALSE;
+            break;
+
+        case GZIP_AFTER_HEADER:
+            point[16] = SEEK_INDEX_GZIP_AFTER_HEADER;
+            break;
+
+#ifdef HAVE_ZSTD
+        case ZSTD:
+            point[16] = SEEK_INDEX_ZSTD;
+            break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+        case LZ4:
+            point[16] = SEEK_INDEX_LZ4;
+            break;
+#endif
+
+        default:
+            point[16] = SEEK_INDEX_UNCOMPRESSED;
+            break;
+        }
+        phtole32(&point[26], (guint32)packed_len);
+        if (ok && fwrite(point, 1, sizeof point, fp) != sizeof point)
+            ok = FALSE;
+        if (ok && packed_len != 0 && fwrite(packed, 1, packed_len, fp) != packed_len)
+            ok = FALSE;
+    }
+    g_free(packed);
+
+    if (fclose(fp) != 0)
+        ok = FALSE;
+    if (!ok || ws_rename(tmp_path, stream->seek_index_path) != 0)
+        ws_unlink(tmp_path);
+    g_free(tmp_path);
+}
+#endif /* HAVE_ZLIB */
+
+/*
+ * Load the seek points of the file at "path" from its sidecar in the
+ * user's cache directory, if it has an up-to-date one; otherwise, arrange
+ * to write the sidecar once "stream" has been read to the end. Call this,
+ * for the sequential stream, after file_set_random_access() and before
+ * reading.
+ */
+void
+file_use_seek_index(
+#ifdef HAVE_ZLIB
+    FILE_T stream, const char *path)
+#else
+    FILE_T stream _U_, const char *path _U_)
+#endif
+{
+#ifdef HAVE_ZLIB
+    ws_statb64 st;
+    gchar *index_path;
+
+    if (stream->fast_seek == NULL || stream->fast_seek->len != 0)
+        return;
+
+    if (ws_fstat64(stream->fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return;
+    stream->seek_index_size = (gint64)st.st_size;
+    stream->seek_index_mtime = (gint64)st.st_mtime;
+    if (!seek_index_tail_crc(path, stream->seek_index_size, &stream->seek_index_tail_crc))
+        return;
+
+    index_path = seek_index_sidecar_path(path);
+    if (index_path == NULL)
+        return;
+    if (seek_index_load(stream, index_path)) {
+        stream->seek_index_loaded = TRUE;
+        g_free(index_path);
+    } else
+        stream->seek_index_path = index_path;
+#endif
+}
+
+/*
+ * Read whatever of the file is in "tail" from there rather than from
+ * the file; the file is being written, and its end is mirrored there
+ * before it's written out.
+ */
+void
+file_set_shm_tail(FILE_T stream, shm_tail_t *tail)
+{
+    if (stream->shm_tail != NULL || !shm_tail_file_id(stream->fd, &stream->shm_dev, &stream->shm_ino))
+        return;
+    stream->shm_tail = shm_tail_ref(tail);
+}
+
 gint64
 file_seek(FILE_T file, gint64 offset, int whence, int *err)
 {
@@ -1148,6 +1843,18 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off = here->in;
             off2 = here->out;
         } else
+#endif
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD) {
+            off = here->in;
+            off2 = here->out;
+        } else
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (here->compression == LZ4) {
+            off = here->in;
+            off2 = here->out;
+        } else
 #endif
         {
             off2 = (file->pos + offset);
@@ -1161,6 +1868,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         fast_seek_reset(file);
 
         file->raw_pos = off;
+        file->fd_behind = FALSE;
         buf_reset(&file->out);
         file->eof = FALSE;
         file->seek_pending = FALSE;
@@ -1200,6 +1908,19 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             strm->adler = crc32(0L, Z_NULL, 0);
             file->compression = ZLIB;
         } else
+#endif
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD) {
+            /* Start over at the beginning of the frame. */
+            ZSTD_DCtx_reset(file->zstd_dctx, ZSTD_reset_session_only);
+            file->compression = ZSTD;
+        } else
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (here->compression == LZ4) {
+            LZ4F_resetDecompressionContext(file->lz4_dctx);
+            file->compression = LZ4;
+        } else
 #endif
             file->compression = here->compression;
 
@@ -1234,7 +1955,13 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
-        if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
+        if (file->fd_behind) {
+            if (ws_lseek64(file->fd, file->raw_pos + offset - file->out.avail, SEEK_SET) == -1) {
+                *err = errno;
+                return -1;
+            }
+            file->fd_behind = FALSE;
+        } else if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
         }
@@ -1274,6 +2001,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         }
         fast_seek_reset(file);
         file->raw_pos = file->start;
+        file->fd_behind = FALSE;
         gz_reset(file);
     }
 
@@ -1330,6 +2058,12 @@ file_iscompressed(FILE_T stream)
     return stream->is_compressed;
 }
 
+static wtap_compression_type
+file_get_compression_type(FILE_T stream)
+{
+    return stream->compression_type;
+}
+
 int
 file_read(void *buf, unsigned int len, FILE_T file)
 {
@@ -1593,18 +2327,17 @@ file_close(FILE_T file)
 {
     int fd = file->fd;
 
-    /* free memory and close file */
-    if (file->size) {
 #ifdef HAVE_ZLIB
-        inflateEnd(&(file->strm));
+    /* If we've read all of a compressed file, save what we learned
+       about seeking in it for the next reader. */
+    if (file->seek_index_path != NULL && file->is_compressed &&
+        file->eof && file->err == 0 && file->fast_seek != NULL)
+        seek_index_save(file);
 #endif
-        g_free(file->out.buf);
-        g_free(file->in.buf);
-    }
-    g_free(file->fast_seek_cur);
-    file->err = 0;
-    file->err_info = NULL;
-    g_free(file);
+    g_free(file->seek_index_path);
+
+    /* free memory and close file */
+    file_close_streams(file);
     /*
      * If fd is -1, somebody's done a file_closefd() on us, so
      * we don't need to close the FD itself, and shouldn't do
@@ -1899,6 +2632,244 @@ gzwfile_geterr(GZWFILE_T state)
 }
 #endif
 
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+/*
+ * zstd and LZ4 files are written as a series of independent frames, each
+ * holding FRAME_SPAN bytes of uncompressed data, so that a reader can
+ * start decompressing at the beginning of any frame; see gz_head().
+ */
+#define FRAME_SPAN ((guint)SPAN)
+
+/* internal zstd or LZ4 file state data structure for writing */
+struct wtap_frame_writer {
+    int fd;                     /* file descriptor */
+    wtap_compression_type type; /* WTAP_ZSTD_COMPRESSED or WTAP_LZ4_COMPRESSED */
+    unsigned char *in;          /* uncompressed data for the current frame */
+    guint have;                 /* number of bytes in "in" */
+    unsigned char *out;         /* compressed frame */
+    size_t out_size;            /* size of "out" */
+    int err;                    /* error code */
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zstd_cctx;       /* zstd compression context */
+#endif
+};
+
+#ifdef HAVE_LZ4FRAME_H
+static void
+lz4_frame_prefs(LZ4F_preferences_t *prefs, size_t len)
+{
+    memset(prefs, 0, sizeof *prefs);
+    prefs->frameInfo.blockSizeID = LZ4F_max1MB;
+    prefs->frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    prefs->frameInfo.contentSize = len;
+}
+#endif
+
+FRAMEWFILE_T
+framewfile_open(const char *path, wtap_compression_type type)
+{
+    int fd;
+    FRAMEWFILE_T state;
+    int save_errno;
+
+    fd = ws_open(path, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1)
+        return NULL;
+    state = framewfile_fdopen(fd, type);
+    if (state == NULL) {
+        save_errno = errno;
+        ws_close(fd);
+        errno = save_errno;
+    }
+    return state;
+}
+
+FRAMEWFILE_T
+framewfile_fdopen(int fd, wtap_compression_type type)
+{
+    FRAMEWFILE_T state;
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_preferences_t prefs;
+#endif
+
+    /* allocate wtap_frame_writer structure to return */
+    state = g_try_new0(struct wtap_frame_writer, 1);
+    if (state == NULL)
+        return NULL;
+    state->fd = fd;
+    state->type = type;
+
+    switch (type) {
+
+#ifdef HAVE_ZSTD
+    case WTAP_ZSTD_COMPRESSED:
+        state->zstd_cctx = ZSTD_createCCtx();
+        if (state->zstd_cctx == NULL)
+            goto fail;
+        ZSTD_CCtx_setParameter(state->zstd_cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+        ZSTD_CCtx_setParameter(state->zstd_cctx, ZSTD_c_checksumFlag, 1);
+        state->out_size = ZSTD_compressBound(FRAME_SPAN);
+        break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case WTAP_LZ4_COMPRESSED:
+        lz4_frame_prefs(&prefs, FRAME_SPAN);
+        state->out_size = LZ4F_compressFrameBound(FRAME_SPAN, &prefs);
+        break;
+#endif
+
+    default:
+        g_free(state);
+        errno = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+        return NULL;
+    }
+
+    state->in = (unsigned char *)g_try_malloc(FRAME_SPAN);
+    state->out = (unsigned char *)g_try_malloc(state->out_size);
+    if (state->in == NULL || state->out == NULL)
+        goto fail;
+    return state;
+
+fail:
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(state->zstd_cctx);
+#endif
+    g_free(state->out);
+    g_free(state->in);
+    g_free(state);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Compress the buffered data as one frame and write it to the output
+   file.  Return -1, and set state->err, on failure; return 0 on
+   success. */
+static int
+frame_comp(FRAMEWFILE_T state)
+{
+    size_t len = 0;
+    ssize_t got;
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_preferences_t prefs;
+#endif
+
+    if (state->have == 0)
+        return 0;
+
+    switch (state->type) {
+
+#ifdef HAVE_ZSTD
+    case WTAP_ZSTD_COMPRESSED:
+        len = ZSTD_compress2(state->zstd_cctx, state->out, state->out_size,
+                             state->in, state->have);
+        if (ZSTD_isError(len)) {
+            /* This "shouldn't happen". */
+            state->err = WTAP_ERR_INTERNAL;
+            return -1;
+        }
+        break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case WTAP_LZ4_COMPRESSED:
+        lz4_frame_prefs(&prefs, state->have);
+        len = LZ4F_compressFrame(state->out, state->out_size,
+                                 state->in, state->have, &prefs);
+        if (LZ4F_isError(len)) {
+            /* This "shouldn't happen". */
+            state->err = WTAP_ERR_INTERNAL;
+            return -1;
+        }
+        break;
+#endif
+
+    default:
+        state->err = WTAP_ERR_INTERNAL;
+        return -1;
+    }
+
+    got = ws_write(state->fd, state->out, (unsigned int)len);
+    if (got < 0) {
+        state->err = errno;
+        return -1;
+    }
+    if ((size_t)got != len) {
+        state->err = WTAP_ERR_SHORT_WRITE;
+        return -1;
+    }
+    state->have = 0;
+    return 0;
+}
+
+/* Write out len bytes from buf.  Return 0, and set state->err, on
+   failure or on an attempt to write 0 bytes (in which case state->err
+   is 0); return the number of bytes written on success. */
+guint
+framewfile_write(FRAMEWFILE_T state, const void *buf, guint len)
+{
+    guint put = len;
+    guint n;
+
+    /* check that there's no error */
+    if (state->err != 0)
+        return 0;
+
+    while (len != 0) {
+        n = FRAME_SPAN - state->have;
+        if (n > len)
+            n = len;
+        memcpy(state->in + state->have, buf, n);
+        state->have += n;
+        buf = (const char *)buf + n;
+        len -= n;
+        if (state->have == FRAME_SPAN && frame_comp(state) == -1)
+            return 0;
+    }
+    return put;
+}
+
+/* Flush out what we've written so far, ending the current frame early.
+   Returns -1, and sets state->err, on failure; returns 0 on success. */
+int
+framewfile_flush(FRAMEWFILE_T state)
+{
+    /* check that there's no error */
+    if (state->err != 0)
+        return -1;
+
+    return frame_comp(state);
+}
+
+/* Flush out all data written, and close the file.  Returns a Wiretap
+   error on failure; returns 0 on success. */
+int
+framewfile_close(FRAMEWFILE_T state)
+{
+    int ret;
+
+    /* flush, free memory, and close file */
+    if (state->err == 0)
+        (void)frame_comp(state);
+    ret = state->err;
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(state->zstd_cctx);
+#endif
+    g_free(state->out);
+    g_free(state->in);
+    if (ws_close(state->fd) == -1 && ret == 0)
+        ret = errno;
+    g_free(state);
+    return ret;
+}
+
+int
+framewfile_geterr(FRAMEWFILE_T state)
+{
+    return state->err;
+}
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
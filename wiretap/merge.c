@@ -38,6 +38,28 @@
 #endif
 
 
+/*
+ * Number of records read from an input file in one go when merging by
+ * timestamp.  Reading a batch from each file, rather than one record
+ * from whichever file is next, keeps the reads for a file together
+ * when merging many files.
+ */
+#define MERGE_READ_AHEAD    16
+
+/*
+ * Binary min-heap of the input files that have a record available,
+ * ordered by the time stamp of that record, used to pick the next
+ * record to write when merging by timestamp.  The file whose record
+ * was handed out last stays at the top until the next call, when it
+ * is refilled and sifted down (or dropped at EOF).
+ */
+typedef struct {
+    merge_in_file_t   **files;
+    guint               count;
+    gboolean            primed;     /* every file has been read from once */
+    gboolean            top_taken;  /* files[0]'s record has been handed out */
+} merge_heap_t;
+
 static const char* idb_merge_mode_strings[] = {
     /* IDB_MERGE_MODE_NONE */
     "none",
@@ -84,6 +106,21 @@ cleanup_in_file(merge_in_file_t *in_file)
 
     wtap_rec_cleanup(&in_file->rec);
     ws_buffer_free(&in_file->frame_buffer);
+
+    if (in_file->ra_recs != NULL) {
+        guint i;
+
+        for (i = 0; i < MERGE_READ_AHEAD; i++) {
+            wtap_rec_cleanup(&in_file->ra_recs[i]);
+            ws_buffer_free(&in_file->ra_bufs[i]);
+        }
+        g_free(in_file->ra_recs);
+        g_free(in_file->ra_bufs);
+        in_file->ra_recs = NULL;
+        in_file->ra_bufs = NULL;
+    }
+    g_free(in_file->ra_err_info);
+    in_file->ra_err_info = NULL;
 }
 
 static void
@@ -207,21 +244,126 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Returns TRUE if the current record of file a must be written before
+ * the current record of file b.  Records with no time stamp come before
+ * all other records, in file order; otherwise the earlier time stamp
+ * wins, and for equal time stamps the file later in the list wins.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_heap_before(const merge_in_file_t *a, const merge_in_file_t *b)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
-        return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return FALSE;
+    gboolean a_has_ts = (a->rec.presence_flags & WTAP_HAS_TS) != 0;
+    gboolean b_has_ts = (b->rec.presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!a_has_ts || !b_has_ts) {
+        if (a_has_ts != b_has_ts)
+            return !a_has_ts;
+        return a < b;
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
+    if (a->rec.ts.secs != b->rec.ts.secs)
+        return a->rec.ts.secs < b->rec.ts.secs;
+    if (a->rec.ts.nsecs != b->rec.ts.nsecs)
+        return a->rec.ts.nsecs < b->rec.ts.nsecs;
+    return a > b;
+}
+
+static void
+merge_heap_sift_up(merge_heap_t *heap, guint i)
+{
+    merge_in_file_t *file = heap->files[i];
+
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+
+        if (!merge_heap_before(file, heap->files[parent]))
+            break;
+        heap->files[i] = heap->files[parent];
+        i = parent;
+    }
+    heap->files[i] = file;
+}
+
+static void
+merge_heap_sift_down(merge_heap_t *heap, guint i)
+{
+    merge_in_file_t *file = heap->files[i];
+
+    for (;;) {
+        guint child = 2 * i + 1;
+
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_heap_before(heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_heap_before(heap->files[child], file))
+            break;
+        heap->files[i] = heap->files[child];
+        i = child;
+    }
+    heap->files[i] = file;
+}
+
+/*
+ * Make the next record of in_file its current record (in_file->rec and
+ * in_file->frame_buffer), reading a new batch of records if we've handed
+ * out all of the previous one.
+ *
+ * Returns TRUE if a record is available; otherwise returns FALSE, with
+ * *err set to 0 at EOF or to the error with which reading failed.
+ */
+static gboolean
+merge_next_record(merge_in_file_t *in_file, int *err, gchar **err_info)
+{
+    wtap_rec tmp_rec;
+    Buffer   tmp_buf;
+    gint64   data_offset;
+
+    if (in_file->ra_next == in_file->ra_count) {
+        if (in_file->ra_recs == NULL) {
+            guint i;
+
+            in_file->ra_recs = g_new(wtap_rec, MERGE_READ_AHEAD);
+            in_file->ra_bufs = g_new(Buffer, MERGE_READ_AHEAD);
+            for (i = 0; i < MERGE_READ_AHEAD; i++) {
+                wtap_rec_init(&in_file->ra_recs[i]);
+                ws_buffer_init(&in_file->ra_bufs[i], 1514);
+            }
+        }
+
+        in_file->ra_count = 0;
+        in_file->ra_next = 0;
+        while (!in_file->ra_done && in_file->ra_count < MERGE_READ_AHEAD) {
+            if (!wtap_read(in_file->wth, &in_file->ra_recs[in_file->ra_count],
+                           &in_file->ra_bufs[in_file->ra_count],
+                           &in_file->ra_err, &in_file->ra_err_info,
+                           &data_offset)) {
+                in_file->ra_done = TRUE;
+                break;
+            }
+            in_file->ra_count++;
+        }
+
+        if (in_file->ra_count == 0) {
+            /* Report the EOF or error only once the batch is used up. */
+            *err = in_file->ra_err;
+            *err_info = in_file->ra_err_info;
+            in_file->ra_err_info = NULL;
+            return FALSE;
+        }
+    }
+
+    /* Swap rather than copy, so the buffers just get recycled. */
+    tmp_rec = in_file->rec;
+    in_file->rec = in_file->ra_recs[in_file->ra_next];
+    in_file->ra_recs[in_file->ra_next] = tmp_rec;
+
+    tmp_buf = in_file->frame_buffer;
+    in_file->frame_buffer = in_file->ra_bufs[in_file->ra_next];
+    in_file->ra_bufs[in_file->ra_next] = tmp_buf;
+
+    in_file->ra_next++;
+    *err = 0;
     return TRUE;
 }
 
@@ -237,8 +379,13 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
+ * The files with a record available are kept in a min-heap keyed on
+ * the record's time stamp, so picking a record costs O(log n) in the
+ * number of files rather than a scan of all of them.
+ *
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
+ * @param heap heap state, zero-initialized before the first call
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -247,79 +394,76 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  */
 static merge_in_file_t *
 merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+                  merge_heap_t *heap, int *err, gchar **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    merge_in_file_t *in_file;
 
-    /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
-     */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
+    if (!heap->primed) {
+        /*
+         * Get the first record from each file and build the heap.
+         */
+        heap->files = g_new(merge_in_file_t *, in_file_count);
+        heap->count = 0;
+        for (i = 0; i < in_file_count; i++) {
+            if (!merge_next_record(&in_files[i], err, err_info)) {
                 if (*err != 0) {
                     in_files[i].state = GOT_ERROR;
                     return &in_files[i];
                 }
                 in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
+                continue;
             }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
+            in_files[i].state = RECORD_PRESENT;
+            heap->files[heap->count] = &in_files[i];
+            merge_heap_sift_up(heap, heap->count);
+            heap->count++;
+        }
+        heap->primed = TRUE;
+    } else if (heap->top_taken) {
+        /*
+         * We handed out the record of the file at the top of the heap;
+         * try to read another one from that file, and put it back in
+         * its place.
+         */
+        in_file = heap->files[0];
+        heap->top_taken = FALSE;
+        if (merge_next_record(in_file, err, err_info)) {
+            in_file->state = RECORD_PRESENT;
+        } else {
+            if (*err != 0) {
+                in_file->state = GOT_ERROR;
+                return in_file;
             }
+            in_file->state = AT_EOF;
+            heap->count--;
+            heap->files[0] = heap->files[heap->count];
         }
+        if (heap->count > 0)
+            merge_heap_sift_down(heap, 0);
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    in_file = heap->files[0];
+    heap->top_taken = TRUE;
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -851,6 +995,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap = { NULL, 0, FALSE, FALSE };
 
     for (;;) {
         *err = 0;
@@ -860,7 +1005,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(in_file_count, in_files, &heap, err,
                                         err_info);
         }
 
@@ -942,6 +1087,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    g_free(heap.files);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -979,7 +1126,9 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
 static merge_result
 merge_files_common(const gchar* out_filename, /* normal output mode */
                    gchar **out_filenamep, const char *pfx, /* tempfile mode  */
-                   const int file_type, const char *const *in_filenames,
+                   const int file_type,
+                   const wtap_compression_type compression_type,
+                   const char *const *in_filenames,
                    const guint in_file_count, const gboolean do_append,
                    const idb_merge_mode mode, guint snaplen,
                    const gchar *app_name, merge_progress_callback_t* cb,
@@ -1050,12 +1199,12 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
         params.dsbs_growing = dsb_combined;
     }
     if (out_filename) {
-        pdh = wtap_dump_open(out_filename, file_type, WTAP_UNCOMPRESSED, &params, err);
+        pdh = wtap_dump_open(out_filename, file_type, compression_type, &params, err);
     } else if (out_filenamep) {
         pdh = wtap_dump_open_tempfile(out_filenamep, pfx, file_type,
-                                      WTAP_UNCOMPRESSED, &params, err);
+                                      compression_type, &params, err);
     } else {
-        pdh = wtap_dump_open_stdout(file_type, WTAP_UNCOMPRESSED, &params, err);
+        pdh = wtap_dump_open_stdout(file_type, compression_type, &params, err);
     }
     if (pdh == NULL) {
         merge_close_in_files(in_file_count, in_files);
@@ -1093,6 +1242,7 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
  */
 merge_result
 merge_files(const gchar* out_filename, const int file_type,
+            const wtap_compression_type compression_type,
             const char *const *in_filenames, const guint in_file_count,
             const gboolean do_append, const idb_merge_mode mode,
             guint snaplen, const gchar *app_name, merge_progress_callback_t* cb,
@@ -1102,7 +1252,7 @@ merge_files(const gchar* out_filename, const int file_type,
     g_assert(out_filename != NULL);
 
     return merge_files_common(out_filename, NULL, NULL,
-                              file_type, in_filenames, in_file_count,
+                              file_type, compression_type, in_filenames, in_file_count,
                               do_append, mode, snaplen, app_name, cb, err,
                               err_info, err_fileno, err_framenum);
 }
@@ -1127,7 +1277,7 @@ merge_files_to_tempfile(gchar **out_filenamep, const char *pfx,
     *out_filenamep = NULL;
 
     return merge_files_common(NULL, out_filenamep, pfx,
-                              file_type, in_filenames, in_file_count,
+                              file_type, WTAP_UNCOMPRESSED, in_filenames, in_file_count,
                               do_append, mode, snaplen, app_name, cb, err,
                               err_info, err_fileno, err_framenum);
 }
@@ -1138,7 +1288,9 @@ merge_files_to_tempfile(gchar **out_filenamep, const char *pfx,
  * on failure.
  */
 merge_result
-merge_files_to_stdout(const int file_type, const char *const *in_filenames,
+merge_files_to_stdout(const int file_type,
+                      const wtap_compression_type compression_type,
+                      const char *const *in_filenames,
                       const guint in_file_count, const gboolean do_append,
                       const idb_merge_mode mode, guint snaplen,
                       const gchar *app_name, merge_progress_callback_t* cb,
@@ -1146,7 +1298,7 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
                       guint32 *err_framenum)
 {
     return merge_files_common(NULL, NULL, NULL,
-                              file_type, in_filenames, in_file_count,
+                              file_type, compression_type, in_filenames, in_file_count,
                               do_append, mode, snaplen, app_name, cb, err,
                               err_info, err_fileno, err_framenum);
 }
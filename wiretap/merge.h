@@ -37,6 +37,13 @@ typedef struct merge_in_file_s {
     gint64          size;           /* file size */
     GArray         *idb_index_map;  /* used for mapping the old phdr interface_id values to new during merge */
     guint           dsbs_seen;      /* number of elements processed so far from wth->dsbs */
+    wtap_rec       *ra_recs;        /* records read ahead of rec, when merging by timestamp */
+    Buffer         *ra_bufs;        /* frame data for ra_recs */
+    guint           ra_count;       /* number of records in the current read-ahead batch */
+    guint           ra_next;        /* index of the next read-ahead record to hand out */
+    gboolean        ra_done;        /* read-ahead hit EOF or an error; see ra_err */
+    int             ra_err;         /* error that ended read-ahead, or 0 for EOF */
+    gchar          *ra_err_info;    /* error string for ra_err */
 } merge_in_file_t;
 
 /** Return values from merge_files(). */
@@ -117,6 +124,7 @@ typedef struct {
  *
  * @param out_filename The output filename
  * @param file_type The WTAP_FILE_TYPE_SUBTYPE_XXX output file type
+ * @param compression_type The compression to apply to the output file
  * @param in_filenames An array of input filenames to merge from
  * @param in_file_count The number of entries in in_filenames
  * @param do_append Whether to append by file order instead of chronological order
@@ -136,6 +144,7 @@ typedef struct {
  */
 WS_DLL_PUBLIC merge_result
 merge_files(const gchar* out_filename, const int file_type,
+            const wtap_compression_type compression_type,
             const char *const *in_filenames, const guint in_file_count,
             const gboolean do_append, const idb_merge_mode mode,
             guint snaplen, const gchar *app_name, merge_progress_callback_t* cb,
@@ -177,6 +186,7 @@ merge_files_to_tempfile(gchar **out_filenamep, const char *pfx,
 /** Merge the given input files to the standard output
  *
  * @param file_type The WTAP_FILE_TYPE_SUBTYPE_XXX output file type
+ * @param compression_type The compression to apply to the output file
  * @param in_filenames An array of input filenames to merge from
  * @param in_file_count The number of entries in in_filenames
  * @param do_append Whether to append by file order instead of chronological order
@@ -195,7 +205,9 @@ merge_files_to_tempfile(gchar **out_filenamep, const char *pfx,
  * @return the frame type
  */
 WS_DLL_PUBLIC merge_result
-merge_files_to_stdout(const int file_type, const char *const *in_filenames,
+merge_files_to_stdout(const int file_type,
+                      const wtap_compression_type compression_type,
+                      const char *const *in_filenames,
                       const guint in_file_count, const gboolean do_append,
                       const idb_merge_mode mode, guint snaplen,
                       const gchar *app_name, merge_progress_callback_t* cb,
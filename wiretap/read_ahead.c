@@ -0,0 +1,387 @@
+/* read_ahead.c
+ * Reading records of a capture file in a separate thread
+ *
+ * Wiretap Library
+ * Copyright (c) 1998 by Gilbert Ramirez <gram@alumni.rice.edu>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "wtap-int.h"
+
+#include <wsutil/buffer.h>
+
+/*
+ * The reader thread takes empty slots from "free_slots", reads a record
+ * into each with the wtap locked and hands it to wtap_read() through
+ * "full_slots", in file order. wtap_read() swaps the record and its data
+ * into the caller's wtap_rec and Buffer, so nothing is copied.
+ *
+ * The name resolution and secrets callbacks are called by the file
+ * readers in the middle of a read, i.e. in the reader thread. They are
+ * recorded with the record being read and passed on to the real callbacks
+ * when that record is returned by wtap_read(), so the callers see them in
+ * the same order, and from the same thread, as without read-ahead.
+ */
+
+typedef enum {
+	RA_NEW_IPV4,
+	RA_NEW_IPV6,
+	RA_NEW_SECRETS
+} ra_event_type_t;
+
+typedef struct {
+	ra_event_type_t type;
+	guint32		value;		/* IPv4 address or secrets type */
+	guint8		*data;		/* IPv6 address or secrets */
+	guint		size;
+	gchar		*name;
+} ra_event_t;
+
+typedef struct {
+	wtap_rec	rec;
+	Buffer		buf;
+	gint64		offset;
+	gboolean	ok;
+	int		err;
+	gchar		*err_info;
+	GPtrArray	*events;	/* of ra_event_t *, or NULL */
+	guint		dsbs_len;	/* DSBs read up to and with this record */
+} ra_slot_t;
+
+struct wtap_read_ahead {
+	GThread		*thread;	/* NULL once stopped */
+	GMutex		lock;		/* held while the wtap is used */
+	GAsyncQueue	*free_slots;
+	GAsyncQueue	*full_slots;
+	ra_slot_t	*slots;
+	guint		depth;
+	guint		dsbs_delivered;	/* DSBs read with the records handed out */
+
+	/* The callbacks set by the caller */
+	wtap_new_ipv4_callback_t	add_new_ipv4;
+	wtap_new_ipv6_callback_t	add_new_ipv6;
+	wtap_new_secrets_callback_t	add_new_secrets;
+};
+
+/* In a reader thread, the slot it is reading into */
+static GPrivate ra_current_slot = G_PRIVATE_INIT(NULL);
+
+static void
+ra_event_free(gpointer data)
+{
+	ra_event_t *event = (ra_event_t *)data;
+
+	g_free(event->data);
+	g_free(event->name);
+	g_free(event);
+}
+
+static void
+ra_add_event(ra_event_type_t type, guint32 value, const void *data,
+    guint size, const gchar *name)
+{
+	ra_slot_t *slot = (ra_slot_t *)g_private_get(&ra_current_slot);
+	ra_event_t *event;
+
+	if (slot == NULL)
+		return;
+
+	event = g_new(ra_event_t, 1);
+	event->type = type;
+	event->value = value;
+	event->data = size ? (guint8 *)g_memdup(data, size) : NULL;
+	event->size = size;
+	event->name = g_strdup(name);
+	if (slot->events == NULL)
+		slot->events = g_ptr_array_new_with_free_func(ra_event_free);
+	g_ptr_array_add(slot->events, event);
+}
+
+static void
+ra_new_ipv4(const guint addr, const gchar *name)
+{
+	ra_add_event(RA_NEW_IPV4, addr, NULL, 0, name);
+}
+
+static void
+ra_new_ipv6(const void *addrp, const gchar *name)
+{
+	ra_add_event(RA_NEW_IPV6, 0, addrp, 16, name);
+}
+
+static void
+ra_new_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+	ra_add_event(RA_NEW_SECRETS, secrets_type, secrets, size, NULL);
+}
+
+/* Points the wtap at our callbacks, for those the caller has set.
+ * Secrets are always recorded: a caller that sets its callback later
+ * is given the DSBs read so far by wtap_set_cb_new_secrets(), except
+ * for those of records still queued, which come with their record. */
+static void
+ra_set_callbacks(wtap *wth, struct wtap_read_ahead *ra)
+{
+	wth->add_new_ipv4 = ra->add_new_ipv4 ? ra_new_ipv4 : NULL;
+	wth->add_new_ipv6 = ra->add_new_ipv6 ? ra_new_ipv6 : NULL;
+	wth->add_new_secrets = ra_new_secrets;
+}
+
+static void
+ra_replay_events(struct wtap_read_ahead *ra, ra_slot_t *slot)
+{
+	guint i;
+
+	for (i = 0; i < slot->events->len; i++) {
+		ra_event_t *event = (ra_event_t *)g_ptr_array_index(slot->events, i);
+
+		switch (event->type) {
+
+		case RA_NEW_IPV4:
+			if (ra->add_new_ipv4)
+				ra->add_new_ipv4(event->value, event->name);
+			break;
+
+		case RA_NEW_IPV6:
+			if (ra->add_new_ipv6)
+				ra->add_new_ipv6(event->data, event->name);
+			break;
+
+		case RA_NEW_SECRETS:
+			if (ra->add_new_secrets)
+				ra->add_new_secrets(event->value, event->data, event->size);
+			break;
+		}
+	}
+	g_ptr_array_free(slot->events, TRUE);
+	slot->events = NULL;
+}
+
+static gpointer
+ra_worker(gpointer data)
+{
+	wtap *wth = (wtap *)data;
+	struct wtap_read_ahead *ra = wth->read_ahead;
+	ra_slot_t *slot;
+	gboolean ok;
+
+	do {
+		slot = (ra_slot_t *)g_async_queue_pop(ra->free_slots);
+		if (slot == (ra_slot_t *)ra) {
+			/* wtap_read_ahead_stop() */
+			break;
+		}
+
+		g_private_set(&ra_current_slot, slot);
+		g_mutex_lock(&ra->lock);
+		ok = wtap_read_direct(wth, &slot->rec, &slot->buf, &slot->err,
+		    &slot->err_info, &slot->offset);
+		slot->dsbs_len = wth->dsbs ? wth->dsbs->len : 0;
+		g_mutex_unlock(&ra->lock);
+		g_private_set(&ra_current_slot, NULL);
+
+		slot->ok = ok;
+		g_async_queue_push(ra->full_slots, slot);
+	} while (ok);
+
+	return NULL;
+}
+
+gboolean
+wtap_read_ahead_start(wtap *wth, guint depth)
+{
+	struct wtap_read_ahead *ra;
+	guint i;
+
+	if (wth == NULL || depth == 0)
+		return FALSE;
+	if (wth->read_ahead != NULL) {
+		/* Still handing out records read before it was stopped. */
+		return wth->read_ahead->thread != NULL;
+	}
+
+	ra = g_new0(struct wtap_read_ahead, 1);
+	g_mutex_init(&ra->lock);
+	ra->free_slots = g_async_queue_new();
+	ra->full_slots = g_async_queue_new();
+	ra->depth = depth;
+	ra->dsbs_delivered = wth->dsbs ? wth->dsbs->len : 0;
+	ra->slots = g_new0(ra_slot_t, depth);
+	for (i = 0; i < depth; i++) {
+		wtap_rec_init(&ra->slots[i].rec);
+		ws_buffer_init(&ra->slots[i].buf, 1514);
+		g_async_queue_push(ra->free_slots, &ra->slots[i]);
+	}
+
+	ra->add_new_ipv4 = wth->add_new_ipv4;
+	ra->add_new_ipv6 = wth->add_new_ipv6;
+	ra->add_new_secrets = wth->add_new_secrets;
+	ra_set_callbacks(wth, ra);
+
+	wth->read_ahead = ra;
+	ra->thread = g_thread_new("Read ahead", ra_worker, wth);
+	return TRUE;
+}
+
+static void
+ra_free(wtap *wth)
+{
+	struct wtap_read_ahead *ra = wth->read_ahead;
+	ra_slot_t *slot;
+	guint i;
+
+	while ((slot = (ra_slot_t *)g_async_queue_try_pop(ra->full_slots)) != NULL)
+		g_free(slot->err_info);
+	for (i = 0; i < ra->depth; i++) {
+		wtap_rec_cleanup(&ra->slots[i].rec);
+		ws_buffer_free(&ra->slots[i].buf);
+		if (ra->slots[i].events != NULL)
+			g_ptr_array_free(ra->slots[i].events, TRUE);
+	}
+	g_free(ra->slots);
+	g_async_queue_unref(ra->free_slots);
+	g_async_queue_unref(ra->full_slots);
+	g_mutex_clear(&ra->lock);
+	g_free(ra);
+	wth->read_ahead = NULL;
+}
+
+void
+wtap_read_ahead_stop(wtap *wth)
+{
+	struct wtap_read_ahead *ra;
+
+	if (wth == NULL || wth->read_ahead == NULL)
+		return;
+	ra = wth->read_ahead;
+
+	if (ra->thread != NULL) {
+		g_async_queue_push_front(ra->free_slots, ra);
+		g_thread_join(ra->thread);
+		ra->thread = NULL;
+
+		wth->add_new_ipv4 = ra->add_new_ipv4;
+		wth->add_new_ipv6 = ra->add_new_ipv6;
+		wth->add_new_secrets = ra->add_new_secrets;
+	}
+
+	/*
+	 * Records that have already been read are still handed out by
+	 * wtap_read(); free everything once there are none left.
+	 */
+	if (g_async_queue_length(ra->full_slots) <= 0)
+		ra_free(wth);
+}
+
+void
+wtap_read_ahead_discard(wtap *wth)
+{
+	if (wth->read_ahead == NULL)
+		return;
+	wtap_read_ahead_stop(wth);
+	if (wth->read_ahead != NULL)
+		ra_free(wth);
+}
+
+gboolean
+wtap_read_ahead_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+    gchar **err_info, gint64 *offset)
+{
+	struct wtap_read_ahead *ra = wth->read_ahead;
+	ra_slot_t *slot;
+	wtap_rec tmp_rec;
+	Buffer tmp_buf;
+	gboolean ok;
+
+	if (ra->thread != NULL)
+		slot = (ra_slot_t *)g_async_queue_pop(ra->full_slots);
+	else
+		slot = (ra_slot_t *)g_async_queue_try_pop(ra->full_slots);
+	if (slot == NULL) {
+		/* Stopped, and everything read ahead has been handed out. */
+		ra_free(wth);
+		return wtap_read_direct(wth, rec, buf, err, err_info, offset);
+	}
+
+	if (slot->events != NULL)
+		ra_replay_events(ra, slot);
+	ra->dsbs_delivered = slot->dsbs_len;
+
+	ok = slot->ok;
+	*err = slot->err;
+	*err_info = slot->err_info;
+	slot->err_info = NULL;
+	if (ok) {
+		tmp_rec = *rec;
+		*rec = slot->rec;
+		slot->rec = tmp_rec;
+		tmp_buf = *buf;
+		*buf = slot->buf;
+		slot->buf = tmp_buf;
+		*offset = slot->offset;
+		g_async_queue_push(ra->free_slots, slot);
+	} else {
+		/* The reader thread has finished. */
+		wtap_read_ahead_stop(wth);
+	}
+	return ok;
+}
+
+void
+wtap_read_ahead_update_callbacks(wtap *wth)
+{
+	struct wtap_read_ahead *ra = wth->read_ahead;
+
+	if (ra == NULL)
+		return;
+
+	/* Anything but our own callbacks was just set by the caller. */
+	if (wth->add_new_ipv4 != ra_new_ipv4)
+		ra->add_new_ipv4 = wth->add_new_ipv4;
+	if (wth->add_new_ipv6 != ra_new_ipv6)
+		ra->add_new_ipv6 = wth->add_new_ipv6;
+	if (wth->add_new_secrets != ra_new_secrets)
+		ra->add_new_secrets = wth->add_new_secrets;
+	if (ra->thread != NULL)
+		ra_set_callbacks(wth, ra);
+}
+
+guint
+wtap_read_ahead_dsbs_delivered(wtap *wth)
+{
+	if (wth->read_ahead == NULL)
+		return wth->dsbs ? wth->dsbs->len : 0;
+	return wth->read_ahead->dsbs_delivered;
+}
+
+void
+wtap_read_ahead_lock(wtap *wth)
+{
+	if (wth->read_ahead != NULL)
+		g_mutex_lock(&wth->read_ahead->lock);
+}
+
+void
+wtap_read_ahead_unlock(wtap *wth)
+{
+	if (wth->read_ahead != NULL)
+		g_mutex_unlock(&wth->read_ahead->lock);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
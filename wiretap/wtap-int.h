@@ -70,8 +70,28 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    struct wtap_read_ahead      *read_ahead;    /* NULL unless records are being read in another thread */
 };
 
+/*
+ * Read-ahead, in read_ahead.c. While it is active, the sequential stream
+ * and everything the file readers update (priv, interface_data, shb_hdrs,
+ * nrb_hdrs, dsbs) may only be used with the wtap locked.
+ */
+gboolean wtap_read_direct(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+    gchar **err_info, gint64 *offset);
+gboolean wtap_read_ahead_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+    gchar **err_info, gint64 *offset);
+/* Takes up callbacks just stored in the wtap, which must be locked. */
+void wtap_read_ahead_update_callbacks(wtap *wth);
+/* Stops reading ahead and drops any records not yet handed out. */
+void wtap_read_ahead_discard(wtap *wth);
+/* Number of DSBs, counting from the first, whose secrets have been passed
+ * on by wtap_read(); the wtap must be locked. */
+guint wtap_read_ahead_dsbs_delivered(wtap *wth);
+void wtap_read_ahead_lock(wtap *wth);
+void wtap_read_ahead_unlock(wtap *wth);
+
 struct wtap_dumper;
 
 /*
@@ -98,10 +98,19 @@ wtap_file_tsprec(wtap *wth)
 wtap_block_t
 wtap_file_get_shb(wtap *wth)
 {
-	if ((wth == NULL) || (wth->shb_hdrs == NULL) || (wth->shb_hdrs->len == 0))
+	wtap_block_t shb;
+
+	if (wth == NULL)
 		return NULL;
 
-	return g_array_index(wth->shb_hdrs, wtap_block_t, 0);
+	wtap_read_ahead_lock(wth);
+	if ((wth->shb_hdrs == NULL) || (wth->shb_hdrs->len == 0))
+		shb = NULL;
+	else
+		shb = g_array_index(wth->shb_hdrs, wtap_block_t, 0);
+	wtap_read_ahead_unlock(wth);
+
+	return shb;
 }
 
 GArray*
@@ -149,6 +158,19 @@ wtap_file_get_idb_info(wtap *wth)
 	return idb_info;
 }
 
+wtap_block_t
+wtap_file_get_idb(wtap *wth, guint interface_id)
+{
+	wtap_block_t idb = NULL;
+
+	wtap_read_ahead_lock(wth);
+	if (wth->interface_data != NULL && interface_id < wth->interface_data->len)
+		idb = g_array_index(wth->interface_data, wtap_block_t, interface_id);
+	wtap_read_ahead_unlock(wth);
+
+	return idb;
+}
+
 
 void
 wtap_free_idb_info(wtapng_iface_descriptions_t *idb_info)
@@ -281,10 +303,19 @@ wtap_get_debug_if_descr(const wtap_block_t if_descr,
 wtap_block_t
 wtap_file_get_nrb(wtap *wth)
 {
-	if ((wth == NULL) || (wth->nrb_hdrs == NULL) || (wth->nrb_hdrs->len == 0))
+	wtap_block_t nrb;
+
+	if (wth == NULL)
 		return NULL;
 
-	return g_array_index(wth->nrb_hdrs, wtap_block_t, 0);
+	wtap_read_ahead_lock(wth);
+	if ((wth->nrb_hdrs == NULL) || (wth->nrb_hdrs->len == 0))
+		nrb = NULL;
+	else
+		nrb = g_array_index(wth->nrb_hdrs, wtap_block_t, 0);
+	wtap_read_ahead_unlock(wth);
+
+	return nrb;
 }
 
 GArray*
@@ -1197,6 +1228,8 @@ wtap_strerror(int err)
 void
 wtap_sequential_close(wtap *wth)
 {
+	wtap_read_ahead_discard(wth);
+
 	if (wth->subtype_sequential_close != NULL)
 		(*wth->subtype_sequential_close)(wth);
 
@@ -1221,6 +1254,7 @@ g_fast_seek_item_free(gpointer data, gpointer user_data _U_)
 void
 wtap_fdclose(wtap *wth)
 {
+	wtap_read_ahead_stop(wth);
 	if (wth->fh != NULL)
 		file_fdclose(wth->fh);
 	if (wth->random_fh != NULL)
@@ -1256,17 +1290,38 @@ wtap_close(wtap *wth)
 void
 wtap_cleareof(wtap *wth) {
 	/* Reset EOF */
+	wtap_read_ahead_stop(wth);
+	wtap_read_ahead_lock(wth);
 	file_clearerr(wth->fh);
+	wtap_read_ahead_unlock(wth);
+}
+
+void
+wtap_set_shm_tail(wtap *wth, shm_tail_t *tail) {
+	wtap_read_ahead_lock(wth);
+	if (wth->fh != NULL)
+		file_set_shm_tail(wth->fh, tail);
+	if (wth->random_fh != NULL)
+		file_set_shm_tail(wth->random_fh, tail);
+	wtap_read_ahead_unlock(wth);
 }
 
 void wtap_set_cb_new_ipv4(wtap *wth, wtap_new_ipv4_callback_t add_new_ipv4) {
-	if (wth)
+	if (wth) {
+		wtap_read_ahead_lock(wth);
 		wth->add_new_ipv4 = add_new_ipv4;
+		wtap_read_ahead_update_callbacks(wth);
+		wtap_read_ahead_unlock(wth);
+	}
 }
 
 void wtap_set_cb_new_ipv6(wtap *wth, wtap_new_ipv6_callback_t add_new_ipv6) {
-	if (wth)
+	if (wth) {
+		wtap_read_ahead_lock(wth);
 		wth->add_new_ipv6 = add_new_ipv6;
+		wtap_read_ahead_update_callbacks(wth);
+		wtap_read_ahead_unlock(wth);
+	}
 }
 
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets) {
@@ -1274,16 +1329,27 @@ void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secr
 	if (!wth || !wth->dsbs)
 		return;
 
+	wtap_read_ahead_lock(wth);
 	wth->add_new_secrets = add_new_secrets;
+	wtap_read_ahead_update_callbacks(wth);
 	/*
 	 * Send all DSBs that were read so far to the new callback. file.c
 	 * relies on this to support redissection (during redissection, the
-	 * previous secrets are lost and has to be resupplied).
+	 * previous secrets are lost and has to be resupplied). DSBs read
+	 * ahead with records that wtap_read() has yet to return are left
+	 * out; they are passed on with their record.
 	 */
-	for (guint i = 0; i < wth->dsbs->len; i++) {
-		wtap_block_t dsb = g_array_index(wth->dsbs, wtap_block_t, i);
-		wtapng_process_dsb(wth, dsb);
+	if (add_new_secrets) {
+		guint delivered = wtap_read_ahead_dsbs_delivered(wth);
+
+		for (guint i = 0; i < delivered; i++) {
+			wtap_block_t dsb = g_array_index(wth->dsbs, wtap_block_t, i);
+			const wtapng_dsb_mandatory_t *dsb_mand = (wtapng_dsb_mandatory_t*)wtap_block_get_mandatory_data(dsb);
+
+			add_new_secrets(dsb_mand->secrets_type, dsb_mand->secrets_data, dsb_mand->secrets_len);
+		}
 	}
+	wtap_read_ahead_unlock(wth);
 }
 
 void
@@ -1298,6 +1364,16 @@ wtapng_process_dsb(wtap *wth, wtap_block_t dsb)
 gboolean
 wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	gchar **err_info, gint64 *offset)
+{
+	if (wth->read_ahead != NULL)
+		return wtap_read_ahead_read(wth, rec, buf, err, err_info, offset);
+
+	return wtap_read_direct(wth, rec, buf, err, err_info, offset);
+}
+
+gboolean
+wtap_read_direct(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+	gchar **err_info, gint64 *offset)
 {
 	/*
 	 * Set the packet encapsulation to the file's encapsulation
@@ -1438,7 +1514,12 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
 gint64
 wtap_read_so_far(wtap *wth)
 {
-	return file_tell_raw(wth->fh);
+	gint64 so_far;
+
+	wtap_read_ahead_lock(wth);
+	so_far = file_tell_raw(wth->fh);
+	wtap_read_ahead_unlock(wth);
+	return so_far;
 }
 
 void
@@ -1460,6 +1541,14 @@ gboolean
 wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info)
 {
+	gboolean ok;
+
+	/*
+	 * The file reader's state is shared with the sequential
+	 * stream, which may be in use by the read-ahead thread.
+	 */
+	wtap_read_ahead_lock(wth);
+
 	/*
 	 * Set the packet encapsulation to the file's encapsulation
 	 * value; if that's not WTAP_ENCAP_PER_PACKET, it's the
@@ -1475,7 +1564,9 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 
 	*err = 0;
 	*err_info = NULL;
-	if (!wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info))
+	ok = wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info);
+	wtap_read_ahead_unlock(wth);
+	if (!ok)
 		return FALSE;
 
 	/*
@@ -14,6 +14,7 @@
 #include <wsutil/buffer.h>
 #include <wsutil/nstime.h>
 #include <wsutil/inet_addr.h>
+#include <wsutil/shm_tail.h>
 #include "wtap_opttypes.h"
 #include "ws_symbol_export.h"
 #include "ws_attributes.h"
@@ -1744,6 +1745,14 @@ struct wtap* wtap_open_offline(const char *filename, unsigned int type, int *err
 WS_DLL_PUBLIC
 void wtap_cleareof(wtap *wth);
 
+/**
+ * The file is being written, and its end is mirrored in tail before it's
+ * written out; read what's there from there, rather than waiting for it
+ * to reach the file.
+ */
+WS_DLL_PUBLIC
+void wtap_set_shm_tail(wtap *wth, shm_tail_t *tail);
+
 /**
  * Set callback functions to add new hostnames. Currently pcapng-only.
  * MUST match add_ipv4_name and add_ipv6_name in addr_resolv.c.
@@ -1783,6 +1792,34 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/** Start reading records in a separate thread, so that the work of
+ * wtap_read() (I/O, decompression and parsing the file format) is done
+ * while the caller processes the records read before. wtap_read()
+ * returns the same records, and the new host name and secrets callbacks
+ * are called at the same points, from the calling thread, as without
+ * read-ahead.
+ *
+ * While records are read ahead, wtap_seek_read() and the functions that
+ * get blocks of the file other than wtap_file_get_idb_info() may be used
+ * as usual; they wait for the read in progress, if any. The interface,
+ * name resolution and decryption secrets blocks may be seen up to
+ * "depth" records earlier than without read-ahead.
+ *
+ * Read-ahead stops by itself at the end of the file or on an error.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @depth the number of records to read ahead.
+ * @return TRUE if records are being read ahead.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_ahead_start(wtap *wth, guint depth);
+
+/** Stop reading records ahead. Records already read are still returned
+ * by wtap_read(), in order, before it goes on reading the file itself.
+ */
+WS_DLL_PUBLIC
+void wtap_read_ahead_stop(wtap *wth);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1816,7 +1853,10 @@ void wtap_rec_cleanup(wtap_rec *rec);
  */
 typedef enum {
     WTAP_UNCOMPRESSED,
-    WTAP_GZIP_COMPRESSED
+    WTAP_GZIP_COMPRESSED,
+    WTAP_ZSTD_COMPRESSED,
+    WTAP_LZ4_COMPRESSED,
+    WTAP_UNKNOWN_COMPRESSION
 } wtap_compression_type;
 
 WS_DLL_PUBLIC
@@ -1828,6 +1868,24 @@ const char *wtap_compression_type_extension(wtap_compression_type compression_ty
 WS_DLL_PUBLIC
 GSList *wtap_get_all_compression_type_extensions_list(void);
 
+/**
+ * @brief Get the compression type with the given name.
+ * @details The names are "gzip", "zstd" and "lz4", for those this build
+ * can read and write, and "none".
+ *
+ * @return The compression type, or WTAP_UNKNOWN_COMPRESSION if there is
+ * no such compression type or it isn't supported.
+ */
+WS_DLL_PUBLIC
+wtap_compression_type wtap_name_to_compression_type(const char *name);
+
+/**
+ * @brief Get the names of the compression types that can be written.
+ * @details The list, but not the names, must be freed with g_slist_free().
+ */
+WS_DLL_PUBLIC
+GSList *wtap_get_all_output_compression_type_names_list(void);
+
 /*** get various information snippets about the current file ***/
 
 /** Return an approximation of the amount of data we've read sequentially
@@ -1902,6 +1960,19 @@ void wtap_write_shb_comment(wtap *wth, gchar *comment);
 WS_DLL_PUBLIC
 wtapng_iface_descriptions_t *wtap_file_get_idb_info(wtap *wth);
 
+/**
+ * @brief Gets an existing interface description.
+ * @details Unlike wtap_file_get_idb_info(), this may be used while
+ *          records are being read ahead.
+ *
+ * @param wth The wiretap session.
+ * @param interface_id The interface ID.
+ * @return The interface description, or NULL if none has been read for
+ *         that ID.
+ */
+WS_DLL_PUBLIC
+wtap_block_t wtap_file_get_idb(wtap *wth, guint interface_id);
+
 /**
  * @brief Free's a interface description block and all of its members.
  *
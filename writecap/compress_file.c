@@ -0,0 +1,335 @@
+/* compress_file.c
+ * Our routines for compressing complete capture files.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include <glib.h>
+
+#ifdef HAVE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif
+
+#include <wsutil/file_util.h>
+
+#include "compress_file.h"
+
+/* Uncompressed data per zstd or LZ4 frame, and per read of the input;
+   the same as libwiretap's, so that it seeks the same way in our files. */
+#define FRAME_SPAN      (1024 * 1024)
+
+static const struct {
+    compress_file_type_t  type;
+    const char           *name;
+    const char           *extension;
+} compress_file_types[] = {
+#ifdef HAVE_ZLIB
+    { COMPRESS_FILE_GZIP, "gzip", "gz" },
+#endif
+#ifdef HAVE_ZSTD
+    { COMPRESS_FILE_ZSTD, "zstd", "zst" },
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    { COMPRESS_FILE_LZ4,  "lz4",  "lz4" },
+#endif
+    { COMPRESS_FILE_NONE, NULL,   NULL }
+};
+
+gboolean
+compress_file_type_from_name(const char *name, compress_file_type_t *type)
+{
+    guint i;
+
+    for (i = 0; compress_file_types[i].name != NULL; i++) {
+        if (strcmp(name, compress_file_types[i].name) == 0) {
+            *type = compress_file_types[i].type;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+GSList *
+compress_file_type_names(void)
+{
+    GSList *names = NULL;
+    guint i;
+
+    for (i = 0; compress_file_types[i].name != NULL; i++)
+        names = g_slist_append(names, (gpointer)compress_file_types[i].name);
+    return names;
+}
+
+const char *
+compress_file_type_extension(compress_file_type_t type)
+{
+    guint i;
+
+    for (i = 0; compress_file_types[i].name != NULL; i++) {
+        if (compress_file_types[i].type == type)
+            return compress_file_types[i].extension;
+    }
+    return NULL;
+}
+
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+/* Write all of buf; returns 0 or an errno value. */
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+    ssize_t got;
+
+    while (len != 0) {
+        got = ws_write(fd, buf, (unsigned int)MIN(len, G_MAXINT));
+        if (got < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        buf = (const char *)buf + got;
+        len -= (size_t)got;
+    }
+    return 0;
+}
+
+/* Read as much of buf as the file has left; returns the length read, or
+   -1 with errno set. */
+static ssize_t
+read_full(int fd, void *buf, size_t len)
+{
+    size_t have = 0;
+    ssize_t got;
+
+    while (have < len) {
+        got = ws_read(fd, (char *)buf + have, (unsigned int)(len - have));
+        if (got < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (got == 0)
+            break;
+        have += (size_t)got;
+    }
+    return (ssize_t)have;
+}
+#endif
+
+#ifdef HAVE_ZLIB
+static int
+compress_gzip(int in_fd, int out_fd, guint8 *in, guint8 *out, size_t out_size)
+{
+    z_stream strm;
+    ssize_t nread;
+    int flush;
+    int ret;
+    int err = 0;
+
+    memset(&strm, 0, sizeof strm);
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return ENOMEM;
+
+    do {
+        nread = read_full(in_fd, in, FRAME_SPAN);
+        if (nread < 0) {
+            err = errno;
+            break;
+        }
+        flush = nread < FRAME_SPAN ? Z_FINISH : Z_NO_FLUSH;
+        strm.next_in = in;
+        strm.avail_in = (uInt)nread;
+        do {
+            strm.next_out = out;
+            strm.avail_out = (uInt)out_size;
+            ret = deflate(&strm, flush);
+            if (ret == Z_STREAM_ERROR) {
+                err = EINVAL;
+                break;
+            }
+            err = write_all(out_fd, out, out_size - strm.avail_out);
+        } while (err == 0 && strm.avail_out == 0);
+    } while (err == 0 && flush != Z_FINISH);
+
+    deflateEnd(&strm);
+    return err;
+}
+#endif
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+#ifdef HAVE_LZ4FRAME_H
+static void
+lz4_frame_prefs(LZ4F_preferences_t *prefs, size_t len)
+{
+    memset(prefs, 0, sizeof *prefs);
+    prefs->frameInfo.blockSizeID = LZ4F_max1MB;
+    prefs->frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    prefs->frameInfo.contentSize = len;
+}
+#endif
+
+/* Writes each FRAME_SPAN bytes of the input as a frame of its own. */
+static int
+compress_frames(int in_fd, int out_fd, compress_file_type_t type,
+                guint8 *in, guint8 *out, size_t out_size)
+{
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *cctx = NULL;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_preferences_t prefs;
+#endif
+    ssize_t nread;
+    size_t len;
+    int err = 0;
+
+#ifdef HAVE_ZSTD
+    if (type == COMPRESS_FILE_ZSTD) {
+        cctx = ZSTD_createCCtx();
+        if (cctx == NULL)
+            return ENOMEM;
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    }
+#endif
+
+    while (err == 0 && (nread = read_full(in_fd, in, FRAME_SPAN)) != 0) {
+        if (nread < 0) {
+            err = errno;
+            break;
+        }
+        switch (type) {
+
+#ifdef HAVE_ZSTD
+        case COMPRESS_FILE_ZSTD:
+            len = ZSTD_compress2(cctx, out, out_size, in, (size_t)nread);
+            if (ZSTD_isError(len))
+                err = EINVAL;
+            break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+        case COMPRESS_FILE_LZ4:
+            lz4_frame_prefs(&prefs, (size_t)nread);
+            len = LZ4F_compressFrame(out, out_size, in, (size_t)nread, &prefs);
+            if (LZ4F_isError(len))
+                err = EINVAL;
+            break;
+#endif
+
+        default:
+            len = 0;
+            err = EINVAL;
+            break;
+        }
+        if (err == 0)
+            err = write_all(out_fd, out, len);
+    }
+
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(cctx);
+#endif
+    return err;
+}
+#endif
+
+int
+compress_file(const char *in_path, int out_fd, compress_file_type_t type)
+{
+    int in_fd;
+    guint8 *in;
+    guint8 *out;
+    size_t out_size;
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_preferences_t prefs;
+#endif
+    int err;
+
+    switch (type) {
+
+#ifdef HAVE_ZLIB
+    case COMPRESS_FILE_GZIP:
+        out_size = FRAME_SPAN;
+        break;
+#endif
+
+#ifdef HAVE_ZSTD
+    case COMPRESS_FILE_ZSTD:
+        out_size = ZSTD_compressBound(FRAME_SPAN);
+        break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case COMPRESS_FILE_LZ4:
+        lz4_frame_prefs(&prefs, FRAME_SPAN);
+        out_size = LZ4F_compressFrameBound(FRAME_SPAN, &prefs);
+        break;
+#endif
+
+    default:
+        ws_close(out_fd);
+        return EINVAL;
+    }
+
+    in_fd = ws_open(in_path, O_RDONLY|O_BINARY, 0000);
+    if (in_fd == -1) {
+        err = errno;
+        ws_close(out_fd);
+        return err;
+    }
+
+    in = (guint8 *)g_malloc(FRAME_SPAN);
+    out = (guint8 *)g_malloc(out_size);
+#ifdef HAVE_ZLIB
+    if (type == COMPRESS_FILE_GZIP)
+        err = compress_gzip(in_fd, out_fd, in, out, out_size);
+    else
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+        err = compress_frames(in_fd, out_fd, type, in, out, out_size);
+#else
+        err = EINVAL;
+#endif
+    g_free(out);
+    g_free(in);
+    ws_close(in_fd);
+
+    if (ws_close(out_fd) == -1 && err == 0)
+        err = errno;
+    return err;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,63 @@
+/* compress_file.h
+ * Declarations of our routines for compressing complete capture files.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __COMPRESS_FILE_H__
+#define __COMPRESS_FILE_H__
+
+#include <glib.h>
+
+/*
+ * Compresses a capture file that has been written out, so that dumpcap
+ * can compress its ring buffer files without linking with libwiretap.
+ * The files are written the way libwiretap writes them: zstd and LZ4
+ * files as a series of independent frames of 1 MiB of uncompressed data
+ * each, so that readers can seek in them.
+ */
+typedef enum {
+    COMPRESS_FILE_NONE,
+    COMPRESS_FILE_GZIP,
+    COMPRESS_FILE_ZSTD,
+    COMPRESS_FILE_LZ4
+} compress_file_type_t;
+
+/** Look up a compression type by name ("gzip", "zstd" or "lz4").
+   Returns FALSE if it isn't known, or isn't supported by this build. */
+extern gboolean
+compress_file_type_from_name(const char *name, compress_file_type_t *type);
+
+/** The names of the compression types this build supports; free the list,
+   but not the names, with g_slist_free(). */
+extern GSList *
+compress_file_type_names(void);
+
+/** The file name extension for a compression type, without the dot, or
+   NULL for COMPRESS_FILE_NONE. */
+extern const char *
+compress_file_type_extension(compress_file_type_t type);
+
+/** Write the file at in_path, compressed, to out_fd, and close out_fd.
+   Returns 0 on success, or an errno value. */
+extern int
+compress_file(const char *in_path, int out_fd, compress_file_type_t type);
+
+#endif /* __COMPRESS_FILE_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -41,6 +41,7 @@
 
 #include <glib.h>
 
+#include "pcapio_writer.h"
 #include "pcapio.h"
 
 /* Magic numbers in "libpcap" files.
@@ -164,16 +165,29 @@ struct option {
 #define ISB_USRDELIV      8
 #define ADD_PADDING(x) ((((x) + 3) >> 2) << 2)
 
+/* Where we write: a standard I/O stream or one of our writers */
+typedef struct {
+        FILE *pfile;
+        pcapio_writer_t *writer;
+} pcapio_sink_t;
+
 /* Write to capture file */
 static gboolean
-write_to_file(FILE* pfile, const guint8* data, size_t data_length,
+write_to_file(const pcapio_sink_t *sink, const guint8* data, size_t data_length,
               guint64 *bytes_written, int *err)
 {
         size_t nwritten;
 
-        nwritten = fwrite(data, data_length, 1, pfile);
+        if (sink->writer != NULL) {
+                if (!pcapio_writer_write(sink->writer, data, data_length, err))
+                        return FALSE;
+                (*bytes_written) += data_length;
+                return TRUE;
+        }
+
+        nwritten = fwrite(data, data_length, 1, sink->pfile);
         if (nwritten != 1) {
-                if (ferror(pfile)) {
+                if (ferror(sink->pfile)) {
                         *err = errno;
                 } else {
                         *err = 0;
@@ -190,8 +204,8 @@ write_to_file(FILE* pfile, const guint8* data, size_t data_length,
 /* Write the file header to a dump file.
    Returns TRUE on success, FALSE on failure.
    Sets "*err" to an error code, or 0 for a short write, on failure*/
-gboolean
-libpcap_write_file_header(FILE* pfile, int linktype, int snaplen, gboolean ts_nsecs, guint64 *bytes_written, int *err)
+static gboolean
+libpcap_write_file_header_to_sink(const pcapio_sink_t *sink, int linktype, int snaplen, gboolean ts_nsecs, guint64 *bytes_written, int *err)
 {
         struct pcap_hdr file_hdr;
 
@@ -204,17 +218,17 @@ libpcap_write_file_header(FILE* pfile, int linktype, int snaplen, gboolean ts_ns
         file_hdr.snaplen = snaplen;
         file_hdr.network = linktype;
 
-        return write_to_file(pfile, (const guint8*)&file_hdr, sizeof(file_hdr), bytes_written, err);
+        return write_to_file(sink, (const guint8*)&file_hdr, sizeof(file_hdr), bytes_written, err);
 }
 
 /* Write a record for a packet to a dump file.
    Returns TRUE on success, FALSE on failure. */
-gboolean
-libpcap_write_packet(FILE* pfile,
-                     time_t sec, guint32 usec,
-                     guint32 caplen, guint32 len,
-                     const guint8 *pd,
-                     guint64 *bytes_written, int *err)
+static gboolean
+libpcap_write_packet_to_sink(const pcapio_sink_t *sink,
+                             time_t sec, guint32 usec,
+                             guint32 caplen, guint32 len,
+                             const guint8 *pd,
+                             guint64 *bytes_written, int *err)
 {
         struct pcaprec_hdr rec_hdr;
 
@@ -222,10 +236,10 @@ libpcap_write_packet(FILE* pfile,
         rec_hdr.ts_usec = usec;
         rec_hdr.incl_len = caplen;
         rec_hdr.orig_len = len;
-        if (!write_to_file(pfile, (const guint8*)&rec_hdr, sizeof(rec_hdr), bytes_written, err))
+        if (!write_to_file(sink, (const guint8*)&rec_hdr, sizeof(rec_hdr), bytes_written, err))
                 return FALSE;
 
-        return write_to_file(pfile, pd, caplen, bytes_written, err);
+        return write_to_file(sink, pd, caplen, bytes_written, err);
 }
 
 /* Writing pcapng files */
@@ -242,7 +256,7 @@ pcapng_count_string_option(const char *option_value)
 }
 
 static gboolean
-pcapng_write_string_option(FILE* pfile,
+pcapng_write_string_option(const pcapio_sink_t *sink,
                            guint16 option_type, const char *option_value,
                            guint64 *bytes_written, int *err)
 {
@@ -258,14 +272,14 @@ pcapng_write_string_option(FILE* pfile,
                 option.type = option_type;
                 option.value_length = (guint16)option_value_length;
 
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)option_value, (int) option_value_length, bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)option_value, (int) option_value_length, bytes_written, err))
                         return FALSE;
 
                 if (option_value_length % 4) {
-                        if (!write_to_file(pfile, (const guint8*)&padding, 4 - option_value_length % 4, bytes_written, err))
+                        if (!write_to_file(sink, (const guint8*)&padding, 4 - option_value_length % 4, bytes_written, err))
                                 return FALSE;
                 }
         }
@@ -273,12 +287,12 @@ pcapng_write_string_option(FILE* pfile,
 }
 
 /* Write a pre-formatted pcapng block directly to the output file */
-gboolean
-pcapng_write_block(FILE* pfile,
-                   const guint8 *data,
-                   guint32 length,
-                   guint64 *bytes_written,
-                   int *err)
+static gboolean
+pcapng_write_block_to_sink(const pcapio_sink_t *sink,
+                           const guint8 *data,
+                           guint32 length,
+                           guint64 *bytes_written,
+                           int *err)
 {
     guint32 block_length, end_length;
     /* Check
@@ -299,18 +313,18 @@ pcapng_write_block(FILE* pfile,
         *err = EBADMSG;
         return FALSE;
     }
-    return write_to_file(pfile, data, length, bytes_written, err);
+    return write_to_file(sink, data, length, bytes_written, err);
 }
 
-gboolean
-pcapng_write_section_header_block(FILE* pfile,
-                                  const char *comment,
-                                  const char *hw,
-                                  const char *os,
-                                  const char *appname,
-                                  guint64 section_length,
-                                  guint64 *bytes_written,
-                                  int *err)
+static gboolean
+pcapng_write_section_header_block_to_sink(const pcapio_sink_t *sink,
+                                          const char *comment,
+                                          const char *hw,
+                                          const char *os,
+                                          const char *appname,
+                                          guint64 section_length,
+                                          guint64 *bytes_written,
+                                          int *err)
 {
         struct shb shb;
         struct option option;
@@ -339,46 +353,46 @@ pcapng_write_section_header_block(FILE* pfile,
         shb.minor_version = PCAPNG_MINOR_VERSION;
         shb.section_length = section_length;
 
-        if (!write_to_file(pfile, (const guint8*)&shb, sizeof(struct shb), bytes_written, err))
+        if (!write_to_file(sink, (const guint8*)&shb, sizeof(struct shb), bytes_written, err))
                 return FALSE;
 
-        if (!pcapng_write_string_option(pfile, OPT_COMMENT, comment,
+        if (!pcapng_write_string_option(sink, OPT_COMMENT, comment,
                                         bytes_written, err))
                 return FALSE;
-        if (!pcapng_write_string_option(pfile, SHB_HARDWARE, hw,
+        if (!pcapng_write_string_option(sink, SHB_HARDWARE, hw,
                                         bytes_written, err))
                 return FALSE;
-        if (!pcapng_write_string_option(pfile, SHB_OS, os,
+        if (!pcapng_write_string_option(sink, SHB_OS, os,
                                         bytes_written, err))
                 return FALSE;
-        if (!pcapng_write_string_option(pfile, SHB_USERAPPL, appname,
+        if (!pcapng_write_string_option(sink, SHB_USERAPPL, appname,
                                         bytes_written, err))
                 return FALSE;
         if (options_length != 0) {
                 /* write end of options */
                 option.type = OPT_ENDOFOPT;
                 option.value_length = 0;
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
         }
 
         /* write the trailing block total length */
-        return write_to_file(pfile, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+        return write_to_file(sink, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
 }
 
-gboolean
-pcapng_write_interface_description_block(FILE* pfile,
-                                         const char *comment, /* OPT_COMMENT        1 */
-                                         const char *name,    /* IDB_NAME           2 */
-                                         const char *descr,   /* IDB_DESCRIPTION    3 */
-                                         const char *filter,  /* IDB_FILTER        11 */
-                                         const char *os,      /* IDB_OS            12 */
-                                         int link_type,
-                                         int snap_len,
-                                         guint64 *bytes_written,
-                                         guint64 if_speed,    /* IDB_IF_SPEED       8 */
-                                         guint8 tsresol,      /* IDB_TSRESOL        9 */
-                                         int *err)
+static gboolean
+pcapng_write_interface_description_block_to_sink(const pcapio_sink_t *sink,
+                                                 const char *comment, /* OPT_COMMENT        1 */
+                                                 const char *name,    /* IDB_NAME           2 */
+                                                 const char *descr,   /* IDB_DESCRIPTION    3 */
+                                                 const char *filter,  /* IDB_FILTER        11 */
+                                                 const char *os,      /* IDB_OS            12 */
+                                                 int link_type,
+                                                 int snap_len,
+                                                 guint64 *bytes_written,
+                                                 guint64 if_speed,    /* IDB_IF_SPEED       8 */
+                                                 guint8 tsresol,      /* IDB_TSRESOL        9 */
+                                                 int *err)
 {
         struct idb idb;
         struct option option;
@@ -431,22 +445,22 @@ pcapng_write_interface_description_block(FILE* pfile,
         idb.link_type = link_type;
         idb.reserved = 0;
         idb.snap_len = snap_len;
-        if (!write_to_file(pfile, (const guint8*)&idb, sizeof(struct idb), bytes_written, err))
+        if (!write_to_file(sink, (const guint8*)&idb, sizeof(struct idb), bytes_written, err))
                 return FALSE;
 
         /* 01 - OPT_COMMENT - write comment string if applicable */
-        if (!pcapng_write_string_option(pfile, OPT_COMMENT, comment,
+        if (!pcapng_write_string_option(sink, OPT_COMMENT, comment,
                                         bytes_written, err))
                 return FALSE;
 
         /* 02 - IDB_NAME - write interface name string if applicable */
-        if (!pcapng_write_string_option(pfile, IDB_NAME, name,
+        if (!pcapng_write_string_option(sink, IDB_NAME, name,
                                         bytes_written, err))
                 return FALSE;
 
         /* 03 - IDB_DESCRIPTION */
         /* write interface description string if applicable */
-        if (!pcapng_write_string_option(pfile, IDB_DESCRIPTION, descr,
+        if (!pcapng_write_string_option(sink, IDB_DESCRIPTION, descr,
                                         bytes_written, err))
                 return FALSE;
 
@@ -455,10 +469,10 @@ pcapng_write_interface_description_block(FILE* pfile,
                 option.type = IDB_IF_SPEED;
                 option.value_length = sizeof(guint64);
 
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&if_speed, sizeof(guint64), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&if_speed, sizeof(guint64), bytes_written, err))
                         return FALSE;
         }
 
@@ -467,13 +481,13 @@ pcapng_write_interface_description_block(FILE* pfile,
                 option.type = IDB_TSRESOL;
                 option.value_length = sizeof(guint8);
 
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&tsresol, sizeof(guint8), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&tsresol, sizeof(guint8), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&padding, 3, bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&padding, 3, bytes_written, err))
                         return FALSE;
         }
 
@@ -483,22 +497,22 @@ pcapng_write_interface_description_block(FILE* pfile,
         if ((filter != NULL) && (strlen(filter) > 0) && (strlen(filter) < G_MAXUINT16 - 1)) {
                 option.type = IDB_FILTER;
                 option.value_length = (guint16)(strlen(filter) + 1 );
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
                 /* The first byte of the Option Data keeps a code of the filter used, 0 = lipbpcap filter string */
-                if (!write_to_file(pfile, (const guint8*)&padding, 1, bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&padding, 1, bytes_written, err))
                         return FALSE;
-                if (!write_to_file(pfile, (const guint8*)filter, (int) strlen(filter), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)filter, (int) strlen(filter), bytes_written, err))
                         return FALSE;
                 if ((strlen(filter) + 1) % 4) {
-                        if (!write_to_file(pfile, (const guint8*)&padding, 4 - (strlen(filter) + 1) % 4, bytes_written, err))
+                        if (!write_to_file(sink, (const guint8*)&padding, 4 - (strlen(filter) + 1) % 4, bytes_written, err))
                                 return FALSE;
                 }
         }
 
         /* 12 - IDB_OS - write os string if applicable */
-        if (!pcapng_write_string_option(pfile, IDB_OS, os,
+        if (!pcapng_write_string_option(sink, IDB_OS, os,
                                         bytes_written, err))
                 return FALSE;
 
@@ -506,27 +520,27 @@ pcapng_write_interface_description_block(FILE* pfile,
                 /* write end of options */
                 option.type = OPT_ENDOFOPT;
                 option.value_length = 0;
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
         }
 
         /* write the trailing Block Total Length */
-        return write_to_file(pfile, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+        return write_to_file(sink, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
 }
 
 /* Write a record for a packet to a dump file.
    Returns TRUE on success, FALSE on failure. */
-gboolean
-pcapng_write_enhanced_packet_block(FILE* pfile,
-                                   const char *comment,
-                                   time_t sec, guint32 usec,
-                                   guint32 caplen, guint32 len,
-                                   guint32 interface_id,
-                                   guint ts_mul,
-                                   const guint8 *pd,
-                                   guint32 flags,
-                                   guint64 *bytes_written,
-                                   int *err)
+static gboolean
+pcapng_write_enhanced_packet_block_to_sink(const pcapio_sink_t *sink,
+                                           const char *comment,
+                                           time_t sec, guint32 usec,
+                                           guint32 caplen, guint32 len,
+                                           guint32 interface_id,
+                                           guint ts_mul,
+                                           const guint8 *pd,
+                                           guint32 flags,
+                                           guint64 *bytes_written,
+                                           int *err)
 {
         struct epb epb;
         struct option option;
@@ -560,9 +574,9 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
         epb.timestamp_low = (guint32)(timestamp & 0xffffffff);
         epb.captured_len = caplen;
         epb.packet_len = len;
-        if (!write_to_file(pfile, (const guint8*)&epb, sizeof(struct epb), bytes_written, err))
+        if (!write_to_file(sink, (const guint8*)&epb, sizeof(struct epb), bytes_written, err))
                 return FALSE;
-        if (!write_to_file(pfile, pd, caplen, bytes_written, err))
+        if (!write_to_file(sink, pd, caplen, bytes_written, err))
                 return FALSE;
         /* Use more efficient write in case of no "extras" */
         if(caplen % 4) {
@@ -580,44 +594,44 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
             /* Write the total length */
             memcpy(&buff[i], &block_total_length, sizeof(guint32));
             i += sizeof(guint32);
-            return write_to_file(pfile, (const guint8*)&buff, i, bytes_written, err);
+            return write_to_file(sink, (const guint8*)&buff, i, bytes_written, err);
         }
         if (pad_len) {
-                if (!write_to_file(pfile, (const guint8*)&padding, pad_len, bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&padding, pad_len, bytes_written, err))
                         return FALSE;
         }
-        if (!pcapng_write_string_option(pfile, OPT_COMMENT, comment,
+        if (!pcapng_write_string_option(sink, OPT_COMMENT, comment,
                                         bytes_written, err))
                 return FALSE;
         if (flags != 0) {
                 option.type = EPB_FLAGS;
                 option.value_length = sizeof(guint32);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
-                if (!write_to_file(pfile, (const guint8*)&flags, sizeof(guint32), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&flags, sizeof(guint32), bytes_written, err))
                         return FALSE;
         }
         if (options_length != 0) {
                 /* write end of options */
                 option.type = OPT_ENDOFOPT;
                 option.value_length = 0;
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
         }
 
-       return write_to_file(pfile, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+       return write_to_file(sink, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
 }
 
-gboolean
-pcapng_write_interface_statistics_block(FILE* pfile,
-                                        guint32 interface_id,
-                                        guint64 *bytes_written,
-                                        const char *comment,   /* OPT_COMMENT           1 */
-                                        guint64 isb_starttime, /* ISB_STARTTIME         2 */
-                                        guint64 isb_endtime,   /* ISB_ENDTIME           3 */
-                                        guint64 isb_ifrecv,    /* ISB_IFRECV            4 */
-                                        guint64 isb_ifdrop,    /* ISB_IFDROP            5 */
-                                        int *err)
+static gboolean
+pcapng_write_interface_statistics_block_to_sink(const pcapio_sink_t *sink,
+                                                guint32 interface_id,
+                                                guint64 *bytes_written,
+                                                const char *comment,   /* OPT_COMMENT           1 */
+                                                guint64 isb_starttime, /* ISB_STARTTIME         2 */
+                                                guint64 isb_endtime,   /* ISB_ENDTIME           3 */
+                                                guint64 isb_ifrecv,    /* ISB_IFRECV            4 */
+                                                guint64 isb_ifdrop,    /* ISB_IFDROP            5 */
+                                                int *err)
 {
         struct isb isb;
 #ifdef _WIN32
@@ -700,11 +714,11 @@ pcapng_write_interface_statistics_block(FILE* pfile,
         isb.interface_id = interface_id;
         isb.timestamp_high = (guint32)((timestamp>>32) & 0xffffffff);
         isb.timestamp_low = (guint32)(timestamp & 0xffffffff);
-        if (!write_to_file(pfile, (const guint8*)&isb, sizeof(struct isb), bytes_written, err))
+        if (!write_to_file(sink, (const guint8*)&isb, sizeof(struct isb), bytes_written, err))
                 return FALSE;
 
         /* write comment string if applicable */
-        if (!pcapng_write_string_option(pfile, OPT_COMMENT, comment,
+        if (!pcapng_write_string_option(sink, OPT_COMMENT, comment,
                                         bytes_written, err))
                 return FALSE;
 
@@ -715,13 +729,13 @@ pcapng_write_interface_statistics_block(FILE* pfile,
                 option.value_length = sizeof(guint64);
                 high = (guint32)((isb_starttime>>32) & 0xffffffff);
                 low = (guint32)(isb_starttime & 0xffffffff);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&high, sizeof(guint32), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&high, sizeof(guint32), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&low, sizeof(guint32), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&low, sizeof(guint32), bytes_written, err))
                         return FALSE;
         }
         if (isb_endtime !=0) {
@@ -731,42 +745,242 @@ pcapng_write_interface_statistics_block(FILE* pfile,
                 option.value_length = sizeof(guint64);
                 high = (guint32)((isb_endtime>>32) & 0xffffffff);
                 low = (guint32)(isb_endtime & 0xffffffff);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&high, sizeof(guint32), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&high, sizeof(guint32), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&low, sizeof(guint32), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&low, sizeof(guint32), bytes_written, err))
                         return FALSE;
         }
         if (isb_ifrecv != G_MAXUINT64) {
                 option.type = ISB_IFRECV;
                 option.value_length = sizeof(guint64);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&isb_ifrecv, sizeof(guint64), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&isb_ifrecv, sizeof(guint64), bytes_written, err))
                         return FALSE;
         }
         if (isb_ifdrop != G_MAXUINT64) {
                 option.type = ISB_IFDROP;
                 option.value_length = sizeof(guint64);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
 
-                if (!write_to_file(pfile, (const guint8*)&isb_ifdrop, sizeof(guint64), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&isb_ifdrop, sizeof(guint64), bytes_written, err))
                         return FALSE;
         }
         if (options_length != 0) {
                 /* write end of options */
                 option.type = OPT_ENDOFOPT;
                 option.value_length = 0;
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct option), bytes_written, err))
+                if (!write_to_file(sink, (const guint8*)&option, sizeof(struct option), bytes_written, err))
                         return FALSE;
         }
 
-        return write_to_file(pfile, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+        return write_to_file(sink, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+}
+
+/* Public entry points, for standard I/O streams and for our writers */
+
+gboolean
+libpcap_write_file_header(FILE* pfile, int linktype, int snaplen, gboolean ts_nsecs, guint64 *bytes_written, int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return libpcap_write_file_header_to_sink(&sink, linktype, snaplen, ts_nsecs, bytes_written, err);
+}
+
+gboolean
+libpcap_write_file_header_to_writer(pcapio_writer_t *writer, int linktype, int snaplen, gboolean ts_nsecs, guint64 *bytes_written, int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return libpcap_write_file_header_to_sink(&sink, linktype, snaplen, ts_nsecs, bytes_written, err);
+}
+
+gboolean
+libpcap_write_packet(FILE* pfile,
+                     time_t sec, guint32 usec,
+                     guint32 caplen, guint32 len,
+                     const guint8 *pd,
+                     guint64 *bytes_written, int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return libpcap_write_packet_to_sink(&sink, sec, usec, caplen, len, pd, bytes_written, err);
+}
+
+gboolean
+libpcap_write_packet_to_writer(pcapio_writer_t *writer,
+                               time_t sec, guint32 usec,
+                               guint32 caplen, guint32 len,
+                               const guint8 *pd,
+                               guint64 *bytes_written, int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return libpcap_write_packet_to_sink(&sink, sec, usec, caplen, len, pd, bytes_written, err);
+}
+
+gboolean
+pcapng_write_block(FILE* pfile,
+                   const guint8 *data,
+                   guint32 length,
+                   guint64 *bytes_written,
+                   int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return pcapng_write_block_to_sink(&sink, data, length, bytes_written, err);
+}
+
+gboolean
+pcapng_write_block_to_writer(pcapio_writer_t *writer,
+                             const guint8 *data,
+                             guint32 length,
+                             guint64 *bytes_written,
+                             int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return pcapng_write_block_to_sink(&sink, data, length, bytes_written, err);
+}
+
+gboolean
+pcapng_write_section_header_block(FILE* pfile,
+                                  const char *comment,
+                                  const char *hw,
+                                  const char *os,
+                                  const char *appname,
+                                  guint64 section_length,
+                                  guint64 *bytes_written,
+                                  int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return pcapng_write_section_header_block_to_sink(&sink, comment, hw, os, appname, section_length, bytes_written, err);
+}
+
+gboolean
+pcapng_write_section_header_block_to_writer(pcapio_writer_t *writer,
+                                            const char *comment,
+                                            const char *hw,
+                                            const char *os,
+                                            const char *appname,
+                                            guint64 section_length,
+                                            guint64 *bytes_written,
+                                            int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return pcapng_write_section_header_block_to_sink(&sink, comment, hw, os, appname, section_length, bytes_written, err);
+}
+
+gboolean
+pcapng_write_interface_description_block(FILE* pfile,
+                                         const char *comment,
+                                         const char *name,
+                                         const char *descr,
+                                         const char *filter,
+                                         const char *os,
+                                         int link_type,
+                                         int snap_len,
+                                         guint64 *bytes_written,
+                                         guint64 if_speed,
+                                         guint8 tsresol,
+                                         int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return pcapng_write_interface_description_block_to_sink(&sink, comment, name, descr, filter, os, link_type, snap_len, bytes_written, if_speed, tsresol, err);
+}
+
+gboolean
+pcapng_write_interface_description_block_to_writer(pcapio_writer_t *writer,
+                                                   const char *comment,
+                                                   const char *name,
+                                                   const char *descr,
+                                                   const char *filter,
+                                                   const char *os,
+                                                   int link_type,
+                                                   int snap_len,
+                                                   guint64 *bytes_written,
+                                                   guint64 if_speed,
+                                                   guint8 tsresol,
+                                                   int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return pcapng_write_interface_description_block_to_sink(&sink, comment, name, descr, filter, os, link_type, snap_len, bytes_written, if_speed, tsresol, err);
+}
+
+gboolean
+pcapng_write_enhanced_packet_block(FILE* pfile,
+                                   const char *comment,
+                                   time_t sec, guint32 usec,
+                                   guint32 caplen, guint32 len,
+                                   guint32 interface_id,
+                                   guint ts_mul,
+                                   const guint8 *pd,
+                                   guint32 flags,
+                                   guint64 *bytes_written,
+                                   int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return pcapng_write_enhanced_packet_block_to_sink(&sink, comment, sec, usec, caplen, len, interface_id, ts_mul, pd, flags, bytes_written, err);
+}
+
+gboolean
+pcapng_write_enhanced_packet_block_to_writer(pcapio_writer_t *writer,
+                                             const char *comment,
+                                             time_t sec, guint32 usec,
+                                             guint32 caplen, guint32 len,
+                                             guint32 interface_id,
+                                             guint ts_mul,
+                                             const guint8 *pd,
+                                             guint32 flags,
+                                             guint64 *bytes_written,
+                                             int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return pcapng_write_enhanced_packet_block_to_sink(&sink, comment, sec, usec, caplen, len, interface_id, ts_mul, pd, flags, bytes_written, err);
+}
+
+gboolean
+pcapng_write_interface_statistics_block(FILE* pfile,
+                                        guint32 interface_id,
+                                        guint64 *bytes_written,
+                                        const char *comment,
+                                        guint64 isb_starttime,
+                                        guint64 isb_endtime,
+                                        guint64 isb_ifrecv,
+                                        guint64 isb_ifdrop,
+                                        int *err)
+{
+        pcapio_sink_t sink = { pfile, NULL };
+
+        return pcapng_write_interface_statistics_block_to_sink(&sink, interface_id, bytes_written, comment, isb_starttime, isb_endtime, isb_ifrecv, isb_ifdrop, err);
+}
+
+gboolean
+pcapng_write_interface_statistics_block_to_writer(pcapio_writer_t *writer,
+                                                  guint32 interface_id,
+                                                  guint64 *bytes_written,
+                                                  const char *comment,
+                                                  guint64 isb_starttime,
+                                                  guint64 isb_endtime,
+                                                  guint64 isb_ifrecv,
+                                                  guint64 isb_ifdrop,
+                                                  int *err)
+{
+        pcapio_sink_t sink = { NULL, writer };
+
+        return pcapng_write_interface_statistics_block_to_sink(&sink, interface_id, bytes_written, comment, isb_starttime, isb_endtime, isb_ifrecv, isb_ifdrop, err);
 }
 
 /*
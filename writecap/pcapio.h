@@ -11,6 +11,8 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#include "pcapio_writer.h"
+
 /* Writing pcap files */
 
 /** Write the file header to a dump file.
@@ -98,6 +100,72 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
                                    guint64 *bytes_written,
                                    int *err);
 
+/* The same, writing through one of our writers rather than a stream */
+
+extern gboolean
+libpcap_write_file_header_to_writer(pcapio_writer_t *writer, int linktype, int snaplen, gboolean ts_nsecs, guint64 *bytes_written, int *err);
+
+extern gboolean
+libpcap_write_packet_to_writer(pcapio_writer_t *writer,
+                               time_t sec, guint32 usec,
+                               guint32 caplen, guint32 len,
+                               const guint8 *pd,
+                               guint64 *bytes_written, int *err);
+
+extern gboolean
+pcapng_write_block_to_writer(pcapio_writer_t *writer,
+                             const guint8 *data,
+                             guint32 length,
+                             guint64 *bytes_written,
+                             int *err);
+
+extern gboolean
+pcapng_write_section_header_block_to_writer(pcapio_writer_t *writer,
+                                            const char *comment,
+                                            const char *hw,
+                                            const char *os,
+                                            const char *appname,
+                                            guint64 section_length,
+                                            guint64 *bytes_written,
+                                            int *err);
+
+extern gboolean
+pcapng_write_interface_description_block_to_writer(pcapio_writer_t *writer,
+                                                   const char *comment,
+                                                   const char *name,
+                                                   const char *descr,
+                                                   const char *filter,
+                                                   const char *os,
+                                                   int link_type,
+                                                   int snap_len,
+                                                   guint64 *bytes_written,
+                                                   guint64 if_speed,
+                                                   guint8 tsresol,
+                                                   int *err);
+
+extern gboolean
+pcapng_write_enhanced_packet_block_to_writer(pcapio_writer_t *writer,
+                                             const char *comment,
+                                             time_t sec, guint32 usec,
+                                             guint32 caplen, guint32 len,
+                                             guint32 interface_id,
+                                             guint ts_mul,
+                                             const guint8 *pd,
+                                             guint32 flags,
+                                             guint64 *bytes_written,
+                                             int *err);
+
+extern gboolean
+pcapng_write_interface_statistics_block_to_writer(pcapio_writer_t *writer,
+                                                  guint32 interface_id,
+                                                  guint64 *bytes_written,
+                                                  const char *comment,
+                                                  guint64 isb_starttime,
+                                                  guint64 isb_endtime,
+                                                  guint64 isb_ifrecv,
+                                                  guint64 isb_ifdrop,
+                                                  int *err);
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
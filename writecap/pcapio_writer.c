@@ -0,0 +1,403 @@
+/* pcapio_writer.c
+ * Our routines for writing capture files in large blocks, optionally
+ * from a separate thread.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#define _GNU_SOURCE /* Otherwise O_DIRECT and fallocate() won't be defined on Linux */
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/time_util.h>
+
+#include "pcapio_writer.h"
+
+/* Buffers are aligned to, and are a multiple of, this; it's what O_DIRECT
+   wants on the file systems that support it. */
+#define WRITER_ALIGN            4096
+
+/* One buffer to fill while the other is being written */
+#define WRITER_ASYNC_BUFFERS    2
+
+/* Most we hand to a single write() */
+#define WRITER_MAX_WRITE        (1U << 30)
+
+typedef struct {
+    guint8  *base;              /* as allocated */
+    guint8  *data;              /* aligned */
+    gsize    len;               /* bytes in the buffer */
+} writer_buffer_t;
+
+/*
+ * The buffers are filled, and written, in turn.  The one being filled is
+ * buffers[submitted % nbuffers]; the ones from completed up to submitted
+ * are waiting to be written, or being written.
+ */
+struct pcapio_writer {
+    int              fd;
+    gboolean         direct;        /* O_DIRECT is set on fd */
+    gboolean         whole_blocks;  /* ...so only write whole blocks */
+    guint64          offset;        /* where the next write() goes */
+    guint64          preallocated;  /* end of the space allocated up front */
+    gsize            buffer_size;
+    guint            nbuffers;
+    writer_buffer_t  buffers[WRITER_ASYNC_BUFFERS];
+    guint64          submitted;
+    guint64          completed;
+    pcapio_writer_stats_t *stats;
+    shm_tail_t      *tail;          /* copy of the end of the file, or NULL */
+
+    /* Only used with PCAPIO_WRITER_ASYNC */
+    GThread         *thread;
+    GMutex           mutex;         /* protects submitted, completed, stopping and err */
+    GCond            cond;          /* signalled when any of them changes */
+    gboolean         stopping;
+
+    int              err;           /* first write error, or 0 */
+};
+
+static writer_buffer_t *
+writer_current(pcapio_writer_t *writer)
+{
+    return &writer->buffers[writer->submitted % writer->nbuffers];
+}
+
+static void
+writer_clear_direct(pcapio_writer_t *writer)
+{
+#ifdef O_DIRECT
+    int flags;
+
+    if (!writer->direct)
+        return;
+    flags = fcntl(writer->fd, F_GETFL);
+    if (flags != -1)
+        fcntl(writer->fd, F_SETFL, flags & ~O_DIRECT);
+    writer->direct = FALSE;
+#else
+    (void)writer;
+#endif
+}
+
+/* Returns 0 on success, or an error code. */
+static int
+writer_write_all(pcapio_writer_t *writer, const guint8 *data, gsize data_length)
+{
+    ssize_t nwritten;
+
+    while (data_length != 0) {
+        nwritten = ws_write(writer->fd, data, (unsigned int)MIN(data_length, WRITER_MAX_WRITE));
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (nwritten == 0)
+            return EIO;
+        data += nwritten;
+        data_length -= nwritten;
+        writer->offset += nwritten;
+        if (writer->direct && (nwritten % WRITER_ALIGN) != 0) {
+            /* A short write; what's left can't be written with O_DIRECT. */
+            writer_clear_direct(writer);
+        }
+    }
+    return 0;
+}
+
+static gpointer
+writer_thread(gpointer data)
+{
+    pcapio_writer_t *writer = (pcapio_writer_t *)data;
+    writer_buffer_t *buf;
+    int err;
+
+    g_mutex_lock(&writer->mutex);
+    for (;;) {
+        while (writer->completed == writer->submitted && !writer->stopping)
+            g_cond_wait(&writer->cond, &writer->mutex);
+        if (writer->completed == writer->submitted)
+            break;
+        buf = &writer->buffers[writer->completed % writer->nbuffers];
+        err = writer->err;
+        g_mutex_unlock(&writer->mutex);
+
+        /* After an error, the rest is dropped. */
+        if (err == 0)
+            err = writer_write_all(writer, buf->data, buf->len);
+
+        g_mutex_lock(&writer->mutex);
+        writer->err = err;
+        writer->completed++;
+        g_cond_broadcast(&writer->cond);
+    }
+    g_mutex_unlock(&writer->mutex);
+    return NULL;
+}
+
+/*
+ * Hand the current buffer over to be written, and make the next one
+ * current, waiting for it to be written if need be.  Returns the first
+ * error from a write, or 0.
+ */
+static int
+writer_submit(pcapio_writer_t *writer)
+{
+    writer_buffer_t *buf = writer_current(writer);
+    writer_buffer_t *next;
+    gsize len = buf->len;
+    gsize tail = 0;
+    guint64 stall_start;
+    guint depth;
+    int err;
+
+    if (writer->whole_blocks) {
+        /* Keep anything after the last whole block for the next buffer. */
+        tail = len % WRITER_ALIGN;
+        len -= tail;
+        if (len == 0)
+            return writer->thread ? 0 : writer->err;
+        buf->len = len;
+    }
+
+    if (writer->thread == NULL) {
+        if (writer->err == 0)
+            writer->err = writer_write_all(writer, buf->data, len);
+        writer->submitted++;
+        writer->completed++;
+        if (writer->stats)
+            writer->stats->buffers_written++;
+        memmove(buf->data, buf->data + len, tail);
+        buf->len = tail;
+        return writer->err;
+    }
+
+    g_mutex_lock(&writer->mutex);
+    writer->submitted++;
+    g_cond_broadcast(&writer->cond);
+    depth = (guint)(writer->submitted - writer->completed);
+    if (writer->stats) {
+        writer->stats->buffers_written++;
+        if (depth > writer->stats->max_queue_depth)
+            writer->stats->max_queue_depth = depth;
+    }
+    if (depth >= writer->nbuffers) {
+        stall_start = get_monotonic_time_ns();
+        while (writer->submitted - writer->completed >= writer->nbuffers)
+            g_cond_wait(&writer->cond, &writer->mutex);
+        if (writer->stats) {
+            writer->stats->stalls++;
+            writer->stats->stall_ns += get_monotonic_time_ns() - stall_start;
+        }
+    }
+    err = writer->err;
+    g_mutex_unlock(&writer->mutex);
+
+    /* The writer thread doesn't look past buf->len. */
+    next = writer_current(writer);
+    memcpy(next->data, buf->data + len, tail);
+    next->len = tail;
+    return err;
+}
+
+/* Returns the first error from a write, or 0. */
+static int
+writer_flush(pcapio_writer_t *writer)
+{
+    int err;
+
+    if (writer_current(writer)->len != 0) {
+        err = writer_submit(writer);
+        if (err != 0)
+            return err;
+    }
+    if (writer->thread == NULL)
+        return writer->err;
+
+    g_mutex_lock(&writer->mutex);
+    while (writer->completed != writer->submitted)
+        g_cond_wait(&writer->cond, &writer->mutex);
+    err = writer->err;
+    g_mutex_unlock(&writer->mutex);
+    return err;
+}
+
+pcapio_writer_t *
+pcapio_writer_open(int fd, guint flags, gsize buffer_size,
+                   guint64 preallocate, pcapio_writer_stats_t *stats)
+{
+    pcapio_writer_t *writer = g_new0(pcapio_writer_t, 1);
+    gint64 offset;
+    guint i;
+
+    writer->fd = fd;
+    writer->stats = stats;
+    if (buffer_size == 0)
+        buffer_size = PCAPIO_WRITER_BUFFER_SIZE;
+    writer->buffer_size = (buffer_size + WRITER_ALIGN - 1) & ~(gsize)(WRITER_ALIGN - 1);
+    writer->nbuffers = (flags & PCAPIO_WRITER_ASYNC) ? WRITER_ASYNC_BUFFERS : 1;
+    for (i = 0; i < writer->nbuffers; i++) {
+        writer->buffers[i].base = (guint8 *)g_malloc(writer->buffer_size + WRITER_ALIGN - 1);
+        writer->buffers[i].data = (guint8 *)(((guintptr)writer->buffers[i].base + WRITER_ALIGN - 1) & ~(guintptr)(WRITER_ALIGN - 1));
+    }
+
+    /* Not seekable if it's a pipe; that's fine, we just do without. */
+    offset = (gint64)ws_lseek64(fd, 0, SEEK_CUR);
+    if (offset > 0)
+        writer->offset = (guint64)offset;
+
+#ifdef O_DIRECT
+    if ((flags & PCAPIO_WRITER_DIRECT) && offset >= 0 && offset % WRITER_ALIGN == 0) {
+        int fd_flags = fcntl(fd, F_GETFL);
+
+        /* This fails if the file system doesn't do direct I/O. */
+        if (fd_flags != -1 && fcntl(fd, F_SETFL, fd_flags | O_DIRECT) == 0) {
+            writer->direct = TRUE;
+            writer->whole_blocks = TRUE;
+        }
+    }
+#endif
+
+#ifdef HAVE_FALLOCATE
+    /*
+     * The file's size stays what's been written, so a reader never sees
+     * space we haven't filled yet.  Unlike posix_fallocate(), this fails
+     * on file systems that can't allocate space, rather than writing
+     * zeros to it, in which case we do without.
+     */
+    if (preallocate != 0 && offset >= 0 &&
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)preallocate) == 0)
+        writer->preallocated = (guint64)offset + preallocate;
+#else
+    (void)preallocate;
+#endif
+
+    if (flags & PCAPIO_WRITER_ASYNC) {
+        g_mutex_init(&writer->mutex);
+        g_cond_init(&writer->cond);
+        writer->thread = g_thread_new("pcapio writer", writer_thread, writer);
+    }
+    return writer;
+}
+
+gboolean
+pcapio_writer_set_tail(pcapio_writer_t *writer, shm_tail_t *tail)
+{
+    /*
+     * What falls out of the window must have been written, so that a
+     * reader can get it from the file; what hasn't is in the buffers,
+     * including what's kept back for the next O_DIRECT block.  That
+     * holds as long as no more is appended to the window at a time than
+     * there's room for in the current buffer.
+     */
+    if (shm_tail_size(tail) <= writer->nbuffers * writer->buffer_size + WRITER_ALIGN)
+        return FALSE;
+    writer->tail = shm_tail_ref(tail);
+    shm_tail_begin_file(tail, writer->fd, writer->offset);
+    return TRUE;
+}
+
+gboolean
+pcapio_writer_write(pcapio_writer_t *writer, const guint8 *data,
+                    size_t data_length, int *err)
+{
+    writer_buffer_t *buf;
+    gsize n;
+
+    while (data_length != 0) {
+        buf = writer_current(writer);
+        n = MIN(writer->buffer_size - buf->len, data_length);
+        memcpy(buf->data + buf->len, data, n);
+        if (writer->tail != NULL)
+            shm_tail_append(writer->tail, data, n);
+        buf->len += n;
+        data += n;
+        data_length -= n;
+        if (buf->len == writer->buffer_size) {
+            *err = writer_submit(writer);
+            if (*err != 0)
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+gboolean
+pcapio_writer_flush(pcapio_writer_t *writer, int *err)
+{
+    *err = writer_flush(writer);
+    return *err == 0;
+}
+
+gboolean
+pcapio_writer_close(pcapio_writer_t *writer, int *err)
+{
+    writer_buffer_t *buf;
+    int close_err = writer_flush(writer);
+    guint i;
+
+    if (writer->thread != NULL) {
+        g_mutex_lock(&writer->mutex);
+        writer->stopping = TRUE;
+        g_cond_broadcast(&writer->cond);
+        g_mutex_unlock(&writer->mutex);
+        g_thread_join(writer->thread);
+        g_cond_clear(&writer->cond);
+        g_mutex_clear(&writer->mutex);
+    }
+
+    buf = writer_current(writer);
+    if (close_err == 0 && buf->len != 0) {
+        /* What's left isn't a whole block. */
+        writer_clear_direct(writer);
+        close_err = writer_write_all(writer, buf->data, buf->len);
+    }
+
+#ifdef HAVE_FALLOCATE
+    /* Free the space we didn't use past the end of the file. */
+    if (close_err == 0 && writer->preallocated > writer->offset &&
+        ftruncate(writer->fd, (off_t)writer->offset) != 0)
+        close_err = errno;
+#endif
+
+    if (ws_close(writer->fd) != 0 && close_err == 0)
+        close_err = errno;
+
+    for (i = 0; i < writer->nbuffers; i++)
+        g_free(writer->buffers[i].base);
+    shm_tail_unref(writer->tail);
+    g_free(writer);
+
+    *err = close_err;
+    return close_err == 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
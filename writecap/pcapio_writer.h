@@ -0,0 +1,103 @@
+/* pcapio_writer.h
+ * Declarations of our routines for writing capture files in large blocks.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __PCAPIO_WRITER_H__
+#define __PCAPIO_WRITER_H__
+
+#include <glib.h>
+
+#include <wsutil/shm_tail.h>
+
+/*
+ * A writer collects what's written to it into large, aligned buffers,
+ * and writes each buffer to the file with a single write() when it's
+ * full, or when it's flushed.
+ *
+ * With PCAPIO_WRITER_ASYNC, full buffers are written by a thread of the
+ * writer's own, so that the caller only waits for the disk when all the
+ * buffers are full.
+ *
+ * With PCAPIO_WRITER_DIRECT, the file is written with O_DIRECT, where
+ * the OS and file system support it, so that captured data doesn't push
+ * everything else out of the page cache.  As O_DIRECT writes must be a
+ * multiple of the block size, a flush leaves anything after the last
+ * whole block in the buffer; it's written when the file is closed.
+ */
+typedef struct pcapio_writer pcapio_writer_t;
+
+#define PCAPIO_WRITER_ASYNC     0x01    /* write from a separate thread */
+#define PCAPIO_WRITER_DIRECT    0x02    /* bypass the page cache */
+
+/* Size of the buffers if the caller doesn't choose one */
+#define PCAPIO_WRITER_BUFFER_SIZE (1024 * 1024)
+
+/* Statistics kept by a writer; the caller owns them, so that they can be
+ * kept across files. */
+typedef struct {
+    guint64 buffers_written;    /* buffers handed to the file */
+    guint   max_queue_depth;    /* most full buffers waiting to be written */
+    guint64 stalls;             /* times we had to wait for a free buffer */
+    guint64 stall_ns;           /* time spent waiting for a free buffer */
+} pcapio_writer_stats_t;
+
+/** Start writing to fd, which is at the start of a new file, with buffers
+   of buffer_size bytes, or PCAPIO_WRITER_BUFFER_SIZE if it's 0.  If
+   preallocate isn't 0, room for that many bytes is allocated for the file
+   up front, where the OS and file system support that, without changing
+   its size; the space that wasn't used is freed when it's closed.  If stats isn't NULL, our statistics are
+   added to it.
+   If O_DIRECT or preallocation isn't supported for the file, the writer
+   does without. */
+extern pcapio_writer_t *
+pcapio_writer_open(int fd, guint flags, gsize buffer_size,
+                   guint64 preallocate, pcapio_writer_stats_t *stats);
+
+/** Add data to the file.
+   Returns TRUE on success, FALSE on failure, which may be the failure of
+   an earlier asynchronous write. */
+extern gboolean
+pcapio_writer_write(pcapio_writer_t *writer, const guint8 *data,
+                    size_t data_length, int *err);
+
+/** Also copy everything added to tail, so that a reader of the file can
+   get it from there before it's been written to the file; the file is
+   written as usual.  Must be called before anything is added.  Returns FALSE if the window is too small
+   to hold everything the writer might not have written to the file yet,
+   in which case the writer doesn't use it.  The writer takes a reference
+   to the window, and drops it when it's closed. */
+extern gboolean
+pcapio_writer_set_tail(pcapio_writer_t *writer, shm_tail_t *tail);
+
+/** Write out everything added so far (but see PCAPIO_WRITER_DIRECT), and
+   wait until it's been written, so that a reader of the file sees it.
+   Returns TRUE on success, FALSE on failure. */
+extern gboolean
+pcapio_writer_flush(pcapio_writer_t *writer, int *err);
+
+/** Write out everything, close the fd and free the writer.
+   Returns TRUE on success, FALSE on failure; the writer is freed and the
+   fd closed either way. */
+extern gboolean
+pcapio_writer_close(pcapio_writer_t *writer, int *err);
+
+#endif /* __PCAPIO_WRITER_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
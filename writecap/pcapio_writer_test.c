@@ -0,0 +1,209 @@
+/* pcapio_writer_test.c
+ * Standalone program to test that pcapio_writer writes exactly what it's
+ * given, with and without its writer thread and O_DIRECT, and that a
+ * flush with O_DIRECT keeps back only the last partial block.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#define _GNU_SOURCE /* Otherwise O_DIRECT won't be defined on Linux */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+
+#include "pcapio_writer.h"
+
+/* What the writer aligns O_DIRECT writes to */
+#define TEST_BLOCK      4096
+
+/* Not a multiple of TEST_BLOCK, so there's always a partial block */
+#define TEST_DATA_LEN   (300 * 1024 + 123)
+
+static gboolean failed = FALSE;
+
+#define check(what, cond) \
+    do { \
+        if (!(cond)) { \
+            printf("Failed %s: %s (line %d)\n", what, #cond, __LINE__); \
+            failed = TRUE; \
+        } \
+    } while (0)
+
+static guint8 *test_data;
+
+/* The file in the current directory, which is likelier than the
+   temporary directory to be on a file system that does O_DIRECT. */
+static int
+open_test_file(char **path)
+{
+    *path = g_strdup("pcapio_writer_test.XXXXXX");
+    return g_mkstemp(*path);
+}
+
+static gboolean
+is_direct(int fd)
+{
+#ifdef O_DIRECT
+    int flags = fcntl(fd, F_GETFL);
+
+    return flags != -1 && (flags & O_DIRECT) != 0;
+#else
+    (void)fd;
+    return FALSE;
+#endif
+}
+
+/* Checks that the file holds the first len bytes of test_data. */
+static void
+check_file(const char *what, const char *path, gsize len)
+{
+    gchar *contents = NULL;
+    gsize contents_len = 0;
+
+    if (!g_file_get_contents(path, &contents, &contents_len, NULL)) {
+        printf("Failed %s: can't read %s\n", what, path);
+        failed = TRUE;
+        return;
+    }
+    check(what, contents_len == len);
+    check(what, memcmp(contents, test_data, MIN(contents_len, len)) == 0);
+    g_free(contents);
+}
+
+/* Writes test_data in pieces of various sizes, some bigger than a
+   buffer. */
+static gboolean
+write_test_data(pcapio_writer_t *writer, gsize start, gsize end)
+{
+    static const gsize sizes[] = { 1, 7, 24, 4096, 100, 9000, 3, 20000 };
+    gsize offset = start;
+    gsize n;
+    guint i = 0;
+    int err;
+
+    while (offset < end) {
+        n = sizes[i++ % G_N_ELEMENTS(sizes)];
+        n = MIN(n, end - offset);
+        if (!pcapio_writer_write(writer, test_data + offset, n, &err)) {
+            printf("Write failed: %s\n", g_strerror(err));
+            return FALSE;
+        }
+        offset += n;
+    }
+    return TRUE;
+}
+
+static void
+test_writer(const char *what, guint flags, gsize buffer_size,
+            guint64 preallocate)
+{
+    pcapio_writer_stats_t stats;
+    pcapio_writer_t *writer;
+    gboolean direct;
+    char *path;
+    int fd;
+    int err;
+
+    fd = open_test_file(&path);
+    if (fd == -1) {
+        printf("Failed %s: can't create a file: %s\n", what, g_strerror(errno));
+        failed = TRUE;
+        g_free(path);
+        return;
+    }
+
+    memset(&stats, 0, sizeof stats);
+    writer = pcapio_writer_open(fd, flags, buffer_size, preallocate, &stats);
+    direct = is_direct(fd);
+    if ((flags & PCAPIO_WRITER_DIRECT) && !direct)
+        printf("%s: O_DIRECT isn't supported here, testing without it\n", what);
+
+    check(what, write_test_data(writer, 0, TEST_DATA_LEN / 2));
+    check(what, pcapio_writer_flush(writer, &err));
+    /* With O_DIRECT, the last partial block is carried over until the
+       next flush or the close; otherwise everything is in the file, and
+       a preallocated file doesn't look any bigger. */
+    if (direct)
+        check_file(what, path, (TEST_DATA_LEN / 2) & ~(gsize)(TEST_BLOCK - 1));
+    else
+        check_file(what, path, TEST_DATA_LEN / 2);
+
+    /* What was carried over comes before what's written next. */
+    check(what, write_test_data(writer, TEST_DATA_LEN / 2, TEST_DATA_LEN));
+    check(what, pcapio_writer_flush(writer, &err));
+    if (direct)
+        check_file(what, path, TEST_DATA_LEN & ~(gsize)(TEST_BLOCK - 1));
+    else
+        check_file(what, path, TEST_DATA_LEN);
+
+    check(what, pcapio_writer_close(writer, &err));
+    check_file(what, path, TEST_DATA_LEN);
+
+    /* Full buffers, and anything left at the flushes */
+    check(what, stats.buffers_written >= TEST_DATA_LEN / (buffer_size ? buffer_size : PCAPIO_WRITER_BUFFER_SIZE));
+    if (flags & PCAPIO_WRITER_ASYNC) {
+        /* One buffer filling while the other's written */
+        check(what, stats.max_queue_depth >= 1 && stats.max_queue_depth <= 2);
+    } else {
+        check(what, stats.max_queue_depth == 0);
+        check(what, stats.stalls == 0);
+    }
+
+    ws_unlink(path);
+    g_free(path);
+}
+
+int
+main(void)
+{
+    guint i;
+
+    test_data = (guint8 *)g_malloc(TEST_DATA_LEN);
+    for (i = 0; i < TEST_DATA_LEN; i++)
+        test_data[i] = (guint8)(i * 31 + i / 251);
+
+    test_writer("sync", 0, TEST_BLOCK, 0);
+    test_writer("sync, large buffer", 0, 0, 0);
+    test_writer("async", PCAPIO_WRITER_ASYNC, TEST_BLOCK, 0);
+    test_writer("direct", PCAPIO_WRITER_DIRECT, 2 * TEST_BLOCK, 0);
+    test_writer("async, direct", PCAPIO_WRITER_ASYNC|PCAPIO_WRITER_DIRECT, 2 * TEST_BLOCK, 0);
+    test_writer("preallocated", 0, TEST_BLOCK, 2 * TEST_DATA_LEN);
+    test_writer("preallocated, too small", PCAPIO_WRITER_ASYNC, TEST_BLOCK, TEST_BLOCK);
+
+    g_free(test_data);
+    if (failed)
+        exit(1);
+    printf("Passed pcapio_writer tests\n");
+    return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
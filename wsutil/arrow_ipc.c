@@ -0,0 +1,692 @@
+/* arrow_ipc.c
+ * Routines for writing tables in the Apache Arrow IPC streaming format
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "arrow_ipc.h"
+
+/*
+ * Each message of the stream is a 0xFFFFFFFF continuation marker, the
+ * length of the metadata, the metadata - a Message flatbuffer, padded to
+ * 8 bytes - and the message body, whose buffers are each padded to
+ * 8 bytes. The definitions are in Schema.fbs and Message.fbs in the Arrow
+ * sources; only what's needed here is listed.
+ */
+#define ARROW_METADATA_V5           4
+
+#define ARROW_HEADER_SCHEMA         1
+#define ARROW_HEADER_DICTIONARY     2
+#define ARROW_HEADER_RECORD_BATCH   3
+
+#define ARROW_TYPE_INT              2
+#define ARROW_TYPE_FLOATING_POINT   3
+#define ARROW_TYPE_UTF8             5
+#define ARROW_TYPE_BOOL             6
+#define ARROW_TYPE_TIMESTAMP        10
+#define ARROW_TYPE_DURATION         18
+
+#define ARROW_PRECISION_SINGLE      1
+#define ARROW_PRECISION_DOUBLE      2
+
+#define ARROW_TIME_UNIT_NANOSECOND  3
+
+typedef struct {
+    gchar            *name;
+    arrow_ipc_type_e  type;
+    GByteArray       *validity;     /* bitmap, one bit per row */
+    GByteArray       *values;       /* little-endian values, or a bitmap for ARROW_IPC_BOOL */
+    guint             null_count;
+    gboolean          row_set;      /* the current row has a value */
+    guint64           row_value;    /* its bits, or the dictionary index */
+    GHashTable       *dict;         /* string -> index + 1, for ARROW_IPC_STRING */
+    GByteArray       *dict_offsets;
+    GByteArray       *dict_data;
+    guint32           dict_count;
+} arrow_ipc_column_t;
+
+struct arrow_ipc_writer {
+    FILE       *fh;
+    guint       batch_rows;
+    GPtrArray  *columns;
+    guint       rows;               /* rows in the current batch */
+    gboolean    schema_written;
+    gboolean    failed;
+};
+
+/*
+ * A minimal flatbuffer builder. Flatbuffers are normally built back to
+ * front; this one writes front to back, parents before children, which
+ * works because the offsets from a table to its children are unsigned and
+ * so only have to point forward, while the offset from a table to its
+ * vtable is signed. Each vtable is written just before its table.
+ */
+typedef struct {
+    guint8      id;         /* field number in the schema */
+    guint8      size;       /* 1, 2, 4 or 8 bytes */
+    guint64     value;
+    gsize      *ref;        /* for offsets to children: where to store the position to patch */
+} fb_field_t;
+
+static void
+fb_put(GByteArray *b, guint64 value, guint size)
+{
+    guint8 le[8];
+    guint i;
+
+    for (i = 0; i < size; i++) {
+        le[i] = (guint8)(value >> (8 * i));
+    }
+    g_byte_array_append(b, le, size);
+}
+
+/* Pads with zeros until (length + skew) is a multiple of align. */
+static void
+fb_pad(GByteArray *b, guint align, gsize skew)
+{
+    static const guint8 zero;
+
+    while ((b->len + skew) % align != 0) {
+        g_byte_array_append(b, &zero, 1);
+    }
+}
+
+/* Points the offset at "ref" to the object at "pos". */
+static void
+fb_link(GByteArray *b, gsize ref, gsize pos)
+{
+    guint32 offset = (guint32)(pos - ref);
+
+    b->data[ref]     = (guint8)offset;
+    b->data[ref + 1] = (guint8)(offset >> 8);
+    b->data[ref + 2] = (guint8)(offset >> 16);
+    b->data[ref + 3] = (guint8)(offset >> 24);
+}
+
+static gsize
+fb_table(GByteArray *b, const fb_field_t *fields, guint count)
+{
+    guint16 slots[8] = { 0 };
+    guint num_slots = 0, inline_len = 4, offset, size, i;
+    gboolean has_long = FALSE;
+    gsize vtable_len, table;
+
+    for (i = 0; i < count; i++) {
+        g_assert(fields[i].id < G_N_ELEMENTS(slots));
+        num_slots = MAX(num_slots, fields[i].id + 1U);
+        inline_len += fields[i].size;
+        if (fields[i].size == 8)
+            has_long = TRUE;
+    }
+    vtable_len = 4 + 2 * num_slots;
+
+    /*
+     * The table starts 4-byte aligned, or 4 bytes past an 8-byte boundary
+     * if it has 8-byte fields; its fields are laid out largest first after
+     * the vtable offset, so that each is naturally aligned.
+     */
+    if (has_long)
+        fb_pad(b, 8, vtable_len + 4);
+    else
+        fb_pad(b, 4, vtable_len);
+
+    offset = 4;
+    for (size = 8; size >= 1; size /= 2) {
+        for (i = 0; i < count; i++) {
+            if (fields[i].size == size) {
+                slots[fields[i].id] = offset;
+                offset += size;
+            }
+        }
+    }
+
+    fb_put(b, vtable_len, 2);
+    fb_put(b, inline_len, 2);
+    for (i = 0; i < num_slots; i++) {
+        fb_put(b, slots[i], 2);
+    }
+
+    table = b->len;
+    fb_put(b, vtable_len, 4);
+    for (size = 8; size >= 1; size /= 2) {
+        for (i = 0; i < count; i++) {
+            if (fields[i].size == size) {
+                if (fields[i].ref)
+                    *fields[i].ref = b->len;
+                fb_put(b, fields[i].value, size);
+            }
+        }
+    }
+    return table;
+}
+
+static gsize
+fb_string(GByteArray *b, const char *str)
+{
+    gsize len = strlen(str), pos;
+
+    fb_pad(b, 4, 0);
+    pos = b->len;
+    fb_put(b, len, 4);
+    g_byte_array_append(b, (const guint8 *)str, (guint)len + 1);
+    return pos;
+}
+
+/* A vector of offsets to tables; refs receives the positions to patch. */
+static gsize
+fb_offset_vector(GByteArray *b, guint count, gsize *refs)
+{
+    gsize pos;
+    guint i;
+
+    fb_pad(b, 4, 0);
+    pos = b->len;
+    fb_put(b, count, 4);
+    for (i = 0; i < count; i++) {
+        refs[i] = b->len;
+        fb_put(b, 0, 4);
+    }
+    return pos;
+}
+
+/* A vector of FieldNode or Buffer structs, both pairs of longs. */
+static gsize
+fb_long_pair_vector(GByteArray *b, const GArray *pairs)
+{
+    gsize pos;
+    guint i;
+
+    fb_pad(b, 8, 4);
+    pos = b->len;
+    fb_put(b, pairs->len / 2, 4);
+    for (i = 0; i < pairs->len; i++) {
+        fb_put(b, g_array_index(pairs, guint64, i), 8);
+    }
+    return pos;
+}
+
+static void
+arrow_write(arrow_ipc_writer_t *writer, const void *data, gsize len)
+{
+    if (len != 0 && fwrite(data, 1, len, writer->fh) != len)
+        writer->failed = TRUE;
+}
+
+/* Writes an encapsulated message: metadata is padded in place. */
+static void
+arrow_write_message(arrow_ipc_writer_t *writer, GByteArray *metadata, const GByteArray *body)
+{
+    GByteArray *prefix = g_byte_array_sized_new(8);
+
+    fb_pad(metadata, 8, 0);
+    fb_put(prefix, 0xFFFFFFFF, 4);
+    fb_put(prefix, metadata->len, 4);
+    arrow_write(writer, prefix->data, prefix->len);
+    arrow_write(writer, metadata->data, metadata->len);
+    if (body)
+        arrow_write(writer, body->data, body->len);
+    g_byte_array_free(prefix, TRUE);
+}
+
+/* Starts a Message; returns the position of the header offset to patch. */
+static gsize
+arrow_message_start(GByteArray *b, guint8 header_type, gsize body_len)
+{
+    gsize header_ref = 0;
+    fb_field_t message[] = {
+        { 0, 2, ARROW_METADATA_V5, NULL },
+        { 1, 1, header_type, NULL },
+        { 2, 4, 0, &header_ref },
+        { 3, 8, body_len, NULL },
+    };
+
+    fb_put(b, 0, 4);    /* root offset */
+    fb_link(b, 0, fb_table(b, message, G_N_ELEMENTS(message)));
+    return header_ref;
+}
+
+static gsize
+arrow_int_type(GByteArray *b, guint bit_width, gboolean is_signed)
+{
+    fb_field_t int_type[] = {
+        { 0, 4, bit_width, NULL },
+        { 1, 1, is_signed, NULL },
+    };
+
+    return fb_table(b, int_type, G_N_ELEMENTS(int_type));
+}
+
+static guint8
+arrow_type_tag(arrow_ipc_type_e type)
+{
+    switch (type) {
+    case ARROW_IPC_UINT32:
+    case ARROW_IPC_UINT64:
+    case ARROW_IPC_INT32:
+    case ARROW_IPC_INT64:
+        return ARROW_TYPE_INT;
+    case ARROW_IPC_BOOL:
+        return ARROW_TYPE_BOOL;
+    case ARROW_IPC_FLOAT:
+    case ARROW_IPC_DOUBLE:
+        return ARROW_TYPE_FLOATING_POINT;
+    case ARROW_IPC_TIMESTAMP:
+        return ARROW_TYPE_TIMESTAMP;
+    case ARROW_IPC_DURATION:
+        return ARROW_TYPE_DURATION;
+    case ARROW_IPC_STRING:
+        return ARROW_TYPE_UTF8;
+    }
+    g_assert_not_reached();
+    return 0;
+}
+
+/* Writes the Type table of a column, the union member for its tag. */
+static void
+arrow_column_type(GByteArray *b, gsize ref, arrow_ipc_type_e type)
+{
+    gsize timezone_ref = 0;
+    fb_field_t precision[] = { { 0, 2, 0, NULL } };
+    fb_field_t timestamp[] = {
+        { 0, 2, ARROW_TIME_UNIT_NANOSECOND, NULL },
+        { 1, 4, 0, &timezone_ref },
+    };
+    fb_field_t duration[] = { { 0, 2, ARROW_TIME_UNIT_NANOSECOND, NULL } };
+
+    switch (type) {
+    case ARROW_IPC_UINT32:
+    case ARROW_IPC_UINT64:
+    case ARROW_IPC_INT32:
+    case ARROW_IPC_INT64:
+        fb_link(b, ref, arrow_int_type(b,
+                    (type == ARROW_IPC_UINT32 || type == ARROW_IPC_INT32) ? 32 : 64,
+                    type == ARROW_IPC_INT32 || type == ARROW_IPC_INT64));
+        break;
+    case ARROW_IPC_BOOL:
+        fb_link(b, ref, fb_table(b, NULL, 0));
+        break;
+    case ARROW_IPC_FLOAT:
+    case ARROW_IPC_DOUBLE:
+        precision[0].value = type == ARROW_IPC_FLOAT ? ARROW_PRECISION_SINGLE : ARROW_PRECISION_DOUBLE;
+        fb_link(b, ref, fb_table(b, precision, G_N_ELEMENTS(precision)));
+        break;
+    case ARROW_IPC_TIMESTAMP:
+        fb_link(b, ref, fb_table(b, timestamp, G_N_ELEMENTS(timestamp)));
+        fb_link(b, timezone_ref, fb_string(b, "UTC"));
+        break;
+    case ARROW_IPC_DURATION:
+        fb_link(b, ref, fb_table(b, duration, G_N_ELEMENTS(duration)));
+        break;
+    case ARROW_IPC_STRING:
+        fb_link(b, ref, fb_table(b, NULL, 0));
+        break;
+    }
+}
+
+static void
+arrow_write_schema(arrow_ipc_writer_t *writer)
+{
+    GByteArray *b = g_byte_array_new();
+    gsize header_ref, fields_ref = 0, *refs;
+    guint i;
+
+    fb_field_t schema[] = {
+        { 0, 2, 0, NULL },      /* little-endian */
+        { 1, 4, 0, &fields_ref },
+    };
+
+    header_ref = arrow_message_start(b, ARROW_HEADER_SCHEMA, 0);
+    fb_link(b, header_ref, fb_table(b, schema, G_N_ELEMENTS(schema)));
+
+    refs = g_new(gsize, writer->columns->len);
+    fb_link(b, fields_ref, fb_offset_vector(b, writer->columns->len, refs));
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_ipc_column_t *column = (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, i);
+        gboolean is_string = column->type == ARROW_IPC_STRING;
+        gsize name_ref = 0, type_ref = 0, dict_ref = 0, children_ref = 0, index_ref = 0;
+        fb_field_t field[] = {
+            { 0, 4, 0, &name_ref },
+            { 1, 1, TRUE, NULL },           /* nullable */
+            { 2, 1, 0, NULL },              /* type tag, set below */
+            { 3, 4, 0, &type_ref },
+            { 5, 4, 0, &children_ref },
+            { 4, 4, 0, &dict_ref },
+        };
+        fb_field_t dictionary[] = {
+            { 0, 8, i, NULL },              /* dictionary id */
+            { 1, 4, 0, &index_ref },
+        };
+
+        field[2].value = arrow_type_tag(column->type);
+        fb_link(b, refs[i], fb_table(b, field, is_string ? 6 : 5));
+        fb_link(b, name_ref, fb_string(b, column->name));
+        arrow_column_type(b, type_ref, column->type);
+        fb_link(b, children_ref, fb_offset_vector(b, 0, NULL));
+        if (is_string) {
+            fb_link(b, dict_ref, fb_table(b, dictionary, G_N_ELEMENTS(dictionary)));
+            fb_link(b, index_ref, arrow_int_type(b, 32, TRUE));
+        }
+    }
+    g_free(refs);
+
+    arrow_write_message(writer, b, NULL);
+    g_byte_array_free(b, TRUE);
+    writer->schema_written = TRUE;
+}
+
+/* Adds a buffer to a message body, recording it in "buffers". */
+static void
+arrow_body_add(GByteArray *body, GArray *buffers, const guint8 *data, gsize len)
+{
+    guint64 offset = body->len, length = len;
+
+    if (len != 0)
+        g_byte_array_append(body, data, (guint)len);
+    fb_pad(body, 8, 0);
+    g_array_append_val(buffers, offset);
+    g_array_append_val(buffers, length);
+}
+
+/* Writes a RecordBatch message, or a DictionaryBatch wrapping it if
+ * dictionary_id is not -1. nodes and buffers are (length, null count) and
+ * (offset, length) pairs. */
+static void
+arrow_write_batch(arrow_ipc_writer_t *writer, gint64 dictionary_id, guint64 length,
+                  const GArray *nodes, const GArray *buffers, const GByteArray *body)
+{
+    GByteArray *b = g_byte_array_new();
+    gsize batch_ref = 0, nodes_ref = 0, buffers_ref = 0, header_ref;
+    fb_field_t dictionary_batch[] = {
+        { 0, 8, (guint64)dictionary_id, NULL },
+        { 1, 4, 0, &batch_ref },
+        { 2, 1, FALSE, NULL },      /* isDelta: replaces the previous dictionary */
+    };
+    fb_field_t record_batch[] = {
+        { 0, 8, length, NULL },
+        { 1, 4, 0, &nodes_ref },
+        { 2, 4, 0, &buffers_ref },
+    };
+
+    if (dictionary_id >= 0) {
+        header_ref = arrow_message_start(b, ARROW_HEADER_DICTIONARY, body->len);
+        fb_link(b, header_ref, fb_table(b, dictionary_batch, G_N_ELEMENTS(dictionary_batch)));
+        header_ref = batch_ref;
+    } else {
+        header_ref = arrow_message_start(b, ARROW_HEADER_RECORD_BATCH, body->len);
+    }
+    fb_link(b, header_ref, fb_table(b, record_batch, G_N_ELEMENTS(record_batch)));
+    fb_link(b, nodes_ref, fb_long_pair_vector(b, nodes));
+    fb_link(b, buffers_ref, fb_long_pair_vector(b, buffers));
+
+    arrow_write_message(writer, b, body);
+    g_byte_array_free(b, TRUE);
+}
+
+static void
+arrow_column_reset(arrow_ipc_column_t *column)
+{
+    guint32 zero = 0;
+
+    g_byte_array_set_size(column->validity, 0);
+    g_byte_array_set_size(column->values, 0);
+    column->null_count = 0;
+    if (column->type == ARROW_IPC_STRING) {
+        g_hash_table_remove_all(column->dict);
+        g_byte_array_set_size(column->dict_offsets, 0);
+        g_byte_array_append(column->dict_offsets, (const guint8 *)&zero, 4);
+        g_byte_array_set_size(column->dict_data, 0);
+        column->dict_count = 0;
+    }
+}
+
+static void
+arrow_flush_batch(arrow_ipc_writer_t *writer)
+{
+    GArray *nodes = g_array_new(FALSE, FALSE, sizeof(guint64));
+    GArray *buffers = g_array_new(FALSE, FALSE, sizeof(guint64));
+    GByteArray *body = g_byte_array_new();
+    guint64 pair[2];
+    guint i;
+
+    if (!writer->schema_written)
+        arrow_write_schema(writer);
+
+    /* The dictionaries of this batch's string columns. */
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_ipc_column_t *column = (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, i);
+
+        if (column->type != ARROW_IPC_STRING)
+            continue;
+        g_array_set_size(nodes, 0);
+        g_array_set_size(buffers, 0);
+        g_byte_array_set_size(body, 0);
+        pair[0] = column->dict_count;
+        pair[1] = 0;
+        g_array_append_vals(nodes, pair, 2);
+        arrow_body_add(body, buffers, NULL, 0);
+        arrow_body_add(body, buffers, column->dict_offsets->data, column->dict_offsets->len);
+        arrow_body_add(body, buffers, column->dict_data->data, column->dict_data->len);
+        arrow_write_batch(writer, i, column->dict_count, nodes, buffers, body);
+    }
+
+    g_array_set_size(nodes, 0);
+    g_array_set_size(buffers, 0);
+    g_byte_array_set_size(body, 0);
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_ipc_column_t *column = (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, i);
+
+        pair[0] = writer->rows;
+        pair[1] = column->null_count;
+        g_array_append_vals(nodes, pair, 2);
+        /* The validity bitmap may be left out if nothing is null. */
+        if (column->null_count != 0)
+            arrow_body_add(body, buffers, column->validity->data, column->validity->len);
+        else
+            arrow_body_add(body, buffers, NULL, 0);
+        arrow_body_add(body, buffers, column->values->data, column->values->len);
+        arrow_column_reset(column);
+    }
+    arrow_write_batch(writer, -1, writer->rows, nodes, buffers, body);
+    writer->rows = 0;
+
+    g_array_free(nodes, TRUE);
+    g_array_free(buffers, TRUE);
+    g_byte_array_free(body, TRUE);
+}
+
+arrow_ipc_writer_t *
+arrow_ipc_writer_new(FILE *fh, guint batch_rows)
+{
+    arrow_ipc_writer_t *writer = g_new0(arrow_ipc_writer_t, 1);
+
+    writer->fh = fh;
+    writer->batch_rows = batch_rows ? batch_rows : 1;
+    writer->columns = g_ptr_array_new();
+    return writer;
+}
+
+guint
+arrow_ipc_writer_add_column(arrow_ipc_writer_t *writer, const char *name, arrow_ipc_type_e type)
+{
+    arrow_ipc_column_t *column = g_new0(arrow_ipc_column_t, 1);
+
+    g_assert(!writer->schema_written && writer->rows == 0);
+
+    column->name = g_strdup(name);
+    column->type = type;
+    column->validity = g_byte_array_new();
+    column->values = g_byte_array_new();
+    if (type == ARROW_IPC_STRING) {
+        column->dict = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        column->dict_offsets = g_byte_array_new();
+        column->dict_data = g_byte_array_new();
+    }
+    arrow_column_reset(column);
+    g_ptr_array_add(writer->columns, column);
+    return writer->columns->len - 1;
+}
+
+static inline arrow_ipc_column_t *
+arrow_column(arrow_ipc_writer_t *writer, guint col)
+{
+    g_assert(col < writer->columns->len);
+    return (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, col);
+}
+
+void
+arrow_ipc_set_uint(arrow_ipc_writer_t *writer, guint col, guint64 value)
+{
+    arrow_ipc_column_t *column = arrow_column(writer, col);
+
+    column->row_set = TRUE;
+    column->row_value = value;
+}
+
+void
+arrow_ipc_set_int(arrow_ipc_writer_t *writer, guint col, gint64 value)
+{
+    arrow_ipc_set_uint(writer, col, (guint64)value);
+}
+
+void
+arrow_ipc_set_double(arrow_ipc_writer_t *writer, guint col, double value)
+{
+    arrow_ipc_column_t *column = arrow_column(writer, col);
+    float single;
+
+    column->row_set = TRUE;
+    if (column->type == ARROW_IPC_FLOAT) {
+        guint32 bits;
+
+        single = (float)value;
+        memcpy(&bits, &single, sizeof bits);
+        column->row_value = bits;
+    } else {
+        memcpy(&column->row_value, &value, sizeof value);
+    }
+}
+
+void
+arrow_ipc_set_string(arrow_ipc_writer_t *writer, guint col, const char *value)
+{
+    arrow_ipc_column_t *column = arrow_column(writer, col);
+    gpointer index;
+    guint8 le[4];
+
+    g_assert(column->type == ARROW_IPC_STRING);
+
+    index = g_hash_table_lookup(column->dict, value);
+    if (index == NULL) {
+        g_byte_array_append(column->dict_data, (const guint8 *)value, (guint)strlen(value));
+        le[0] = (guint8)column->dict_data->len;
+        le[1] = (guint8)(column->dict_data->len >> 8);
+        le[2] = (guint8)(column->dict_data->len >> 16);
+        le[3] = (guint8)(column->dict_data->len >> 24);
+        g_byte_array_append(column->dict_offsets, le, 4);
+        column->dict_count++;
+        index = GUINT_TO_POINTER(column->dict_count);
+        g_hash_table_insert(column->dict, g_strdup(value), index);
+    }
+    column->row_set = TRUE;
+    column->row_value = GPOINTER_TO_UINT(index) - 1;
+}
+
+static inline void
+arrow_append_bit(GByteArray *bits, guint row, gboolean set)
+{
+    static const guint8 zero;
+
+    if (row % 8 == 0)
+        g_byte_array_append(bits, &zero, 1);
+    if (set)
+        bits->data[row / 8] |= 1 << (row % 8);
+}
+
+void
+arrow_ipc_end_row(arrow_ipc_writer_t *writer)
+{
+    guint i;
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_ipc_column_t *column = (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, i);
+        guint64 value = column->row_set ? column->row_value : 0;
+
+        arrow_append_bit(column->validity, writer->rows, column->row_set);
+        if (!column->row_set)
+            column->null_count++;
+
+        switch (column->type) {
+        case ARROW_IPC_BOOL:
+            arrow_append_bit(column->values, writer->rows, value != 0);
+            break;
+        case ARROW_IPC_UINT32:
+        case ARROW_IPC_INT32:
+        case ARROW_IPC_FLOAT:
+        case ARROW_IPC_STRING:
+            fb_put(column->values, value, 4);
+            break;
+        default:
+            fb_put(column->values, value, 8);
+            break;
+        }
+        column->row_set = FALSE;
+    }
+
+    if (++writer->rows == writer->batch_rows)
+        arrow_flush_batch(writer);
+}
+
+gboolean
+arrow_ipc_writer_finish(arrow_ipc_writer_t *writer)
+{
+    static const guint8 end_of_stream[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+    gboolean ok;
+    guint i;
+
+    if (writer->rows != 0)
+        arrow_flush_batch(writer);
+    else if (!writer->schema_written)
+        arrow_write_schema(writer);
+    arrow_write(writer, end_of_stream, sizeof end_of_stream);
+    if (fflush(writer->fh) != 0)
+        writer->failed = TRUE;
+    ok = !writer->failed;
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_ipc_column_t *column = (arrow_ipc_column_t *)g_ptr_array_index(writer->columns, i);
+
+        g_free(column->name);
+        g_byte_array_free(column->validity, TRUE);
+        g_byte_array_free(column->values, TRUE);
+        if (column->type == ARROW_IPC_STRING) {
+            g_hash_table_destroy(column->dict);
+            g_byte_array_free(column->dict_offsets, TRUE);
+            g_byte_array_free(column->dict_data, TRUE);
+        }
+        g_free(column);
+    }
+    g_ptr_array_free(writer->columns, TRUE);
+    g_free(writer);
+    return ok;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
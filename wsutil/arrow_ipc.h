@@ -0,0 +1,121 @@
+/* arrow_ipc.h
+ * Routines for writing tables in the Apache Arrow IPC streaming format
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_ARROW_IPC_H__
+#define __WSUTIL_ARROW_IPC_H__
+
+#include "ws_symbol_export.h"
+
+#include <stdio.h>
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A writer for the Arrow IPC streaming format
+ * (https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format),
+ * which pyarrow, pandas, polars, DuckDB and Spark read directly.
+ *
+ * The table has a fixed set of nullable columns. Rows are buffered and
+ * written as one record batch every "batch_rows" rows. String columns are
+ * dictionary-encoded; each batch is preceded by the dictionaries of its
+ * string columns, which replace those of the previous batch.
+ *
+ * Example:
+ *
+ *  arrow_ipc_writer_t *w = arrow_ipc_writer_new(stdout, 65536);
+ *  arrow_ipc_writer_add_column(w, "frame.number", ARROW_IPC_UINT32);
+ *  arrow_ipc_writer_add_column(w, "http.host", ARROW_IPC_STRING);
+ *  for (each row) {
+ *      arrow_ipc_set_uint(w, 0, number);
+ *      if (host)
+ *          arrow_ipc_set_string(w, 1, host);
+ *      arrow_ipc_end_row(w);
+ *  }
+ *  arrow_ipc_writer_finish(w);
+ */
+typedef enum {
+    ARROW_IPC_UINT32,
+    ARROW_IPC_UINT64,
+    ARROW_IPC_INT32,
+    ARROW_IPC_INT64,
+    ARROW_IPC_BOOL,
+    ARROW_IPC_FLOAT,
+    ARROW_IPC_DOUBLE,
+    ARROW_IPC_TIMESTAMP,    /* nanoseconds since the epoch, UTC */
+    ARROW_IPC_DURATION,     /* nanoseconds */
+    ARROW_IPC_STRING        /* UTF-8, dictionary-encoded */
+} arrow_ipc_type_e;
+
+typedef struct arrow_ipc_writer arrow_ipc_writer_t;
+
+WS_DLL_PUBLIC
+arrow_ipc_writer_t *
+arrow_ipc_writer_new(FILE *fh, guint batch_rows);
+
+/* Columns must all be added before the first row is ended. Returns the
+ * column's index. */
+WS_DLL_PUBLIC
+guint
+arrow_ipc_writer_add_column(arrow_ipc_writer_t *writer, const char *name, arrow_ipc_type_e type);
+
+/*
+ * Set a column of the current row. Columns that aren't set are null;
+ * setting one again replaces the value. arrow_ipc_set_uint() is for the
+ * unsigned and boolean columns, arrow_ipc_set_int() for the signed, time
+ * and duration ones and arrow_ipc_set_double() for floating point ones.
+ */
+WS_DLL_PUBLIC
+void
+arrow_ipc_set_uint(arrow_ipc_writer_t *writer, guint col, guint64 value);
+
+WS_DLL_PUBLIC
+void
+arrow_ipc_set_int(arrow_ipc_writer_t *writer, guint col, gint64 value);
+
+WS_DLL_PUBLIC
+void
+arrow_ipc_set_double(arrow_ipc_writer_t *writer, guint col, double value);
+
+WS_DLL_PUBLIC
+void
+arrow_ipc_set_string(arrow_ipc_writer_t *writer, guint col, const char *value);
+
+/* Adds the current row to the table, writing a record batch if it's full. */
+WS_DLL_PUBLIC
+void
+arrow_ipc_end_row(arrow_ipc_writer_t *writer);
+
+/* Writes the remaining rows and the end-of-stream marker and frees the
+ * writer. Returns FALSE if writing to the file failed at any point. */
+WS_DLL_PUBLIC
+gboolean
+arrow_ipc_writer_finish(arrow_ipc_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WSUTIL_ARROW_IPC_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
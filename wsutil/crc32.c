@@ -15,8 +15,16 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 #include <wsutil/crc32.h>
+#include <wsutil/pint.h>
+
+#ifdef HAVE_SSE4_2
+#include "ws_cpuid.h"
+#endif
+#include "crc32_int.h"
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -353,6 +361,167 @@ static const guint32 crc32_5D6DCB[] =
 		0x0098206c, 0x00c54da7, 0x0022fbfa, 0x007f9631
 };
 
+/*
+ * Slicing-by-8 (Kounavis and Berry, "Novel Table Lookup-Based Algorithms
+ * for High-Performance CRC Generation", IEEE Transactions on Computers,
+ * 2008): entry i of table k is the CRC register after byte i followed
+ * by k zero bytes, so eight bytes are folded in with eight independent
+ * lookups instead of eight dependent ones. The tables are built from the
+ * byte-at-a-time ones on first use.
+ */
+typedef guint32 crc32_slice8_table_t[8][256];
+
+static crc32_slice8_table_t crc32c_slice8;
+static crc32_slice8_table_t crc32_ccitt_slice8;
+
+/* Shorter buffers are done a byte at a time. */
+#define CRC32_SLICE8_MIN_LEN 16
+
+static void
+crc32_slice8_init(crc32_slice8_table_t table, const guint32 *byte_table)
+{
+	guint i, k;
+
+	for (i = 0; i < 256; i++)
+		table[0][i] = byte_table[i];
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++)
+			table[k][i] = (table[k - 1][i] >> 8) ^ byte_table[table[k - 1][i] & 0xFF];
+	}
+}
+
+static guint32
+crc32_slice8(const crc32_slice8_table_t table, const guint32 *byte_table,
+	     const guint8 *buf, gsize len, guint32 crc)
+{
+	while (len > 0 && ((gsize)buf & 7) != 0) {
+		CRC32_ACCUMULATE(crc, *buf++, byte_table);
+		len--;
+	}
+	while (len >= 8) {
+		guint32 lo = crc ^ pletoh32(buf);
+		guint32 hi = pletoh32(buf + 4);
+
+		crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+		      table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+		      table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+		      table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+		buf += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		CRC32_ACCUMULATE(crc, *buf++, byte_table);
+		len--;
+	}
+	return crc;
+}
+
+static guint32
+crc32c_bytewise(const guint8 *buf, gsize len, guint32 crc)
+{
+	while (len-- > 0) {
+		CRC32C(crc, *buf++);
+	}
+	return crc;
+}
+
+static guint32
+crc32c_slice8_update(const guint8 *buf, gsize len, guint32 crc)
+{
+	return crc32_slice8(crc32c_slice8, crc32c_table, buf, len, crc);
+}
+
+static guint32
+crc32_ccitt_bytewise(const guint8 *buf, gsize len, guint32 crc)
+{
+	while (len-- > 0)
+		CRC32_ACCUMULATE(crc, *buf++, crc32_ccitt_table);
+	return crc;
+}
+
+static guint32
+crc32_ccitt_slice8_update(const guint8 *buf, gsize len, guint32 crc)
+{
+	return crc32_slice8(crc32_ccitt_slice8, crc32_ccitt_table, buf, len, crc);
+}
+
+#ifdef HAVE_PCLMUL
+/* Folds the largest multiple of 16 bytes, and does the rest with slicing-by-8. */
+static guint32
+crc32_ccitt_pclmul_update(const guint8 *buf, gsize len, guint32 crc)
+{
+	gsize folded = len & ~(gsize)15;
+
+	if (folded >= 64) {
+		crc = crc32_ccitt_pclmul(buf, folded, crc);
+		buf += folded;
+		len -= folded;
+	}
+	return crc32_ccitt_slice8_update(buf, len, crc);
+}
+#endif
+
+/*
+ * These work on the CRC register, without any inversion or byte swapping
+ * of the seed or the result. They're chosen on first use; the environment
+ * variable WIRESHARK_CRC32 can be set to "slice8" or "bytewise" to choose
+ * a slower one, for comparison.
+ */
+static guint32 (*crc32c_update)(const guint8 *buf, gsize len, guint32 crc);
+static guint32 (*crc32_ccitt_update)(const guint8 *buf, gsize len, guint32 crc);
+
+static void
+crc32_init(void)
+{
+	static gsize initialized = 0;
+	const char *impl;
+
+	if (!g_once_init_enter(&initialized))
+		return;
+
+	impl = g_getenv("WIRESHARK_CRC32");
+	if (impl != NULL && strcmp(impl, "bytewise") == 0) {
+		crc32c_update = crc32c_bytewise;
+		crc32_ccitt_update = crc32_ccitt_bytewise;
+	} else {
+		crc32_slice8_init(crc32c_slice8, crc32c_table);
+		crc32_slice8_init(crc32_ccitt_slice8, crc32_ccitt_table);
+		crc32c_update = crc32c_slice8_update;
+		crc32_ccitt_update = crc32_ccitt_slice8_update;
+
+		if (impl == NULL || strcmp(impl, "slice8") != 0) {
+#ifdef HAVE_SSE4_2
+			if (ws_cpuid_sse42())
+				crc32c_update = crc32c_sse42;
+#endif
+#ifdef HAVE_PCLMUL
+			if (ws_cpuid_sse42() && ws_cpuid_pclmulqdq())
+				crc32_ccitt_update = crc32_ccitt_pclmul_update;
+#endif
+		}
+	}
+
+	g_once_init_leave(&initialized, 1);
+}
+
+static inline guint32
+crc32c_accumulate(const guint8 *buf, gsize len, guint32 crc)
+{
+	if (len < CRC32_SLICE8_MIN_LEN)
+		return crc32c_bytewise(buf, len, crc);
+	crc32_init();
+	return crc32c_update(buf, len, crc);
+}
+
+static inline guint32
+crc32_ccitt_accumulate(const guint8 *buf, gsize len, guint32 crc)
+{
+	if (len < CRC32_SLICE8_MIN_LEN)
+		return crc32_ccitt_bytewise(buf, len, crc);
+	crc32_init();
+	return crc32_ccitt_update(buf, len, crc);
+}
+
 guint32
 crc32c_table_lookup (guchar pos)
 {
@@ -368,23 +537,19 @@ crc32_ccitt_table_lookup (guchar pos)
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
+	if (len <= 0)
+		return crc;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	crc = crc32c_accumulate((const guint8 *)buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
-
-	return crc;
+	if (len <= 0)
+		return crc;
+	return crc32c_accumulate((const guint8 *)buf, len, crc);
 }
 
 guint32
@@ -396,13 +561,7 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
-	guint32 crc32 = seed;
-
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
-
-	return ( ~crc32 );
+	return ( ~crc32_ccitt_accumulate(buf, len, seed) );
 }
 
 guint32
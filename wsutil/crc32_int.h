@@ -0,0 +1,29 @@
+/* crc32_int.h
+ * Internal declarations for the CRC-32 routines
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CRC32_INT_H__
+#define __CRC32_INT_H__
+
+/*
+ * These work on the CRC register: the caller does any inversion or byte
+ * swapping of the seed and the result.
+ */
+#ifdef HAVE_SSE4_2
+/* CRC32C with the SSE 4.2 crc32 instruction. */
+guint32 crc32c_sse42(const guint8 *buf, gsize len, guint32 crc);
+#endif
+
+#ifdef HAVE_PCLMUL
+/* CRC32 CCITT by folding with carry-less multiplies; only for multiples
+ * of 16 bytes, at least 64 of them. */
+guint32 crc32_ccitt_pclmul(const guint8 *buf, gsize len, guint32 crc);
+#endif
+
+#endif /* __CRC32_INT_H__ */
@@ -0,0 +1,164 @@
+/* crc32_sse42.c
+ * CRC-32 routines using the SSE 4.2 crc32 and PCLMULQDQ instructions;
+ * this file is built with them enabled, and they're only called if the
+ * CPU has them.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * The folding is described in "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction", Gopal et al., Intel, 2009.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <nmmintrin.h>
+#ifdef HAVE_PCLMUL
+#include <wmmintrin.h>
+#endif
+
+#include "crc32_int.h"
+
+guint32
+crc32c_sse42(const guint8 *buf, gsize len, guint32 crc)
+{
+	while (len > 0 && ((gsize)buf & 7) != 0) {
+		crc = _mm_crc32_u8(crc, *buf++);
+		len--;
+	}
+
+#if defined(__x86_64__) || defined(_M_X64)
+	{
+		guint64 crc64 = crc;
+		guint64 data;
+
+		while (len >= 8) {
+			memcpy(&data, buf, 8);
+			crc64 = _mm_crc32_u64(crc64, data);
+			buf += 8;
+			len -= 8;
+		}
+		crc = (guint32)crc64;
+	}
+#endif
+	while (len >= 4) {
+		guint32 data;
+
+		memcpy(&data, buf, 4);
+		crc = _mm_crc32_u32(crc, data);
+		buf += 4;
+		len -= 4;
+	}
+	while (len > 0) {
+		crc = _mm_crc32_u8(crc, *buf++);
+		len--;
+	}
+	return crc;
+}
+
+#ifdef HAVE_PCLMUL
+
+#define cast_m128i(p) ((const __m128i *) (const void *) (p))
+
+/*
+ * Constants for the bit-reflected polynomial 0x04C11DB7, as in the paper:
+ * the pairs of x^n mod P for folding across four blocks and across one,
+ * the one for folding 64 bits to 32 and, for the Barrett reduction, P and
+ * floor(x^64 / P).
+ */
+static const guint64 k1k2[2] = { 0x0154442bd4, 0x01c6e41596 };
+static const guint64 k3k4[2] = { 0x01751997d0, 0x00ccaa009e };
+static const guint64 k5k0[2] = { 0x0163cd6124, 0x0000000000 };
+static const guint64 poly[2] = { 0x01db710641, 0x01f7011641 };
+
+/* Folds one 128-bit block into the next, 128 bits further on. */
+static inline __m128i
+fold_128(__m128i x, __m128i k, __m128i next)
+{
+	__m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+	__m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+
+	return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+guint32
+crc32_ccitt_pclmul(const guint8 *buf, gsize len, guint32 crc)
+{
+	__m128i x0, x1, x2, x3, x4, mask32;
+
+	/* Four blocks at a time, to keep four multiplies in flight. */
+	x1 = _mm_xor_si128(_mm_loadu_si128(cast_m128i(buf)), _mm_cvtsi32_si128((int)crc));
+	x2 = _mm_loadu_si128(cast_m128i(buf + 16));
+	x3 = _mm_loadu_si128(cast_m128i(buf + 32));
+	x4 = _mm_loadu_si128(cast_m128i(buf + 48));
+	buf += 64;
+	len -= 64;
+
+	x0 = _mm_loadu_si128(cast_m128i(k1k2));
+	while (len >= 64) {
+		x1 = fold_128(x1, x0, _mm_loadu_si128(cast_m128i(buf)));
+		x2 = fold_128(x2, x0, _mm_loadu_si128(cast_m128i(buf + 16)));
+		x3 = fold_128(x3, x0, _mm_loadu_si128(cast_m128i(buf + 32)));
+		x4 = fold_128(x4, x0, _mm_loadu_si128(cast_m128i(buf + 48)));
+		buf += 64;
+		len -= 64;
+	}
+
+	/* Fold them into one, then fold in the remaining blocks. */
+	x0 = _mm_loadu_si128(cast_m128i(k3k4));
+	x1 = fold_128(x1, x0, x2);
+	x1 = fold_128(x1, x0, x3);
+	x1 = fold_128(x1, x0, x4);
+	while (len >= 16) {
+		x1 = fold_128(x1, x0, _mm_loadu_si128(cast_m128i(buf)));
+		buf += 16;
+		len -= 16;
+	}
+
+	/* Fold 128 bits to 64. */
+	mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x0 = _mm_loadl_epi64(cast_m128i(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits. */
+	x0 = _mm_loadu_si128(cast_m128i(poly));
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (guint32)_mm_extract_epi32(x1, 1);
+}
+
+#endif /* HAVE_PCLMUL */
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
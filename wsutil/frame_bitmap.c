@@ -0,0 +1,528 @@
+/* frame_bitmap.c
+ * Compressed sets of frame numbers
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "frame_bitmap.h"
+#include "bits_count_ones.h"
+#include "bits_ctz.h"
+
+#define CHUNK_WORDS	(65536 / 64)	/* guint64 words in a bitmap chunk */
+#define ARRAY_MAX	4096		/* beyond this a bitmap is smaller */
+
+#define WORD_BIT(low)	(G_GUINT64_CONSTANT(1) << ((low) % 64))
+
+typedef struct {
+	guint16	key;		/* upper 16 bits of the values in this chunk */
+	guint32	cardinality;
+	guint32	capacity;	/* allocated entries of "array" */
+	guint16	*array;		/* sorted lower 16 bits, if "bits" is NULL */
+	guint64	*bits;		/* CHUNK_WORDS words, or NULL */
+} fb_chunk_t;
+
+struct frame_bitmap {
+	fb_chunk_t	*chunks;	/* sorted by key */
+	guint		num_chunks;
+	guint		max_chunks;
+};
+
+frame_bitmap_t *
+frame_bitmap_new(void)
+{
+	return g_new0(frame_bitmap_t, 1);
+}
+
+void
+frame_bitmap_free(frame_bitmap_t *fb)
+{
+	guint i;
+
+	if (!fb)
+		return;
+
+	for (i = 0; i < fb->num_chunks; i++) {
+		g_free(fb->chunks[i].array);
+		g_free(fb->chunks[i].bits);
+	}
+	g_free(fb->chunks);
+	g_free(fb);
+}
+
+/* Returns the chunk for "key", or NULL; "pos" is set to the index of the
+ * first chunk whose key is >= "key". */
+static fb_chunk_t *
+fb_find_chunk(const frame_bitmap_t *fb, guint16 key, guint *pos)
+{
+	guint lo = 0, hi = fb->num_chunks, mid;
+
+	/* Values are mostly added and looked up in increasing order. */
+	if (hi > 0 && fb->chunks[hi - 1].key <= key)
+		lo = hi - 1;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (fb->chunks[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (pos)
+		*pos = lo;
+	if (lo < fb->num_chunks && fb->chunks[lo].key == key)
+		return &fb->chunks[lo];
+	return NULL;
+}
+
+static fb_chunk_t *
+fb_insert_chunk(frame_bitmap_t *fb, guint pos, guint16 key)
+{
+	fb_chunk_t *c;
+
+	if (fb->num_chunks == fb->max_chunks) {
+		fb->max_chunks = fb->max_chunks ? fb->max_chunks * 2 : 4;
+		fb->chunks = g_renew(fb_chunk_t, fb->chunks, fb->max_chunks);
+	}
+	memmove(&fb->chunks[pos + 1], &fb->chunks[pos],
+		(fb->num_chunks - pos) * sizeof(fb_chunk_t));
+	fb->num_chunks++;
+
+	c = &fb->chunks[pos];
+	memset(c, 0, sizeof(*c));
+	c->key = key;
+	return c;
+}
+
+/* Index of the first entry of "array" that is >= "low" */
+static guint32
+fb_array_lower_bound(const guint16 *array, guint32 count, guint16 low)
+{
+	guint32 lo = 0, hi = count, mid;
+
+	if (count > 0 && array[count - 1] < low)
+		return count;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (array[mid] < low)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Fills "words" with the contents of chunk "c". */
+static void
+fb_chunk_to_words(const fb_chunk_t *c, guint64 *words)
+{
+	guint32 i;
+
+	if (c->bits) {
+		memcpy(words, c->bits, CHUNK_WORDS * sizeof(guint64));
+		return;
+	}
+	memset(words, 0, CHUNK_WORDS * sizeof(guint64));
+	for (i = 0; i < c->cardinality; i++)
+		words[c->array[i] / 64] |= WORD_BIT(c->array[i]);
+}
+
+/* Appends a chunk with the contents of "words", in whichever form is
+ * smaller. The key must be larger than that of any chunk in "fb". */
+static void
+fb_append_words(frame_bitmap_t *fb, guint16 key, const guint64 *words)
+{
+	fb_chunk_t *c;
+	guint32 cardinality = 0, n = 0;
+	guint64 word;
+	guint i;
+
+	for (i = 0; i < CHUNK_WORDS; i++)
+		cardinality += ws_count_ones(words[i]);
+	if (cardinality == 0)
+		return;
+
+	c = fb_insert_chunk(fb, fb->num_chunks, key);
+	c->cardinality = cardinality;
+	if (cardinality > ARRAY_MAX) {
+		c->bits = g_new(guint64, CHUNK_WORDS);
+		memcpy(c->bits, words, CHUNK_WORDS * sizeof(guint64));
+		return;
+	}
+
+	c->capacity = cardinality;
+	c->array = g_new(guint16, cardinality);
+	for (i = 0; i < CHUNK_WORDS; i++) {
+		for (word = words[i]; word != 0; word &= word - 1)
+			c->array[n++] = (guint16)(i * 64 + ws_ctz(word));
+	}
+}
+
+/* Appends a chunk that takes over "array", which holds "count" entries. */
+static void
+fb_append_array(frame_bitmap_t *fb, guint16 key, guint16 *array, guint32 count)
+{
+	fb_chunk_t *c;
+
+	if (count == 0) {
+		g_free(array);
+		return;
+	}
+	c = fb_insert_chunk(fb, fb->num_chunks, key);
+	c->cardinality = count;
+	c->capacity = count;
+	c->array = g_renew(guint16, array, count);
+}
+
+static void
+fb_append_copy(frame_bitmap_t *fb, const fb_chunk_t *src)
+{
+	fb_chunk_t *c;
+
+	c = fb_insert_chunk(fb, fb->num_chunks, src->key);
+	c->cardinality = src->cardinality;
+	if (src->bits) {
+		c->bits = g_new(guint64, CHUNK_WORDS);
+		memcpy(c->bits, src->bits, CHUNK_WORDS * sizeof(guint64));
+	} else {
+		c->capacity = src->cardinality;
+		c->array = g_new(guint16, src->cardinality);
+		memcpy(c->array, src->array, src->cardinality * sizeof(guint16));
+	}
+}
+
+frame_bitmap_t *
+frame_bitmap_copy(const frame_bitmap_t *fb)
+{
+	frame_bitmap_t *copy;
+	guint i;
+
+	copy = frame_bitmap_new();
+	for (i = 0; i < fb->num_chunks; i++)
+		fb_append_copy(copy, &fb->chunks[i]);
+	return copy;
+}
+
+void
+frame_bitmap_add(frame_bitmap_t *fb, guint32 value)
+{
+	guint16 key = (guint16)(value >> 16);
+	guint16 low = (guint16)(value & 0xffff);
+	fb_chunk_t *c;
+	guint64 *bits;
+	guint32 i;
+	guint pos;
+
+	c = fb_find_chunk(fb, key, &pos);
+	if (!c)
+		c = fb_insert_chunk(fb, pos, key);
+
+	if (!c->bits) {
+		i = fb_array_lower_bound(c->array, c->cardinality, low);
+		if (i < c->cardinality && c->array[i] == low)
+			return;
+
+		if (c->cardinality < ARRAY_MAX) {
+			if (c->cardinality == c->capacity) {
+				c->capacity = c->capacity ? MIN(c->capacity * 2, ARRAY_MAX) : 4;
+				c->array = g_renew(guint16, c->array, c->capacity);
+			}
+			memmove(&c->array[i + 1], &c->array[i],
+				(c->cardinality - i) * sizeof(guint16));
+			c->array[i] = low;
+			c->cardinality++;
+			return;
+		}
+
+		/* The array is full; switch to a bitmap. */
+		bits = g_new(guint64, CHUNK_WORDS);
+		fb_chunk_to_words(c, bits);
+		c->bits = bits;
+		g_free(c->array);
+		c->array = NULL;
+		c->capacity = 0;
+	}
+
+	if (!(c->bits[low / 64] & WORD_BIT(low))) {
+		c->bits[low / 64] |= WORD_BIT(low);
+		c->cardinality++;
+	}
+}
+
+gboolean
+frame_bitmap_contains(const frame_bitmap_t *fb, guint32 value)
+{
+	guint16 low = (guint16)(value & 0xffff);
+	const fb_chunk_t *c;
+	guint32 i;
+
+	c = fb_find_chunk(fb, (guint16)(value >> 16), NULL);
+	if (!c)
+		return FALSE;
+	if (c->bits)
+		return (c->bits[low / 64] & WORD_BIT(low)) != 0;
+
+	i = fb_array_lower_bound(c->array, c->cardinality, low);
+	return i < c->cardinality && c->array[i] == low;
+}
+
+gboolean
+frame_bitmap_next(const frame_bitmap_t *fb, guint32 from, guint32 *value)
+{
+	guint16 key = (guint16)(from >> 16);
+	const fb_chunk_t *c;
+	guint32 start, i;
+	guint64 word;
+	guint pos;
+
+	fb_find_chunk(fb, key, &pos);
+	for (; pos < fb->num_chunks; pos++) {
+		c = &fb->chunks[pos];
+		start = (c->key == key) ? (from & 0xffff) : 0;
+
+		if (c->bits) {
+			i = start / 64;
+			word = c->bits[i] & (G_GUINT64_CONSTANT(0xffffffffffffffff) << (start % 64));
+			for (;;) {
+				if (word != 0) {
+					*value = ((guint32)c->key << 16) | (i * 64 + ws_ctz(word));
+					return TRUE;
+				}
+				if (++i == CHUNK_WORDS)
+					break;
+				word = c->bits[i];
+			}
+		} else {
+			i = fb_array_lower_bound(c->array, c->cardinality, (guint16)start);
+			if (i < c->cardinality) {
+				*value = ((guint32)c->key << 16) | c->array[i];
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+guint32
+frame_bitmap_cardinality(const frame_bitmap_t *fb)
+{
+	guint32 cardinality = 0;
+	guint i;
+
+	for (i = 0; i < fb->num_chunks; i++)
+		cardinality += fb->chunks[i].cardinality;
+	return cardinality;
+}
+
+gsize
+frame_bitmap_memory_size(const frame_bitmap_t *fb)
+{
+	gsize size;
+	guint i;
+
+	size = sizeof(*fb) + fb->max_chunks * sizeof(fb_chunk_t);
+	for (i = 0; i < fb->num_chunks; i++) {
+		if (fb->chunks[i].bits)
+			size += CHUNK_WORDS * sizeof(guint64);
+		else
+			size += fb->chunks[i].capacity * sizeof(guint16);
+	}
+	return size;
+}
+
+static void
+fb_and_chunks(frame_bitmap_t *result, const fb_chunk_t *a, const fb_chunk_t *b,
+	guint64 *words)
+{
+	const fb_chunk_t *tmp;
+	guint16 *array;
+	guint32 i, j, n = 0;
+
+	if (a->bits && b->bits) {
+		for (i = 0; i < CHUNK_WORDS; i++)
+			words[i] = a->bits[i] & b->bits[i];
+		fb_append_words(result, a->key, words);
+		return;
+	}
+
+	/* At least one of them is an array, so the result is one too. */
+	if (a->bits) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+	array = g_new(guint16, a->cardinality);
+	if (b->bits) {
+		for (i = 0; i < a->cardinality; i++) {
+			if (b->bits[a->array[i] / 64] & WORD_BIT(a->array[i]))
+				array[n++] = a->array[i];
+		}
+	} else {
+		for (i = 0, j = 0; i < a->cardinality && j < b->cardinality; ) {
+			if (a->array[i] < b->array[j]) {
+				i++;
+			} else if (a->array[i] > b->array[j]) {
+				j++;
+			} else {
+				array[n++] = a->array[i];
+				i++;
+				j++;
+			}
+		}
+	}
+	fb_append_array(result, a->key, array, n);
+}
+
+frame_bitmap_t *
+frame_bitmap_and(const frame_bitmap_t *a, const frame_bitmap_t *b)
+{
+	frame_bitmap_t *result;
+	guint64 *words;
+	guint i = 0, j = 0;
+
+	result = frame_bitmap_new();
+	words = g_new(guint64, CHUNK_WORDS);
+	while (i < a->num_chunks && j < b->num_chunks) {
+		if (a->chunks[i].key < b->chunks[j].key) {
+			i++;
+		} else if (a->chunks[i].key > b->chunks[j].key) {
+			j++;
+		} else {
+			fb_and_chunks(result, &a->chunks[i], &b->chunks[j], words);
+			i++;
+			j++;
+		}
+	}
+	g_free(words);
+	return result;
+}
+
+static void
+fb_or_chunks(frame_bitmap_t *result, const fb_chunk_t *a, const fb_chunk_t *b,
+	guint64 *words)
+{
+	guint16 *array;
+	guint32 i, j, n = 0;
+
+	if (!a->bits && !b->bits && a->cardinality + b->cardinality <= ARRAY_MAX) {
+		array = g_new(guint16, a->cardinality + b->cardinality);
+		for (i = 0, j = 0; i < a->cardinality || j < b->cardinality; ) {
+			if (j == b->cardinality || (i < a->cardinality && a->array[i] < b->array[j])) {
+				array[n++] = a->array[i++];
+			} else if (i == a->cardinality || a->array[i] > b->array[j]) {
+				array[n++] = b->array[j++];
+			} else {
+				array[n++] = a->array[i];
+				i++;
+				j++;
+			}
+		}
+		fb_append_array(result, a->key, array, n);
+		return;
+	}
+
+	fb_chunk_to_words(a, words);
+	if (b->bits) {
+		for (i = 0; i < CHUNK_WORDS; i++)
+			words[i] |= b->bits[i];
+	} else {
+		for (i = 0; i < b->cardinality; i++)
+			words[b->array[i] / 64] |= WORD_BIT(b->array[i]);
+	}
+	fb_append_words(result, a->key, words);
+}
+
+frame_bitmap_t *
+frame_bitmap_or(const frame_bitmap_t *a, const frame_bitmap_t *b)
+{
+	frame_bitmap_t *result;
+	guint64 *words;
+	guint i = 0, j = 0;
+
+	result = frame_bitmap_new();
+	words = g_new(guint64, CHUNK_WORDS);
+	while (i < a->num_chunks || j < b->num_chunks) {
+		if (j == b->num_chunks ||
+		    (i < a->num_chunks && a->chunks[i].key < b->chunks[j].key)) {
+			fb_append_copy(result, &a->chunks[i++]);
+		} else if (i == a->num_chunks || a->chunks[i].key > b->chunks[j].key) {
+			fb_append_copy(result, &b->chunks[j++]);
+		} else {
+			fb_or_chunks(result, &a->chunks[i], &b->chunks[j], words);
+			i++;
+			j++;
+		}
+	}
+	g_free(words);
+	return result;
+}
+
+frame_bitmap_t *
+frame_bitmap_complement(const frame_bitmap_t *fb, guint32 first, guint32 last)
+{
+	frame_bitmap_t *result;
+	const fb_chunk_t *c;
+	guint64 *words;
+	guint64 mask;
+	guint32 key, first_key, last_key, lo, hi, wlo, whi, i;
+	guint pos;
+
+	result = frame_bitmap_new();
+	if (first > last)
+		return result;
+
+	words = g_new(guint64, CHUNK_WORDS);
+	first_key = first >> 16;
+	last_key = last >> 16;
+	fb_find_chunk(fb, (guint16)first_key, &pos);
+	for (key = first_key; key <= last_key; key++) {
+		lo = (key == first_key) ? (first & 0xffff) : 0;
+		hi = (key == last_key) ? (last & 0xffff) : 0xffff;
+
+		c = (pos < fb->num_chunks && fb->chunks[pos].key == key) ? &fb->chunks[pos++] : NULL;
+		if (c)
+			fb_chunk_to_words(c, words);
+		else
+			memset(words, 0, CHUNK_WORDS * sizeof(guint64));
+
+		for (i = 0; i < CHUNK_WORDS; i++) {
+			wlo = i * 64;
+			whi = wlo + 63;
+			if (whi < lo || wlo > hi) {
+				words[i] = 0;
+				continue;
+			}
+			mask = G_GUINT64_CONSTANT(0xffffffffffffffff);
+			if (lo > wlo)
+				mask &= mask << (lo - wlo);
+			if (hi < whi)
+				mask &= G_GUINT64_CONSTANT(0xffffffffffffffff) >> (whi - hi);
+			words[i] = ~words[i] & mask;
+		}
+		fb_append_words(result, (guint16)key, words);
+	}
+	g_free(words);
+	return result;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,103 @@
+/* frame_bitmap.h
+ * Compressed sets of frame numbers
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_FRAME_BITMAP_H__
+#define __WSUTIL_FRAME_BITMAP_H__
+
+#include "ws_symbol_export.h"
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A set of 32-bit values, typically the frame numbers that match a
+ * display filter, stored in the manner of a "roaring" bitmap: the value
+ * space is cut into chunks of 65536 keyed by the upper 16 bits, and each
+ * chunk present in the set is held either as a sorted array of its lower
+ * 16 bits (up to 4096 entries) or as a plain 8 KiB bitmap, whichever is
+ * smaller. A sparse filter over a large capture thus costs a couple of
+ * bytes per match, a dense one at most one bit per frame.
+ */
+typedef struct frame_bitmap frame_bitmap_t;
+
+WS_DLL_PUBLIC
+frame_bitmap_t *
+frame_bitmap_new(void);
+
+WS_DLL_PUBLIC
+void
+frame_bitmap_free(frame_bitmap_t *fb);
+
+WS_DLL_PUBLIC
+frame_bitmap_t *
+frame_bitmap_copy(const frame_bitmap_t *fb);
+
+/* Adds "value" to the set. Adding values in increasing order is cheapest. */
+WS_DLL_PUBLIC
+void
+frame_bitmap_add(frame_bitmap_t *fb, guint32 value);
+
+WS_DLL_PUBLIC
+gboolean
+frame_bitmap_contains(const frame_bitmap_t *fb, guint32 value);
+
+/* Finds the smallest value in the set that is >= "from". Returns FALSE
+ * if there is none. */
+WS_DLL_PUBLIC
+gboolean
+frame_bitmap_next(const frame_bitmap_t *fb, guint32 from, guint32 *value);
+
+/* Number of values in the set */
+WS_DLL_PUBLIC
+guint32
+frame_bitmap_cardinality(const frame_bitmap_t *fb);
+
+/* Approximate number of bytes of memory used by the set */
+WS_DLL_PUBLIC
+gsize
+frame_bitmap_memory_size(const frame_bitmap_t *fb);
+
+/* Returns a new set holding the values in both "a" and "b". */
+WS_DLL_PUBLIC
+frame_bitmap_t *
+frame_bitmap_and(const frame_bitmap_t *a, const frame_bitmap_t *b);
+
+/* Returns a new set holding the values in "a", "b" or both. */
+WS_DLL_PUBLIC
+frame_bitmap_t *
+frame_bitmap_or(const frame_bitmap_t *a, const frame_bitmap_t *b);
+
+/* Returns a new set holding the values in [first, last] that are not
+ * in "fb". */
+WS_DLL_PUBLIC
+frame_bitmap_t *
+frame_bitmap_complement(const frame_bitmap_t *fb, guint32 first, guint32 last);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WSUTIL_FRAME_BITMAP_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,232 @@
+/* frame_bitmap_test.c
+ * Standalone program to test frame_bitmap against a plain array of
+ * booleans, for sparse and dense chunks and across chunk boundaries.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "frame_bitmap.h"
+
+/* Four chunks: empty, sparse (array), dense (bitmap) and mixed */
+#define TEST_RANGE	(4 * 65536)
+
+static gboolean failed = FALSE;
+
+typedef struct {
+	frame_bitmap_t *fb;
+	gboolean *ref;		/* TEST_RANGE entries */
+} test_set_t;
+
+static void
+test_set_init(test_set_t *ts)
+{
+	ts->fb = frame_bitmap_new();
+	ts->ref = g_new0(gboolean, TEST_RANGE);
+}
+
+static void
+test_set_free(test_set_t *ts)
+{
+	frame_bitmap_free(ts->fb);
+	g_free(ts->ref);
+}
+
+static void
+test_set_add(test_set_t *ts, guint32 value)
+{
+	frame_bitmap_add(ts->fb, value);
+	ts->ref[value] = TRUE;
+}
+
+/* Fills "ts" in "order": 0 increasing, 1 decreasing, 2 random. */
+static void
+test_set_fill(test_set_t *ts, GRand *rand, double sparse, double dense, int order)
+{
+	guint32 i, value;
+
+	test_set_init(ts);
+	for (i = 0; i < TEST_RANGE; i++) {
+		value = order == 1 ? TEST_RANGE - 1 - i : i;
+		/* Chunk 0 stays empty. */
+		if (value < 65536)
+			continue;
+		if (value < 2 * 65536) {
+			if (g_rand_double(rand) < sparse)
+				test_set_add(ts, value);
+		} else if (value < 3 * 65536) {
+			if (g_rand_double(rand) < dense)
+				test_set_add(ts, value);
+		} else {
+			/* Dense and sparse halves */
+			if (g_rand_double(rand) < (value % 65536 < 32768 ? dense : sparse))
+				test_set_add(ts, value);
+		}
+	}
+	if (order == 2) {
+		/* Add some again, out of order; this changes nothing. */
+		for (i = 0; i < 10000; i++) {
+			value = g_rand_int_range(rand, 0, TEST_RANGE);
+			if (ts->ref[value])
+				frame_bitmap_add(ts->fb, value);
+		}
+	}
+}
+
+static void
+check(const char *what, const frame_bitmap_t *fb, const gboolean *ref)
+{
+	guint32 i, count = 0, next;
+	gboolean found;
+
+	for (i = 0; i < TEST_RANGE; i++) {
+		if (frame_bitmap_contains(fb, i) != ref[i]) {
+			printf("Failed %s: contains(%u) is %d\n", what, i, !ref[i]);
+			failed = TRUE;
+			return;
+		}
+		if (ref[i])
+			count++;
+	}
+	if (frame_bitmap_cardinality(fb) != count) {
+		printf("Failed %s: cardinality %u, expected %u\n", what,
+		       frame_bitmap_cardinality(fb), count);
+		failed = TRUE;
+	}
+
+	/* Walk the set with frame_bitmap_next(). */
+	i = 0;
+	for (;;) {
+		found = frame_bitmap_next(fb, i, &next);
+		while (i < TEST_RANGE && !ref[i])
+			i++;
+		if (i == TEST_RANGE) {
+			if (found) {
+				printf("Failed %s: next() found %u past the last value\n", what, next);
+				failed = TRUE;
+			}
+			break;
+		}
+		if (!found || next != i) {
+			printf("Failed %s: next() didn't find %u\n", what, i);
+			failed = TRUE;
+			break;
+		}
+		i++;
+	}
+}
+
+static void
+test_basic(void)
+{
+	frame_bitmap_t *fb = frame_bitmap_new();
+	guint32 value;
+
+	if (frame_bitmap_cardinality(fb) != 0 || frame_bitmap_contains(fb, 0) ||
+	    frame_bitmap_next(fb, 0, &value)) {
+		printf("Failed: the empty set isn't empty\n");
+		failed = TRUE;
+	}
+
+	/* The extremes of the value space */
+	frame_bitmap_add(fb, G_MAXUINT32);
+	frame_bitmap_add(fb, 0);
+	frame_bitmap_add(fb, 65535);
+	frame_bitmap_add(fb, 65536);
+	if (frame_bitmap_cardinality(fb) != 4 ||
+	    !frame_bitmap_contains(fb, 0) || !frame_bitmap_contains(fb, G_MAXUINT32) ||
+	    frame_bitmap_contains(fb, G_MAXUINT32 - 1) ||
+	    !frame_bitmap_next(fb, 65537, &value) || value != G_MAXUINT32 ||
+	    !frame_bitmap_next(fb, 1, &value) || value != 65535) {
+		printf("Failed: extreme values\n");
+		failed = TRUE;
+	}
+	frame_bitmap_free(fb);
+}
+
+static void
+test_ops(GRand *rand, double sparse, double dense)
+{
+	test_set_t a, b;
+	frame_bitmap_t *result;
+	gboolean *ref = g_new(gboolean, TEST_RANGE);
+	guint32 first = 65536 + 1000, last = 3 * 65536 + 40000;
+	guint32 i;
+	int order;
+
+	for (order = 0; order < 3; order++) {
+		test_set_fill(&a, rand, sparse, dense, order);
+		test_set_fill(&b, rand, dense, sparse, (order + 1) % 3);
+		check("fill", a.fb, a.ref);
+		check("fill", b.fb, b.ref);
+
+		result = frame_bitmap_copy(a.fb);
+		check("copy", result, a.ref);
+		frame_bitmap_free(result);
+
+		result = frame_bitmap_and(a.fb, b.fb);
+		for (i = 0; i < TEST_RANGE; i++)
+			ref[i] = a.ref[i] && b.ref[i];
+		check("and", result, ref);
+		frame_bitmap_free(result);
+
+		result = frame_bitmap_or(a.fb, b.fb);
+		for (i = 0; i < TEST_RANGE; i++)
+			ref[i] = a.ref[i] || b.ref[i];
+		check("or", result, ref);
+		frame_bitmap_free(result);
+
+		result = frame_bitmap_complement(a.fb, first, last);
+		for (i = 0; i < TEST_RANGE; i++)
+			ref[i] = i >= first && i <= last && !a.ref[i];
+		check("complement", result, ref);
+		frame_bitmap_free(result);
+
+		test_set_free(&a);
+		test_set_free(&b);
+	}
+	g_free(ref);
+}
+
+int
+main(void)
+{
+	GRand *rand = g_rand_new_with_seed(1);
+
+	test_basic();
+	/* Chunks well below, around and well above the array limit of
+	 * 4096 values, and full ones. */
+	test_ops(rand, 0.01, 0.5);
+	test_ops(rand, 4000.0 / 65536, 4200.0 / 65536);
+	test_ops(rand, 0.001, 1.0);
+	g_rand_free(rand);
+
+	if (failed)
+		exit(1);
+	printf("Passed frame_bitmap tests\n");
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
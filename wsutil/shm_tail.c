@@ -0,0 +1,368 @@
+/* shm_tail.c
+ * The end of a file being written, mirrored in shared memory
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE /* Otherwise memfd_create won't be defined on Linux */
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "shm_tail.h"
+
+#include "ws_attributes.h"
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SHM_TAIL_MAGIC      0x5773546c  /* "WsTl" */
+#define SHM_TAIL_VERSION    1
+#define SHM_TAIL_PAGE_SIZE  4096
+
+/* Times a reader tries to get a consistent view of the header before it
+   gives up and reads from the file; the writer only holds seq odd for a
+   moment, unless it died doing so. */
+#define SHM_TAIL_READ_TRIES 1000
+
+/* Orders a reader's plain reads of the shared memory before its read of
+   seq that follows; without memfd_create() there's no shared memory. */
+#ifdef HAVE_MEMFD_CREATE
+#define SHM_TAIL_ACQUIRE_FENCE()    __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#define SHM_TAIL_ACQUIRE_FENCE()
+#endif
+
+/*
+ * The header at the start of the shared memory; the window's bytes
+ * start on the next page.  The window holds the bytes of the file from
+ * start up to end, the byte at offset x being at data[x % size].
+ *
+ * The writer makes seq odd while it changes the file or moves start, and
+ * even again when it's done, so that a reader can tell whether what it
+ * copied could have been overwritten while it was copying it; end is
+ * only ever moved forward, after the bytes are in place.
+ */
+typedef struct {
+    guint32        magic;
+    guint32        version;
+    guint64        size;
+    volatile gint  seq;
+    guint32        pad;
+    guint64        dev;
+    guint64        ino;
+    guint64        start;
+    guint64        end;
+} shm_tail_hdr_t;
+
+/* What a reader needs of the header */
+typedef struct {
+    guint64        dev;
+    guint64        ino;
+    guint64        start;
+    guint64        end;
+} shm_tail_view_t;
+
+struct shm_tail {
+    shm_tail_hdr_t *hdr;
+    guint8         *data;
+    gsize           size;       /* of the window, not the mapping */
+    int             fd;
+    gint            refcount;
+};
+
+#ifdef HAVE_MEMFD_CREATE
+
+static shm_tail_t *
+shm_tail_map(int fd, gsize map_size, int *err)
+{
+    shm_tail_t *tail;
+    void *addr;
+
+    addr = mmap(NULL, map_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        *err = errno;
+        return NULL;
+    }
+    tail = g_new0(shm_tail_t, 1);
+    tail->hdr = (shm_tail_hdr_t *)addr;
+    tail->data = (guint8 *)addr + SHM_TAIL_PAGE_SIZE;
+    tail->size = map_size - SHM_TAIL_PAGE_SIZE;
+    tail->fd = fd;
+    tail->refcount = 1;
+    return tail;
+}
+
+shm_tail_t *
+shm_tail_create(gsize size, int *err)
+{
+    shm_tail_t *tail;
+    gsize map_size;
+    int fd;
+
+    size = (size + SHM_TAIL_PAGE_SIZE - 1) & ~(gsize)(SHM_TAIL_PAGE_SIZE - 1);
+    if (size == 0) {
+        *err = EINVAL;
+        return NULL;
+    }
+    map_size = SHM_TAIL_PAGE_SIZE + size;
+
+    fd = memfd_create("wireshark-capture-tail", MFD_CLOEXEC);
+    if (fd == -1) {
+        *err = errno;
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)map_size) == -1) {
+        *err = errno;
+        close(fd);
+        return NULL;
+    }
+    tail = shm_tail_map(fd, map_size, err);
+    if (tail == NULL) {
+        close(fd);
+        return NULL;
+    }
+    tail->hdr->size = size;
+    tail->hdr->version = SHM_TAIL_VERSION;
+    tail->hdr->magic = SHM_TAIL_MAGIC;
+    return tail;
+}
+
+shm_tail_t *
+shm_tail_open_fd(int fd, int *err)
+{
+    shm_tail_t *tail;
+    struct stat st;
+
+    if (fstat(fd, &st) == -1) {
+        *err = errno;
+        return NULL;
+    }
+    if ((guint64)st.st_size <= SHM_TAIL_PAGE_SIZE) {
+        *err = EINVAL;
+        return NULL;
+    }
+    tail = shm_tail_map(fd, (gsize)st.st_size, err);
+    if (tail == NULL)
+        return NULL;
+    if (tail->hdr->magic != SHM_TAIL_MAGIC ||
+        tail->hdr->version != SHM_TAIL_VERSION ||
+        tail->hdr->size != (guint64)st.st_size - SHM_TAIL_PAGE_SIZE) {
+        munmap(tail->hdr, (gsize)st.st_size);
+        g_free(tail);
+        *err = EINVAL;
+        return NULL;
+    }
+    return tail;
+}
+
+void
+shm_tail_unref(shm_tail_t *tail)
+{
+    if (tail == NULL || !g_atomic_int_dec_and_test(&tail->refcount))
+        return;
+    munmap(tail->hdr, SHM_TAIL_PAGE_SIZE + tail->size);
+    close(tail->fd);
+    g_free(tail);
+}
+
+gboolean
+shm_tail_file_id(int fd, guint64 *dev, guint64 *ino)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) == -1)
+        return FALSE;
+    *dev = (guint64)st.st_dev;
+    *ino = (guint64)st.st_ino;
+    return TRUE;
+}
+
+#else /* HAVE_MEMFD_CREATE */
+
+shm_tail_t *
+shm_tail_create(gsize size _U_, int *err)
+{
+    *err = ENOSYS;
+    return NULL;
+}
+
+shm_tail_t *
+shm_tail_open_fd(int fd _U_, int *err)
+{
+    *err = ENOSYS;
+    return NULL;
+}
+
+void
+shm_tail_unref(shm_tail_t *tail _U_)
+{
+}
+
+gboolean
+shm_tail_file_id(int fd _U_, guint64 *dev _U_, guint64 *ino _U_)
+{
+    return FALSE;
+}
+
+#endif /* HAVE_MEMFD_CREATE */
+
+int
+shm_tail_fd(shm_tail_t *tail)
+{
+    return tail->fd;
+}
+
+gsize
+shm_tail_size(shm_tail_t *tail)
+{
+    return tail->size;
+}
+
+shm_tail_t *
+shm_tail_ref(shm_tail_t *tail)
+{
+    g_atomic_int_inc(&tail->refcount);
+    return tail;
+}
+
+void
+shm_tail_begin_file(shm_tail_t *tail, int fd, guint64 offset)
+{
+    shm_tail_hdr_t *hdr = tail->hdr;
+    guint64 dev = 0, ino = 0;
+
+    /* If we can't tell what the file is, no reader will match it. */
+    shm_tail_file_id(fd, &dev, &ino);
+
+    g_atomic_int_inc(&hdr->seq);
+    hdr->dev = dev;
+    hdr->ino = ino;
+    hdr->start = offset;
+    hdr->end = offset;
+    g_atomic_int_inc(&hdr->seq);
+}
+
+void
+shm_tail_append(shm_tail_t *tail, const guint8 *data, gsize len)
+{
+    shm_tail_hdr_t *hdr = tail->hdr;
+    guint64 end = hdr->end;
+    gsize pos, n;
+
+    if (len > tail->size) {
+        /* Only the last size bytes will be left. */
+        end += len - tail->size;
+        data += len - tail->size;
+        len = tail->size;
+    }
+
+    /* Give up the bytes we're about to overwrite before overwriting them. */
+    if (end + len - hdr->start > tail->size) {
+        g_atomic_int_inc(&hdr->seq);
+        hdr->start = end + len - tail->size;
+        if (hdr->end < hdr->start)
+            hdr->end = hdr->start;
+        g_atomic_int_inc(&hdr->seq);
+    }
+
+    while (len != 0) {
+        pos = (gsize)(end % tail->size);
+        n = MIN(len, tail->size - pos);
+        memcpy(tail->data + pos, data, n);
+        data += n;
+        len -= n;
+        end += n;
+    }
+
+    /* A full barrier, so the bytes are there before end says they are. */
+    g_atomic_int_inc(&hdr->seq);
+    hdr->end = end;
+    g_atomic_int_inc(&hdr->seq);
+}
+
+/* Gets a consistent copy of the header, and the seq it was had at.
+   Returns FALSE if the writer kept changing it. */
+static gboolean
+shm_tail_get_view(shm_tail_hdr_t *hdr, shm_tail_view_t *view, gint *seqp)
+{
+    guint tries;
+    gint seq;
+
+    for (tries = 0; tries < SHM_TAIL_READ_TRIES; tries++) {
+        seq = g_atomic_int_get(&hdr->seq);
+        if (seq & 1)
+            continue;
+        view->dev = hdr->dev;
+        view->ino = hdr->ino;
+        view->start = hdr->start;
+        view->end = hdr->end;
+        SHM_TAIL_ACQUIRE_FENCE();
+        if (g_atomic_int_get(&hdr->seq) == seq) {
+            *seqp = seq;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gsize
+shm_tail_read(shm_tail_t *tail, guint64 dev, guint64 ino,
+              guint64 offset, guint8 *buf, gsize len)
+{
+    shm_tail_hdr_t *hdr = tail->hdr;
+    shm_tail_view_t view;
+    gsize copied, pos, n;
+    gint seq;
+
+    if (!shm_tail_get_view(hdr, &view, &seq))
+        return 0;
+    if (view.dev != dev || view.ino != ino || offset < view.start || offset >= view.end)
+        return 0;
+
+    len = (gsize)MIN((guint64)len, view.end - offset);
+    copied = 0;
+    while (copied < len) {
+        pos = (gsize)((offset + copied) % tail->size);
+        n = MIN(len - copied, tail->size - pos);
+        memcpy(buf + copied, tail->data + pos, n);
+        copied += n;
+    }
+
+    /*
+     * If start moved past offset while we were copying, the writer may
+     * have overwritten some of what we copied.  Changing the file moves
+     * start as well.
+     */
+    SHM_TAIL_ACQUIRE_FENCE();
+    if (g_atomic_int_get(&hdr->seq) != seq) {
+        if (!shm_tail_get_view(hdr, &view, &seq) ||
+            view.dev != dev || view.ino != ino || view.start > offset)
+            return 0;
+    }
+    return copied;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
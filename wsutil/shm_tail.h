@@ -0,0 +1,96 @@
+/* shm_tail.h
+ * The end of a file being written, mirrored in shared memory
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __SHM_TAIL_H__
+#define __SHM_TAIL_H__
+
+#include "ws_symbol_export.h"
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A window, in shared memory, onto the last bytes written to a file, so
+ * that a process reading the file as another one writes it can get what
+ * was just written without waiting for it to reach the file, and without
+ * reading it back from the file.
+ *
+ * The writer appends everything it writes to the file to the window as
+ * well, and the window keeps the most recent bytes.  The writer must
+ * have handed anything that falls out of the window to the OS, so that a
+ * reader can always get the bytes it can't get from the window from the
+ * file; a reader that finds the bytes it wants aren't in the window, or
+ * were replaced while it was copying them, reads them from the file.
+ *
+ * The window is backed by a memfd, which is handed to the writer process
+ * by inheritance; it's only available where memfd_create() is.  There
+ * can be one writer, and any number of readers.
+ */
+typedef struct shm_tail shm_tail_t;
+
+/* Creates a window of size bytes, rounded up to a whole page.  Returns
+ * NULL, and sets *err, if that can't be done. */
+WS_DLL_PUBLIC shm_tail_t *shm_tail_create(gsize size, int *err);
+
+/* Maps the window with the given fd, as returned by shm_tail_fd() in the
+ * process that created it.  Returns NULL, and sets *err, if that can't
+ * be done. */
+WS_DLL_PUBLIC shm_tail_t *shm_tail_open_fd(int fd, int *err);
+
+/* The fd of the window's memfd; it's closed on exec, so a child that's
+ * to open the window must have that undone. */
+WS_DLL_PUBLIC int shm_tail_fd(shm_tail_t *tail);
+
+/* Size of the window. */
+WS_DLL_PUBLIC gsize shm_tail_size(shm_tail_t *tail);
+
+/* The window is unmapped when the last reference is dropped. */
+WS_DLL_PUBLIC shm_tail_t *shm_tail_ref(shm_tail_t *tail);
+WS_DLL_PUBLIC void shm_tail_unref(shm_tail_t *tail);
+
+/* Writer: the bytes that follow are written to fd, starting at offset;
+ * that empties the window. */
+WS_DLL_PUBLIC void shm_tail_begin_file(shm_tail_t *tail, int fd, guint64 offset);
+
+/* Writer: appends what was just written to the file. */
+WS_DLL_PUBLIC void shm_tail_append(shm_tail_t *tail, const guint8 *data, gsize len);
+
+/* Reader: the device and inode numbers that identify fd's file to
+ * shm_tail_read().  Returns FALSE if they can't be had. */
+WS_DLL_PUBLIC gboolean shm_tail_file_id(int fd, guint64 *dev, guint64 *ino);
+
+/* Reader: copies up to len bytes at offset in the given file into buf.
+ * Returns the number of bytes copied, which is 0 if the window doesn't
+ * have the byte at offset, or is onto another file, or if the writer was
+ * changing it every time we looked. */
+WS_DLL_PUBLIC gsize shm_tail_read(shm_tail_t *tail, guint64 dev, guint64 ino,
+                                  guint64 offset, guint8 *buf, gsize len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __SHM_TAIL_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,308 @@
+/* shm_tail_test.c
+ * Standalone program to test shm_tail: wrapping around the window,
+ * switching files, and a reader thread racing the writer.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include "shm_tail.h"
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#define TEST_WINDOW	4096
+
+/* The writer thread appends THREAD_CHUNKS of THREAD_CHUNK bytes while
+ * the reader thread reads */
+#define THREAD_CHUNK	333
+#define THREAD_CHUNKS	200000
+
+static gboolean failed = FALSE;
+
+#define check(what, cond) \
+	do { \
+		if (!(cond)) { \
+			printf("Failed %s: %s (line %d)\n", what, #cond, __LINE__); \
+			failed = TRUE; \
+		} \
+	} while (0)
+
+/* The byte at each offset of the files */
+static guint8
+byte_at(guint64 offset)
+{
+	return (guint8)(offset * 7 + offset / 509);
+}
+
+static void
+append_bytes(shm_tail_t *tail, guint64 offset, gsize len)
+{
+	guint8 buf[1024];
+	gsize i, n;
+
+	while (len != 0) {
+		n = MIN(len, sizeof buf);
+		for (i = 0; i < n; i++)
+			buf[i] = byte_at(offset + i);
+		shm_tail_append(tail, buf, n);
+		offset += n;
+		len -= n;
+	}
+}
+
+static gboolean
+bytes_ok(const guint8 *buf, guint64 offset, gsize len)
+{
+	gsize i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != byte_at(offset + i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+typedef struct {
+	int fd;
+	char *path;
+	guint64 dev;
+	guint64 ino;
+} test_file_t;
+
+static gboolean
+test_file_open(test_file_t *file)
+{
+	file->fd = g_file_open_tmp("shm_tail_test.XXXXXX", &file->path, NULL);
+	if (file->fd == -1)
+		return FALSE;
+	return shm_tail_file_id(file->fd, &file->dev, &file->ino);
+}
+
+static void
+test_file_close(test_file_t *file)
+{
+	close(file->fd);
+	g_unlink(file->path);
+	g_free(file->path);
+}
+
+static void
+test_wrap(shm_tail_t *tail, test_file_t *file)
+{
+	guint8 buf[TEST_WINDOW];
+	guint64 end;
+
+	shm_tail_begin_file(tail, file->fd, 100);
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, 100, buf, 1) == 0);
+
+	/* Two and a half windows, in pieces */
+	for (end = 100; end < 100 + 5 * TEST_WINDOW / 2; end += 1000)
+		append_bytes(tail, end, 1000);
+
+	/* What fell out of the window is left to the file. */
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, 100, buf, 1) == 0);
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, end - TEST_WINDOW - 1, buf, 1) == 0);
+	/* Past the end */
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, end, buf, 1) == 0);
+
+	/* The whole window, which wraps around the end of the buffer */
+	memset(buf, 0, sizeof buf);
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, end - TEST_WINDOW, buf, sizeof buf) == TEST_WINDOW);
+	check("wrap", bytes_ok(buf, end - TEST_WINDOW, TEST_WINDOW));
+
+	/* Only up to the end */
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, end - 10, buf, sizeof buf) == 10);
+	check("wrap", bytes_ok(buf, end - 10, 10));
+
+	/* An append bigger than the window leaves its last bytes. */
+	append_bytes(tail, end, 3 * TEST_WINDOW);
+	end += 3 * TEST_WINDOW;
+	check("wrap", shm_tail_read(tail, file->dev, file->ino, end - TEST_WINDOW, buf, sizeof buf) == TEST_WINDOW);
+	check("wrap", bytes_ok(buf, end - TEST_WINDOW, TEST_WINDOW));
+}
+
+static void
+test_switch(shm_tail_t *tail, test_file_t *file1, test_file_t *file2)
+{
+	guint8 buf[100];
+
+	shm_tail_begin_file(tail, file1->fd, 0);
+	append_bytes(tail, 0, 100);
+	check("switch", shm_tail_read(tail, file1->dev, file1->ino, 0, buf, 100) == 100);
+
+	/* A reader of the old file reads it from the file from now on. */
+	shm_tail_begin_file(tail, file2->fd, 24);
+	check("switch", shm_tail_read(tail, file1->dev, file1->ino, 0, buf, 100) == 0);
+	check("switch", shm_tail_read(tail, file2->dev, file2->ino, 24, buf, 100) == 0);
+	append_bytes(tail, 24, 100);
+	check("switch", shm_tail_read(tail, file1->dev, file1->ino, 24, buf, 100) == 0);
+	check("switch", shm_tail_read(tail, file2->dev, file2->ino, 0, buf, 100) == 0);
+	check("switch", shm_tail_read(tail, file2->dev, file2->ino, 24, buf, 100) == 100);
+	check("switch", bytes_ok(buf, 24, 100));
+}
+
+typedef struct {
+	shm_tail_t *tail;
+	test_file_t *file;
+	volatile gint chunks;	/* appended so far */
+	volatile gint done;
+	guint64 hits;
+	gboolean ok;
+} reader_t;
+
+/* Reads just behind the writer, where the bytes are most likely to be
+ * overwritten while they're being copied; whatever it's given must be
+ * right. */
+static gpointer
+read_racing(gpointer data)
+{
+	reader_t *reader = (reader_t *)data;
+	guint8 buf[TEST_WINDOW];
+	guint64 offset = 0;
+	guint64 end;
+	gsize len;
+
+	reader->ok = TRUE;
+	while (!g_atomic_int_get(&reader->done)) {
+		len = shm_tail_read(reader->tail, reader->file->dev, reader->file->ino,
+				    offset, buf, sizeof buf);
+		if (len != 0) {
+			reader->hits++;
+			if (!bytes_ok(buf, offset, len)) {
+				reader->ok = FALSE;
+				break;
+			}
+			offset += len;
+		} else {
+			/* Caught up, or fell behind; go to just before the end. */
+			end = (guint64)g_atomic_int_get(&reader->chunks) * THREAD_CHUNK;
+			offset = end > TEST_WINDOW / 2 ? end - TEST_WINDOW / 2 : 0;
+		}
+	}
+	return NULL;
+}
+
+static void
+test_race(shm_tail_t *writer_tail, shm_tail_t *reader_tail, test_file_t *file)
+{
+	reader_t reader;
+	GThread *thread;
+	gint i;
+
+	shm_tail_begin_file(writer_tail, file->fd, 0);
+	memset(&reader, 0, sizeof reader);
+	reader.tail = reader_tail;
+	reader.file = file;
+	thread = g_thread_new("shm_tail reader", read_racing, &reader);
+	for (i = 0; i < THREAD_CHUNKS; i++) {
+		append_bytes(writer_tail, (guint64)i * THREAD_CHUNK, THREAD_CHUNK);
+		g_atomic_int_set(&reader.chunks, i + 1);
+	}
+	g_atomic_int_set(&reader.done, 1);
+	g_thread_join(thread);
+
+	check("race", reader.ok);
+	check("race", reader.hits > 0);
+}
+
+/* A writer that dies while it's changing the window leaves seq odd;
+ * readers must give up and read the file rather than spin forever. */
+static void
+test_stuck_writer(shm_tail_t *tail, test_file_t *file)
+{
+	volatile gint *seq;
+	guint8 *map;
+	guint8 buf[100];
+
+	shm_tail_begin_file(tail, file->fd, 0);
+	append_bytes(tail, 0, 100);
+	check("stuck writer", shm_tail_read(tail, file->dev, file->ino, 0, buf, 100) == 100);
+
+	/* seq follows the magic number, version and size in the header. */
+	map = (guint8 *)mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, shm_tail_fd(tail), 0);
+	check("stuck writer", map != MAP_FAILED);
+	if (map == MAP_FAILED)
+		return;
+	seq = (volatile gint *)(map + 16);
+	check("stuck writer", (*seq & 1) == 0);
+	g_atomic_int_inc(seq);
+	check("stuck writer", shm_tail_read(tail, file->dev, file->ino, 0, buf, 100) == 0);
+	g_atomic_int_inc(seq);
+	check("stuck writer", shm_tail_read(tail, file->dev, file->ino, 0, buf, 100) == 100);
+	munmap(map, 4096);
+}
+#endif /* HAVE_MEMFD_CREATE */
+
+int
+main(void)
+{
+#ifdef HAVE_MEMFD_CREATE
+	shm_tail_t *tail, *reader_tail;
+	test_file_t file1, file2;
+	int err;
+
+	tail = shm_tail_create(TEST_WINDOW, &err);
+	if (tail == NULL) {
+		printf("Failed: can't create a window: %s\n", g_strerror(err));
+		exit(1);
+	}
+	check("create", shm_tail_size(tail) == TEST_WINDOW);
+	if (!test_file_open(&file1) || !test_file_open(&file2)) {
+		printf("Failed: can't create the files\n");
+		exit(1);
+	}
+
+	/* The reader's own mapping of the window */
+	reader_tail = shm_tail_open_fd(dup(shm_tail_fd(tail)), &err);
+	check("open", reader_tail != NULL);
+	if (reader_tail == NULL)
+		exit(1);
+	check("open", shm_tail_size(reader_tail) == TEST_WINDOW);
+
+	test_wrap(tail, &file1);
+	test_switch(tail, &file1, &file2);
+	test_race(tail, reader_tail, &file1);
+	test_stuck_writer(tail, &file2);
+
+	shm_tail_unref(reader_tail);
+	shm_tail_unref(tail);
+	test_file_close(&file1);
+	test_file_close(&file2);
+
+	if (failed)
+		exit(1);
+	printf("Passed shm_tail tests\n");
+#else
+	printf("Skipped shm_tail tests: memfd_create() isn't available\n");
+#endif
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,203 @@
+/* spsc_ring.c
+ * Lock-free ring buffer of variable-length records, for one producer
+ * thread and one consumer thread
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "spsc_ring.h"
+
+#define SPSC_RING_MIN_SIZE  64
+#define SPSC_RING_MAX_SIZE  (1U << 30)
+
+/* Marks the unused space at the end of the buffer before a record that
+ * was put at the start. */
+#define SPSC_RING_SKIP      G_MAXUINT32
+
+typedef struct {
+    guint32 len;        /* length of the record, or SPSC_RING_SKIP */
+    guint32 size;       /* bytes up to the next header */
+} spsc_ring_hdr_t;
+
+/*
+ * head and tail count the bytes ever committed and released, modulo
+ * 2^32; as the buffer is at most 1 GiB, head - tail is always the space
+ * in use.  Each is written only by its own side, with a full barrier,
+ * so a record is complete before the consumer can see it, and the
+ * consumer is done with the space before the producer can reuse it.
+ */
+struct spsc_ring {
+    guint8        *buf;
+    guint32        size;
+    guint32        mask;
+
+    /* Written by the producer. */
+    volatile gint  head;
+    volatile gint  produced;
+    volatile gint  high_water;
+    volatile gint  high_water_count;
+    guint32        reserved;        /* head after the reserved record */
+
+    /* Written by the consumer. */
+    volatile gint  tail;
+    volatile gint  consumed;
+    guint32        peeked;          /* bytes to release */
+};
+
+spsc_ring_t *
+spsc_ring_new(gsize size)
+{
+    spsc_ring_t *ring = g_new0(spsc_ring_t, 1);
+
+    ring->size = SPSC_RING_MIN_SIZE;
+    while (ring->size < size && ring->size < SPSC_RING_MAX_SIZE)
+        ring->size *= 2;
+    ring->mask = ring->size - 1;
+    ring->buf = (guint8 *)g_malloc(ring->size);
+    return ring;
+}
+
+void
+spsc_ring_free(spsc_ring_t *ring)
+{
+    if (ring == NULL)
+        return;
+    g_free(ring->buf);
+    g_free(ring);
+}
+
+void *
+spsc_ring_reserve(spsc_ring_t *ring, gsize len)
+{
+    guint32 head = (guint32)g_atomic_int_get(&ring->head);
+    guint32 avail = ring->size - (head - (guint32)g_atomic_int_get(&ring->tail));
+    guint32 offset = head & ring->mask;
+    guint32 to_end = ring->size - offset;
+    guint32 skip = 0;
+    guint32 rec_size;
+    spsc_ring_hdr_t *hdr;
+
+    if (len > ring->size - sizeof *hdr)
+        return NULL;
+    rec_size = (guint32)((sizeof *hdr + len + 7) & ~(gsize)7);
+
+    if (rec_size > to_end) {
+        /* Put it at the start, and have the consumer skip the rest. */
+        skip = to_end;
+        offset = 0;
+    }
+    if (skip + rec_size > avail)
+        return NULL;
+
+    if (skip != 0) {
+        hdr = (spsc_ring_hdr_t *)(ring->buf + (head & ring->mask));
+        hdr->len = SPSC_RING_SKIP;
+        hdr->size = skip;
+    }
+    hdr = (spsc_ring_hdr_t *)(ring->buf + offset);
+    hdr->len = (guint32)len;
+    hdr->size = rec_size;
+    ring->reserved = head + skip + rec_size;
+    return hdr + 1;
+}
+
+void
+spsc_ring_commit(spsc_ring_t *ring)
+{
+    guint32 used = ring->reserved - (guint32)g_atomic_int_get(&ring->tail);
+    guint count = (guint)g_atomic_int_get(&ring->produced) + 1 -
+        (guint)g_atomic_int_get(&ring->consumed);
+
+    g_atomic_int_set(&ring->head, (gint)ring->reserved);
+    g_atomic_int_set(&ring->produced, g_atomic_int_get(&ring->produced) + 1);
+
+    if (used > (guint32)g_atomic_int_get(&ring->high_water))
+        g_atomic_int_set(&ring->high_water, (gint)used);
+    if (count > (guint)g_atomic_int_get(&ring->high_water_count))
+        g_atomic_int_set(&ring->high_water_count, (gint)count);
+}
+
+void *
+spsc_ring_peek(spsc_ring_t *ring, gsize *len)
+{
+    guint32 tail = (guint32)g_atomic_int_get(&ring->tail);
+    guint32 head = (guint32)g_atomic_int_get(&ring->head);
+    spsc_ring_hdr_t *hdr;
+
+    if (tail == head)
+        return NULL;
+
+    hdr = (spsc_ring_hdr_t *)(ring->buf + (tail & ring->mask));
+    ring->peeked = 0;
+    if (hdr->len == SPSC_RING_SKIP) {
+        /* A record is always committed along with its skip. */
+        ring->peeked = hdr->size;
+        hdr = (spsc_ring_hdr_t *)ring->buf;
+    }
+    ring->peeked += hdr->size;
+    *len = hdr->len;
+    return hdr + 1;
+}
+
+void
+spsc_ring_release(spsc_ring_t *ring)
+{
+    guint32 tail = (guint32)g_atomic_int_get(&ring->tail);
+
+    g_atomic_int_set(&ring->tail, (gint)(tail + ring->peeked));
+    g_atomic_int_set(&ring->consumed, g_atomic_int_get(&ring->consumed) + 1);
+    ring->peeked = 0;
+}
+
+gsize
+spsc_ring_size(spsc_ring_t *ring)
+{
+    return ring->size;
+}
+
+gsize
+spsc_ring_used(spsc_ring_t *ring)
+{
+    guint32 tail = (guint32)g_atomic_int_get(&ring->tail);
+
+    return (guint32)g_atomic_int_get(&ring->head) - tail;
+}
+
+guint
+spsc_ring_count(spsc_ring_t *ring)
+{
+    guint consumed = (guint)g_atomic_int_get(&ring->consumed);
+
+    return (guint)g_atomic_int_get(&ring->produced) - consumed;
+}
+
+gsize
+spsc_ring_high_water(spsc_ring_t *ring)
+{
+    return (guint32)g_atomic_int_get(&ring->high_water);
+}
+
+guint
+spsc_ring_high_water_count(spsc_ring_t *ring)
+{
+    return (guint)g_atomic_int_get(&ring->high_water_count);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,73 @@
+/* spsc_ring.h
+ * Lock-free ring buffer of variable-length records, for one producer
+ * thread and one consumer thread
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include "ws_symbol_export.h"
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * The buffer is allocated once, and records are written into it in
+ * place, so that passing a record from one thread to the other takes
+ * no allocation and no lock: the producer reserves space for a record,
+ * fills it in and commits it, and the consumer peeks at the oldest
+ * record and releases it when it's done with it.
+ *
+ * Only one thread may produce and only one may consume; they may be
+ * the same thread.  A record that would wrap around the end of the
+ * buffer is put at the start instead, so records are always contiguous;
+ * records of up to half the size of the buffer always fit in an empty
+ * ring.  Records are 8-byte aligned.
+ */
+typedef struct spsc_ring spsc_ring_t;
+
+/* Size is rounded up to a power of 2 of at least 64 bytes, at most 1 GiB. */
+WS_DLL_PUBLIC spsc_ring_t *spsc_ring_new(gsize size);
+
+WS_DLL_PUBLIC void spsc_ring_free(spsc_ring_t *ring);
+
+/* Producer: returns len bytes to fill in, or NULL if the ring is too full.
+ * The record isn't seen by the consumer until it's committed. */
+WS_DLL_PUBLIC void *spsc_ring_reserve(spsc_ring_t *ring, gsize len);
+
+/* Producer: hands the reserved record to the consumer. */
+WS_DLL_PUBLIC void spsc_ring_commit(spsc_ring_t *ring);
+
+/* Consumer: returns the oldest record and sets *len to its length, or
+ * returns NULL if there are none. */
+WS_DLL_PUBLIC void *spsc_ring_peek(spsc_ring_t *ring, gsize *len);
+
+/* Consumer: frees the space of the record returned by spsc_ring_peek(). */
+WS_DLL_PUBLIC void spsc_ring_release(spsc_ring_t *ring);
+
+/* Size of the buffer. */
+WS_DLL_PUBLIC gsize spsc_ring_size(spsc_ring_t *ring);
+
+/* Bytes used by committed records, including their headers and padding,
+ * and how many records that is.  Either thread may call these. */
+WS_DLL_PUBLIC gsize spsc_ring_used(spsc_ring_t *ring);
+WS_DLL_PUBLIC guint spsc_ring_count(spsc_ring_t *ring);
+
+/* The most bytes, and records, that have been in the ring at once. */
+WS_DLL_PUBLIC gsize spsc_ring_high_water(spsc_ring_t *ring);
+WS_DLL_PUBLIC guint spsc_ring_high_water_count(spsc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __SPSC_RING_H__ */
@@ -0,0 +1,296 @@
+/* spsc_ring_test.c
+ * Standalone program to test spsc_ring: records that wrap around the end
+ * of the buffer, a full ring, and a producer and consumer thread.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "spsc_ring.h"
+
+/* Records the producer thread hands to the consumer thread */
+#define THREAD_RECORDS	200000
+
+static gboolean failed = FALSE;
+
+#define check(what, cond) \
+	do { \
+		if (!(cond)) { \
+			printf("Failed %s: %s (line %d)\n", what, #cond, __LINE__); \
+			failed = TRUE; \
+		} \
+	} while (0)
+
+/* Record "seq" is its number followed by bytes that depend on it. */
+static gsize
+record_len(guint32 seq)
+{
+	return sizeof seq + (seq * 7) % 200;
+}
+
+static void
+fill_record(guint8 *rec, guint32 seq)
+{
+	gsize len = record_len(seq);
+	gsize i;
+
+	memcpy(rec, &seq, sizeof seq);
+	for (i = sizeof seq; i < len; i++)
+		rec[i] = (guint8)(seq + i);
+}
+
+static gboolean
+record_ok(const guint8 *rec, gsize len, guint32 seq)
+{
+	guint32 rec_seq;
+	gsize i;
+
+	if (len != record_len(seq))
+		return FALSE;
+	memcpy(&rec_seq, rec, sizeof rec_seq);
+	if (rec_seq != seq)
+		return FALSE;
+	for (i = sizeof seq; i < len; i++) {
+		if (rec[i] != (guint8)(seq + i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+put_record(spsc_ring_t *ring, guint32 seq)
+{
+	guint8 *rec = (guint8 *)spsc_ring_reserve(ring, record_len(seq));
+
+	if (rec == NULL)
+		return FALSE;
+	fill_record(rec, seq);
+	spsc_ring_commit(ring);
+	return TRUE;
+}
+
+static gboolean
+get_record(spsc_ring_t *ring, guint32 seq)
+{
+	gsize len;
+	guint8 *rec = (guint8 *)spsc_ring_peek(ring, &len);
+	gboolean ok;
+
+	if (rec == NULL)
+		return FALSE;
+	ok = record_ok(rec, len, seq);
+	spsc_ring_release(ring);
+	return ok;
+}
+
+static void
+test_basic(void)
+{
+	spsc_ring_t *ring = spsc_ring_new(100);
+	guint8 *rec;
+	gsize len;
+
+	check("basic", spsc_ring_size(ring) == 128);
+	check("basic", spsc_ring_peek(ring, &len) == NULL);
+
+	/* A reserved record isn't seen until it's committed. */
+	rec = (guint8 *)spsc_ring_reserve(ring, record_len(0));
+	check("basic", rec != NULL);
+	if (rec == NULL) {
+		spsc_ring_free(ring);
+		return;
+	}
+	fill_record(rec, 0);
+	check("basic", spsc_ring_peek(ring, &len) == NULL);
+	check("basic", spsc_ring_count(ring) == 0);
+	spsc_ring_commit(ring);
+	check("basic", put_record(ring, 1));
+	check("basic", spsc_ring_count(ring) == 2);
+
+	check("basic", get_record(ring, 0));
+	check("basic", get_record(ring, 1));
+	check("basic", spsc_ring_peek(ring, &len) == NULL);
+	check("basic", spsc_ring_count(ring) == 0);
+	check("basic", spsc_ring_used(ring) == 0);
+	check("basic", spsc_ring_high_water_count(ring) == 2);
+	spsc_ring_free(ring);
+}
+
+/* 8 bytes of header, and records padded to 8 bytes */
+static void
+test_wrap(void)
+{
+	spsc_ring_t *ring = spsc_ring_new(64);
+	guint8 *rec;
+	gsize len;
+
+	/* A at 0 and B at 24, 24 bytes each */
+	rec = (guint8 *)spsc_ring_reserve(ring, 16);
+	memset(rec, 'A', 16);
+	spsc_ring_commit(ring);
+	rec = (guint8 *)spsc_ring_reserve(ring, 16);
+	memset(rec, 'B', 16);
+	spsc_ring_commit(ring);
+
+	rec = (guint8 *)spsc_ring_peek(ring, &len);
+	check("wrap", rec != NULL && len == 16 && rec[0] == 'A' && rec[15] == 'A');
+	spsc_ring_release(ring);
+
+	/* C doesn't fit in the 16 bytes after B, so the consumer skips
+	 * them, and C goes at 0; that fills the ring. */
+	rec = (guint8 *)spsc_ring_reserve(ring, 16);
+	check("wrap", rec != NULL);
+	if (rec == NULL) {
+		spsc_ring_free(ring);
+		return;
+	}
+	memset(rec, 'C', 16);
+	spsc_ring_commit(ring);
+	check("wrap", spsc_ring_used(ring) == 64);
+	check("wrap", spsc_ring_count(ring) == 2);
+	check("wrap", spsc_ring_high_water(ring) == 64);
+	check("wrap", spsc_ring_reserve(ring, 1) == NULL);
+
+	rec = (guint8 *)spsc_ring_peek(ring, &len);
+	check("wrap", rec != NULL && len == 16 && rec[0] == 'B' && rec[15] == 'B');
+	spsc_ring_release(ring);
+	check("wrap", spsc_ring_used(ring) == 40);
+
+	rec = (guint8 *)spsc_ring_peek(ring, &len);
+	check("wrap", rec != NULL && len == 16 && rec[0] == 'C' && rec[15] == 'C');
+	spsc_ring_release(ring);
+	check("wrap", spsc_ring_used(ring) == 0);
+	check("wrap", spsc_ring_peek(ring, &len) == NULL);
+	spsc_ring_free(ring);
+}
+
+static void
+test_full(void)
+{
+	spsc_ring_t *ring = spsc_ring_new(64);
+	guint32 seq;
+	guint i;
+	gsize len;
+
+	/* Too big for the buffer, even when it's empty */
+	check("full", spsc_ring_reserve(ring, 57) == NULL);
+	check("full", spsc_ring_reserve(ring, 56) != NULL);
+
+	/* Fill the ring, then check that it holds every record it took. */
+	for (seq = 0; put_record(ring, seq); seq++)
+		;
+	check("full", seq > 0);
+	check("full", spsc_ring_count(ring) == seq);
+	check("full", spsc_ring_used(ring) <= spsc_ring_size(ring));
+	for (i = 0; i < seq; i++)
+		check("full", get_record(ring, i));
+	check("full", spsc_ring_used(ring) == 0);
+
+	/* At offsets all around the buffer, a record of up to half of it
+	 * fits in an empty ring. */
+	for (i = 0; i < 8; i++) {
+		check("full", spsc_ring_reserve(ring, 24) != NULL);
+		spsc_ring_commit(ring);
+		check("full", spsc_ring_peek(ring, &len) != NULL && len == 24);
+		spsc_ring_release(ring);
+
+		check("full", spsc_ring_reserve(ring, 0) != NULL);
+		spsc_ring_commit(ring);
+		check("full", spsc_ring_peek(ring, &len) != NULL && len == 0);
+		spsc_ring_release(ring);
+	}
+	check("full", spsc_ring_used(ring) == 0);
+	spsc_ring_free(ring);
+}
+
+typedef struct {
+	spsc_ring_t *ring;
+	gboolean ok;
+} consumer_t;
+
+static gpointer
+consume(gpointer data)
+{
+	consumer_t *consumer = (consumer_t *)data;
+	guint32 seq = 0;
+	guint8 *rec;
+	gsize len;
+
+	while (seq < THREAD_RECORDS) {
+		rec = (guint8 *)spsc_ring_peek(consumer->ring, &len);
+		if (rec == NULL) {
+			g_thread_yield();
+			continue;
+		}
+		if (!record_ok(rec, len, seq)) {
+			consumer->ok = FALSE;
+			return NULL;
+		}
+		spsc_ring_release(consumer->ring);
+		seq++;
+	}
+	consumer->ok = TRUE;
+	return NULL;
+}
+
+static void
+test_threads(void)
+{
+	consumer_t consumer;
+	GThread *thread;
+	guint32 seq;
+
+	/* Small enough that the producer often finds it full */
+	consumer.ring = spsc_ring_new(4096);
+	consumer.ok = FALSE;
+	thread = g_thread_new("spsc_ring consumer", consume, &consumer);
+	for (seq = 0; seq < THREAD_RECORDS; seq++) {
+		while (!put_record(consumer.ring, seq))
+			g_thread_yield();
+	}
+	g_thread_join(thread);
+
+	check("threads", consumer.ok);
+	check("threads", spsc_ring_count(consumer.ring) == 0);
+	check("threads", spsc_ring_used(consumer.ring) == 0);
+	check("threads", spsc_ring_high_water(consumer.ring) <= 4096);
+	spsc_ring_free(consumer.ring);
+}
+
+int
+main(void)
+{
+	test_basic();
+	test_wrap();
+	test_full();
+	test_threads();
+
+	if (failed)
+		exit(1);
+	printf("Passed spsc_ring tests\n");
+	return 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -164,6 +164,29 @@ create_timestamp(void) {
     return timestamp;
 }
 
+guint64
+get_monotonic_time_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    /* Split it, so that the multiplication can't overflow. */
+    return (guint64)(now.QuadPart / frequency.QuadPart) * 1000000000 +
+           (guint64)(now.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+
+    /* On Linux and macOS this doesn't make a system call. */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (guint64)now.tv_sec * 1000000000 + (guint64)now.tv_nsec;
+#else
+    return (guint64)g_get_monotonic_time() * 1000;
+#endif
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
@@ -51,6 +51,13 @@ void log_resource_usage(gboolean reset_delta, const char *format, ...);
 WS_DLL_PUBLIC
 guint64 create_timestamp(void);
 
+/**
+ * Fetch a monotonic clock, in nanoseconds since some unspecified point;
+ * it's cheap enough to be read around every call of a dissector.
+ */
+WS_DLL_PUBLIC
+guint64 get_monotonic_time_ns(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
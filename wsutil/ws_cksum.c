@@ -0,0 +1,160 @@
+/* ws_cksum.c
+ * One's-complement sums, for Internet checksums
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "ws_cpuid.h"
+#include "ws_cksum.h"
+#include "ws_cksum_int.h"
+
+/* SSE2 is part of x86-64, so it needs no check at run time. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_CKSUM_SSE2
+#include <emmintrin.h>
+#endif
+
+guint64
+ws_cksum_sum_portable(const guint8 *buf, size_t len)
+{
+    guint64 sum0 = 0, sum1 = 0;
+    guint32 word0, word1;
+
+    for (; len >= 8; buf += 8, len -= 8) {
+        memcpy(&word0, buf, 4);
+        memcpy(&word1, buf + 4, 4);
+        sum0 += word0;
+        sum1 += word1;
+    }
+    if (len >= 4) {
+        memcpy(&word0, buf, 4);
+        sum0 += word0;
+    }
+    return sum0 + sum1;
+}
+
+#ifdef HAVE_CKSUM_SSE2
+
+#define cast_m128i(p) ((const __m128i *) (const void *) (p))
+
+/* Each 32-bit word is widened to 64 bits, so the sums can't overflow. */
+static guint64
+cksum_sum_sse2(const guint8 *buf, size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum0 = zero, sum1 = zero;
+    guint64 lanes[2];
+
+    for (; len >= 16; buf += 16, len -= 16) {
+        __m128i value = _mm_loadu_si128(cast_m128i(buf));
+
+        sum0 = _mm_add_epi64(sum0, _mm_unpacklo_epi32(value, zero));
+        sum1 = _mm_add_epi64(sum1, _mm_unpackhi_epi32(value, zero));
+    }
+    _mm_storeu_si128((__m128i *) (void *) lanes, _mm_add_epi64(sum0, sum1));
+    return lanes[0] + lanes[1] + ws_cksum_sum_portable(buf, len);
+}
+
+#endif /* HAVE_CKSUM_SSE2 */
+
+typedef struct {
+    const char *name;
+    size_t min_len;     /* shorter buffers are summed a word at a time */
+    guint64 (*sum)(const guint8 *buf, size_t len);
+} cksum_impl_t;
+
+static const cksum_impl_t cksum_impls[] = {
+#ifdef HAVE_AVX2
+    { "avx2", 64, ws_cksum_sum_avx2 },
+#endif
+#ifdef HAVE_CKSUM_SSE2
+    { "sse2", 32, cksum_sum_sse2 },
+#endif
+    { "portable", 0, ws_cksum_sum_portable },
+};
+
+static const cksum_impl_t *cksum_impl;
+
+/*
+ * Picks the fastest version the CPU can run. WIRESHARK_CKSUM can name a
+ * slower one ("sse2" or "portable") for comparing them.
+ */
+static const cksum_impl_t *
+cksum_select(void)
+{
+    const char *name = g_getenv("WIRESHARK_CKSUM");
+    size_t i = 0;
+
+#ifdef HAVE_AVX2
+    if (!ws_cpuid_avx2())
+        i++;
+#endif
+    if (name) {
+        for (size_t j = i; j < G_N_ELEMENTS(cksum_impls); j++) {
+            if (strcmp(name, cksum_impls[j].name) == 0)
+                return &cksum_impls[j];
+        }
+    }
+    return &cksum_impls[i];
+}
+
+guint16
+ws_cksum_sum16(const guint8 *buf, size_t len)
+{
+    size_t  words_len = len & ~(size_t)3;
+    guint64 sum;
+    union {
+        guint8  c[2];
+        guint16 s;
+    } s_util;
+
+    if (g_once_init_enter(&cksum_impl))
+        g_once_init_leave(&cksum_impl, cksum_select());
+
+    if (words_len >= cksum_impl->min_len)
+        sum = cksum_impl->sum(buf, words_len);
+    else
+        sum = ws_cksum_sum_portable(buf, words_len);
+    buf += words_len;
+    len -= words_len;
+
+    if (len >= 2) {
+        memcpy(&s_util.s, buf, 2);
+        sum += s_util.s;
+        buf += 2;
+        len -= 2;
+    }
+    if (len == 1) {
+        s_util.c[0] = *buf;
+        s_util.c[1] = 0;
+        sum += s_util.s;
+    }
+
+    /* Fold the carries back in. */
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return (guint16)sum;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
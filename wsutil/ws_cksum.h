@@ -0,0 +1,38 @@
+/* ws_cksum.h
+ * One's-complement sums, for Internet checksums
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_CKSUM_H__
+#define __WS_CKSUM_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Returns the one's-complement sum of the buffer taken as 16-bit words
+ * in host byte order, folded to 16 bits; if the length is odd, the last
+ * byte is padded with a zero byte. The result is 0 only if every byte is.
+ *
+ * As RFC 1071 explains, the sum is the same whatever order its words are
+ * added in, so it's done 16 or 32 bytes at a time with SSE2 or AVX2 where
+ * the CPU has it (chosen the first time this is called); the environment
+ * variable WIRESHARK_CKSUM can be set to "sse2" or "portable" to choose a
+ * slower version, for comparison.
+ */
+WS_DLL_PUBLIC guint16 ws_cksum_sum16(const guint8 *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_CKSUM_H__ */
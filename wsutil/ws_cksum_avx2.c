@@ -0,0 +1,61 @@
+/* ws_cksum_avx2.c
+ * The AVX2 version of the one's-complement sum; this file is built with
+ * AVX2 enabled, and it's only called if the CPU has it.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+
+#include <immintrin.h>
+
+#include "ws_cksum.h"
+#include "ws_cksum_int.h"
+
+#define cast_m256i(p) ((const __m256i *) (const void *) (p))
+
+/* As in cksum_sum_sse2(), but two blocks at a time, to keep both adders
+ * busy. */
+guint64
+ws_cksum_sum_avx2(const guint8 *buf, size_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+    guint64 lanes[4];
+
+    for (; len >= 64; buf += 64, len -= 64) {
+        __m256i value0 = _mm256_loadu_si256(cast_m256i(buf));
+        __m256i value1 = _mm256_loadu_si256(cast_m256i(buf + 32));
+
+        sum0 = _mm256_add_epi64(sum0, _mm256_unpacklo_epi32(value0, zero));
+        sum1 = _mm256_add_epi64(sum1, _mm256_unpackhi_epi32(value0, zero));
+        sum2 = _mm256_add_epi64(sum2, _mm256_unpacklo_epi32(value1, zero));
+        sum3 = _mm256_add_epi64(sum3, _mm256_unpackhi_epi32(value1, zero));
+    }
+    sum0 = _mm256_add_epi64(_mm256_add_epi64(sum0, sum1), _mm256_add_epi64(sum2, sum3));
+    _mm256_storeu_si256((__m256i *) (void *) lanes, sum0);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ws_cksum_sum_portable(buf, len);
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,25 @@
+/* ws_cksum_int.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_CKSUM_INT_H__
+#define __WS_CKSUM_INT_H__
+
+/*
+ * These return a sum that's congruent, modulo 2^16 - 1, to the sum of
+ * the buffer's 16-bit words; it's folded to 16 bits by the caller. Adding
+ * up the 32-bit words instead is the same thing, as 2^16 is congruent to
+ * 1. The length of the buffer must be a multiple of 4.
+ */
+guint64 ws_cksum_sum_portable(const guint8 *buf, size_t len);
+
+#ifdef HAVE_AVX2
+guint64 ws_cksum_sum_avx2(const guint8 *buf, size_t len);
+#endif
+
+#endif /* __WS_CKSUM_INT_H__ */
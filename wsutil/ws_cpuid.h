@@ -18,6 +18,8 @@
 #include "ws_attributes.h"
 
 #if defined(_MSC_VER)     /* MSVC */
+#include <immintrin.h>    /* _xgetbv() */
+
 static gboolean
 ws_cpuid(guint32 *CPUInfo, guint32 selector)
 {
@@ -27,6 +29,12 @@ ws_cpuid(guint32 *CPUInfo, guint32 selector)
 	return TRUE;
 }
 
+static inline guint64
+ws_xgetbv(guint32 selector)
+{
+	return _xgetbv(selector);
+}
+
 #elif defined(__GNUC__)  /* GCC/clang */
 
 #if defined(__x86_64__)
@@ -42,6 +50,18 @@ ws_cpuid(guint32 *CPUInfo, int selector)
 							"c" (0));
 	return TRUE;
 }
+
+static inline guint64
+ws_xgetbv(guint32 selector)
+{
+	guint32 eax, edx;
+
+	/* xgetbv, spelled out for assemblers that don't know it */
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+						: "=a" (eax), "=d" (edx)
+						: "c" (selector));
+	return ((guint64)edx << 32) | eax;
+}
 #elif defined(__i386__)
 static gboolean
 ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
@@ -71,6 +91,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 	 */
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv(guint32 selector _U_)
+{
+	return 0;
+}
 #else /* not x86 */
 static gboolean
 ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
@@ -78,6 +104,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 	/* Not x86, so no cpuid instruction */
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv(guint32 selector _U_)
+{
+	return 0;
+}
 #endif
 
 #else /* Other compilers */
@@ -87,9 +119,15 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 {
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv(guint32 selector _U_)
+{
+	return 0;
+}
 #endif
 
-static int
+static inline int
 ws_cpuid_sse42(void)
 {
 	guint32 CPUInfo[4];
@@ -100,3 +138,42 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+static inline int
+ws_cpuid_pclmulqdq(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return 0;
+
+	/* in ECX bit 1 toggled on */
+	return (CPUInfo[2] & (1 << 1));
+}
+
+/*
+ * AVX2 also needs the OS to save the YMM registers on a context switch,
+ * so check that it has enabled them in XCR0 before looking at the AVX2
+ * bit in leaf 7.
+ */
+static inline int
+ws_cpuid_avx2(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return 0;
+
+	/* in ECX bits 27 (OSXSAVE) and 28 (AVX) toggled on */
+	ws_cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+		return 0;
+
+	/* XMM and YMM state enabled */
+	if ((ws_xgetbv(0) & 0x6) != 0x6)
+		return 0;
+
+	/* in EBX of leaf 7 bit 5 toggled on */
+	ws_cpuid(CPUInfo, 7);
+	return (CPUInfo[1] & (1 << 5));
+}
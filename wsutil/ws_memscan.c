@@ -0,0 +1,256 @@
+/* ws_memscan.c
+ * Scanning buffers for line terminators and other delimiters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "ws_cpuid.h"
+#include "ws_memscan.h"
+#include "ws_memscan_int.h"
+#include "bits_ctz.h"
+
+/* SSE2 is part of x86-64, so it needs no check at run time. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_MEMSCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+const guint8 *
+ws_memscan_crlf_portable(const guint8 *haystack, size_t haystacklen)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+
+    for (; haystack < haystack_end; haystack++) {
+        if (*haystack == '\r' || *haystack == '\n')
+            return haystack;
+    }
+    return NULL;
+}
+
+const guint8 *
+ws_memscan_crlf_unquoted_portable(const guint8 *haystack, size_t haystacklen, gboolean quoted)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+
+    for (; haystack < haystack_end; haystack++) {
+        if (*haystack == '"')
+            quoted = !quoted;
+        else if (!quoted && (*haystack == '\r' || *haystack == '\n'))
+            return haystack;
+    }
+    return NULL;
+}
+
+const guint8 *
+ws_memscan_pair_portable(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+
+    if (haystacklen < 2)
+        return NULL;
+
+    while ((haystack = (const guint8 *)memchr(haystack, first, haystack_end - haystack - 1)) != NULL) {
+        if (haystack[1] == second)
+            return haystack;
+        if (++haystack >= haystack_end - 1)
+            break;
+    }
+    return NULL;
+}
+
+static const guint8 *
+memscan_crlf_unquoted_portable(const guint8 *haystack, size_t haystacklen)
+{
+    return ws_memscan_crlf_unquoted_portable(haystack, haystacklen, FALSE);
+}
+
+#ifdef HAVE_MEMSCAN_SSE2
+
+#define cast_m128i(p) ((const __m128i *) (const void *) (p))
+
+/*
+ * The last block is loaded so that it ends at the end of the buffer,
+ * overlapping the one before; the bytes looked at twice didn't match the
+ * first time, so they don't match the second. The caller makes sure
+ * there is at least one block.
+ */
+static const guint8 *
+memscan_crlf_sse2(const guint8 *haystack, size_t haystacklen)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const guint8 *last = haystack + haystacklen - 16;
+    const guint8 *p = haystack;
+
+    for (;;) {
+        __m128i value = _mm_loadu_si128(cast_m128i(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(value, cr), _mm_cmpeq_epi8(value, lf)));
+
+        if (mask)
+            return p + ws_ctz(mask);
+        if (p == last)
+            return NULL;
+        p += 16;
+        if (p > last)
+            p = last;
+    }
+}
+
+/*
+ * Whether a byte is quoted depends on the parity of the quotes before it,
+ * so blocks can't overlap here; the tail is done a byte at a time.
+ */
+static const guint8 *
+memscan_crlf_unquoted_sse2(const guint8 *haystack, size_t haystacklen)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i dquote = _mm_set1_epi8('"');
+    guint32 quoted = 0;
+
+    while (haystacklen >= 16) {
+        __m128i value = _mm_loadu_si128(cast_m128i(haystack));
+        guint32 quotes = _mm_movemask_epi8(_mm_cmpeq_epi8(value, dquote));
+        guint32 eol = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(value, cr), _mm_cmpeq_epi8(value, lf)));
+        guint32 inside = ws_memscan_quoted_mask(quotes) ^ quoted;
+
+        eol &= ~inside;
+        if (eol)
+            return haystack + ws_ctz(eol);
+        quoted = (inside & 0x8000) ? G_MAXUINT32 : 0;
+        haystack += 16;
+        haystacklen -= 16;
+    }
+    return ws_memscan_crlf_unquoted_portable(haystack, haystacklen, quoted != 0);
+}
+
+/* Needs at least 17 bytes, so that both loads of the last block are in
+ * the buffer. */
+static const guint8 *
+memscan_pair_sse2(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second)
+{
+    const __m128i first_v = _mm_set1_epi8((char)first);
+    const __m128i second_v = _mm_set1_epi8((char)second);
+    const guint8 *last = haystack + haystacklen - 17;
+    const guint8 *p = haystack;
+
+    for (;;) {
+        __m128i at = _mm_cmpeq_epi8(_mm_loadu_si128(cast_m128i(p)), first_v);
+        __m128i next = _mm_cmpeq_epi8(_mm_loadu_si128(cast_m128i(p + 1)), second_v);
+        int mask = _mm_movemask_epi8(_mm_and_si128(at, next));
+
+        if (mask)
+            return p + ws_ctz(mask);
+        if (p == last)
+            return NULL;
+        p += 16;
+        if (p > last)
+            p = last;
+    }
+}
+
+#endif /* HAVE_MEMSCAN_SSE2 */
+
+typedef struct {
+    const char *name;
+    size_t min_len;     /* shorter buffers are scanned a byte at a time */
+    const guint8 *(*crlf)(const guint8 *haystack, size_t haystacklen);
+    const guint8 *(*crlf_unquoted)(const guint8 *haystack, size_t haystacklen);
+    const guint8 *(*pair)(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second);
+} memscan_impl_t;
+
+static const memscan_impl_t memscan_impls[] = {
+#ifdef HAVE_AVX2
+    { "avx2", 33, ws_memscan_crlf_avx2, ws_memscan_crlf_unquoted_avx2, ws_memscan_pair_avx2 },
+#endif
+#ifdef HAVE_MEMSCAN_SSE2
+    { "sse2", 17, memscan_crlf_sse2, memscan_crlf_unquoted_sse2, memscan_pair_sse2 },
+#endif
+    { "portable", 0, ws_memscan_crlf_portable, memscan_crlf_unquoted_portable, ws_memscan_pair_portable },
+};
+
+static const memscan_impl_t *memscan_impl;
+
+/*
+ * Picks the fastest version the CPU can run. WIRESHARK_MEMSCAN can name a
+ * slower one ("sse2" or "portable") for comparing them.
+ */
+static const memscan_impl_t *
+memscan_select(void)
+{
+    const char *name = g_getenv("WIRESHARK_MEMSCAN");
+    size_t i = 0;
+
+#ifdef HAVE_AVX2
+    if (!ws_cpuid_avx2())
+        i++;
+#endif
+    if (name) {
+        for (size_t j = i; j < G_N_ELEMENTS(memscan_impls); j++) {
+            if (strcmp(name, memscan_impls[j].name) == 0)
+                return &memscan_impls[j];
+        }
+    }
+    return &memscan_impls[i];
+}
+
+static inline const memscan_impl_t *
+memscan_get(void)
+{
+    if (g_once_init_enter(&memscan_impl))
+        g_once_init_leave(&memscan_impl, memscan_select());
+    return memscan_impl;
+}
+
+const guint8 *
+ws_memscan_crlf(const guint8 *haystack, size_t haystacklen)
+{
+    const memscan_impl_t *impl = memscan_get();
+
+    if (haystacklen < impl->min_len)
+        return ws_memscan_crlf_portable(haystack, haystacklen);
+    return impl->crlf(haystack, haystacklen);
+}
+
+const guint8 *
+ws_memscan_crlf_unquoted(const guint8 *haystack, size_t haystacklen)
+{
+    const memscan_impl_t *impl = memscan_get();
+
+    if (haystacklen < impl->min_len)
+        return ws_memscan_crlf_unquoted_portable(haystack, haystacklen, FALSE);
+    return impl->crlf_unquoted(haystack, haystacklen);
+}
+
+const guint8 *
+ws_memscan_pair(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second)
+{
+    const memscan_impl_t *impl = memscan_get();
+
+    if (haystacklen < impl->min_len)
+        return ws_memscan_pair_portable(haystack, haystacklen, first, second);
+    return impl->pair(haystack, haystacklen, first, second);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,53 @@
+/* ws_memscan.h
+ * Scanning buffers for line terminators and other delimiters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_MEMSCAN_H__
+#define __WS_MEMSCAN_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * These look at 16 or 32 bytes at a time with SSE2 or AVX2 where the
+ * CPU has it (the choice is made the first time one of them is called),
+ * and a byte at a time otherwise. Unlike ws_mempbrk_exec(), they don't
+ * treat a NUL as the end of the data.
+ *
+ * To find a single byte, including a NUL, use memchr(), which the C
+ * library already vectorizes.
+ */
+
+/** Returns a pointer to the first CR or LF in the buffer, or NULL if
+ * there is none.
+ */
+WS_DLL_PUBLIC const guint8 *ws_memscan_crlf(const guint8 *haystack, size_t haystacklen);
+
+/** Returns a pointer to the first CR or LF in the buffer that is not
+ * between a pair of '"', or NULL if there is none. A '"' that isn't
+ * closed in the buffer quotes everything after it.
+ */
+WS_DLL_PUBLIC const guint8 *ws_memscan_crlf_unquoted(const guint8 *haystack, size_t haystacklen);
+
+/** Returns a pointer to the first place where the byte "first" is
+ * followed by the byte "second", or NULL if there is none. Both bytes
+ * must be in the buffer.
+ */
+WS_DLL_PUBLIC const guint8 *ws_memscan_pair(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_MEMSCAN_H__ */
@@ -0,0 +1,109 @@
+/* ws_memscan_avx2.c
+ * The AVX2 versions of the ws_memscan routines; this file is built with
+ * AVX2 enabled, and they're only called if the CPU has it.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+
+#include <immintrin.h>
+
+#include "ws_memscan.h"
+#include "ws_memscan_int.h"
+#include "bits_ctz.h"
+
+#define cast_m256i(p) ((const __m256i *) (const void *) (p))
+
+/* See memscan_crlf_sse2() for how the last block is done. */
+const guint8 *
+ws_memscan_crlf_avx2(const guint8 *haystack, size_t haystacklen)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const guint8 *last = haystack + haystacklen - 32;
+    const guint8 *p = haystack;
+
+    for (;;) {
+        __m256i value = _mm256_loadu_si256(cast_m256i(p));
+        guint32 mask = (guint32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(value, cr), _mm256_cmpeq_epi8(value, lf)));
+
+        if (mask)
+            return p + ws_ctz(mask);
+        if (p == last)
+            return NULL;
+        p += 32;
+        if (p > last)
+            p = last;
+    }
+}
+
+const guint8 *
+ws_memscan_crlf_unquoted_avx2(const guint8 *haystack, size_t haystacklen)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i dquote = _mm256_set1_epi8('"');
+    guint32 quoted = 0;
+
+    while (haystacklen >= 32) {
+        __m256i value = _mm256_loadu_si256(cast_m256i(haystack));
+        guint32 quotes = (guint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(value, dquote));
+        guint32 eol = (guint32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(value, cr), _mm256_cmpeq_epi8(value, lf)));
+        guint32 inside = ws_memscan_quoted_mask(quotes) ^ quoted;
+
+        eol &= ~inside;
+        if (eol)
+            return haystack + ws_ctz(eol);
+        quoted = (inside & 0x80000000) ? G_MAXUINT32 : 0;
+        haystack += 32;
+        haystacklen -= 32;
+    }
+    return ws_memscan_crlf_unquoted_portable(haystack, haystacklen, quoted != 0);
+}
+
+const guint8 *
+ws_memscan_pair_avx2(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second)
+{
+    const __m256i first_v = _mm256_set1_epi8((char)first);
+    const __m256i second_v = _mm256_set1_epi8((char)second);
+    const guint8 *last = haystack + haystacklen - 33;
+    const guint8 *p = haystack;
+
+    for (;;) {
+        __m256i at = _mm256_cmpeq_epi8(_mm256_loadu_si256(cast_m256i(p)), first_v);
+        __m256i next = _mm256_cmpeq_epi8(_mm256_loadu_si256(cast_m256i(p + 1)), second_v);
+        guint32 mask = (guint32)_mm256_movemask_epi8(_mm256_and_si256(at, next));
+
+        if (mask)
+            return p + ws_ctz(mask);
+        if (p == last)
+            return NULL;
+        p += 32;
+        if (p > last)
+            p = last;
+    }
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
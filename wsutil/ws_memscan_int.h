@@ -0,0 +1,41 @@
+/* ws_memscan_int.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_MEMSCAN_INT_H__
+#define __WS_MEMSCAN_INT_H__
+
+/* The byte-at-a-time versions, which the vector ones use for the tail of
+ * the buffer. "quoted" is whether the buffer starts inside a quoted string. */
+const guint8 *ws_memscan_crlf_portable(const guint8 *haystack, size_t haystacklen);
+const guint8 *ws_memscan_crlf_unquoted_portable(const guint8 *haystack, size_t haystacklen, gboolean quoted);
+const guint8 *ws_memscan_pair_portable(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second);
+
+#ifdef HAVE_AVX2
+const guint8 *ws_memscan_crlf_avx2(const guint8 *haystack, size_t haystacklen);
+const guint8 *ws_memscan_crlf_unquoted_avx2(const guint8 *haystack, size_t haystacklen);
+const guint8 *ws_memscan_pair_avx2(const guint8 *haystack, size_t haystacklen, guint8 first, guint8 second);
+#endif
+
+/*
+ * Given a mask with a bit set for each '"' in a block, returns a mask
+ * with a bit set for each byte from an opening quote up to, but not
+ * including, the closing one, i.e. the running parity of the quotes.
+ */
+static inline guint32
+ws_memscan_quoted_mask(guint32 quotes)
+{
+    quotes ^= quotes << 1;
+    quotes ^= quotes << 2;
+    quotes ^= quotes << 4;
+    quotes ^= quotes << 8;
+    quotes ^= quotes << 16;
+    return quotes;
+}
+
+#endif /* __WS_MEMSCAN_INT_H__ */